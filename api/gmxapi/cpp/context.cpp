@@ -45,12 +45,28 @@
 
 #include "gmxapi/context.h"
 
+#include "config.h"
+
+#include <cerrno>
+#include <cstdint>
 #include <cstring>
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <new>
+#include <random>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#ifdef HAVE_UNISTD_H
+#    include <fcntl.h>
+#    include <unistd.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#endif
+
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/commandline/pargs.h"
@@ -59,24 +75,30 @@
 #include "gromacs/mdrunutility/logging.h"
 #include "gromacs/mdrunutility/multisim.h"
 #include "gromacs/mdrun/runner.h"
+#include "gromacs/mdrun/simulationinput.h"
 #include "gromacs/mdrunutility/handlerestart.h"
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/basenetwork.h"
+#include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxmpi.h"
 #include "gromacs/utility/init.h"
 #include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/stringutil.h"
 
 #include "gmxapi/mpi/resourceassignment.h"
 #include "gmxapi/exceptions.h"
 #include "gmxapi/session.h"
 #include "gmxapi/status.h"
+#include "gmxapi/session/ensemble.h"
 #include "gmxapi/version.h"
 
 #include "context_impl.h"
 #include "createsession.h"
 #include "session_impl.h"
 #include "workflow.h"
+#include "workflow_impl.h"
 
 namespace gmxapi
 {
@@ -186,6 +208,467 @@ MPI_Comm MpiContextManager::communicator() const
     return *communicator_;
 }
 
+namespace
+{
+
+//! Sum \p numBuffers buffers of \p count elements, in buffer order.
+template<typename T>
+void sumInOrder(const char* buffers, size_t bufferStride, int numBuffers, size_t count, void* recv)
+{
+    auto* result = static_cast<T*>(recv);
+    for (size_t i = 0; i < count; ++i)
+    {
+        T sum = 0;
+        for (int b = 0; b < numBuffers; ++b)
+        {
+            T value;
+            std::memcpy(&value, buffers + b * bufferStride + i * sizeof(T), sizeof(T));
+            sum += value;
+        }
+        result[i] = sum;
+    }
+}
+
+//! Size in bytes of an element of \p type.
+size_t dataTypeSize(EnsembleCommunicator::DataType type)
+{
+    switch (type)
+    {
+        case EnsembleCommunicator::DataType::Int32: return sizeof(int32_t);
+        case EnsembleCommunicator::DataType::Int64: return sizeof(int64_t);
+        case EnsembleCommunicator::DataType::Float: return sizeof(float);
+        case EnsembleCommunicator::DataType::Double: return sizeof(double);
+    }
+    GMX_THROW(gmx::InternalError("Unknown ensemble data type"));
+}
+
+/*!
+ * \brief Communicator for an ensemble with a single member.
+ */
+class SingleMemberEnsembleCommunicator final : public EnsembleCommunicator
+{
+public:
+    [[nodiscard]] int size() const override { return 1; }
+    [[nodiscard]] int rank() const override { return 0; }
+
+protected:
+    void allReduceData(const void* send, void* recv, size_t count, DataType type) override
+    {
+        std::memmove(recv, send, count * dataTypeSize(type));
+    }
+    void broadcastBytes(void* /* buffer */, size_t /* numBytes */, int root) override
+    {
+        if (root != 0)
+        {
+            throw UsageError("Invalid root for broadcast in an ensemble with a single member.");
+        }
+    }
+    void allGatherBytes(const void* send, void* recv, size_t numBytes) override
+    {
+        std::memmove(recv, send, numBytes);
+    }
+};
+
+#ifdef HAVE_UNISTD_H
+/*!
+ * \brief Communicator for ensemble members on the same node.
+ *
+ * The shared memory segment starts with the state of a barrier, followed by
+ * one join token and one acknowledgement per member, and one fixed-size slot
+ * per member. Collectives on larger buffers proceed in chunks of the slot
+ * size. Each chunk is copied to the slot of the member, read by all members
+ * after a barrier, and released by a second barrier.
+ *
+ * Member 0 removes any segment left behind by an earlier run with the same
+ * name, creates a new one and initializes the barrier. The other members
+ * write a random token to the segment and wait for member 0 to acknowledge
+ * it, so that none of them can be left behind in a stale segment.
+ */
+class NodeEnsembleCommunicator final : public EnsembleCommunicator
+{
+public:
+    NodeEnsembleCommunicator(const std::string& name, int size, int rank) :
+        name_(name.empty() || name[0] == '/' ? name : '/' + name),
+        size_(size),
+        rank_(rank),
+        slotOffset_(c_headerSize + roundUpToHeaderSize(2 * size * sizeof(std::atomic<uint64_t>))),
+        segmentSize_(slotOffset_ + size * c_slotSize)
+    {
+        if (size < 1 || rank < 0 || rank >= size)
+        {
+            throw UsageError(gmx::formatString(
+                    "Invalid rank %d for an ensemble of size %d.", rank, size));
+        }
+        if (name_.size() < 2)
+        {
+            throw UsageError("Node ensemble requires a name for its shared memory segment.");
+        }
+        if (rank_ == 0)
+        {
+            createSegment();
+        }
+        else
+        {
+            joinSegment();
+        }
+        // Wait for all members to join.
+        barrier();
+    }
+
+    ~NodeEnsembleCommunicator() override
+    {
+        // Make sure no member still reads from the slots.
+        barrier();
+        if (rank_ == 0)
+        {
+            shm_unlink(name_.c_str());
+        }
+        munmap(segment_, segmentSize_);
+    }
+
+    NodeEnsembleCommunicator(const NodeEnsembleCommunicator&) = delete;
+    NodeEnsembleCommunicator& operator=(const NodeEnsembleCommunicator&) = delete;
+
+    [[nodiscard]] int size() const override { return size_; }
+    [[nodiscard]] int rank() const override { return rank_; }
+
+protected:
+    void allReduceData(const void* send, void* recv, size_t count, DataType type) override
+    {
+        const size_t elementSize    = dataTypeSize(type);
+        const size_t elementsPerSlot = c_slotSize / elementSize;
+        for (size_t offset = 0; offset < count; offset += elementsPerSlot)
+        {
+            const size_t numElements = std::min(elementsPerSlot, count - offset);
+            std::memcpy(slot(rank_), static_cast<const char*>(send) + offset * elementSize,
+                        numElements * elementSize);
+            barrier();
+            void* result = static_cast<char*>(recv) + offset * elementSize;
+            switch (type)
+            {
+                case DataType::Int32:
+                    sumInOrder<int32_t>(slot(0), c_slotSize, size_, numElements, result);
+                    break;
+                case DataType::Int64:
+                    sumInOrder<int64_t>(slot(0), c_slotSize, size_, numElements, result);
+                    break;
+                case DataType::Float:
+                    sumInOrder<float>(slot(0), c_slotSize, size_, numElements, result);
+                    break;
+                case DataType::Double:
+                    sumInOrder<double>(slot(0), c_slotSize, size_, numElements, result);
+                    break;
+            }
+            barrier();
+        }
+    }
+
+    void broadcastBytes(void* buffer, size_t numBytes, int root) override
+    {
+        if (root < 0 || root >= size_)
+        {
+            throw UsageError(gmx::formatString("Invalid root %d for broadcast.", root));
+        }
+        for (size_t offset = 0; offset < numBytes; offset += c_slotSize)
+        {
+            const size_t chunk = std::min(c_slotSize, numBytes - offset);
+            if (rank_ == root)
+            {
+                std::memcpy(slot(root), static_cast<char*>(buffer) + offset, chunk);
+            }
+            barrier();
+            if (rank_ != root)
+            {
+                std::memcpy(static_cast<char*>(buffer) + offset, slot(root), chunk);
+            }
+            barrier();
+        }
+    }
+
+    void allGatherBytes(const void* send, void* recv, size_t numBytes) override
+    {
+        for (size_t offset = 0; offset < numBytes; offset += c_slotSize)
+        {
+            const size_t chunk = std::min(c_slotSize, numBytes - offset);
+            std::memcpy(slot(rank_), static_cast<const char*>(send) + offset, chunk);
+            barrier();
+            for (int r = 0; r < size_; ++r)
+            {
+                std::memcpy(static_cast<char*>(recv) + r * numBytes + offset, slot(r), chunk);
+            }
+            barrier();
+        }
+    }
+
+private:
+    //! Barrier state in the shared segment.
+    struct BarrierState
+    {
+        std::atomic<int> numArrived;
+        std::atomic<int> generation;
+    };
+    static_assert(std::atomic<int>::is_always_lock_free
+                          && std::atomic<uint64_t>::is_always_lock_free,
+                  "Synchronization through shared memory requires lock-free atomics.");
+
+    //! Size of the barrier state, keeping it on a cache line of its own.
+    static constexpr size_t c_headerSize = 128;
+    //! Size of the buffer of each member.
+    static constexpr size_t c_slotSize = 1 << 20;
+
+    static size_t roundUpToHeaderSize(size_t numBytes)
+    {
+        return (numBytes + c_headerSize - 1) / c_headerSize * c_headerSize;
+    }
+
+    char* slot(int r) const { return segment_ + slotOffset_ + r * c_slotSize; }
+
+    //! Token written by member \p r when it has mapped the segment.
+    std::atomic<uint64_t>& joinToken(int r) const
+    {
+        return reinterpret_cast<std::atomic<uint64_t>*>(segment_ + c_headerSize)[r];
+    }
+
+    //! Copy of the token of member \p r, written by member 0.
+    std::atomic<uint64_t>& acknowledgedToken(int r) const
+    {
+        return reinterpret_cast<std::atomic<uint64_t>*>(segment_ + c_headerSize)[size_ + r];
+    }
+
+    //! Map the first segmentSize_ bytes of \p fd, which is closed.
+    void map(int fd)
+    {
+        void* segment = mmap(nullptr, segmentSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (segment == MAP_FAILED)
+        {
+            throw ProtocolError(gmx::formatString("Could not map shared memory segment %s: %s",
+                                                  name_.c_str(), std::strerror(errno)));
+        }
+        segment_ = static_cast<char*>(segment);
+        barrier_ = reinterpret_cast<BarrierState*>(segment_);
+    }
+
+    //! Create a new segment, and acknowledge all members that join it.
+    void createSegment()
+    {
+        // A segment left behind by a run that did not finish may be in any state.
+        shm_unlink(name_.c_str());
+        const int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+        if (fd < 0)
+        {
+            throw ProtocolError(gmx::formatString("Could not create shared memory segment %s: %s",
+                                                  name_.c_str(), std::strerror(errno)));
+        }
+        // The new segment is zero-filled, so no member has joined it yet.
+        if (ftruncate(fd, segmentSize_) != 0)
+        {
+            const int error = errno;
+            close(fd);
+            shm_unlink(name_.c_str());
+            throw ProtocolError(gmx::formatString("Could not size shared memory segment %s: %s",
+                                                  name_.c_str(), std::strerror(error)));
+        }
+        map(fd);
+        new (barrier_) BarrierState{ { 0 }, { 0 } };
+        for (int r = 1; r < size_; ++r)
+        {
+            uint64_t token;
+            while ((token = joinToken(r).load()) == 0)
+            {
+                std::this_thread::yield();
+            }
+            acknowledgedToken(r).store(token);
+        }
+    }
+
+    //! Map the segment of member 0, once member 0 has acknowledged us in it.
+    void joinSegment()
+    {
+        std::random_device randomDevice;
+        uint64_t           token = 0;
+        while (token == 0)
+        {
+            token = (uint64_t(randomDevice()) << 32U) | randomDevice();
+        }
+        while (true)
+        {
+            // Wait for member 0 to create and size the segment.
+            const int fd = shm_open(name_.c_str(), O_RDWR, 0);
+            if (fd < 0)
+            {
+                if (errno != ENOENT)
+                {
+                    throw ProtocolError(
+                            gmx::formatString("Could not open shared memory segment %s: %s",
+                                              name_.c_str(), std::strerror(errno)));
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            struct stat status;
+            if (fstat(fd, &status) != 0 || status.st_size != static_cast<off_t>(segmentSize_))
+            {
+                close(fd);
+                std::this_thread::yield();
+                continue;
+            }
+            map(fd);
+            joinToken(rank_).store(token);
+            // If member 0 replaces the segment, it will never acknowledge us in this one.
+            while (acknowledgedToken(rank_).load() != token && isCurrentSegment(status))
+            {
+                std::this_thread::yield();
+            }
+            if (acknowledgedToken(rank_).load() == token)
+            {
+                return;
+            }
+            munmap(segment_, segmentSize_);
+            segment_ = nullptr;
+            barrier_ = nullptr;
+        }
+    }
+
+    //! Whether the segment described by \p status is still the one with our name.
+    bool isCurrentSegment(const struct stat& status) const
+    {
+        const int fd = shm_open(name_.c_str(), O_RDWR, 0);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat current;
+        const bool  isSame = fstat(fd, &current) == 0 && current.st_dev == status.st_dev
+                            && current.st_ino == status.st_ino;
+        close(fd);
+        return isSame;
+    }
+
+    //! Wait until all members have arrived.
+    void barrier()
+    {
+        const int generation = barrier_->generation.load();
+        if (barrier_->numArrived.fetch_add(1) + 1 == size_)
+        {
+            barrier_->numArrived.store(0);
+            barrier_->generation.fetch_add(1);
+        }
+        else
+        {
+            while (barrier_->generation.load() == generation)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    std::string   name_;
+    int           size_;
+    int           rank_;
+    size_t        slotOffset_;
+    size_t        segmentSize_;
+    char*         segment_ = nullptr;
+    BarrierState* barrier_ = nullptr;
+};
+#endif
+
+#if GMX_LIB_MPI
+/*!
+ * \brief Communicator for ensemble members linked by MPI.
+ */
+class MpiEnsembleCommunicator final : public EnsembleCommunicator
+{
+public:
+    explicit MpiEnsembleCommunicator(MPI_Comm communicator)
+    {
+        if (communicator == MPI_COMM_NULL)
+        {
+            throw UsageError("Cannot use a Null communicator for an ensemble.");
+        }
+        int threadSupport = MPI_THREAD_SINGLE;
+        MPI_Query_thread(&threadSupport);
+        if (threadSupport < MPI_THREAD_SERIALIZED)
+        {
+            throw UsageError(
+                    "Ensemble communication requires MPI to be initialized with at least "
+                    "MPI_THREAD_SERIALIZED support.");
+        }
+        MPI_Comm_dup(communicator, &communicator_);
+        MPI_Comm_size(communicator_, &size_);
+        MPI_Comm_rank(communicator_, &rank_);
+    }
+
+    ~MpiEnsembleCommunicator() override { MPI_Comm_free(&communicator_); }
+
+    MpiEnsembleCommunicator(const MpiEnsembleCommunicator&) = delete;
+    MpiEnsembleCommunicator& operator=(const MpiEnsembleCommunicator&) = delete;
+
+    [[nodiscard]] int size() const override { return size_; }
+    [[nodiscard]] int rank() const override { return rank_; }
+
+protected:
+    void allReduceData(const void* send, void* recv, size_t count, DataType type) override
+    {
+        MPI_Datatype datatype = MPI_DOUBLE;
+        switch (type)
+        {
+            case DataType::Int32: datatype = MPI_INT32_T; break;
+            case DataType::Int64: datatype = MPI_INT64_T; break;
+            case DataType::Float: datatype = MPI_FLOAT; break;
+            case DataType::Double: datatype = MPI_DOUBLE; break;
+        }
+        MPI_Allreduce(send == recv ? MPI_IN_PLACE : send, recv, static_cast<int>(count), datatype,
+                      MPI_SUM, communicator_);
+    }
+
+    void broadcastBytes(void* buffer, size_t numBytes, int root) override
+    {
+        MPI_Bcast(buffer, static_cast<int>(numBytes), MPI_BYTE, root, communicator_);
+    }
+
+    void allGatherBytes(const void* send, void* recv, size_t numBytes) override
+    {
+        MPI_Allgather(send, static_cast<int>(numBytes), MPI_BYTE, recv, static_cast<int>(numBytes),
+                      MPI_BYTE, communicator_);
+    }
+
+private:
+    MPI_Comm communicator_ = MPI_COMM_NULL;
+    int      size_         = 0;
+    int      rank_         = 0;
+};
+#endif
+
+} // anonymous namespace
+
+std::shared_ptr<EnsembleCommunicator> createSingleMemberEnsembleCommunicator()
+{
+    return std::make_shared<SingleMemberEnsembleCommunicator>();
+}
+
+std::shared_ptr<EnsembleCommunicator> createNodeEnsembleCommunicator(const std::string& name, int size, int rank)
+{
+#ifdef HAVE_UNISTD_H
+    return std::make_shared<NodeEnsembleCommunicator>(name, size, rank);
+#else
+    GMX_UNUSED_VALUE(name);
+    GMX_UNUSED_VALUE(size);
+    GMX_UNUSED_VALUE(rank);
+    throw NotImplementedError("Node ensembles require POSIX shared memory.");
+#endif
+}
+
+std::shared_ptr<EnsembleCommunicator> createMpiEnsembleCommunicator(MPI_Comm communicator)
+{
+#if GMX_LIB_MPI
+    return std::make_shared<MpiEnsembleCommunicator>(communicator);
+#else
+    GMX_UNUSED_VALUE(communicator);
+    throw NotImplementedError("MPI ensembles require GROMACS built with an MPI library.");
+#endif
+}
+
 ContextImpl::~ContextImpl() = default;
 
 [[maybe_unused]] static Context createContext(const ResourceAssignment& resources, const gmxLibMpi&)
@@ -228,9 +711,10 @@ Context createContext()
     return context;
 }
 
-ContextImpl::ContextImpl(MpiContextManager&& mpi) noexcept(std::is_nothrow_constructible_v<gmx::LegacyMdrunOptions>) :
+ContextImpl::ContextImpl(MpiContextManager&& mpi) :
     mpi_(std::move(mpi))
 {
+    ensemble_ = createSingleMemberEnsembleCommunicator();
     // Confirm our understanding of the MpiContextManager invariant.
     GMX_ASSERT(mpi_.communicator() == MPI_COMM_NULL ? !GMX_LIB_MPI : GMX_LIB_MPI,
                "Precondition violated: inappropriate communicator for the library environment.");
@@ -260,11 +744,16 @@ std::shared_ptr<Session> ContextImpl::launch(const Workflow& work)
     {
         // Check workflow spec, build graph for current context, launch and return new session.
         // \todo This is specific to the session implementation...
-        auto        mdNode = work.getNode("MD");
-        std::string filename{};
+        auto                               mdNode = work.getNode("MD");
+        std::string                        filename{};
+        std::shared_ptr<const InMemoryTpr> inMemoryInput;
         if (mdNode != nullptr)
         {
             filename = mdNode->params();
+            if (const auto* mdNodeSpec = dynamic_cast<const MDNodeSpecification*>(mdNode.get()))
+            {
+                inMemoryInput = mdNodeSpec->inMemoryInput();
+            }
         }
 
         /* Mock up the argv interface used by option processing infrastructure.
@@ -281,13 +770,19 @@ std::shared_ptr<Session> ContextImpl::launch(const Workflow& work)
          *       Ref: https://gitlab.com/gromacs/gromacs/-/issues/3652
          */
 
-        // Set input TPR name
-        mdArgs_.emplace_back("-s");
-        mdArgs_.emplace_back(filename);
+        // Extend a copy, so that the client arguments can be reused for further launches.
+        MDArgs launchArgs = mdArgs_;
+
+        // Set input TPR name, unless the input is already in memory.
+        if (!inMemoryInput)
+        {
+            launchArgs.emplace_back("-s");
+            launchArgs.emplace_back(filename);
+        }
 
         // Set checkpoint file name
-        mdArgs_.emplace_back("-cpi");
-        mdArgs_.emplace_back("state.cpt");
+        launchArgs.emplace_back("-cpi");
+        launchArgs.emplace_back("state.cpt");
         /* Note: we normalize the checkpoint file name, but not its full path.
          * Through version 0.0.8, gmxapi clients change working directory
          * for each session, so relative path(s) below are appropriate.
@@ -300,20 +795,30 @@ std::shared_ptr<Session> ContextImpl::launch(const Workflow& work)
 
         // Create a mock argv. Note that argv[0] is expected to hold the program name.
         const int  offset = 1;
-        const auto argc   = static_cast<size_t>(mdArgs_.size() + offset);
+        const auto argc   = static_cast<size_t>(launchArgs.size() + offset);
         auto       argv   = std::vector<char*>(argc, nullptr);
         // argv[0] is ignored, but should be a valid string (e.g. null terminated array of char)
         argv[0]  = new char[1];
         *argv[0] = '\0';
         for (size_t argvIndex = offset; argvIndex < argc; ++argvIndex)
         {
-            const auto& mdArg = mdArgs_[argvIndex - offset];
+            const auto& mdArg = launchArgs[argvIndex - offset];
             argv[argvIndex]   = new char[mdArg.length() + 1];
             strcpy(argv[argvIndex], mdArg.c_str());
         }
 
         auto mdModules = std::make_unique<MDModules>();
 
+        // Input held in memory does not need a TPR file.
+        for (auto& fileNameOption : options_.filenames)
+        {
+            if (fileNameOption.ftp == efTPR)
+            {
+                fileNameOption.flag = inMemoryInput ? (fileNameOption.flag | (ffOPT))
+                                                    : (fileNameOption.flag & ~(ffOPT));
+            }
+        }
+
         const char* desc[] = { "gmxapi placeholder text" };
         if (options_.updateFromCommandLine(argc, argv.data(), desc) == 0)
         {
@@ -361,7 +866,11 @@ std::shared_ptr<Session> ContextImpl::launch(const Workflow& work)
         // \todo File names are parameters that should be managed modularly through further factoring.
         builder.addFilenames(options_.filenames);
         // TODO: Remove `s` and `-cpi` from LegacyMdrunOptions before launch(). #3652
-        auto simulationInput = makeSimulationInput(options_);
+        auto simulationInput =
+                inMemoryInput ? makeSimulationInput(inMemoryInput,
+                                                    opt2fn("-cpi", ssize(options_.filenames),
+                                                           options_.filenames.data()))
+                              : makeSimulationInput(options_);
         builder.addInput(simulationInput);
 
         // Note: The gmx_output_env_t life time is not managed after the call to parse_common_args.
@@ -417,6 +926,32 @@ void Context::setMDArgs(const MDArgs& mdArgs)
     impl_->mdArgs_ = mdArgs;
 }
 
+void Context::setEnsembleReduce(std::function<void(const double*, double*, size_t)> reduce)
+{
+    impl_->ensembleReduce_ = std::move(reduce);
+}
+
+void Context::joinNodeEnsemble(const std::string& name, int size, int rank)
+{
+    impl_->ensemble_ = createNodeEnsembleCommunicator(name, size, rank);
+}
+
+void Context::setEnsembleCommunicator(const ResourceAssignment& resources)
+{
+    CommHandle handle;
+    resources.applyCommunicator(&handle);
+    impl_->ensemble_ = createMpiEnsembleCommunicator(handle.communicator);
+}
+
+void Context::setEnsembleCommunicator(std::shared_ptr<EnsembleCommunicator> communicator)
+{
+    if (!communicator)
+    {
+        throw UsageError("Ensemble communicator must not be null.");
+    }
+    impl_->ensemble_ = std::move(communicator);
+}
+
 Context::~Context() = default;
 
 } // end namespace gmxapi
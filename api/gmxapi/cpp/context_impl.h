@@ -50,6 +50,7 @@
 
 #include "gmxapi/context.h"
 #include "gmxapi/session.h"
+#include "gmxapi/session/ensemble.h"
 
 namespace gmxapi
 {
@@ -151,6 +152,54 @@ private:
     std::unique_ptr<MPI_Comm> communicator_;
 };
 
+/*!
+ * \brief Get a communicator for an ensemble with a single member.
+ *
+ * Collectives reduce to copies.
+ *
+ * \ingroup gmxapi
+ */
+std::shared_ptr<EnsembleCommunicator> createSingleMemberEnsembleCommunicator();
+
+/*!
+ * \brief Join an ensemble whose members run on the same node.
+ *
+ * Members communicate through a POSIX shared memory segment identified by
+ * \p name, which must be unique for the ensemble on the node. Joining is
+ * collective: the function returns when all \p size members have joined.
+ * Collectives do not involve an MPI library, and sums are performed in rank
+ * order, so that all members obtain bit-identical results.
+ *
+ * Destroying the communicator is also collective. The segment is removed
+ * when the last member releases it.
+ *
+ * \param name name of the shared memory segment
+ * \param size number of ensemble members
+ * \param rank index of this member in the ensemble
+ *
+ * \throws UsageError for invalid arguments.
+ * \throws NotImplementedError if shared memory is not supported on this platform.
+ * \throws ProtocolError if the segment cannot be created or mapped.
+ *
+ * \ingroup gmxapi
+ */
+std::shared_ptr<EnsembleCommunicator>
+createNodeEnsembleCommunicator(const std::string& name, int size, int rank);
+
+/*!
+ * \brief Use an MPI communicator linking the ensemble members.
+ *
+ * The communicator is duplicated, so the client may free its handle. Each
+ * ensemble member is represented by a single rank in \p communicator.
+ *
+ * \throws UsageError if the communicator is null or if the MPI library does
+ *         not allow the reductions to be performed by a thread of their own.
+ * \throws NotImplementedError if GROMACS was not built with an MPI library.
+ *
+ * \ingroup gmxapi
+ */
+std::shared_ptr<EnsembleCommunicator> createMpiEnsembleCommunicator(MPI_Comm communicator);
+
 /*!
  * \brief Context implementation.
  *
@@ -248,6 +297,21 @@ public:
      */
     MDArgs mdArgs_;
 
+    /*!
+     * \brief Communicator among the members of the ensemble of this Context.
+     *
+     * A Context is the only member of its ensemble unless the client joins it
+     * to a larger one.
+     */
+    std::shared_ptr<EnsembleCommunicator> ensemble_;
+
+    /*!
+     * \brief Reduce operation for the ensemble resources of launched sessions.
+     *
+     * If empty, sessions sum over ensemble_.
+     */
+    EnsembleReduceFunction ensembleReduce_;
+
     /*!
      * \brief Legacy option-handling and set up for mdrun.
      *
@@ -284,7 +348,7 @@ private:
      * Don't use this. Use create() to get a shared pointer right away.
      * Otherwise, shared_from_this() is potentially dangerous.
      */
-    explicit ContextImpl(MpiContextManager&& mpi) noexcept(std::is_nothrow_constructible_v<gmx::LegacyMdrunOptions>);
+    explicit ContextImpl(MpiContextManager&& mpi);
 };
 
 /*!
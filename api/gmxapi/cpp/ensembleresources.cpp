@@ -0,0 +1,278 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \file
+ * \brief Implement split-phase ensemble reductions and background persistence.
+ *
+ * \ingroup gmxapi
+ */
+
+#include "gmxapi/session/ensemble.h"
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include "gromacs/restraint/restraintmdmodule.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/textwriter.h"
+
+#include "gmxapi/exceptions.h"
+
+#include "ensembleresources.h"
+#include "sessionresources.h"
+
+namespace gmxapi
+{
+
+class EnsembleResources::WorkQueue
+{
+public:
+    WorkQueue() : thread_([this]() { run(); }) {}
+
+    //! Finish the queued tasks and join the thread.
+    ~WorkQueue()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+        }
+        condition_.notify_one();
+        thread_.join();
+    }
+
+    //! Queue a task to run after all previously queued tasks.
+    void push(std::function<void()>&& task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace_back(std::move(task));
+        }
+        condition_.notify_one();
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            condition_.wait(lock, [this]() { return done_ || !tasks_.empty(); });
+            if (tasks_.empty())
+            {
+                return;
+            }
+            auto task = std::move(tasks_.front());
+            tasks_.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex                        mutex_;
+    std::condition_variable           condition_;
+    std::deque<std::function<void()>> tasks_;
+    bool                              done_ = false;
+    // Declared last so that it starts after the other members are initialized.
+    std::thread thread_;
+};
+
+EnsembleReduction::Impl::Impl(std::future<void>&& result) : result_(std::move(result)) {}
+
+EnsembleReduction::EnsembleReduction() = default;
+
+EnsembleReduction::EnsembleReduction(std::shared_ptr<Impl> impl) : impl_(std::move(impl)) {}
+
+bool EnsembleReduction::isComplete() const
+{
+    return !impl_
+           || impl_->result_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+void EnsembleReduction::wait()
+{
+    if (!impl_)
+    {
+        return;
+    }
+    // Reported separately from the rest of the update call-back of the restraint.
+    gmx::RestraintReductionTimer timer;
+    try
+    {
+        impl_->result_.get();
+    }
+    catch (const std::exception& e)
+    {
+        throw ProtocolError(std::string("Ensemble reduction failed: ") + e.what());
+    }
+}
+
+EnsembleCommunicator::~EnsembleCommunicator() = default;
+
+EnsembleResources::EnsembleResources(std::shared_ptr<EnsembleCommunicator> communicator,
+                                     EnsembleReduceFunction                reduce) :
+    communicator_(std::move(communicator)),
+    reduce_(std::move(reduce))
+{
+    GMX_RELEASE_ASSERT(communicator_, "Ensemble resources require a communicator.");
+    if (!reduce_)
+    {
+        reduce_ = [communicator = communicator_.get()](const double* send, double* recv, size_t size) {
+            communicator->allReduce(send, recv, size);
+        };
+    }
+}
+
+EnsembleResources::~EnsembleResources()
+{
+    // Reductions may still be writing to client buffers, so finish them first.
+    reductions_.reset();
+    writes_.reset();
+}
+
+EnsembleCommunicator* EnsembleResources::communicator() const
+{
+    return communicator_.get();
+}
+
+EnsembleResources::WorkQueue* EnsembleResources::startedQueue(std::unique_ptr<WorkQueue>* queue)
+{
+    // Most sessions never reduce or persist anything, so threads are only
+    // started when they are first needed.
+    if (!*queue)
+    {
+        *queue = std::make_unique<WorkQueue>();
+    }
+    return queue->get();
+}
+
+std::shared_ptr<EnsembleReduction::Impl>
+EnsembleResources::startReduce(const double* send, double* recv, size_t size)
+{
+    auto promise = std::make_shared<std::promise<void>>();
+    auto impl    = std::make_shared<EnsembleReduction::Impl>(promise->get_future());
+    WorkQueue* reductions;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reductions = startedQueue(&reductions_);
+    }
+    reductions->push([this, promise, sendBuffer = std::vector<double>(send, send + size), recv]() {
+        try
+        {
+            reduce_(sendBuffer.data(), recv, sendBuffer.size());
+            promise->set_value();
+        }
+        catch (...)
+        {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return impl;
+}
+
+void EnsembleResources::persist(const std::string& name, const std::string& tag, const double* data, size_t size)
+{
+    std::string fileName;
+    WorkQueue*  writes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (writeError_)
+        {
+            try
+            {
+                std::rethrow_exception(writeError_);
+            }
+            catch (const std::exception& e)
+            {
+                throw ProtocolError(std::string("Could not persist ensemble data: ") + e.what());
+            }
+        }
+        const std::string prefix = gmx::formatString("%s_%s", name.c_str(), tag.c_str());
+        fileName = gmx::formatString("%spart%04d.dat", prefix.c_str(), parts_[prefix]++);
+        writes   = startedQueue(&writes_);
+    }
+    writes->push([this, fileName, values = std::vector<double>(data, data + size)]() {
+        try
+        {
+            gmx::TextWriter writer(fileName);
+            for (const double value : values)
+            {
+                writer.writeLine(gmx::formatString("%.17g", value));
+            }
+            writer.close();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!writeError_)
+            {
+                writeError_ = std::current_exception();
+            }
+        }
+    });
+}
+
+EnsembleCommunicator* getEnsembleCommunicator(SessionResources* resources)
+{
+    if (resources == nullptr)
+    {
+        throw UsageError("Caller must provide a valid SessionResources to getEnsembleCommunicator.");
+    }
+    return resources->ensemble()->communicator();
+}
+
+EnsembleReduction startEnsembleReduce(SessionResources* resources, const double* send, double* recv, size_t size)
+{
+    if (resources == nullptr)
+    {
+        throw UsageError("Caller must provide a valid SessionResources to startEnsembleReduce.");
+    }
+    return EnsembleReduction(resources->ensemble()->startReduce(send, recv, size));
+}
+
+void persistEnsembleData(SessionResources* resources, const std::string& tag, const double* data, size_t size)
+{
+    if (resources == nullptr)
+    {
+        throw UsageError("Caller must provide a valid SessionResources to persistEnsembleData.");
+    }
+    resources->ensemble()->persist(resources->name(), tag, data, size);
+}
+
+} // end namespace gmxapi
@@ -0,0 +1,156 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+#ifndef GMXAPI_ENSEMBLERESOURCES_H
+#define GMXAPI_ENSEMBLERESOURCES_H
+
+/*! \file
+ * \brief Declare the Session-level ensemble communication resources.
+ *
+ * \ingroup gmxapi
+ */
+
+#include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "gmxapi/session/ensemble.h"
+
+namespace gmxapi
+{
+
+/*!
+ * \brief Shared state of a reduction started with EnsembleResources::startReduce().
+ *
+ * \ingroup gmxapi
+ */
+class EnsembleReduction::Impl
+{
+public:
+    /*!
+     * \brief Take ownership of the future result of a reduction.
+     *
+     * \param result becomes ready when the receive buffer has been written.
+     */
+    explicit Impl(std::future<void>&& result);
+
+    //! Future result of the reduction.
+    std::shared_future<void> result_;
+};
+
+/*!
+ * \brief Ensemble communication resources shared by all operations in a Session.
+ *
+ * Reductions are passed, in the order they were started, to a dedicated
+ * thread, started on the first reduction, that calls the blocking reduce function provided by the Context,
+ * or that sums over the ensemble communicator of the Context.
+ * Data to persist is written by a second thread, so that neither the
+ * simulation nor the ensemble communication waits for the file system.
+ *
+ * All pending work is finished before the object is destroyed.
+ *
+ * \ingroup gmxapi
+ */
+class EnsembleResources
+{
+public:
+    /*!
+     * \brief Set up ensemble resources for a member of an ensemble.
+     *
+     * \param communicator collective communication among the ensemble members.
+     * \param reduce blocking reduce function, or an empty function to sum
+     *               over \p communicator.
+     */
+    EnsembleResources(std::shared_ptr<EnsembleCommunicator> communicator, EnsembleReduceFunction reduce);
+
+    //! Finish all pending reductions and writes.
+    ~EnsembleResources();
+
+    EnsembleResources(const EnsembleResources&) = delete;
+    EnsembleResources& operator=(const EnsembleResources&) = delete;
+
+    //! Get the communicator among the ensemble members.
+    EnsembleCommunicator* communicator() const;
+
+    /*!
+     * \brief Copy \p send and queue its reduction into \p recv.
+     *
+     * \return shared state with which to complete the reduction.
+     * \see startEnsembleReduce()
+     */
+    std::shared_ptr<EnsembleReduction::Impl> startReduce(const double* send, double* recv, size_t size);
+
+    /*!
+     * \brief Copy \p data and queue it to be written to a file.
+     *
+     * \param name name of the calling operation
+     * \param tag label of the data set
+     * \param data values to write
+     * \param size number of elements in \p data
+     *
+     * \throws gmxapi::ProtocolError if an earlier write failed.
+     * \see persistEnsembleData()
+     */
+    void persist(const std::string& name, const std::string& tag, const double* data, size_t size);
+
+private:
+    //! Executes tasks in order on a thread of its own.
+    class WorkQueue;
+
+    //! Create \p queue if it has not been started yet. Requires mutex_ to be held.
+    static WorkQueue* startedQueue(std::unique_ptr<WorkQueue>* queue);
+
+    //! Collective communication among the ensemble members.
+    std::shared_ptr<EnsembleCommunicator> communicator_;
+    //! Blocking reduce operation.
+    EnsembleReduceFunction reduce_;
+    //! Protects parts_, writeError_ and the creation of the work queues.
+    std::mutex mutex_;
+    //! Next part number for each file name prefix.
+    std::map<std::string, int> parts_;
+    //! First error encountered by the writer thread, if any.
+    std::exception_ptr writeError_;
+    //! Thread performing the reductions, if any were started.
+    std::unique_ptr<WorkQueue> reductions_;
+    //! Thread writing persisted data, if any was persisted.
+    std::unique_ptr<WorkQueue> writes_;
+};
+
+} // end namespace gmxapi
+
+#endif // GMXAPI_ENSEMBLERESOURCES_H
@@ -50,4 +50,9 @@ std::shared_ptr<::gmx::IRestraintPotential> MDModule::getRestraint()
     return nullptr;
 }
 
+int MDModule::restraintEvaluationPeriod() const
+{
+    return 1;
+}
+
 } // end namespace gmxapi
@@ -39,6 +39,7 @@
 
 #include "gromacs/mdlib/sighandler.h"
 #include "gromacs/mdrunutility/logging.h"
+#include "gromacs/restraint/manager.h"
 #include "gromacs/restraint/restraintpotential.h"
 #include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/basenetwork.h"
@@ -49,7 +50,9 @@
 #include "gmxapi/status.h"
 #include "gmxapi/md/mdmodule.h"
 
+#include "context_impl.h"
 #include "createsession.h"
+#include "ensembleresources.h"
 #include "mdsignals.h"
 #include "session_impl.h"
 #include "sessionresources.h"
@@ -91,6 +94,8 @@ Status SessionImpl::close()
     // Assume unsuccessful until proven otherwise.
     auto successful = Status(false);
 
+    // Finish ensemble communication while the clients' buffers are still alive.
+    ensembleResources_.reset();
     // When the Session is closed, we need to know that the MD output has been finalized.
     runner_.reset();
     logFilePtr_.reset();
@@ -112,6 +117,13 @@ Status SessionImpl::run() noexcept
     {
         successful = true;
     }
+    moduleTimings_.clear();
+    for (const auto& timing : runner_->restraintTimings())
+    {
+        moduleTimings_.push_back({ timing.name, timing.numEvaluations, timing.evaluationSeconds,
+                                   timing.numUpdates, timing.updateSeconds, timing.numReductions,
+                                   timing.reductionSeconds });
+    }
     return successful;
 }
 
@@ -142,6 +154,8 @@ SessionImpl::SessionImpl(std::shared_ptr<ContextImpl> context,
     signalManager_          = std::make_unique<SignalManager>(stopHandlerBuilder.get());
     GMX_ASSERT(signalManager_, "SessionImpl invariant includes a valid SignalManager.");
 
+    ensembleResources_ = std::make_unique<EnsembleResources>(context_->ensemble_, context_->ensembleReduce_);
+
     runnerBuilder.addStopHandlerBuilder(std::move(stopHandlerBuilder));
     runner_ = std::make_unique<gmx::Mdrunner>(runnerBuilder.build());
     GMX_ASSERT(runner_, "SessionImpl invariant implies valid Mdrunner handle.");
@@ -183,7 +197,8 @@ Status SessionImpl::addRestraint(std::shared_ptr<gmxapi::MDModule> module)
                 }
                 else
                 {
-                    runner_->addPotential(restraint, module->name());
+                    runner_->addPotential(restraint, module->name(),
+                                          module->restraintEvaluationPeriod());
                     status = true;
                 }
             }
@@ -203,6 +218,16 @@ SignalManager* SessionImpl::getSignalManager()
     return ptr;
 }
 
+EnsembleResources* SessionImpl::getEnsembleResources()
+{
+    EnsembleResources* ptr = nullptr;
+    if (isOpen())
+    {
+        ptr = ensembleResources_.get();
+    }
+    return ptr;
+}
+
 gmx::Mdrunner* SessionImpl::getRunner()
 {
     gmx::Mdrunner* runner = nullptr;
@@ -272,6 +297,11 @@ Status Session::run() noexcept
     return status;
 }
 
+std::vector<ModuleTiming> Session::moduleTimings() const
+{
+    return impl_->moduleTimings();
+}
+
 Status Session::close()
 {
     GMX_ASSERT(impl_, "Session invariant implies valid implementation object handle.");
@@ -378,4 +408,15 @@ Signal SessionResources::getMdrunnerSignal(md::signals signal)
     return functor;
 }
 
+EnsembleResources* SessionResources::ensemble()
+{
+    auto ensembleResources = sessionImpl_->getEnsembleResources();
+    if (ensembleResources == nullptr)
+    {
+        throw gmxapi::ProtocolError(
+                "Client requested ensemble resources that are not available.");
+    }
+    return ensembleResources;
+}
+
 } // end namespace gmxapi
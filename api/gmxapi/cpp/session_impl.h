@@ -51,6 +51,7 @@
 // Following are public headers for the current module.
 #include "gmxapi/context.h"
 #include "gmxapi/md.h"
+#include "gmxapi/session.h"
 #include "gmxapi/status.h"
 #include "gmxapi/md/mdmodule.h"
 #include "gmxapi/session/resources.h"
@@ -62,6 +63,7 @@ namespace gmxapi
 // Forward declaration
 class ContextImpl;   // locally defined in context.cpp
 class SignalManager; // defined in mdsignals_impl.h
+class EnsembleResources; // defined in ensembleresources.h
 
 /*!
  * \brief Implementation class for executing sessions.
@@ -109,6 +111,13 @@ public:
      */
     Status run() noexcept;
 
+    /*!
+     * \brief Get the time spent in each MD module during the last run().
+     *
+     * \return timings in the order the modules were added.
+     */
+    std::vector<ModuleTiming> moduleTimings() const { return moduleTimings_; }
+
     /*!
      * \brief Create a new implementation object and transfer ownership.
      *
@@ -177,6 +186,13 @@ public:
      */
     SignalManager* getSignalManager();
 
+    /*!
+     * \brief Get a non-owning handle to the ensemble resources of the session.
+     *
+     * \return non-owning pointer if the session is open, else nullptr.
+     */
+    EnsembleResources* getEnsembleResources();
+
     /*!
      * \brief Constructor for use by create()
      *
@@ -239,6 +255,13 @@ private:
      */
     std::unique_ptr<SignalManager> signalManager_;
 
+    /*!
+     * \brief Ensemble communication shared by the operations in this session.
+     *
+     * Pending reductions and writes are finished when the session is closed.
+     */
+    std::unique_ptr<EnsembleResources> ensembleResources_;
+
     /*!
      * \brief Restraints active in this session.
      *
@@ -250,6 +273,9 @@ private:
      * which the runner can get objects at run time can encapsulate object management.
      */
     std::map<std::string, std::weak_ptr<gmx::IRestraintPotential>> restraints_;
+
+    //! Timings of the modules in the last run(), kept after close().
+    std::vector<ModuleTiming> moduleTimings_;
 };
 
 } // end namespace gmxapi
@@ -56,6 +56,8 @@
 namespace gmxapi
 {
 
+class EnsembleResources; // defined in ensembleresources.h
+
 /*!
  * \brief Consumer-specific access to Session resources.
  *
@@ -129,6 +131,15 @@ public:
      */
     Signal getMdrunnerSignal(md::signals signal);
 
+    /*!
+     * \brief Get the ensemble communication resources of the Session.
+     *
+     * \return non-owning pointer, valid while the Session is open.
+     *
+     * \throws gmxapi::ProtocolError if the Session is no longer active.
+     */
+    EnsembleResources* ensemble();
+
 private:
     /*!
      * \brief pointer to the session owning these resources
@@ -60,8 +60,12 @@
 
 #include "gmxapi/gmxapi.h"
 #include "gmxapi/gmxapicompat.h"
+#include "gmxapi/system.h"
 #include "gmxapi/compat/mdparams.h"
 
+#include "system_impl.h"
+#include "workflow.h"
+
 using gmxapi::GmxapiType;
 
 namespace gmxapicompat
@@ -116,12 +120,34 @@ public:
         return *state_;
     }
 
+    /*!
+     * \brief Get the serialized molecular topology.
+     *
+     * The topology is serialized on first use and then shared by all in-memory
+     * simulation input produced from these contents, so that simulations that
+     * differ only in parameters do not each serialize and parse their own copy.
+     * Nothing in gmxapicompat modifies the topology after it is read.
+     *
+     * \return Shared ownership of the immutable serialized topology.
+     */
+    std::shared_ptr<const std::vector<char>> serializedTopology()
+    {
+        if (!serializedTopology_)
+        {
+            serializedTopology_ =
+                    serializeTprToMemory(irInstance_.get(), state_.get(), mtop_.get()).topology;
+        }
+        return serializedTopology_;
+    }
+
 private:
     // These types are not moveable in GROMACS 2019, so we use unique_ptr as a
     // moveable wrapper to let TprContents be moveable.
     std::unique_ptr<t_inputrec> irInstance_;
     std::unique_ptr<gmx_mtop_t> mtop_;
     std::unique_ptr<t_state>    state_;
+    //! Topology serialized for in-memory simulation input, once needed.
+    std::shared_ptr<const std::vector<char>> serializedTopology_;
 };
 
 // Note: This mapping is incomplete. Hopefully we can replace it before more mapping is necessary.
@@ -738,6 +764,20 @@ GmxMdParams::GmxMdParams(std::unique_ptr<GmxMdParamsImpl>&& impl)
     params_.swap(impl);
 };
 
+gmxapi::System fromTprContents(const TprReadHandle& handle)
+{
+    auto tprFile = handle.get();
+    if (!tprFile)
+    {
+        throw gmxapi::UsageError("Need a handle to valid TPR contents.");
+    }
+    auto tpr = std::make_shared<const InMemoryTpr>(serializeTprToMemory(
+            &tprFile->inputRecord(), &tprFile->state(), tprFile->serializedTopology()));
+    auto workflow   = gmxapi::Workflow::create(std::move(tpr));
+    auto systemImpl = std::make_unique<gmxapi::System::Impl>(std::move(workflow));
+    return gmxapi::System(std::move(systemImpl));
+}
+
 // maybe this should return a handle to the new file?
 bool copy_tprfile(const gmxapicompat::TprReadHandle& input, const std::string& outFile)
 {
@@ -751,6 +791,13 @@ bool copy_tprfile(const gmxapicompat::TprReadHandle& input, const std::string& o
     return true;
 }
 
+int64_t nstepsForEndTime(int64_t initStep, double timeStep, double initTime, double endTime)
+{
+    const double run_t = initStep * timeStep + initTime;
+
+    return lround((endTime - run_t) / timeStep);
+}
+
 bool rewrite_tprfile(const std::string& inFile, const std::string& outFile, double endTime)
 {
     auto success = false;
@@ -768,9 +815,8 @@ bool rewrite_tprfile(const std::string& inFile, const std::string& outFile, doub
     bool              bView{ false }; // argument that says we don't want to view graphs.
     output_env_init(&oenv, gmx::getProgramContext(), timeUnit, bView, XvgFormat::Xmgrace, 0);
 
-    double run_t = irInstance.init_step * irInstance.delta_t + irInstance.init_t;
-
-    irInstance.nsteps = lround((endTime - run_t) / irInstance.delta_t);
+    irInstance.nsteps =
+            nstepsForEndTime(irInstance.init_step, irInstance.delta_t, irInstance.init_t, endTime);
 
     write_tpx_state(outFile.c_str(), &irInstance, &state, &mtop);
 
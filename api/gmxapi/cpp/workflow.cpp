@@ -36,6 +36,7 @@
 #include "workflow.h"
 
 #include <memory>
+#include <utility>
 
 #include "gromacs/utility/gmxassert.h"
 
@@ -49,9 +50,16 @@ NodeSpecification::~NodeSpecification() = default;
 
 std::unique_ptr<NodeSpecification> MDNodeSpecification::clone()
 {
-    GMX_ASSERT(!tprfilename_.empty(), "Need a non-empty filename string.");
     std::unique_ptr<NodeSpecification> node = nullptr;
-    node                                    = std::make_unique<MDNodeSpecification>(tprfilename_);
+    if (tpr_)
+    {
+        node = std::make_unique<MDNodeSpecification>(tpr_);
+    }
+    else
+    {
+        GMX_ASSERT(!tprfilename_.empty(), "Need a non-empty filename string.");
+        node = std::make_unique<MDNodeSpecification>(tprfilename_);
+    }
     return node;
 }
 
@@ -60,11 +68,22 @@ MDNodeSpecification::MDNodeSpecification(const std::string& filename) : tprfilen
     GMX_ASSERT(!tprfilename_.empty(), "Need a non-empty filename string.");
 }
 
+MDNodeSpecification::MDNodeSpecification(std::shared_ptr<const InMemoryTpr> tpr) :
+    tpr_{ std::move(tpr) }
+{
+    GMX_ASSERT(tpr_, "Need valid simulation input.");
+}
+
 NodeSpecification::paramsType MDNodeSpecification::params() const noexcept
 {
     return tprfilename_;
 }
 
+std::shared_ptr<const InMemoryTpr> MDNodeSpecification::inMemoryInput() const noexcept
+{
+    return tpr_;
+}
+
 NodeKey Workflow::addNode(std::unique_ptr<NodeSpecification> spec)
 {
     // TODO capture provided NodeSpecification.
@@ -84,6 +103,16 @@ std::unique_ptr<Workflow> Workflow::create(const std::string& filename)
     return workflow;
 }
 
+std::unique_ptr<Workflow> Workflow::create(std::shared_ptr<const InMemoryTpr> tpr)
+{
+    const std::string name = "MD";
+    auto              spec = std::make_unique<MDNodeSpecification>(std::move(tpr));
+    Workflow::Impl    graph;
+    graph.emplace(std::make_pair(name, std::move(spec)));
+    auto workflow = std::make_unique<Workflow>(std::move(graph));
+    return workflow;
+}
+
 std::unique_ptr<NodeSpecification> Workflow::getNode(const NodeKey& key) const noexcept
 {
     const Impl& graph = graph_;
@@ -47,6 +47,8 @@
 #include <memory>
 #include <string>
 
+struct InMemoryTpr;
+
 namespace gmxapi
 {
 
@@ -182,6 +184,14 @@ public:
      */
     static std::unique_ptr<Workflow> create(const std::string& filename);
 
+    /*!
+     * \brief Create a new workflow from simulation input held in memory.
+     *
+     * \param tpr Serialized simulation input, of which ownership is shared.
+     * \return Ownership of a new Workflow instance.
+     */
+    static std::unique_ptr<Workflow> create(std::shared_ptr<const InMemoryTpr> tpr);
+
 private:
     /*!
      * \brief Storage structure.
@@ -76,6 +76,13 @@ public:
      */
     explicit MDNodeSpecification(const std::string& filename);
 
+    /*!
+     * \brief Simulation node from input held in memory
+     *
+     * \param tpr Serialized simulation input, of which ownership is shared.
+     */
+    explicit MDNodeSpecification(std::shared_ptr<const InMemoryTpr> tpr);
+
     /*
      * \brief Implement NodeSpecification::clone()
      *
@@ -91,9 +98,18 @@ public:
      */
     paramsType params() const noexcept override;
 
+    /*! \brief Get the simulation input held in memory.
+     *
+     * \return Shared ownership of the input, or nullptr if the input is a TPR file.
+     */
+    std::shared_ptr<const InMemoryTpr> inMemoryInput() const noexcept;
+
 private:
     //! The TPR input filename, set during construction
     paramsType tprfilename_;
+
+    //! Simulation input held in memory, used instead of a TPR file when set.
+    std::shared_ptr<const InMemoryTpr> tpr_;
 };
 
 
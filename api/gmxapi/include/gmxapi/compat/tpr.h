@@ -43,10 +43,12 @@
 #ifndef GMXAPICOMPAT_TPR_H
 #define GMXAPICOMPAT_TPR_H
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 #include "gmxapi/gmxapicompat.h"
+#include "gmxapi/system.h"
 #include "gmxapi/compat/mdparams.h"
 
 namespace gmxapicompat
@@ -125,6 +127,21 @@ public:
     std::shared_ptr<TprContents> tprFile_;
 };
 
+/*!
+ * \brief Get a simulation System directly from TPR contents, without a TPR file.
+ *
+ * The current contents of \p handle, including any parameters changed with
+ * setParam(), are handed to the simulation in memory. Systems created from the
+ * same TPR contents share the molecular topology, so only the parameters and
+ * the state are copied for each System, e.g. for each member of an ensemble.
+ *
+ * \param handle TPR contents from which to run a simulation.
+ * \return System that can be launched like one from gmxapi::fromTprFile().
+ *
+ * \throws gmxapi::UsageError if \p handle does not refer to TPR contents.
+ */
+gmxapi::System fromTprContents(const TprReadHandle& handle);
+
 /*!
  * \brief Copy TPR file.
  *
@@ -134,12 +151,26 @@ public:
  */
 bool copy_tprfile(const gmxapicompat::TprReadHandle& input, const std::string& outFile);
 
+/*!
+ * \brief Get the number of steps after which a simulation reaches \p endTime.
+ *
+ * Rounds to the nearest step, with halves away from zero, so that all
+ * clients that set `nsteps` from an end time agree with rewrite_tprfile().
+ *
+ * \param initStep `init-step` of the simulation
+ * \param timeStep `dt` of the simulation
+ * \param initTime `tinit` of the simulation
+ * \param endTime simulation time at which the simulation should end
+ * \return value for `nsteps`
+ */
+int64_t nstepsForEndTime(int64_t initStep, double timeStep, double initTime, double endTime);
+
 /*!
  * \brief Copy and possibly update TPR file by name.
  *
  * \param inFile Input file name
  * \param outFile Output file name
- * \param endTime Replace `nsteps` in infile with `endTime/dt`
+ * \param endTime Replace `nsteps` in infile with nstepsForEndTime()
  * \return true if successful, else false
  */
 bool rewrite_tprfile(const std::string& inFile, const std::string& outFile, double endTime);
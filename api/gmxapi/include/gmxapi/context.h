@@ -59,6 +59,9 @@
  * See gmxapi_mpi.h
  */
 
+#include <cstddef>
+
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -68,6 +71,8 @@ namespace gmxapi
 
 class Workflow;
 class Session;
+class ResourceAssignment;
+class EnsembleCommunicator;
 
 /*!
  * \brief Container for arguments passed to the simulation runner.
@@ -162,9 +167,70 @@ public:
      */
     void setMDArgs(const MDArgs& mdArgs);
 
+    /*!
+     * \brief Set the ensemble reduce operation for Sessions launched from this Context.
+     *
+     * \param reduce Blocking function summing a buffer of doubles over the
+     *               ensemble members, with the signature described by
+     *               gmxapi::EnsembleReduceFunction in gmxapi/session/ensemble.h.
+     *
+     * Sessions call the function from a thread of their own, so that
+     * operations can overlap ensemble reductions with the simulation.
+     * If no function is set, Sessions sum over the ensemble communicator of
+     * the Context, see joinNodeEnsemble() and setEnsembleCommunicator().
+     */
+    void setEnsembleReduce(std::function<void(const double*, double*, size_t)> reduce);
+
+    /*!
+     * \brief Join an ensemble of Contexts on the same node.
+     *
+     * The members communicate through shared memory, without an MPI library.
+     * The call is collective: it returns when all \p size members have joined.
+     * Releasing the last handle to a Context that joined an ensemble is
+     * collective as well.
+     *
+     * \param name identifies the ensemble, and must be unique on the node.
+     * \param size number of ensemble members
+     * \param rank index of this member, in [0, size)
+     *
+     * \throws UsageError for invalid arguments.
+     * \throws NotImplementedError if shared memory is not supported on this platform.
+     * \throws ProtocolError if the shared memory cannot be set up.
+     */
+    void joinNodeEnsemble(const std::string& name, int size, int rank);
+
+    /*!
+     * \brief Use an MPI communicator for communication among ensemble members.
+     *
+     * \param resources assignment of a communicator with one rank per ensemble
+     *                  member, as returned by assignResource().
+     *
+     * \throws UsageError if the communicator is not usable.
+     * \throws NotImplementedError if GROMACS was not built with an MPI library.
+     */
+    void setEnsembleCommunicator(const ResourceAssignment& resources);
+
+    /*!
+     * \brief Use a communicator provided by the client for communication among ensemble members.
+     *
+     * Allows clients that communicate through other means than the MPI
+     * library of GROMACS to provide the collectives of the ensemble.
+     *
+     * \param communicator implementation of the collectives, with one member
+     *                     per Context in the ensemble.
+     *
+     * \throws UsageError if \p communicator is null.
+     */
+    void setEnsembleCommunicator(std::shared_ptr<EnsembleCommunicator> communicator);
+
     /*!
      * \brief Launch a workflow in the current context, if possible.
      *
+     * A Context can launch any number of Sessions, one after the other, with
+     * the same MD arguments. Only the hardware detection is kept between them.
+     * Each Session starts its own thread-MPI ranks, sets thread affinities and
+     * initializes the GPU devices, and releases them again at the end of its run.
+     *
      * \param work Configured workflow to instantiate.
      * \return Ownership of a new session or nullptr if not possible.
      */
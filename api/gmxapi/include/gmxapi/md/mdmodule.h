@@ -97,6 +97,18 @@ public:
      * place this git repository is found.
      */
     virtual std::shared_ptr<::gmx::IRestraintPotential> getRestraint();
+
+    /*!
+     * \brief Number of MD steps between evaluations of the restraint.
+     *
+     * A restraint that varies slowly relative to the MD time step can be evaluated
+     * only every \c k steps. Its forces are then applied as an impulse scaled by
+     * \c k, as is done for the slow forces with multiple time-stepping. This
+     * requires the leap-frog (md) integrator.
+     *
+     * \return evaluation period in steps. The default of 1 evaluates the restraint every step.
+     */
+    virtual int restraintEvaluationPeriod() const;
 };
 
 
@@ -51,6 +51,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace gmxapi
 {
@@ -61,6 +62,29 @@ class MDModule;
 class Status;   // defined in gmxapi/status.h
 class Workflow; // implementation detail
 
+/*!
+ * \brief Time spent in the call-backs of an MD module during a Session::run().
+ *
+ * \ingroup gmxapi
+ */
+struct ModuleTiming
+{
+    //! Name of the module, see MDModule::name().
+    std::string name;
+    //! Number of force evaluation call-backs.
+    int numEvaluations = 0;
+    //! Wall time of the force evaluations in seconds.
+    double evaluationSeconds = 0;
+    //! Number of update call-backs.
+    int numUpdates = 0;
+    //! Wall time of the update call-backs in seconds, excluding ensemble reductions.
+    double updateSeconds = 0;
+    //! Number of ensemble reductions waited for in the update call-backs.
+    int numReductions = 0;
+    //! Wall time spent waiting for ensemble reductions in seconds.
+    double reductionSeconds = 0;
+};
+
 /*!
  * \brief Private implementation class for a session.
  *
@@ -162,6 +186,18 @@ public:
      */
     bool isOpen() const noexcept;
 
+    /*!
+     * \brief Get the time spent in each MD module during the last run().
+     *
+     * The same times are reported in the performance table of the log file.
+     * Modules are only timed when the simulation has cycle counting.
+     *
+     * \return timings of the modules, in the order they were added with
+     *         addSessionRestraint(), so that modules with the same name are
+     *         reported separately.
+     */
+    std::vector<ModuleTiming> moduleTimings() const;
+
     /*! \cond internal
      * \brief Get a non-owning handle to the implementation object.
      *
@@ -0,0 +1,276 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+#ifndef GMXAPI_SESSION_ENSEMBLE_H
+#define GMXAPI_SESSION_ENSEMBLE_H
+
+/*! \file
+ * \brief Ensemble communication for operations running in a Session.
+ *
+ * Ensemble reductions are split-phase: startEnsembleReduce() returns as soon
+ * as the data to reduce has been captured, and the result is only guaranteed
+ * to be available after EnsembleReduction::wait() returns. A client can thus
+ * overlap the communication with one or more MD steps.
+ *
+ * \ingroup gmxapi
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+namespace gmxapi
+{
+
+class SessionResources; // reference gmxapi/session/resources.h
+
+/*!
+ * \brief Collective communication among the members of a simulation ensemble.
+ *
+ * Each ensemble member participates through one Context. All members must
+ * call the same collectives in the same order. Buffers are typed; sums are
+ * supported for int32_t, int64_t, float and double elements, while
+ * broadcasts and gathers accept any trivially copyable element type.
+ *
+ * Implementations are provided by the library. See Context::joinNodeEnsemble()
+ * and Context::setEnsembleCommunicator().
+ *
+ * \ingroup gmxapi
+ */
+class EnsembleCommunicator
+{
+public:
+    //! Element types supported by allReduce().
+    enum class DataType
+    {
+        Int32,
+        Int64,
+        Float,
+        Double
+    };
+
+    virtual ~EnsembleCommunicator();
+
+    //! Number of ensemble members.
+    [[nodiscard]] virtual int size() const = 0;
+
+    //! Index of this member in the ensemble.
+    [[nodiscard]] virtual int rank() const = 0;
+
+    /*!
+     * \brief Sum \p count elements of \p send over the ensemble into \p recv.
+     *
+     * \p send and \p recv may be the same buffer. All members receive
+     * identical results.
+     */
+    template<typename T>
+    void allReduce(const T* send, T* recv, size_t count)
+    {
+        allReduceData(send, recv, count, dataType<T>());
+    }
+
+    //! Copy \p count elements from \p buffer on member \p root to all other members.
+    template<typename T>
+    void broadcast(T* buffer, size_t count, int root)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Can only broadcast trivially copyable data.");
+        broadcastBytes(buffer, count * sizeof(T), root);
+    }
+
+    /*!
+     * \brief Gather \p count elements from every member into \p recv on all members.
+     *
+     * \p recv holds size() * \p count elements, ordered by member rank.
+     */
+    template<typename T>
+    void allGather(const T* send, T* recv, size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Can only gather trivially copyable data.");
+        allGatherBytes(send, recv, count * sizeof(T));
+    }
+
+protected:
+    //! Sum \p count elements of type \p type over the ensemble.
+    virtual void allReduceData(const void* send, void* recv, size_t count, DataType type) = 0;
+    //! Copy \p numBytes from member \p root to all members.
+    virtual void broadcastBytes(void* buffer, size_t numBytes, int root) = 0;
+    //! Gather \p numBytes from every member into \p recv on all members.
+    virtual void allGatherBytes(const void* send, void* recv, size_t numBytes) = 0;
+
+private:
+    //! Map element types to the supported reduction types.
+    template<typename T>
+    static constexpr DataType dataType()
+    {
+        if constexpr (std::is_same_v<T, int32_t>)
+        {
+            return DataType::Int32;
+        }
+        else if constexpr (std::is_same_v<T, int64_t>)
+        {
+            return DataType::Int64;
+        }
+        else if constexpr (std::is_same_v<T, float>)
+        {
+            return DataType::Float;
+        }
+        else
+        {
+            static_assert(std::is_same_v<T, double>, "Unsupported type for ensemble reduction.");
+            return DataType::Double;
+        }
+    }
+};
+
+/*!
+ * \brief Get the ensemble communicator of the Session.
+ *
+ * Collectives issued through the communicator must not overlap with
+ * reductions started with startEnsembleReduce() that have not been completed.
+ *
+ * \param resources non-null pointer to the active Session resources.
+ * \return non-owning pointer, valid while the Session is open.
+ *
+ * \throws gmxapi::UsageError for invalid resources argument.
+ * \throws gmxapi::ProtocolError if the Session is no longer active.
+ */
+EnsembleCommunicator* getEnsembleCommunicator(SessionResources* resources);
+
+/*!
+ * \brief Blocking sum over the members of an ensemble.
+ *
+ * Called with the local contribution \p send and a \p recv buffer of the same
+ * \p size. On return, \p recv holds the element-wise sum of the contributions
+ * of all ensemble members. Reductions are issued in the same order on all
+ * members.
+ *
+ * \see Context::setEnsembleReduce()
+ */
+using EnsembleReduceFunction = std::function<void(const double* send, double* recv, size_t size)>;
+
+/*!
+ * \brief Handle to an ensemble reduction that may still be in progress.
+ *
+ * A default-constructed handle refers to no reduction and is always complete.
+ *
+ * \ingroup gmxapi
+ */
+class EnsembleReduction
+{
+public:
+    //! \internal
+    class Impl;
+
+    //! Construct a handle that does not refer to a reduction.
+    EnsembleReduction();
+
+    /*!
+     * \brief Construct from shared ownership of a pending reduction.
+     *
+     * \param impl state of a reduction started by startEnsembleReduce()
+     */
+    explicit EnsembleReduction(std::shared_ptr<Impl> impl);
+
+    /*!
+     * \brief Check, without blocking, whether the reduction has finished.
+     *
+     * \return true if the result is available and wait() would not block.
+     */
+    [[nodiscard]] bool isComplete() const;
+
+    /*!
+     * \brief Complete the reduction.
+     *
+     * Blocks until the reduced data has been written to the receive buffer.
+     * May be called more than once.
+     *
+     * \throws gmxapi::ProtocolError if the reduction could not be performed.
+     */
+    void wait();
+
+private:
+    //! Shared state of the reduction, or nullptr if there is none.
+    std::shared_ptr<Impl> impl_;
+};
+
+/*!
+ * \brief Start a reduction of \p send over the ensemble into \p recv.
+ *
+ * The contents of \p send are copied before the function returns, so the
+ * caller may reuse the send buffer immediately. \p recv must remain valid and
+ * must not be accessed until the returned reduction has been completed with
+ * EnsembleReduction::wait().
+ *
+ * Reductions started through the same Session are performed in the order in
+ * which they were started, so all ensemble members must start matching
+ * reductions in the same order.
+ *
+ * \param resources non-null pointer to the active Session resources.
+ * \param send local contribution
+ * \param recv buffer to receive the ensemble sum
+ * \param size number of elements in \p send and \p recv
+ * \return handle with which to complete the reduction.
+ *
+ * \throws gmxapi::UsageError for invalid resources argument.
+ * \throws gmxapi::ProtocolError if the Session is no longer active.
+ */
+EnsembleReduction startEnsembleReduce(SessionResources* resources, const double* send, double* recv, size_t size);
+
+/*!
+ * \brief Persist ensemble data without blocking the caller.
+ *
+ * \p data is copied and written by a background thread to a file named
+ * after the calling operation and \p tag, with a part number that increases
+ * with each call for the same tag. Files are written in the working
+ * directory of the Session, and all pending writes are finished when the
+ * Session is closed.
+ *
+ * \param resources non-null pointer to the active Session resources.
+ * \param tag label distinguishing the data sets of an operation.
+ * \param data values to write
+ * \param size number of elements in \p data
+ *
+ * \throws gmxapi::UsageError for invalid resources argument.
+ * \throws gmxapi::ProtocolError if the Session is no longer active.
+ */
+void persistEnsembleData(SessionResources* resources, const std::string& tag, const double* data, size_t size);
+
+} // end namespace gmxapi
+
+#endif // GMXAPI_SESSION_ENSEMBLE_H
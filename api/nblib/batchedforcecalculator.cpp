@@ -0,0 +1,154 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief Implements nblib BatchedForceCalculator
+ */
+#include "nblib/batchedforcecalculator.h"
+
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/utility/classhelpers.h"
+#include "gromacs/utility/exceptions.h"
+#include "nblib/exception.h"
+#include "nblib/gmxcalculator.h"
+#include "nblib/gmxsetup.h"
+
+namespace nblib
+{
+
+BatchedForceCalculator::BatchedForceCalculator(const SimulationState& system,
+                                               const NBKernelOptions& options,
+                                               const int              numReplicas) :
+    numParticles_(system.topology().numParticles()),
+    numThreads_(options.numOpenMPThreads),
+    replicaCalculators_(GmxSetupDirector::setupGmxForceCalculators(system, options, numReplicas))
+{
+}
+
+BatchedForceCalculator::~BatchedForceCalculator() = default;
+
+namespace
+{
+
+/*! \internal \brief Sets the thread count of the nbnxm modules to the single thread each replica was set up with
+ *
+ * The setting is global, so it is set for each call, in case other calculators changed it,
+ * and the previous thread counts are restored when the object goes out of scope.
+ */
+class SingleThreadPerReplicaScope
+{
+public:
+    SingleThreadPerReplicaScope() :
+        numPairsearchThreads_(gmx_omp_nthreads_get(emntPairsearch)),
+        numNonbondedThreads_(gmx_omp_nthreads_get(emntNonbonded))
+    {
+        gmx_omp_nthreads_set(emntPairsearch, 1);
+        gmx_omp_nthreads_set(emntNonbonded, 1);
+    }
+
+    ~SingleThreadPerReplicaScope()
+    {
+        gmx_omp_nthreads_set(emntPairsearch, numPairsearchThreads_);
+        gmx_omp_nthreads_set(emntNonbonded, numNonbondedThreads_);
+    }
+
+    GMX_DISALLOW_COPY_AND_ASSIGN(SingleThreadPerReplicaScope);
+
+private:
+    //! The pair search thread count to restore
+    const int numPairsearchThreads_;
+    //! The nonbonded thread count to restore
+    const int numNonbondedThreads_;
+};
+
+} // namespace
+
+int BatchedForceCalculator::numReplicas() const
+{
+    return replicaCalculators_.size();
+}
+
+void BatchedForceCalculator::checkBuffers(gmx::ArrayRef<const std::vector<Vec3>> buffers) const
+{
+    if (buffers.ssize() != numReplicas())
+    {
+        throw InputException("Need one coordinate or force buffer per replica");
+    }
+    for (const std::vector<Vec3>& buffer : buffers)
+    {
+        if (buffer.size() != numParticles_)
+        {
+            throw InputException("Need one coordinate or force per particle in each replica");
+        }
+    }
+}
+
+void BatchedForceCalculator::compute(gmx::ArrayRef<const std::vector<Vec3>> coordinates,
+                                     gmx::ArrayRef<std::vector<Vec3>>       forces)
+{
+    // Check before the threaded loop, exceptions can not be propagated out of it
+    checkBuffers(coordinates);
+    checkBuffers(forces);
+    const SingleThreadPerReplicaScope singleThreadPerReplica;
+
+    const int numReplicas = this->numReplicas();
+#pragma omp parallel for schedule(dynamic) num_threads(numThreads_)
+    for (int replica = 0; replica < numReplicas; replica++)
+    {
+        try
+        {
+            replicaCalculators_[replica]->compute(coordinates[replica], forces[replica]);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+}
+
+void BatchedForceCalculator::updatePairLists(gmx::ArrayRef<const std::vector<Vec3>> coordinates)
+{
+    checkBuffers(coordinates);
+    const SingleThreadPerReplicaScope singleThreadPerReplica;
+
+    const int numReplicas = this->numReplicas();
+#pragma omp parallel for schedule(dynamic) num_threads(numThreads_)
+    for (int replica = 0; replica < numReplicas; replica++)
+    {
+        try
+        {
+            replicaCalculators_[replica]->rebuildPairList(coordinates[replica]);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+}
+
+} // namespace nblib
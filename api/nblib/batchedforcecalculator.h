@@ -0,0 +1,121 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \inpublicapi \file
+ * \brief
+ * Implements nblib BatchedForceCalculator
+ *
+ * Computes the nonbonded forces of many replicas of the same system,
+ * for instance different conformers or walkers, with a single setup.
+ */
+#ifndef NBLIB_BATCHEDFORCECALCULATOR_H
+#define NBLIB_BATCHEDFORCECALCULATOR_H
+
+#include <memory>
+#include <vector>
+
+#include "nblib/kerneloptions.h"
+#include "nblib/simulationstate.h"
+
+namespace gmx
+{
+template<typename T>
+class ArrayRef;
+} // namespace gmx
+
+namespace nblib
+{
+class GmxForceCalculator;
+
+/*! \brief Sets up and computes nonbonded forces for many replicas of a system using the gromacs backend.
+ *
+ * All replicas have the topology and the box of the SimulationState, but each has its own
+ * coordinates. The costly translation of the SimulationState and NBKernelOptions to gromacs
+ * data structures, including the interaction constants and the Lennard-Jones parameter table,
+ * is done once and shared by all replicas. Each replica has its own grid, pairlist and
+ * particle data, as well as a copy of the Lennard-Jones parameters in the layout used by the
+ * nonbonded kernels, which is small compared to the particle data.
+ *
+ * The replicas are distributed over NBKernelOptions::numOpenMPThreads threads, each replica
+ * being computed by a single thread. This scales better than threading the computation of a
+ * single replica when the number of replicas is large compared to the number of threads.
+ *
+ * At construction, the pairlists of all replicas are built for the coordinates of the
+ * SimulationState. Replicas with other coordinates need updatePairLists to be called with
+ * their coordinates, unless NBKernelOptions::useAutomaticPairlistUpdate is set.
+ */
+class BatchedForceCalculator final
+{
+public:
+    BatchedForceCalculator(const SimulationState& system, const NBKernelOptions& options, int numReplicas);
+
+    ~BatchedForceCalculator();
+
+    //! Returns the number of replicas
+    int numReplicas() const;
+
+    /*! \brief Dispatch the nonbonded force kernels for all replicas and reduce the forces
+     *
+     * The forces of each replica are zeroed before they are computed, so forces can be
+     * regarded as an output only param.
+     *
+     * \param[in] coordinates of each replica to be used for the force calculation
+     * \param[out] forces buffers to store the output forces of each replica
+     */
+    void compute(gmx::ArrayRef<const std::vector<Vec3>> coordinates,
+                 gmx::ArrayRef<std::vector<Vec3>>       forces);
+
+    /*! \brief Puts the particles of each replica on its grid and rebuilds its pairlist
+     *
+     * \param[in] coordinates of each replica, in the box of the SimulationState
+     */
+    void updatePairLists(gmx::ArrayRef<const std::vector<Vec3>> coordinates);
+
+private:
+    //! Throws when the number of replicas or of particles in \p buffers is not as expected
+    void checkBuffers(gmx::ArrayRef<const std::vector<Vec3>> buffers) const;
+
+    //! The number of particles in each replica
+    size_t numParticles_;
+
+    //! The number of threads to distribute the replicas over
+    int numThreads_;
+
+    //! GROMACS force calculators for each replica, sharing the interaction setup
+    std::vector<std::unique_ptr<GmxForceCalculator>> replicaCalculators_;
+};
+
+} // namespace nblib
+
+#endif // NBLIB_BATCHEDFORCECALCULATOR_H
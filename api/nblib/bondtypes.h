@@ -0,0 +1,225 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \inpublicapi \file
+ * \brief
+ * Declares the listed (bonded) interaction types of nblib
+ *
+ * Listed interactions act on explicitly listed particles, e.g. bonds,
+ * angles and dihedrals, and are computed by the ListedForceCalculator.
+ */
+#ifndef NBLIB_BONDTYPES_H
+#define NBLIB_BONDTYPES_H
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "nblib/basicdefinitions.h"
+#include "nblib/util/user.h"
+
+namespace nblib
+{
+
+//! Named type for the force constant of a listed interaction
+using ForceConstant = StrongType<real, struct ForceConstantParameter>;
+//! Named type for the equilibrium distance of a bond
+using EquilibriumDistance = StrongType<real, struct EquilibriumDistanceParameter>;
+//! Named type for an angle in degrees
+using Degrees = StrongType<real, struct DegreesParameter>;
+//! Named type for the multiplicity of a dihedral
+using Multiplicity = StrongType<int, struct MultiplicityParameter>;
+
+/*! \brief Harmonic bond between two particles
+ *
+ * V(r) = 1/2 k (r - r0)^2
+ */
+class HarmonicBondType final
+{
+public:
+    //! The number of particles of one interaction
+    static constexpr int numParticles = 2;
+
+    //! Constructor with the force constant in kJ/(mol nm^2) and the equilibrium distance in nm
+    HarmonicBondType(ForceConstant forceConstant, EquilibriumDistance equilibriumDistance) :
+        forceConstant_(forceConstant),
+        equilibriumDistance_(equilibriumDistance)
+    {
+    }
+
+    //! Get the force constant
+    [[nodiscard]] ForceConstant forceConstant() const { return forceConstant_; }
+
+    //! Get the equilibrium distance
+    [[nodiscard]] EquilibriumDistance equilibriumDistance() const { return equilibriumDistance_; }
+
+private:
+    //! The force constant
+    ForceConstant forceConstant_;
+    //! The equilibrium distance
+    EquilibriumDistance equilibriumDistance_;
+};
+
+//! Returns whether the bond types have identical parameters
+inline bool operator==(const HarmonicBondType& a, const HarmonicBondType& b)
+{
+    return a.forceConstant() == b.forceConstant() && a.equilibriumDistance() == b.equilibriumDistance();
+}
+
+/*! \brief Harmonic angle between three particles, with the second particle at the apex
+ *
+ * V(theta) = 1/2 k (theta - theta0)^2
+ */
+class HarmonicAngleType final
+{
+public:
+    //! The number of particles of one interaction
+    static constexpr int numParticles = 3;
+
+    //! Constructor with the force constant in kJ/(mol rad^2) and the equilibrium angle
+    HarmonicAngleType(ForceConstant forceConstant, Degrees equilibriumAngle) :
+        forceConstant_(forceConstant),
+        equilibriumAngle_(equilibriumAngle)
+    {
+    }
+
+    //! Get the force constant
+    [[nodiscard]] ForceConstant forceConstant() const { return forceConstant_; }
+
+    //! Get the equilibrium angle
+    [[nodiscard]] Degrees equilibriumAngle() const { return equilibriumAngle_; }
+
+private:
+    //! The force constant
+    ForceConstant forceConstant_;
+    //! The equilibrium angle
+    Degrees equilibriumAngle_;
+};
+
+//! Returns whether the angle types have identical parameters
+inline bool operator==(const HarmonicAngleType& a, const HarmonicAngleType& b)
+{
+    return a.forceConstant() == b.forceConstant() && a.equilibriumAngle() == b.equilibriumAngle();
+}
+
+/*! \brief Proper dihedral between four particles
+ *
+ * V(phi) = k (1 + cos(n phi - phi0))
+ */
+class ProperDihedralType final
+{
+public:
+    //! The number of particles of one interaction
+    static constexpr int numParticles = 4;
+
+    //! Constructor with the phase angle, the force constant in kJ/mol and the multiplicity
+    ProperDihedralType(Degrees phase, ForceConstant forceConstant, Multiplicity multiplicity) :
+        phase_(phase),
+        forceConstant_(forceConstant),
+        multiplicity_(multiplicity)
+    {
+    }
+
+    //! Get the phase angle
+    [[nodiscard]] Degrees phase() const { return phase_; }
+
+    //! Get the force constant
+    [[nodiscard]] ForceConstant forceConstant() const { return forceConstant_; }
+
+    //! Get the multiplicity
+    [[nodiscard]] Multiplicity multiplicity() const { return multiplicity_; }
+
+private:
+    //! The phase angle
+    Degrees phase_;
+    //! The force constant
+    ForceConstant forceConstant_;
+    //! The multiplicity
+    Multiplicity multiplicity_;
+};
+
+//! Returns whether the dihedral types have identical parameters
+inline bool operator==(const ProperDihedralType& a, const ProperDihedralType& b)
+{
+    return a.phase() == b.phase() && a.forceConstant() == b.forceConstant()
+           && a.multiplicity() == b.multiplicity();
+}
+
+/*! \brief All interactions of one listed interaction type
+ *
+ * Interactions with identical parameters share an entry in \p parameters.
+ */
+template<class InteractionType>
+struct ListedInteractionList
+{
+    //! The particle indices of one interaction
+    using ParticleIndices = std::array<int, InteractionType::numParticles>;
+
+    //! Adds an interaction between the particles with indices \p particles
+    void add(const ParticleIndices& particles, const InteractionType& interaction)
+    {
+        const int parameterIndex =
+                std::find(parameters.begin(), parameters.end(), interaction) - parameters.begin();
+        if (parameterIndex == int(parameters.size()))
+        {
+            parameters.push_back(interaction);
+        }
+        particleIndices.push_back(particles);
+        parameterIndices.push_back(parameterIndex);
+    }
+
+    //! The number of interactions
+    [[nodiscard]] size_t size() const { return particleIndices.size(); }
+
+    //! The distinct parameter sets
+    std::vector<InteractionType> parameters;
+    //! The particle indices of each interaction
+    std::vector<ParticleIndices> particleIndices;
+    //! The index in \p parameters of each interaction
+    std::vector<int> parameterIndices;
+};
+
+//! The listed interactions of a molecule or of a topology, by interaction type
+struct ListedInteractionData
+{
+    //! Harmonic bonds
+    ListedInteractionList<HarmonicBondType> harmonicBonds;
+    //! Harmonic angles
+    ListedInteractionList<HarmonicAngleType> harmonicAngles;
+    //! Proper dihedrals
+    ListedInteractionList<ProperDihedralType> properDihedrals;
+};
+
+} // namespace nblib
+#endif // NBLIB_BONDTYPES_H
@@ -43,6 +43,7 @@
  */
 #include <cmath>
 
+#include "gromacs/pbcutil/pbc.h"
 #include "nblib/box.h"
 #include "nblib/exception.h"
 
@@ -63,4 +64,24 @@ Box::Box(real x, real y, real z) : legacyMatrix_{ 0 }
     legacyMatrix_[dimZ][dimZ] = z;
 }
 
+Box::Box(real x, real y, real z, real alpha, real beta, real gamma) : legacyMatrix_{ 0 }
+{
+    for (real value : { x, y, z, alpha, beta, gamma })
+    {
+        if (std::isnan(value) || std::isinf(value))
+        {
+            throw InputException("Cannot have NaN or Inf box length or angle.");
+        }
+    }
+
+    const rvec lengths = { x, y, z };
+    const rvec angles  = { alpha, beta, gamma };
+    matrix_convert(legacyMatrix_, lengths, angles);
+
+    if (const char* boxError = check_box(PbcType::Xyz, legacyMatrix_))
+    {
+        throw InputException(boxError);
+    }
+}
+
 } // namespace nblib
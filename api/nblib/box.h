@@ -54,7 +54,10 @@ namespace nblib
  * \inpublicapi
  * \ingroup nblib
  *
- * Currently only cubic and rectangular boxes are supported.
+ * Cubic, rectangular and triclinic boxes are supported. Triclinic boxes
+ * must satisfy the same restrictions as in GROMACS, i.e. the box matrix is
+ * lower triangular and the off-diagonal elements are at most half of the
+ * diagonal element of the same column.
  *
  */
 class Box final
@@ -68,6 +71,18 @@ public:
     //! Construct a rectangular box.
     Box(real x, real y, real z);
 
+    /*! \brief Construct a triclinic box.
+     *
+     * \param x, y, z Lengths of the three box vectors
+     * \param alpha Angle between the second and third box vector in degrees
+     * \param beta Angle between the first and third box vector in degrees
+     * \param gamma Angle between the first and second box vector in degrees
+     *
+     * E.g. Box(d, d, d, 60, 60, 90) is a rhombic dodecahedron (xy-square)
+     * with image distance d.
+     */
+    Box(real x, real y, real z, real alpha, real beta, real gamma);
+
     //! Return the full matrix that specifies the box. Used for gromacs setup code.
     [[nodiscard]] LegacyMatrix const& legacyMatrix() const { return legacyMatrix_; }
 
@@ -41,6 +41,7 @@
  * \author Sebastian Keller <keller@cscs.ch>
  */
 #include "nblib/forcecalculator.h"
+#include "gromacs/utility/arrayref.h"
 #include "nblib/gmxcalculator.h"
 #include "nblib/gmxsetup.h"
 
@@ -59,11 +60,39 @@ void ForceCalculator::compute(gmx::ArrayRef<const Vec3> coordinates, gmx::ArrayR
     return gmxForceCalculator_->compute(coordinates, forces);
 }
 
+NonBondedEnergiesAndVirial ForceCalculator::computeEnergiesAndVirial(gmx::ArrayRef<const Vec3> coordinates,
+                                                                     gmx::ArrayRef<Vec3>       forces)
+{
+    NonBondedEnergiesAndVirial energiesAndVirial;
+    gmxForceCalculator_->compute(coordinates, forces, &energiesAndVirial);
+    return energiesAndVirial;
+}
+
+void ForceCalculator::computeInGridOrder(gmx::ArrayRef<const Vec3> coordinates, gmx::ArrayRef<Vec3> forces)
+{
+    gmxForceCalculator_->computeInGridOrder(coordinates, forces);
+}
+
+gmx::ArrayRef<const int> ForceCalculator::gridOrder() const
+{
+    return gmxForceCalculator_->gridOrder();
+}
+
+int64_t ForceCalculator::numPairlistRebuilds() const
+{
+    return gmxForceCalculator_->numPairlistRebuilds();
+}
+
+int64_t ForceCalculator::numPairlistPrunes() const
+{
+    return gmxForceCalculator_->numPairlistPrunes();
+}
+
 void ForceCalculator::updatePairList(gmx::ArrayRef<const int> particleInfoAllVdW,
                                      gmx::ArrayRef<Vec3>      coordinates,
                                      const Box&               box)
 {
-    gmxForceCalculator_->setParticlesOnGrid(particleInfoAllVdW, coordinates, box);
+    gmxForceCalculator_->updatePairList(particleInfoAllVdW, coordinates, box);
 }
 
 } // namespace nblib
@@ -44,6 +44,8 @@
 #ifndef NBLIB_FORCECALCULATOR_H
 #define NBLIB_FORCECALCULATOR_H
 
+#include <cstdint>
+
 #include "nblib/interactions.h"
 #include "nblib/kerneloptions.h"
 #include "nblib/simulationstate.h"
@@ -59,6 +61,24 @@ namespace nblib
 class NbvSetupUtil;
 class GmxForceCalculator;
 
+/*! \brief The energies and the virial of the nonbonded interactions
+ *
+ * The virial is -0.5 times the sum over the particles of the outer product of the coordinates
+ * and the forces, where interactions over periodic boundaries are accounted for with the shift
+ * forces, as in GROMACS. As in mdrun, the Coulomb energy includes the self and exclusion
+ * corrections of reaction-field and Ewald computed by the nonbonded kernels. With PME, the
+ * Coulomb energy and virial only include the real-space part.
+ */
+struct NonBondedEnergiesAndVirial final
+{
+    //! The Lennard-Jones energy
+    real ljEnergy = 0;
+    //! The Coulomb energy
+    real coulombEnergy = 0;
+    //! The virial tensor
+    matrix virial = { { 0 } };
+};
+
 /*! \brief Setups up and computes forces using gromacs backend.
  *
  * The ForceCalculator uses the data in the SimulationState and NBKernelOptions to opaquely
@@ -71,6 +91,18 @@ class GmxForceCalculator;
  * sufficiently far from their positions at construction time, the efficiency of the calculation
  * will suffer. To alleviate this, the user can call updatePairList.
  *
+ * With NBKernelOptions::useAutomaticPairlistUpdate, the pairlist is built with a buffer and
+ * compute tracks how far particles moved since then. The pairlist is only rebuilt when the
+ * displacement could bring a pair missing from the list within the cut-off, and, with
+ * dynamic pruning, the list is pruned to a smaller buffer when needed. The forces are then
+ * those of a pairlist rebuilt every step, without the cost of doing so.
+ *
+ * With CoulombType::Pme, only the real-space part of the electrostatics is computed, unless
+ * NBKernelOptions::usePmeMesh is set. The reciprocal-space part is then computed on the CPU
+ * with the PME module of GROMACS, threaded as in mdrun. The PME grid is set up for the box
+ * at construction and reused for all calls to compute. As in mdrun, the system should be
+ * neutral and excluded pairs should be within the cut-off.
+ *
  */
 class ForceCalculator final
 {
@@ -89,11 +121,55 @@ public:
      */
     void compute(gmx::ArrayRef<const Vec3> coordinates, gmx::ArrayRef<Vec3> forces);
 
+    /*! \brief Dispatch the nonbonded force kernels, reduce the forces and compute the energies and the virial
+     *
+     * Computes the same forces as compute, and in addition the energies and the virial,
+     * independently of NBKernelOptions::computeVirialAndEnergy. This is more expensive
+     * than only computing the forces, so it is best used only on steps where the energies
+     * or the pressure are needed.
+     *
+     * \param[in] coordinates to be used for the force calculation
+     * \param[out] forces buffer to store the output forces
+     * \returns the energies and the virial of the nonbonded interactions
+     */
+    NonBondedEnergiesAndVirial computeEnergiesAndVirial(gmx::ArrayRef<const Vec3> coordinates,
+                                                        gmx::ArrayRef<Vec3>       forces);
+
+    /*! \brief Dispatch the nonbonded force kernels with coordinates and forces in grid order
+     *
+     * The nonbonded kernels work on the particles in the order of the search grid. compute
+     * reorders the coordinates to this order and the forces back, and has to clear the force
+     * buffer first. Here the caller provides the coordinates in grid order and gets the forces
+     * in grid order, which avoids both reorderings. gridOrder() returns the particle index for
+     * each grid position. Grid positions that do not hold a particle are padding, their
+     * coordinates are not used and their forces are set to zero.
+     *
+     * The grid order changes when updatePairList is called, so this can not be used with
+     * NBKernelOptions::useAutomaticPairlistUpdate. The PME mesh part is not supported.
+     *
+     * \param[in] coordinates in grid order, one per grid position
+     * \param[out] forces buffer to store the output forces in grid order, one per grid position
+     */
+    void computeInGridOrder(gmx::ArrayRef<const Vec3> coordinates, gmx::ArrayRef<Vec3> forces);
+
+    //! Returns the particle index for each grid position, -1 for positions that hold no particle
+    gmx::ArrayRef<const int> gridOrder() const;
+
+    /*! \brief Returns how often the pairlist was rebuilt since the calculator was constructed
+     *
+     * This counts the calls to updatePairList and the automatic pairlist updates.
+     */
+    int64_t numPairlistRebuilds() const;
+
+    //! Returns how often the pairlist was pruned to the inner buffer with dynamic pruning
+    int64_t numPairlistPrunes() const;
+
     /*! \brief Puts particles on a grid based on bounds specified by the box
      *
      * As compute is called repeatedly, the particles drift apart and the force computation becomes
      * progressively less efficient. Calling this function recomputes the particle-particle pair
-     * lists so that computation can proceed efficiently. Should be called around every 100 steps.
+     * lists so that computation can proceed efficiently. Should be called around every 100 steps,
+     * unless automatic pairlist updates are used.
      *
      * \param particleInfoAllVdW The types of the particles to be placed on grids
      * \param coordinates The coordinates to be placed on grids
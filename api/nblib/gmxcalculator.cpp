@@ -41,16 +41,29 @@
  * \author Sebastian Keller <keller@cscs.ch>
  */
 #include "nblib/gmxcalculator.h"
+
+#include <algorithm>
+#include <string>
+
 #include "gromacs/ewald/ewald_utils.h"
+#include "gromacs/ewald/pme.h"
 #include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/calcvir.h"
 #include "gromacs/mdlib/rf_util.h"
 #include "gromacs/mdtypes/enerdata.h"
 #include "gromacs/mdtypes/forcerec.h"
 #include "gromacs/mdtypes/interaction_const.h"
 #include "gromacs/mdtypes/simulation_workload.h"
+#include "gromacs/nbnxm/atomdata.h"
 #include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/nbnxm/pairlistsets.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/pbcutil/pbc.h"
 #include "gromacs/utility/range.h"
 #include "nblib/exception.h"
+#include "nblib/forcecalculator.h"
 #include "nblib/simulationstate.h"
 
 namespace nblib
@@ -59,39 +72,222 @@ namespace nblib
 GmxForceCalculator::GmxForceCalculator()
 {
     enerd_            = std::make_unique<gmx_enerdata_t>(1, 0);
-    forcerec_         = std::make_unique<t_forcerec>();
-    interactionConst_ = std::make_unique<interaction_const_t>();
-    stepWork_         = std::make_unique<gmx::StepWorkload>();
+    forcerec_         = std::make_shared<t_forcerec>();
+    interactionConst_ = std::make_shared<interaction_const_t>();
+    stepWork_         = std::make_shared<gmx::StepWorkload>();
     nrnb_             = std::make_unique<t_nrnb>();
+    commrec_          = gmx_pme_make_single_rank_commrec();
 }
 
 GmxForceCalculator::~GmxForceCalculator() = default;
 
+void GmxForceCalculator::PmeDeleter::operator()(gmx_pme_t* pme) const
+{
+    gmx_pme_destroy(pme);
+}
+
+//! Returns the largest squared distance any particle moved from \p reference to \p coordinates
+static real maxDisplacementSquared(gmx::ArrayRef<const gmx::RVec> reference,
+                                   gmx::ArrayRef<const gmx::RVec> coordinates)
+{
+    if (reference.size() != coordinates.size())
+    {
+        throw InputException("The number of coordinates changed since the pairlist was built");
+    }
+
+    real maxDisplacement2 = 0;
+    for (size_t i = 0; i < coordinates.size(); i++)
+    {
+        maxDisplacement2 = std::max(maxDisplacement2, gmx::norm2(coordinates[i] - reference[i]));
+    }
+
+    return maxDisplacement2;
+}
+
+/*! \brief Returns whether the pairlist built with \p buffer may miss pairs within the cut-off
+ *
+ * Two particles that each moved less than half the buffer can not have come closer
+ * than the cut-off without having been within the pairlist radius at search time.
+ * A particle wrapped into the box over a periodic boundary appears to move a box length,
+ * which triggers a rebuild, as required since the shift of its pairs changes.
+ */
+static bool displacementExceedsBuffer(gmx::ArrayRef<const gmx::RVec> reference,
+                                      gmx::ArrayRef<const gmx::RVec> coordinates,
+                                      const real                     buffer)
+{
+    return 4 * maxDisplacementSquared(reference, coordinates) >= gmx::square(buffer);
+}
+
 void GmxForceCalculator::compute(gmx::ArrayRef<const gmx::RVec> coordinateInput,
                                  gmx::ArrayRef<gmx::RVec>       forceOutput)
 {
+    computeForces(coordinateInput, forceOutput, *stepWork_);
+
+    real   meshEnergy = 0;
+    matrix meshVirial = { { 0 } };
+    addPmeMeshForces(coordinateInput, forceOutput, *stepWork_, &meshEnergy, meshVirial);
+}
+
+void GmxForceCalculator::compute(gmx::ArrayRef<const gmx::RVec> coordinateInput,
+                                 gmx::ArrayRef<gmx::RVec>       forceOutput,
+                                 NonBondedEnergiesAndVirial*    energiesAndVirial)
+{
+    // The step workload can be shared, so the energy and virial tasks are set on a copy
+    gmx::StepWorkload stepWork = *stepWork_;
+    stepWork.computeEnergy     = true;
+    stepWork.computeVirial     = true;
+
+    // The kernels add their energies to the group energies
+    std::fill(enerd_->grpp.ener[egLJSR].begin(), enerd_->grpp.ener[egLJSR].end(), 0);
+    std::fill(enerd_->grpp.ener[egCOULSR].begin(), enerd_->grpp.ener[egCOULSR].end(), 0);
+
+    computeForces(coordinateInput, forceOutput, stepWork);
+
+    energiesAndVirial->ljEnergy      = enerd_->grpp.ener[egLJSR][0];
+    energiesAndVirial->coulombEnergy = enerd_->grpp.ener[egCOULSR][0];
+
+    // The virial of pairs over periodic boundaries is accounted for by the shift forces,
+    // as in mdrun: -0.5 sum_i x_i f_i - 0.5 sum_s shift_s fshift_s
+    std::vector<gmx::RVec> shiftForces(SHIFTS, gmx::RVec{ 0, 0, 0 });
+    nbnxn_atomdata_add_nbat_fshift_to_fshift(*nbv_->nbat, shiftForces);
+
+    clear_mat(energiesAndVirial->virial);
+    calc_vir(SHIFTS, forcerec_->shift_vec, as_rvec_array(shiftForces.data()),
+             energiesAndVirial->virial, false, box_);
+    calc_vir(coordinateInput.ssize(), as_rvec_array(coordinateInput.data()),
+             as_rvec_array(forceOutput.data()), energiesAndVirial->virial, false, box_);
+
+    // The mesh computes its own virial, so its forces are added after the virial above
+    real   meshEnergy = 0;
+    matrix meshVirial = { { 0 } };
+    addPmeMeshForces(coordinateInput, forceOutput, stepWork, &meshEnergy, meshVirial);
+    energiesAndVirial->coulombEnergy += meshEnergy;
+    m_add(energiesAndVirial->virial, meshVirial, energiesAndVirial->virial);
+}
+
+void GmxForceCalculator::computeForces(gmx::ArrayRef<const gmx::RVec> coordinateInput,
+                                       gmx::ArrayRef<gmx::RVec>       forceOutput,
+                                       const gmx::StepWorkload&       stepWork)
+{
+    if (useAutomaticPairlistUpdate_
+        && displacementExceedsBuffer(pairlistCoordinates_, coordinateInput,
+                                     nbv_->pairlistOuterRadius() - interactionCutoff()))
+    {
+        rebuildPairList(coordinateInput);
+    }
+
     // update the coordinates in the backend
     nbv_->convertCoordinates(gmx::AtomLocality::Local, false, coordinateInput);
 
+    prunePairListIfNeeded(coordinateInput);
+
     // set forces to zero
     std::fill(forceOutput.begin(), forceOutput.end(), gmx::RVec{ 0, 0, 0 });
 
-    nbv_->dispatchNonbondedKernel(gmx::InteractionLocality::Local, *interactionConst_, *stepWork_,
+    nbv_->dispatchNonbondedKernel(gmx::InteractionLocality::Local, *interactionConst_, stepWork,
                                   enbvClearFYes, *forcerec_, enerd_.get(), nrnb_.get());
 
     nbv_->atomdata_add_nbat_f_to_f(gmx::AtomLocality::All, forceOutput);
 }
 
+void GmxForceCalculator::computeInGridOrder(gmx::ArrayRef<const gmx::RVec> gridCoordinates,
+                                            gmx::ArrayRef<gmx::RVec>       gridForces)
+{
+    if (useAutomaticPairlistUpdate_)
+    {
+        throw InputException(
+                "Forces in grid order can not be computed with automatic pairlist updates");
+    }
+    if (pme_)
+    {
+        throw InputException("Forces in grid order can not be computed with the PME mesh");
+    }
+    const size_t numGridPositions = gridOrder().size();
+    if (gridCoordinates.size() != numGridPositions || gridForces.size() != numGridPositions)
+    {
+        throw InputException("Coordinates and forces in grid order need one entry per grid position");
+    }
+
+    // Dynamic pruning is only used with automatic pairlist updates, which are excluded above,
+    // so the kernels use the list as it was built
+    nbv_->convertGridOrderedCoordinates(gridCoordinates);
+
+    nbv_->dispatchNonbondedKernel(gmx::InteractionLocality::Local, *interactionConst_, *stepWork_,
+                                  enbvClearFYes, *forcerec_, enerd_.get(), nrnb_.get());
+
+    nbv_->getGridOrderedForces(gridForces);
+}
+
+gmx::ArrayRef<const int> GmxForceCalculator::gridOrder() const
+{
+    return nbv_->getLocalAtomOrder();
+}
+
+void GmxForceCalculator::prunePairListIfNeeded(gmx::ArrayRef<const gmx::RVec> coordinates)
+{
+    // With dynamic pruning the kernels use the inner list, pruned from the outer list
+    if (nbv_->pairlistSets().params().useDynamicPruning
+        && (prunedCoordinates_.empty()
+            || displacementExceedsBuffer(prunedCoordinates_, coordinates,
+                                         nbv_->pairlistInnerRadius() - interactionCutoff())))
+    {
+        nbv_->dispatchPruneKernelCpu(gmx::InteractionLocality::Local, forcerec_->shift_vec);
+        prunedCoordinates_.assign(coordinates.begin(), coordinates.end());
+        numPairlistPrunes_++;
+    }
+}
+
+void GmxForceCalculator::addPmeMeshForces(gmx::ArrayRef<const gmx::RVec> coordinateInput,
+                                          gmx::ArrayRef<gmx::RVec>       forceOutput,
+                                          const gmx::StepWorkload&       stepWork,
+                                          real*                          energy,
+                                          matrix                         virial)
+{
+    if (!pme_)
+    {
+        return;
+    }
+
+    real   energyLJ    = 0;
+    matrix virialLJ    = { { 0 } };
+    real   dvdlambdaQ  = 0;
+    real   dvdlambdaLJ = 0;
+
+    const int status = gmx_pme_do(pme_.get(), coordinateInput, forceOutput, charges_.data(), nullptr,
+                                  nullptr, nullptr, nullptr, nullptr, box_, commrec_.get(), 0, 0,
+                                  nrnb_.get(), nullptr, virial, virialLJ, energy, &energyLJ, 0, 0,
+                                  &dvdlambdaQ, &dvdlambdaLJ, stepWork);
+    if (status != 0)
+    {
+        throw InputException("Error " + std::to_string(status) + " in the PME mesh computation");
+    }
+}
+
+real GmxForceCalculator::interactionCutoff() const
+{
+    return std::max(interactionConst_->rvdw, interactionConst_->rcoulomb);
+}
+
 void GmxForceCalculator::setParticlesOnGrid(gmx::ArrayRef<const int>       particleInfoAllVdw,
                                             gmx::ArrayRef<const gmx::RVec> coordinates,
                                             const Box&                     box)
 {
-    auto legacyBox = box.legacyMatrix();
+    setParticlesOnGrid(particleInfoAllVdw, coordinates, box.legacyMatrix());
+}
 
-    if (TRICLINIC(legacyBox))
+void GmxForceCalculator::setParticlesOnGrid(gmx::ArrayRef<const int>       particleInfoAllVdw,
+                                            gmx::ArrayRef<const gmx::RVec> coordinates,
+                                            const matrix&                  legacyBox)
+{
+    // The grid search only considers shifts by single box vectors
+    const real cutoff = std::max(interactionCutoff(), nbv_->pairlistOuterRadius());
+    if (gmx::square(cutoff) > max_cutoff2(PbcType::Xyz, legacyBox))
     {
-        throw InputException("Only rectangular unit-cells are supported here");
+        throw InputException("The pairlist cutoff is too long for the box");
     }
+
+    // Triclinic boxes are handled by the grid and the pairlist search, as in mdrun,
+    // provided the particles are in the unit cell (see put_atoms_in_box)
     const rvec lowerCorner = { 0, 0, 0 };
     const rvec upperCorner = { legacyBox[dimX][dimX], legacyBox[dimY][dimY], legacyBox[dimZ][dimZ] };
 
@@ -100,6 +296,39 @@ void GmxForceCalculator::setParticlesOnGrid(gmx::ArrayRef<const int>       parti
     nbnxn_put_on_grid(nbv_.get(), legacyBox, 0, lowerCorner, upperCorner, nullptr,
                       { 0, int(coordinates.size()) }, particleDensity, particleInfoAllVdw,
                       coordinates, 0, nullptr);
+
+    // Keep the shift vectors consistent with the box the particles were put in.
+    // They are only written when the box changed, as the forcerec can be shared.
+    const bool boxChanged = !std::equal(&legacyBox[0][0], &legacyBox[0][0] + DIM * DIM, &box_[0][0]);
+    copy_mat(legacyBox, box_);
+    if (boxChanged && forcerec_->shift_vec != nullptr)
+    {
+        calc_shifts(box_, forcerec_->shift_vec);
+    }
+
+    // A list built from this grid is valid for displacements relative to these coordinates
+    pairlistCoordinates_.assign(coordinates.begin(), coordinates.end());
+    prunedCoordinates_.clear();
+}
+
+void GmxForceCalculator::updatePairList(gmx::ArrayRef<const int>       particleInfoAllVdw,
+                                        gmx::ArrayRef<const gmx::RVec> coordinates,
+                                        const Box&                     box)
+{
+    particleInfoAllVdw_.assign(particleInfoAllVdw.begin(), particleInfoAllVdw.end());
+    setParticlesOnGrid(particleInfoAllVdw_, coordinates, box.legacyMatrix());
+    nbv_->constructPairlist(gmx::InteractionLocality::Local, exclusions_, 0, nrnb_.get());
+    nbv_->setAtomProperties(particleTypeIdOfAllParticles_, charges_, particleInfoAllVdw_);
+    numPairlistRebuilds_++;
+}
+
+void GmxForceCalculator::rebuildPairList(gmx::ArrayRef<const gmx::RVec> coordinates)
+{
+    setParticlesOnGrid(particleInfoAllVdw_, coordinates, box_);
+    nbv_->constructPairlist(gmx::InteractionLocality::Local, exclusions_, 0, nrnb_.get());
+    // The grid reorders the particles, so their properties have to be set again
+    nbv_->setAtomProperties(particleTypeIdOfAllParticles_, charges_, particleInfoAllVdw_);
+    numPairlistRebuilds_++;
 }
 
 } // namespace nblib
@@ -47,8 +47,11 @@
 #ifndef NBLIB_GMXCALCULATOR_H
 #define NBLIB_GMXCALCULATOR_H
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
+#include "gromacs/utility/listoflists.h"
 #include "nblib/vector.h"
 
 struct nonbonded_verlet_t;
@@ -56,6 +59,8 @@ struct t_forcerec;
 struct t_nrnb;
 struct interaction_const_t;
 struct gmx_enerdata_t;
+struct gmx_pme_t;
+struct t_commrec;
 
 namespace gmx
 {
@@ -68,6 +73,7 @@ namespace nblib
 {
 class Box;
 class NbvSetupUtil;
+struct NonBondedEnergiesAndVirial;
 class SimulationState;
 struct NBKernelOptions;
 
@@ -78,37 +84,142 @@ public:
 
     ~GmxForceCalculator();
 
-    //! Compute forces and return
+    /*! \brief Compute forces and return
+     *
+     * With automatic pairlist updates, the pairlist is rebuilt when a particle has moved
+     * more than half the pairlist buffer since the last search, and pruned when a particle
+     * has moved more than half the inner buffer since the last pruning.
+     */
     void compute(gmx::ArrayRef<const gmx::RVec> coordinateInput, gmx::ArrayRef<gmx::RVec> forceOutput);
 
+    //! Compute forces, and return the energies and the virial computed from the shift forces
+    void compute(gmx::ArrayRef<const gmx::RVec> coordinateInput,
+                 gmx::ArrayRef<gmx::RVec>       forceOutput,
+                 NonBondedEnergiesAndVirial*    energiesAndVirial);
+
+    /*! \brief Compute forces with coordinates and forces in the grid order of gridOrder()
+     *
+     * Both arrays have one entry per grid position, entries for filler positions are not used
+     * and get zero force. The coordinates are copied to the nbnxm atom data and the forces
+     * stored without reordering, so the output buffer does not need to be cleared either.
+     * The grid order changes when the pairlist is rebuilt, so this can not be used with
+     * automatic pairlist updates. The PME mesh part is not supported.
+     */
+    void computeInGridOrder(gmx::ArrayRef<const gmx::RVec> gridCoordinates,
+                            gmx::ArrayRef<gmx::RVec>       gridForces);
+
+    //! Returns the particle index for each grid position, -1 for filler positions
+    gmx::ArrayRef<const int> gridOrder() const;
+
     //! Puts particles on a grid based on bounds specified by the box (for every NS step)
     void setParticlesOnGrid(gmx::ArrayRef<const int>       particleInfoAllVdw,
                             gmx::ArrayRef<const gmx::RVec> coordinates,
                             const Box&                     box);
 
+    //! Puts particles on the grid and rebuilds the pairlist and the particle properties
+    void updatePairList(gmx::ArrayRef<const int>       particleInfoAllVdw,
+                        gmx::ArrayRef<const gmx::RVec> coordinates,
+                        const Box&                     box);
+
+    //! Rebuilds the pairlist for the coordinates, using the stored box and particle properties
+    void rebuildPairList(gmx::ArrayRef<const gmx::RVec> coordinates);
+
+    //! Returns how often the pairlist was rebuilt after its construction at setup
+    int64_t numPairlistRebuilds() const { return numPairlistRebuilds_; }
+
+    //! Returns how often the pairlist was pruned with dynamic pruning
+    int64_t numPairlistPrunes() const { return numPairlistPrunes_; }
+
 private:
     friend class NbvSetupUtil;
 
+    //! Puts particles on a grid based on bounds specified by the legacy box matrix
+    void setParticlesOnGrid(gmx::ArrayRef<const int>       particleInfoAllVdw,
+                            gmx::ArrayRef<const gmx::RVec> coordinates,
+                            const matrix&                  legacyBox);
+
+    //! Compute the forces of the pairlist interactions with the tasks given by \p stepWork
+    void computeForces(gmx::ArrayRef<const gmx::RVec> coordinateInput,
+                       gmx::ArrayRef<gmx::RVec>       forceOutput,
+                       const gmx::StepWorkload&       stepWork);
+
+    //! Prunes the pairlist when dynamic pruning is used and particles moved too far
+    void prunePairListIfNeeded(gmx::ArrayRef<const gmx::RVec> coordinates);
+
+    //! Adds the PME mesh forces and, when requested by \p stepWork, returns its energy and virial
+    void addPmeMeshForces(gmx::ArrayRef<const gmx::RVec> coordinateInput,
+                          gmx::ArrayRef<gmx::RVec>       forceOutput,
+                          const gmx::StepWorkload&       stepWork,
+                          real*                          energy,
+                          matrix                         virial);
+
+    //! Returns the largest cut-off of the interactions computed from the pairlist
+    real interactionCutoff() const;
+
     //! Non-Bonded Verlet object for force calculation
     std::unique_ptr<nonbonded_verlet_t> nbv_;
 
-    //! Only nbfp and shift_vec are used
-    std::unique_ptr<t_forcerec> forcerec_;
+    /*! \brief Only nbfp and shift_vec are used
+     *
+     * The forcerec, the interaction constants and the step workload are only read during
+     * force computation, so calculators for replicas of the same system can share them.
+     */
+    std::shared_ptr<t_forcerec> forcerec_;
 
     //! Parameters for various interactions in the system
-    std::unique_ptr<interaction_const_t> interactionConst_;
+    std::shared_ptr<interaction_const_t> interactionConst_;
 
     //! Tasks to perform in an MD Step
-    std::unique_ptr<gmx::StepWorkload> stepWork_;
+    std::shared_ptr<gmx::StepWorkload> stepWork_;
 
-    //! Energies of different interaction types; currently only needed as an argument for dispatchNonbondedKernel
+    //! Energies of different interaction types, accumulated by dispatchNonbondedKernel
     std::unique_ptr<gmx_enerdata_t> enerd_;
 
     //! Non-bonded flop counter; currently only needed as an argument for dispatchNonbondedKernel
     std::unique_ptr<t_nrnb> nrnb_;
 
+    //! Frees the PME data with the PME module
+    struct PmeDeleter
+    {
+        //! Calls gmx_pme_destroy
+        void operator()(gmx_pme_t* pme) const;
+    };
+
+    //! PME data for the reciprocal-space part of the Coulomb interactions, nullptr without PME mesh
+    std::unique_ptr<gmx_pme_t, PmeDeleter> pme_;
+
+    //! Communication record for PME, for a single rank without parallelization over ranks
+    std::shared_ptr<t_commrec> commrec_;
+
     //! Legacy matrix for box
     matrix box_{ { 0 } };
+
+    //! Exclusions, needed for every pairlist construction
+    gmx::ListOfLists<int> exclusions_;
+
+    //! Particle type IDs, needed after every pairlist construction
+    std::vector<int> particleTypeIdOfAllParticles_;
+
+    //! Particle charges, needed after every pairlist construction
+    std::vector<real> charges_;
+
+    //! Particle info where all particles are marked to have Van der Waals interactions
+    std::vector<int> particleInfoAllVdw_;
+
+    //! Whether compute rebuilds the pairlist when particles have moved too far
+    bool useAutomaticPairlistUpdate_ = false;
+
+    //! Coordinates at the last pairlist construction
+    std::vector<gmx::RVec> pairlistCoordinates_;
+
+    //! Coordinates at the last pairlist pruning, empty when the list needs pruning
+    std::vector<gmx::RVec> prunedCoordinates_;
+
+    //! The number of pairlist constructions after setup
+    int64_t numPairlistRebuilds_ = 0;
+
+    //! The number of dynamic pairlist prunings
+    int64_t numPairlistPrunes_ = 0;
 };
 
 } // namespace nblib
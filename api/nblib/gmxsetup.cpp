@@ -41,12 +41,16 @@
  * \author Sebastian Keller <keller@cscs.ch>
  */
 #include "nblib/gmxsetup.h"
+#include "gromacs/domdec/domdec.h"
 #include "gromacs/ewald/ewald_utils.h"
+#include "gromacs/ewald/pme.h"
+#include "gromacs/fft/calcgrid.h"
 #include "gromacs/gmxlib/nrnb.h"
 #include "gromacs/mdlib/forcerec.h"
 #include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdlib/rf_util.h"
 #include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/mdtypes/interaction_const.h"
 #include "gromacs/mdtypes/simulation_workload.h"
 #include "gromacs/nbnxm/atomdata.h"
@@ -66,6 +70,9 @@
 namespace nblib
 {
 
+//! The fraction of the pairlist buffer used for the dynamically pruned inner list
+static constexpr real c_innerPairlistBufferFraction = 0.25;
+
 //! Helper to translate between the different enumeration values.
 static Nbnxm::KernelType translateBenchmarkEnum(const SimdKernels& kernel)
 {
@@ -169,6 +176,11 @@ void NbvSetupUtil::setAtomProperties(const std::vector<int>&  particleTypeIdOfAl
                                      const std::vector<real>& charges)
 {
     gmxForceCalculator_->nbv_->setAtomProperties(particleTypeIdOfAllParticles, charges, particleInfoAllVdw_);
+
+    // Kept for setting the properties again after each pairlist construction
+    gmxForceCalculator_->particleTypeIdOfAllParticles_ = particleTypeIdOfAllParticles;
+    gmxForceCalculator_->charges_                      = charges;
+    gmxForceCalculator_->particleInfoAllVdw_           = particleInfoAllVdw_;
 }
 
 //! Sets up and returns a Nbnxm object for the given options and system
@@ -185,6 +197,23 @@ void NbvSetupUtil::setupNbnxmInstance(const size_t numParticleTypes, const NBKer
     Nbnxm::KernelSetup kernelSetup = getKernelSetup(options);
 
     PairlistParams pairlistParams(kernelSetup.kernelType, false, options.pairlistCutoff, false);
+    if (options.useAutomaticPairlistUpdate)
+    {
+        if (!(options.pairlistBuffer > 0))
+        {
+            throw InputException("Automatic pairlist updates need a positive pairlist buffer");
+        }
+        pairlistParams.rlistOuter = options.pairlistCutoff + options.pairlistBuffer;
+        pairlistParams.rlistInner = pairlistParams.rlistOuter;
+        if (options.useDynamicPruning)
+        {
+            // A smaller inner buffer gives shorter lists for the kernels at the cost of
+            // more frequent, but cheap, pruning of the outer list
+            pairlistParams.useDynamicPruning = true;
+            pairlistParams.rlistInner =
+                    options.pairlistCutoff + c_innerPairlistBufferFraction * options.pairlistBuffer;
+        }
+    }
     Nbnxm::GridSet gridSet(PbcType::Xyz, false, nullptr, nullptr, pairlistParams.pairlistType,
                            false, numThreads, pinPolicy);
     auto           pairlistSets = std::make_unique<PairlistSets>(pairlistParams, false, 0);
@@ -202,7 +231,8 @@ void NbvSetupUtil::setupNbnxmInstance(const size_t numParticleTypes, const NBKer
     nbnxn_atomdata_init(gmx::MDLogger(), nbv->nbat.get(), kernelSetup.kernelType, combinationRule,
                         numParticleTypes, nonbondedParameters_, 1, numThreads);
 
-    gmxForceCalculator_->nbv_ = std::move(nbv);
+    gmxForceCalculator_->nbv_                        = std::move(nbv);
+    gmxForceCalculator_->useAutomaticPairlistUpdate_ = options.useAutomaticPairlistUpdate;
 }
 
 //! Computes the Ewald splitting coefficient for Coulomb
@@ -291,6 +321,50 @@ void NbvSetupUtil::setupForceRec(const matrix& box)
     calc_shifts(box, gmxForceCalculator_->forcerec_->shift_vec);
 }
 
+void NbvSetupUtil::setupReplicaOf(const GmxForceCalculator& calculator)
+{
+    gmxForceCalculator_                    = std::make_unique<GmxForceCalculator>();
+    gmxForceCalculator_->forcerec_         = calculator.forcerec_;
+    gmxForceCalculator_->interactionConst_ = calculator.interactionConst_;
+    gmxForceCalculator_->stepWork_         = calculator.stepWork_;
+    // With the box already set, the shared shift vectors are not computed again
+    copy_mat(calculator.box_, gmxForceCalculator_->box_);
+}
+
+void NbvSetupUtil::setupPme(const NBKernelOptions& options, const size_t numParticles, const matrix& box)
+{
+    if (!options.usePmeMesh)
+    {
+        return;
+    }
+    if (options.coulombType != CoulombType::Pme)
+    {
+        throw InputException("The PME mesh can only be used with PME electrostatics");
+    }
+
+    // The PME module takes its settings from the inputrec, as in mdrun
+    t_inputrec inputrec;
+    inputrec.pbcType     = PbcType::Xyz;
+    inputrec.coulombtype = eelPME;
+    inputrec.vdwtype     = evdwCUT;
+    inputrec.epsilon_r   = gmxForceCalculator_->interactionConst_->epsilon_r;
+    inputrec.pme_order   = options.pmeOrder;
+    calcFftGrid(nullptr, box, options.pmeFourierSpacing, minimalPmeGridSize(options.pmeOrder),
+                &inputrec.nkx, &inputrec.nky, &inputrec.nkz);
+    if (!gmx_pme_check_restrictions(options.pmeOrder, inputrec.nkx, inputrec.nky, inputrec.nkz, 1,
+                                    options.numOpenMPThreads > 1, false))
+    {
+        throw InputException("The PME grid and order do not satisfy the PME restrictions");
+    }
+
+    NumPmeDomains numPmeDomains = { 1, 1 };
+    gmxForceCalculator_->pme_.reset(gmx_pme_init(
+            gmxForceCalculator_->commrec_.get(), numPmeDomains, &inputrec, false, false, false,
+            gmxForceCalculator_->interactionConst_->ewaldcoeff_q, 0, options.numOpenMPThreads,
+            PmeRunMode::CPU, nullptr, nullptr, nullptr, nullptr, gmx::MDLogger()));
+    gmx_pme_reinit_atoms(gmxForceCalculator_->pme_.get(), numParticles, nullptr, nullptr);
+}
+
 void NbvSetupUtil::setParticlesOnGrid(const std::vector<Vec3>& coordinates, const Box& box)
 {
     gmxForceCalculator_->setParticlesOnGrid(particleInfoAllVdw_, coordinates, box);
@@ -298,6 +372,8 @@ void NbvSetupUtil::setParticlesOnGrid(const std::vector<Vec3>& coordinates, cons
 
 void NbvSetupUtil::constructPairList(const gmx::ListOfLists<int>& exclusions)
 {
+    // Kept for constructing the pairlist again when particles have moved
+    gmxForceCalculator_->exclusions_ = exclusions;
     gmxForceCalculator_->nbv_->constructPairlist(gmx::InteractionLocality::Local, exclusions, 0,
                                                  gmxForceCalculator_->nrnb_.get());
 }
@@ -320,8 +396,60 @@ std::unique_ptr<GmxForceCalculator> GmxSetupDirector::setupGmxForceCalculator(co
     nbvSetupUtil.setAtomProperties(system.topology().getParticleTypeIdOfAllParticles(),
                                    system.topology().getCharges());
     nbvSetupUtil.setupForceRec(system.box().legacyMatrix());
+    nbvSetupUtil.setupPme(options, system.topology().numParticles(), system.box().legacyMatrix());
 
     return nbvSetupUtil.getGmxForceCalculator();
 }
 
+std::vector<std::unique_ptr<GmxForceCalculator>>
+GmxSetupDirector::setupGmxForceCalculators(const SimulationState& system,
+                                           const NBKernelOptions& options,
+                                           const int              numReplicas)
+{
+    if (numReplicas < 1)
+    {
+        throw InputException("Need at least one replica");
+    }
+
+    NBKernelOptions replicaOptions  = options;
+    replicaOptions.numOpenMPThreads = 1;
+
+    NbvSetupUtil nbvSetupUtil;
+    nbvSetupUtil.setExecutionContext(replicaOptions);
+    nbvSetupUtil.setNonBondedParameters(system.topology().getParticleTypes(),
+                                        system.topology().getNonBondedInteractionMap());
+    nbvSetupUtil.setParticleInfoAllVdv(system.topology().numParticles());
+
+    nbvSetupUtil.setupInteractionConst(replicaOptions);
+    nbvSetupUtil.setupStepWorkload(replicaOptions);
+
+    const size_t                numParticleTypes             = system.topology().getParticleTypes().size();
+    const gmx::ListOfLists<int> exclusions                   = system.topology().getGmxExclusions();
+    const std::vector<int>      particleTypeIdOfAllParticles = system.topology().getParticleTypeIdOfAllParticles();
+    const std::vector<real>     charges                      = system.topology().getCharges();
+
+    std::vector<std::unique_ptr<GmxForceCalculator>> calculators;
+    for (int replica = 0; replica < numReplicas; replica++)
+    {
+        if (replica > 0)
+        {
+            nbvSetupUtil.setupReplicaOf(*calculators.front());
+        }
+        nbvSetupUtil.setupNbnxmInstance(numParticleTypes, replicaOptions);
+        nbvSetupUtil.setParticlesOnGrid(system.coordinates(), system.box());
+        nbvSetupUtil.constructPairList(exclusions);
+        nbvSetupUtil.setAtomProperties(particleTypeIdOfAllParticles, charges);
+        if (replica == 0)
+        {
+            nbvSetupUtil.setupForceRec(system.box().legacyMatrix());
+        }
+        // The PME grids hold intermediate results, so each replica needs its own
+        nbvSetupUtil.setupPme(replicaOptions, system.topology().numParticles(),
+                              system.box().legacyMatrix());
+        calculators.push_back(nbvSetupUtil.getGmxForceCalculator());
+    }
+
+    return calculators;
+}
+
 } // namespace nblib
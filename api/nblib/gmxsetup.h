@@ -99,6 +99,17 @@ public:
     //! Sets up t_forcerec object on the GmxForceCalculator
     void setupForceRec(const matrix& box);
 
+    //! Sets up the PME mesh on the GmxForceCalculator, when requested in the options
+    void setupPme(const NBKernelOptions& options, size_t numParticles, const matrix& box);
+
+    /*! \brief Starts setting up a new GmxForceCalculator for a replica of the system of \p calculator
+     *
+     * The new calculator shares the forcerec, with the nonbonded parameter table, the interaction
+     * constants and the step workload of \p calculator, which has to be set up completely. It
+     * needs its own Nbnxm instance, grid, pairlist and particle properties.
+     */
+    void setupReplicaOf(const GmxForceCalculator& calculator);
+
     std::unique_ptr<GmxForceCalculator> getGmxForceCalculator()
     {
         return std::move(gmxForceCalculator_);
@@ -121,6 +132,14 @@ public:
     //! Sets up and returns a GmxForceCalculator
     static std::unique_ptr<GmxForceCalculator> setupGmxForceCalculator(const SimulationState& system,
                                                                        const NBKernelOptions& options);
+
+    /*! \brief Sets up and returns GmxForceCalculators for \p numReplicas replicas of the system
+     *
+     * The interaction setup is done once and shared by all calculators. Each calculator
+     * uses a single thread, so that the OpenMP threads can be spread over the replicas.
+     */
+    static std::vector<std::unique_ptr<GmxForceCalculator>>
+    setupGmxForceCalculators(const SimulationState& system, const NBKernelOptions& options, int numReplicas);
 };
 
 } // namespace nblib
@@ -43,15 +43,111 @@
  * \author Artem Zhmurov <zhmurov@gmail.com>
  */
 #include "nblib/integrator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "gromacs/mdlib/update.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/simd/simd.h"
 #include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/exceptions.h"
+#include "nblib/exception.h"
 #include "nblib/topology.h"
 
 namespace nblib
 {
+
+namespace
+{
+
+/*! \brief Leap-frog update of particles \p start to \p end - 1 with a single T-scaling factor
+ *
+ * \param[in]    start    Index of first particle to update
+ * \param[in]    end      Last particle to update: \p end - 1
+ * \param[in]    dt       The time step
+ * \param[in]    lambda   The velocity scaling factor for temperature coupling
+ * \param[in]    invMass  1/mass per particle
+ * \param[inout] x        Coordinates, updated in-place
+ * \param[inout] v        Velocities
+ * \param[in]    f        Forces
+ */
+void updateLeapFrog(int         start,
+                    int         end,
+                    real        dt,
+                    real        lambda,
+                    const real* invMass,
+                    rvec*       x,
+                    rvec*       v,
+                    const rvec* f)
+{
+    int a = start;
+
+#if GMX_SIMD && GMX_SIMD_HAVE_REAL && GMX_SIMD_HAVE_LOADU && GMX_SIMD_HAVE_STOREU
+    /* This follows updateMDLeapfrogSimpleSimd() in mdrun, but uses unaligned
+     * loads and stores, since the nblib arrays are neither aligned nor padded.
+     */
+    using namespace gmx;
+
+    const SimdReal timestep(dt);
+    const SimdReal lambdaSystem(lambda);
+
+    for (; a + GMX_SIMD_REAL_WIDTH <= end; a += GMX_SIMD_REAL_WIDTH)
+    {
+        SimdReal invMass0, invMass1, invMass2;
+        expandScalarsToTriplets(simdLoadU(invMass + a), &invMass0, &invMass1, &invMass2);
+
+        real* vPtr = v[a];
+        real* xPtr = x[a];
+
+        SimdReal v0 = simdLoadU(vPtr + 0 * GMX_SIMD_REAL_WIDTH);
+        SimdReal v1 = simdLoadU(vPtr + 1 * GMX_SIMD_REAL_WIDTH);
+        SimdReal v2 = simdLoadU(vPtr + 2 * GMX_SIMD_REAL_WIDTH);
+
+        const SimdReal f0 = simdLoadU(f[a] + 0 * GMX_SIMD_REAL_WIDTH);
+        const SimdReal f1 = simdLoadU(f[a] + 1 * GMX_SIMD_REAL_WIDTH);
+        const SimdReal f2 = simdLoadU(f[a] + 2 * GMX_SIMD_REAL_WIDTH);
+
+        v0 = fma(f0 * invMass0, timestep, lambdaSystem * v0);
+        v1 = fma(f1 * invMass1, timestep, lambdaSystem * v1);
+        v2 = fma(f2 * invMass2, timestep, lambdaSystem * v2);
+
+        storeU(vPtr + 0 * GMX_SIMD_REAL_WIDTH, v0);
+        storeU(vPtr + 1 * GMX_SIMD_REAL_WIDTH, v1);
+        storeU(vPtr + 2 * GMX_SIMD_REAL_WIDTH, v2);
+
+        const SimdReal x0 = simdLoadU(xPtr + 0 * GMX_SIMD_REAL_WIDTH);
+        const SimdReal x1 = simdLoadU(xPtr + 1 * GMX_SIMD_REAL_WIDTH);
+        const SimdReal x2 = simdLoadU(xPtr + 2 * GMX_SIMD_REAL_WIDTH);
+
+        storeU(xPtr + 0 * GMX_SIMD_REAL_WIDTH, fma(v0, timestep, x0));
+        storeU(xPtr + 1 * GMX_SIMD_REAL_WIDTH, fma(v1, timestep, x1));
+        storeU(xPtr + 2 * GMX_SIMD_REAL_WIDTH, fma(v2, timestep, x2));
+    }
+#endif
+
+    // The remaining particles, or all of them without SIMD support
+    for (; a < end; a++)
+    {
+        for (int dim = 0; dim < dimSize; dim++)
+        {
+            v[a][dim] = lambda * v[a][dim] + f[a][dim] * dt * invMass[a];
+            x[a][dim] += v[a][dim] * dt;
+        }
+    }
+}
+
+} // namespace
+
 // NOLINTNEXTLINE(performance-unnecessary-value-param)
-LeapFrog::LeapFrog(const Topology& topology, const Box& box) : box_(box)
+LeapFrog::LeapFrog(const Topology& topology, const Box& box, const int numThreads) :
+    box_(box),
+    numThreads_(numThreads)
 {
+    if (numThreads_ < 1)
+    {
+        throw InputException("The number of integrator threads should be at least 1");
+    }
     inverseMasses_.resize(topology.numParticles());
     for (int i = 0; i < topology.numParticles(); i++)
     {
@@ -60,17 +156,60 @@ LeapFrog::LeapFrog(const Topology& topology, const Box& box) : box_(box)
     }
 }
 
+void LeapFrog::setTemperatureCoupling(const real referenceTemperature, const real couplingTime)
+{
+    if (referenceTemperature < 0 || couplingTime <= 0)
+    {
+        throw InputException(
+                "Temperature coupling needs a non-negative reference temperature and a positive "
+                "coupling time");
+    }
+    useTemperatureCoupling_ = true;
+    referenceTemperature_   = referenceTemperature;
+    couplingTime_           = couplingTime;
+}
+
+real LeapFrog::temperatureScalingFactor(const real dt, gmx::ArrayRef<const Vec3> v) const
+{
+    const int numParticles = v.size();
+
+    double twiceKineticEnergy = 0;
+#pragma omp parallel for reduction(+ : twiceKineticEnergy) schedule(static) num_threads(numThreads_)
+    for (int i = 0; i < numParticles; i++)
+    {
+        twiceKineticEnergy += v[i].norm2() / inverseMasses_[i];
+    }
+
+    const real temperature = twiceKineticEnergy / (dimSize * numParticles * BOLTZ);
+    if (temperature <= 0)
+    {
+        return 1.0;
+    }
+    const real lambda =
+            std::sqrt(1.0 + (dt / couplingTime_) * (referenceTemperature_ / temperature - 1.0));
+
+    return std::max<real>(std::min<real>(lambda, 1.25), 0.8);
+}
+
 void LeapFrog::integrate(const real dt, gmx::ArrayRef<Vec3> x, gmx::ArrayRef<Vec3> v, gmx::ArrayRef<const Vec3> f)
 {
-    for (size_t i = 0; i < x.size(); i++)
+    const real lambda       = useTemperatureCoupling_ ? temperatureScalingFactor(dt, v) : 1.0;
+    const int  numParticles = x.size();
+
+#pragma omp parallel for schedule(static) num_threads(numThreads_)
+    for (int thread = 0; thread < numThreads_; thread++)
     {
-        for (int dim = 0; dim < dimSize; dim++)
+        try
         {
-            v[i][dim] += f[i][dim] * dt * inverseMasses_[i];
-            x[i][dim] += v[i][dim] * dt;
+            int start, end;
+            getThreadAtomRange(numThreads_, thread, numParticles, &start, &end);
+
+            updateLeapFrog(start, end, dt, lambda, inverseMasses_.data(), as_rvec_array(x.data()),
+                           as_rvec_array(v.data()), as_rvec_array(f.data()));
+            put_atoms_in_box(PbcType::Xyz, box_.legacyMatrix(), x.subArray(start, end - start));
         }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
     }
-    put_atoms_in_box(PbcType::Xyz, box_.legacyMatrix(), x);
 }
 
 } // namespace nblib
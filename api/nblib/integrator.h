@@ -63,16 +63,31 @@ class Topology;
 
 /*! \brief Simple integrator
  *
+ * The update uses SIMD instructions when GROMACS is built with SIMD support
+ * and is divided over OpenMP threads in SIMD-width blocks of particles,
+ * in the same way as the leap-frog update in mdrun.
  */
 class LeapFrog final
 {
 public:
     /*! \brief Constructor.
      *
-     * \param[in] topology  Topology object to build list of inverse masses.
-     * \param[in] box       Box object for ensuring that coordinates remain within bounds
+     * \param[in] topology    Topology object to build list of inverse masses.
+     * \param[in] box         Box object for ensuring that coordinates remain within bounds
+     * \param[in] numThreads  The number of OpenMP threads to divide the update over
      */
-    LeapFrog(const Topology& topology, const Box& box);
+    LeapFrog(const Topology& topology, const Box& box, int numThreads = 1);
+
+    /*! \brief Couple the system to a heat bath using the Berendsen thermostat
+     *
+     * Before each update the velocities are scaled by a single factor for
+     * the whole system, computed from the temperature of the input velocities.
+     * As in mdrun, the scaling factor is limited to the range [0.8, 1.25].
+     *
+     * \param[in] referenceTemperature  The temperature of the heat bath in K
+     * \param[in] couplingTime          The coupling time constant in ps
+     */
+    void setTemperatureCoupling(real referenceTemperature, real couplingTime);
 
     /*! \brief Integrate
      *
@@ -91,10 +106,21 @@ public:
                    gmx::ArrayRef<const Vec3> forces);
 
 private:
+    //! Returns the Berendsen velocity scaling factor for velocities \p v and time step \p dt
+    real temperatureScalingFactor(real dt, gmx::ArrayRef<const Vec3> v) const;
+
     //! 1/mass for all atoms
     std::vector<real> inverseMasses_;
     //! Box for PBC conformity
     Box box_;
+    //! The number of OpenMP threads used for the update
+    int numThreads_;
+    //! Whether the velocities are coupled to a heat bath
+    bool useTemperatureCoupling_ = false;
+    //! The reference temperature for temperature coupling
+    real referenceTemperature_ = 0;
+    //! The time constant for temperature coupling
+    real couplingTime_ = 0;
 };
 
 } // namespace nblib
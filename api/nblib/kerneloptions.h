@@ -97,12 +97,24 @@ struct NBKernelOptions final
     bool useHalfLJOptimization = false;
     //! The pairlist and interaction cut-off
     real pairlistCutoff = 1.0;
+    //! Whether compute() rebuilds the pairlist by itself when particles have moved too far
+    bool useAutomaticPairlistUpdate = false;
+    //! The pairlist buffer beyond the cut-off, only used with automatic pairlist updates
+    real pairlistBuffer = 0.1;
+    //! Whether to prune the pairlist with a smaller buffer in between pairlist updates
+    bool useDynamicPruning = true;
     //! Whether to compute energies (shift forces for virial are always computed on CPU)
     bool computeVirialAndEnergy = false;
     //! The Coulomb interaction function
     CoulombType coulombType = CoulombType::Pme;
     //! Whether to use tabulated PME grid correction instead of analytical, not applicable with simd=no
     bool useTabulatedEwaldCorr = false;
+    //! Whether to add the reciprocal-space (mesh) part of PME, only used with CoulombType::Pme
+    bool usePmeMesh = false;
+    //! The upper bound for the PME grid spacing, only used with the PME mesh
+    real pmeFourierSpacing = 0.12;
+    //! The PME interpolation order, only used with the PME mesh
+    int pmeOrder = 4;
     //! The number of iterations for each kernel
     int numIterations = 100;
     //! Print cycles/pair instead of pairs/cycle
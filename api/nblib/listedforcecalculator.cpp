@@ -0,0 +1,229 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements a calculator for the listed (bonded) forces of an nblib system
+ */
+#include "nblib/listedforcecalculator.h"
+
+#include <algorithm>
+
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/listed_forces/listed_forces.h"
+#include "gromacs/math/paddedvector.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdtypes/enerdata.h"
+#include "gromacs/mdtypes/fcdata.h"
+#include "gromacs/mdtypes/forceoutput.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/simulation_workload.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/topology/forcefieldparameters.h"
+#include "gromacs/topology/idef.h"
+#include "gromacs/topology/ifunc.h"
+#include "nblib/bondtypes.h"
+#include "nblib/topology.h"
+
+namespace nblib
+{
+
+//! Returns the GROMACS parameters of a harmonic bond
+static t_iparams toIparams(const HarmonicBondType& bond)
+{
+    t_iparams iparams;
+    iparams.harmonic.rA  = bond.equilibriumDistance();
+    iparams.harmonic.krA = bond.forceConstant();
+    iparams.harmonic.rB  = bond.equilibriumDistance();
+    iparams.harmonic.krB = bond.forceConstant();
+    return iparams;
+}
+
+//! Returns the GROMACS parameters of a harmonic angle
+static t_iparams toIparams(const HarmonicAngleType& angle)
+{
+    t_iparams iparams;
+    iparams.harmonic.rA  = angle.equilibriumAngle();
+    iparams.harmonic.krA = angle.forceConstant();
+    iparams.harmonic.rB  = angle.equilibriumAngle();
+    iparams.harmonic.krB = angle.forceConstant();
+    return iparams;
+}
+
+//! Returns the GROMACS parameters of a proper dihedral
+static t_iparams toIparams(const ProperDihedralType& dihedral)
+{
+    t_iparams iparams;
+    iparams.pdihs.phiA = dihedral.phase();
+    iparams.pdihs.cpA  = dihedral.forceConstant();
+    iparams.pdihs.mult = dihedral.multiplicity();
+    iparams.pdihs.phiB = dihedral.phase();
+    iparams.pdihs.cpB  = dihedral.forceConstant();
+    return iparams;
+}
+
+/*! \brief Adds the interactions in \p list with GROMACS function type \p functionType
+ *
+ * Each distinct parameter set of \p list becomes a parameter type in \p ffparams.
+ */
+template<class InteractionType>
+static void addListedInteractions(const ListedInteractionList<InteractionType>& list,
+                                  const int                                     functionType,
+                                  gmx_ffparams_t*                               ffparams,
+                                  InteractionDefinitions*                       idef)
+{
+    const int typeOffset = ffparams->numTypes();
+    for (const InteractionType& parameters : list.parameters)
+    {
+        ffparams->functype.push_back(functionType);
+        ffparams->iparams.push_back(toIparams(parameters));
+    }
+
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        const auto& particleIndices = list.particleIndices[i];
+        idef->il[functionType].push_back(typeOffset + list.parameterIndices[i],
+                                         particleIndices.size(), particleIndices.data());
+    }
+}
+
+class ListedForceCalculator::Impl
+{
+public:
+    Impl(const SimulationState& system, const NBKernelOptions& options);
+
+    void compute(gmx::ArrayRef<const Vec3> coordinates, gmx::ArrayRef<Vec3> forces);
+
+private:
+    //! Parameters of the listed interactions, referred to by idef_
+    gmx_ffparams_t ffparams_;
+    //! The listed interactions
+    InteractionDefinitions idef_;
+    //! Listed forces calculator with the thread decomposition of the interactions
+    ListedForces listedForces_;
+    //! Only the PBC and the kernel flavor settings are used
+    t_forcerec forcerec_;
+    //! Empty distance restraint data, required by ListedForces
+    t_disresdata disresdata_{};
+    //! Empty orientation restraint data, required by ListedForces
+    t_oriresdata oriresdata_{};
+    //! Holds the restraint data above
+    t_fcdata fcdata_;
+    //! Free-energy parameters without lambda states
+    t_lambda fepvals_{};
+    //! Energies of different interaction types
+    gmx_enerdata_t enerd_{ 1, 0 };
+    //! Flop counter
+    t_nrnb nrnb_;
+    //! Tasks to perform, only forces
+    gmx::StepWorkload stepWork_;
+    //! The box
+    matrix box_;
+    //! PBC information for the box
+    t_pbc pbc_;
+    //! Coordinates with padding, as required by the SIMD kernels
+    gmx::PaddedVector<gmx::RVec> coordinates_;
+    //! Force output with padding, as required by the SIMD kernels
+    gmx::PaddedVector<gmx::RVec> forces_;
+    //! Shift forces, unused without virial
+    std::vector<gmx::RVec> shiftForces_;
+};
+
+ListedForceCalculator::Impl::Impl(const SimulationState& system, const NBKernelOptions& options) :
+    idef_(ffparams_),
+    listedForces_(ffparams_, 1, options.numOpenMPThreads, ListedForces::interactionSelectionAll(), nullptr),
+    coordinates_(system.topology().numParticles()),
+    forces_(system.topology().numParticles()),
+    shiftForces_(SHIFTS)
+{
+    const ListedInteractionData listedInteractions = system.topology().getListedInteractions();
+    addListedInteractions(listedInteractions.harmonicBonds, F_BONDS, &ffparams_, &idef_);
+    addListedInteractions(listedInteractions.harmonicAngles, F_ANGLES, &ffparams_, &idef_);
+    addListedInteractions(listedInteractions.properDihedrals, F_PDIHS, &ffparams_, &idef_);
+    idef_.ilsort = ilsortNO_FE;
+
+    listedForces_.setup(idef_, system.topology().numParticles(), false);
+
+    // Molecules may be split over the periodic boundaries, as particles are put in the box
+    forcerec_.pbcType          = PbcType::Xyz;
+    forcerec_.bMolPBC          = true;
+    forcerec_.use_simd_kernels = true;
+
+    fcdata_.disres = &disresdata_;
+    fcdata_.orires = &oriresdata_;
+
+    stepWork_.computeForces       = true;
+    stepWork_.computeListedForces = true;
+
+    copy_mat(system.box().legacyMatrix(), box_);
+    set_pbc(&pbc_, PbcType::Xyz, box_);
+}
+
+void ListedForceCalculator::Impl::compute(gmx::ArrayRef<const Vec3> coordinates, gmx::ArrayRef<Vec3> forces)
+{
+    std::copy(coordinates.begin(), coordinates.end(), coordinates_.begin());
+    std::fill(forces_.begin(), forces_.end(), gmx::RVec{ 0, 0, 0 });
+
+    gmx::ForceWithShiftForces forceWithShiftForces(forces_.arrayRefWithPadding(), false, shiftForces_);
+    gmx::ForceWithVirial      forceWithVirial(forces_.arrayRefWithPadding().unpaddedArrayRef(), false);
+    gmx::ForceOutputs         forceOutputs(forceWithShiftForces, false, forceWithVirial);
+
+    real lambda[efptNR] = { 0 };
+    listedForces_.calculate(nullptr, box_, &fepvals_, nullptr, nullptr,
+                            coordinates_.constArrayRefWithPadding(), {}, &fcdata_, nullptr,
+                            &forceOutputs, &forcerec_, &pbc_, &enerd_, &nrnb_, lambda, nullptr,
+                            nullptr, stepWork_);
+
+    for (size_t i = 0; i < forces.size(); i++)
+    {
+        forces[i] += forces_[i];
+    }
+}
+
+ListedForceCalculator::ListedForceCalculator(const SimulationState& system, const NBKernelOptions& options) :
+    impl_(std::make_unique<Impl>(system, options))
+{
+}
+
+ListedForceCalculator::~ListedForceCalculator() = default;
+
+void ListedForceCalculator::compute(gmx::ArrayRef<const Vec3> coordinates, gmx::ArrayRef<Vec3> forces)
+{
+    impl_->compute(coordinates, forces);
+}
+
+} // namespace nblib
@@ -0,0 +1,93 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \inpublicapi \file
+ * \brief
+ * Declares a calculator for the listed (bonded) forces of an nblib system
+ *
+ * The forces are computed with the listed-forces kernels of GROMACS,
+ * using SIMD and OpenMP threads where available.
+ */
+#ifndef NBLIB_LISTEDFORCECALCULATOR_H
+#define NBLIB_LISTEDFORCECALCULATOR_H
+
+#include <memory>
+
+#include "nblib/kerneloptions.h"
+#include "nblib/simulationstate.h"
+
+namespace gmx
+{
+template<typename T>
+class ArrayRef;
+} // namespace gmx
+
+namespace nblib
+{
+
+/*! \brief Sets up and computes the listed forces of a system using the GROMACS backend.
+ *
+ * The listed interactions of the Topology in the SimulationState are translated
+ * to GROMACS interaction definitions once at construction. The interactions are
+ * distributed over NBKernelOptions::numOpenMPThreads threads, as in mdrun.
+ * Interactions of molecules that are split over periodic boundaries are computed
+ * using the minimum image of the box of the SimulationState.
+ */
+class ListedForceCalculator final
+{
+public:
+    ListedForceCalculator(const SimulationState& system, const NBKernelOptions& options);
+
+    ~ListedForceCalculator();
+
+    /*! \brief Compute the listed forces and add them to the passed in forces buffer
+     *
+     * Contrary to ForceCalculator::compute, this function does not zero the
+     * forces, so it can be called after the nonbonded forces were computed
+     * into the same buffer.
+     *
+     * \param[in] coordinates to be used for the force calculation
+     * \param[inout] forces buffer to add the listed forces to
+     */
+    void compute(gmx::ArrayRef<const Vec3> coordinates, gmx::ArrayRef<Vec3> forces);
+
+private:
+    //! GROMACS data structures for the listed interactions
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace nblib
+
+#endif // NBLIB_LISTEDFORCECALCULATOR_H
@@ -43,6 +43,7 @@
  * \author Artem Zhmurov <zhmurov@gmail.com>
  */
 #include <algorithm>
+#include <map>
 #include <tuple>
 
 #include "nblib/exception.h"
@@ -241,6 +242,123 @@ std::vector<std::tuple<int, int>> Molecule::getExclusions() const
     return ret;
 }
 
+void Molecule::addInteraction(const ParticleName&     particleNameI,
+                              const ResidueName&      residueNameI,
+                              const ParticleName&     particleNameJ,
+                              const ResidueName&      residueNameJ,
+                              const HarmonicBondType& interaction)
+{
+    harmonicBondsByName_.emplace_back(
+            std::array<ParticleIdentifier, 2>{ ParticleIdentifier{ particleNameI, residueNameI },
+                                               ParticleIdentifier{ particleNameJ, residueNameJ } },
+            interaction);
+}
+
+void Molecule::addInteraction(const ParticleName&     particleNameI,
+                              const ParticleName&     particleNameJ,
+                              const HarmonicBondType& interaction)
+{
+    addInteraction(particleNameI, ResidueName(name_), particleNameJ, ResidueName(name_), interaction);
+}
+
+void Molecule::addInteraction(const ParticleName&      particleNameI,
+                              const ResidueName&       residueNameI,
+                              const ParticleName&      particleNameJ,
+                              const ResidueName&       residueNameJ,
+                              const ParticleName&      particleNameK,
+                              const ResidueName&       residueNameK,
+                              const HarmonicAngleType& interaction)
+{
+    harmonicAnglesByName_.emplace_back(
+            std::array<ParticleIdentifier, 3>{ ParticleIdentifier{ particleNameI, residueNameI },
+                                               ParticleIdentifier{ particleNameJ, residueNameJ },
+                                               ParticleIdentifier{ particleNameK, residueNameK } },
+            interaction);
+}
+
+void Molecule::addInteraction(const ParticleName&      particleNameI,
+                              const ParticleName&      particleNameJ,
+                              const ParticleName&      particleNameK,
+                              const HarmonicAngleType& interaction)
+{
+    addInteraction(particleNameI, ResidueName(name_), particleNameJ, ResidueName(name_),
+                   particleNameK, ResidueName(name_), interaction);
+}
+
+void Molecule::addInteraction(const ParticleName&       particleNameI,
+                              const ResidueName&        residueNameI,
+                              const ParticleName&       particleNameJ,
+                              const ResidueName&        residueNameJ,
+                              const ParticleName&       particleNameK,
+                              const ResidueName&        residueNameK,
+                              const ParticleName&       particleNameL,
+                              const ResidueName&        residueNameL,
+                              const ProperDihedralType& interaction)
+{
+    properDihedralsByName_.emplace_back(
+            std::array<ParticleIdentifier, 4>{ ParticleIdentifier{ particleNameI, residueNameI },
+                                               ParticleIdentifier{ particleNameJ, residueNameJ },
+                                               ParticleIdentifier{ particleNameK, residueNameK },
+                                               ParticleIdentifier{ particleNameL, residueNameL } },
+            interaction);
+}
+
+void Molecule::addInteraction(const ParticleName&       particleNameI,
+                              const ParticleName&       particleNameJ,
+                              const ParticleName&       particleNameK,
+                              const ParticleName&       particleNameL,
+                              const ProperDihedralType& interaction)
+{
+    addInteraction(particleNameI, ResidueName(name_), particleNameJ, ResidueName(name_),
+                   particleNameK, ResidueName(name_), particleNameL, ResidueName(name_), interaction);
+}
+
+/*! \brief Converts listed interactions given by particle names to indices and adds them to \p list
+ *
+ * \param[in]  indexOfParticle  Index in the molecule of each (particleName, residueName)
+ * \param[in]  interactionsByName  The interactions with particles given by name
+ * \param[out] list  The interactions with particles given by index
+ */
+template<class ParticleIdentifier, class InteractionsByName, class InteractionType>
+static void convertListedInteractions(const std::map<ParticleIdentifier, int>& indexOfParticle,
+                                      const InteractionsByName&                interactionsByName,
+                                      ListedInteractionList<InteractionType>*  list)
+{
+    for (const auto& interaction : interactionsByName)
+    {
+        typename ListedInteractionList<InteractionType>::ParticleIndices particleIndices;
+        for (size_t i = 0; i < particleIndices.size(); i++)
+        {
+            const ParticleIdentifier& particle = std::get<0>(interaction)[i];
+            const auto                found    = indexOfParticle.find(particle);
+            if (found == indexOfParticle.end())
+            {
+                throw InputException("Particle " + std::get<0>(particle) + " in residue "
+                                     + std::get<1>(particle) + " not found in list of particles");
+            }
+            particleIndices[i] = found->second;
+        }
+        list->add(particleIndices, std::get<1>(interaction));
+    }
+}
+
+ListedInteractionData Molecule::getListedInteractions() const
+{
+    std::map<ParticleIdentifier, int> indexOfParticle;
+    for (int i = 0; i < numParticlesInMolecule(); ++i)
+    {
+        indexOfParticle[{ particles_[i].particleName_, particles_[i].residueName_ }] = i;
+    }
+
+    ListedInteractionData listedInteractions;
+    convertListedInteractions(indexOfParticle, harmonicBondsByName_, &listedInteractions.harmonicBonds);
+    convertListedInteractions(indexOfParticle, harmonicAnglesByName_, &listedInteractions.harmonicAngles);
+    convertListedInteractions(indexOfParticle, properDihedralsByName_,
+                              &listedInteractions.properDihedrals);
+
+    return listedInteractions;
+}
+
 std::unordered_map<std::string, ParticleType> Molecule::particleTypesMap() const
 {
     return particleTypes_;
@@ -48,11 +48,13 @@
 #ifndef NBLIB_MOLECULES_H
 #define NBLIB_MOLECULES_H
 
+#include <array>
 #include <string>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
 
+#include "nblib/bondtypes.h"
 #include "nblib/particletype.h"
 
 namespace nblib
@@ -109,6 +111,51 @@ public:
     //! Specify an exclusion with particle names that have been added to molecule
     void addExclusion(const std::string& particleName, const std::string& particleNameToExclude);
 
+    //! Add a harmonic bond between two particles given by particle and residue names
+    void addInteraction(const ParticleName&     particleNameI,
+                        const ResidueName&      residueNameI,
+                        const ParticleName&     particleNameJ,
+                        const ResidueName&      residueNameJ,
+                        const HarmonicBondType& interaction);
+
+    //! Add a harmonic bond between two particles with residueName set using the molecule name
+    void addInteraction(const ParticleName&     particleNameI,
+                        const ParticleName&     particleNameJ,
+                        const HarmonicBondType& interaction);
+
+    //! Add a harmonic angle between three particles given by particle and residue names
+    void addInteraction(const ParticleName&      particleNameI,
+                        const ResidueName&       residueNameI,
+                        const ParticleName&      particleNameJ,
+                        const ResidueName&       residueNameJ,
+                        const ParticleName&      particleNameK,
+                        const ResidueName&       residueNameK,
+                        const HarmonicAngleType& interaction);
+
+    //! Add a harmonic angle between three particles with residueName set using the molecule name
+    void addInteraction(const ParticleName&      particleNameI,
+                        const ParticleName&      particleNameJ,
+                        const ParticleName&      particleNameK,
+                        const HarmonicAngleType& interaction);
+
+    //! Add a proper dihedral between four particles given by particle and residue names
+    void addInteraction(const ParticleName&       particleNameI,
+                        const ResidueName&        residueNameI,
+                        const ParticleName&       particleNameJ,
+                        const ResidueName&        residueNameJ,
+                        const ParticleName&       particleNameK,
+                        const ResidueName&        residueNameK,
+                        const ParticleName&       particleNameL,
+                        const ResidueName&        residueNameL,
+                        const ProperDihedralType& interaction);
+
+    //! Add a proper dihedral between four particles with residueName set using the molecule name
+    void addInteraction(const ParticleName&       particleNameI,
+                        const ParticleName&       particleNameJ,
+                        const ParticleName&       particleNameK,
+                        const ParticleName&       particleNameL,
+                        const ProperDihedralType& interaction);
+
     //! The number of molecules
     int numParticlesInMolecule() const;
 
@@ -119,6 +166,9 @@ public:
     //! returns a sorted vector containing no duplicates of particles to exclude by indices
     std::vector<std::tuple<int, int>> getExclusions() const;
 
+    //! Convert the particle names of the listed interactions to indices within the molecule
+    ListedInteractionData getListedInteractions() const;
+
     //! Return name of ith particle
     ParticleName particleName(int i) const;
 
@@ -150,6 +200,16 @@ private:
     //! we cannot efficiently compute indices during the build-phase
     //! so we delay the conversion until TopologyBuilder requests it
     std::vector<std::tuple<std::string, std::string, std::string, std::string>> exclusionsByName_;
+
+    //! Particle and residue name of a particle in the molecule
+    using ParticleIdentifier = std::tuple<std::string, std::string>;
+
+    //! Listed interactions by particle and residue names, converted to indices on request
+    std::vector<std::tuple<std::array<ParticleIdentifier, 2>, HarmonicBondType>> harmonicBondsByName_;
+    //! Harmonic angles by particle and residue names
+    std::vector<std::tuple<std::array<ParticleIdentifier, 3>, HarmonicAngleType>> harmonicAnglesByName_;
+    //! Proper dihedrals by particle and residue names
+    std::vector<std::tuple<std::array<ParticleIdentifier, 4>, ProperDihedralType>> properDihedralsByName_;
 };
 
 } // namespace nblib
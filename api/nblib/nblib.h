@@ -46,11 +46,14 @@
 #define NBLIB_HEADERS_H
 
 #include "nblib/basicdefinitions.h"
+#include "nblib/batchedforcecalculator.h"
+#include "nblib/bondtypes.h"
 #include "nblib/box.h"
 #include "nblib/forcecalculator.h"
 #include "nblib/integrator.h"
 #include "nblib/interactions.h"
 #include "nblib/kerneloptions.h"
+#include "nblib/listedforcecalculator.h"
 #include "nblib/molecules.h"
 #include "nblib/particletype.h"
 #include "nblib/simulationstate.h"
@@ -100,7 +100,7 @@ int main()
     topologyBuilder.addParticleTypesInteractions(interactions);
     // Build the topology.
     nblib::Topology topology = topologyBuilder.buildTopology();
-    // The system needs a bounding box. Only cubic and rectangular boxes are supported.
+    // The system needs a bounding box. Cubic, rectangular and triclinic boxes are supported.
     nblib::Box box(6.05449);
     // A simulation state contains all the molecular information about the system.
     nblib::SimulationState simState(coordinates, velocities, forces, box, topology);
@@ -0,0 +1,179 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * This implements tests of the batched force calculator
+ */
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "nblib/batchedforcecalculator.h"
+#include "nblib/exception.h"
+#include "nblib/forcecalculator.h"
+#include "nblib/tests/testhelpers.h"
+#include "nblib/tests/testsystems.h"
+#include "nblib/topology.h"
+
+#include "testutils/testasserts.h"
+
+namespace nblib
+{
+namespace test
+{
+namespace
+{
+
+//! The number of argon particles per dimension in the lattice of the tests
+constexpr int c_numPerDim = 4;
+//! The lattice spacing of the tests
+constexpr real c_spacing = 0.6;
+
+//! Checks that the forces of each replica match those of a separate ForceCalculator
+void checkReplicaForces(const NBKernelOptions& options, bool callUpdatePairLists)
+{
+    const Box box(c_numPerDim * c_spacing);
+
+    std::vector<std::vector<Vec3>> replicaCoordinates;
+    for (real displacement : { 0.01, 0.02, 0.05, 0.1, 0.2 })
+    {
+        replicaCoordinates.push_back(perturbedLattice(c_numPerDim, c_spacing, displacement));
+        put_atoms_in_box(PbcType::Xyz, box.legacyMatrix(), replicaCoordinates.back());
+    }
+    const int numParticles = replicaCoordinates.front().size();
+
+    std::vector<Vec3> zeros(numParticles, Vec3{ 0, 0, 0 });
+    SimulationState   simState(replicaCoordinates.front(), zeros, zeros, box,
+                             ArgonTopologyBuilder(numParticles).argonTopology());
+
+    BatchedForceCalculator batchedCalculator(simState, options, replicaCoordinates.size());
+    EXPECT_EQ(batchedCalculator.numReplicas(), int(replicaCoordinates.size()));
+
+    if (callUpdatePairLists)
+    {
+        batchedCalculator.updatePairLists(replicaCoordinates);
+    }
+    std::vector<std::vector<Vec3>> replicaForces(replicaCoordinates.size(), zeros);
+    batchedCalculator.compute(replicaCoordinates, replicaForces);
+
+    for (size_t replica = 0; replica < replicaCoordinates.size(); replica++)
+    {
+        simState.coordinates() = replicaCoordinates[replica];
+        ForceCalculator(simState, options).compute(simState.coordinates(), simState.forces());
+        expectForcesMatch(simState.forces(), replicaForces[replica], 1e-5);
+    }
+}
+
+TEST(BatchedForceCalculatorTest, ReplicaForcesMatchSeparateCalculators)
+{
+    auto options             = NBKernelOptions();
+    options.nbnxmSimd        = SimdKernels::SimdNo;
+    options.coulombType      = CoulombType::Cutoff;
+    options.numOpenMPThreads = 2;
+
+    checkReplicaForces(options, true);
+}
+
+TEST(BatchedForceCalculatorTest, ReplicaForcesMatchWithAutomaticPairlistUpdate)
+{
+    auto options                       = NBKernelOptions();
+    options.nbnxmSimd                  = SimdKernels::SimdNo;
+    options.coulombType                = CoulombType::Cutoff;
+    options.numOpenMPThreads           = 2;
+    options.useAutomaticPairlistUpdate = true;
+
+    checkReplicaForces(options, false);
+}
+
+TEST(BatchedForceCalculatorTest, RestoresThreadCounts)
+{
+    auto options             = NBKernelOptions();
+    options.nbnxmSimd        = SimdKernels::SimdNo;
+    options.coulombType      = CoulombType::Cutoff;
+    options.numOpenMPThreads = 2;
+
+    const Box         box(c_numPerDim * c_spacing);
+    std::vector<Vec3> coordinates = perturbedLattice(c_numPerDim, c_spacing, 0);
+    std::vector<Vec3> zeros(coordinates.size(), Vec3{ 0, 0, 0 });
+    SimulationState   simState(coordinates, zeros, zeros, box,
+                             ArgonTopologyBuilder(coordinates.size()).argonTopology());
+
+    BatchedForceCalculator batchedCalculator(simState, options, 2);
+
+    const int numPairsearchThreads = gmx_omp_nthreads_get(emntPairsearch);
+    const int numNonbondedThreads  = gmx_omp_nthreads_get(emntNonbonded);
+    gmx_omp_nthreads_set(emntPairsearch, 3);
+    gmx_omp_nthreads_set(emntNonbonded, 3);
+
+    std::vector<std::vector<Vec3>> replicaCoordinates(2, coordinates);
+    std::vector<std::vector<Vec3>> replicaForces(2, zeros);
+    batchedCalculator.updatePairLists(replicaCoordinates);
+    batchedCalculator.compute(replicaCoordinates, replicaForces);
+
+    EXPECT_EQ(3, gmx_omp_nthreads_get(emntPairsearch));
+    EXPECT_EQ(3, gmx_omp_nthreads_get(emntNonbonded));
+
+    gmx_omp_nthreads_set(emntPairsearch, numPairsearchThreads);
+    gmx_omp_nthreads_set(emntNonbonded, numNonbondedThreads);
+}
+
+TEST(BatchedForceCalculatorTest, ThrowsOnWrongNumberOfReplicas)
+{
+    auto options        = NBKernelOptions();
+    options.nbnxmSimd   = SimdKernels::SimdNo;
+    options.coulombType = CoulombType::Cutoff;
+
+    const Box         box(c_numPerDim * c_spacing);
+    std::vector<Vec3> coordinates = perturbedLattice(c_numPerDim, c_spacing, 0);
+    std::vector<Vec3> zeros(coordinates.size(), Vec3{ 0, 0, 0 });
+    SimulationState   simState(coordinates, zeros, zeros, box,
+                             ArgonTopologyBuilder(coordinates.size()).argonTopology());
+
+    EXPECT_THROW(BatchedForceCalculator(simState, options, 0), InputException);
+
+    BatchedForceCalculator batchedCalculator(simState, options, 2);
+
+    std::vector<std::vector<Vec3>> replicaCoordinates(1, coordinates);
+    std::vector<std::vector<Vec3>> replicaForces(1, zeros);
+    EXPECT_THROW(batchedCalculator.compute(replicaCoordinates, replicaForces), InputException);
+    EXPECT_THROW(batchedCalculator.updatePairLists(replicaCoordinates), InputException);
+}
+
+} // namespace
+} // namespace test
+} // namespace nblib
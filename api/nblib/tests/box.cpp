@@ -93,4 +93,32 @@ TEST(NBlibTest, CubicBoxWorks)
     }
 }
 
+TEST(NBlibTest, TriclinicBoxCannotHaveNaN)
+{
+    real number = NAN;
+    EXPECT_THROW(Box box(real(1.), real(1.), real(1.), number, real(90.), real(90.)), InputException);
+}
+
+TEST(NBlibTest, TriclinicBoxMustBeSupportedByGromacs)
+{
+    // The second box vector is tilted by more than half the first box vector
+    EXPECT_THROW(Box box(real(1.), real(1.), real(1.), real(90.), real(90.), real(45.)), InputException);
+}
+
+TEST(NBlibTest, TriclinicBoxWorks)
+{
+    real              length = 3;
+    real              height = length * std::sqrt(real(0.5));
+    Box::LegacyMatrix ref    = { { length, 0, 0 }, { 0, length, 0 }, { length / 2, length / 2, height } };
+    Box               test   = Box(length, length, length, 60, 60, 90);
+
+    for (int i = 0; i < dimSize; ++i)
+    {
+        for (int j = 0; j < dimSize; ++j)
+        {
+            EXPECT_REAL_EQ_TOL(ref[i][j], test.legacyMatrix()[i][j], defaultRealTolerance());
+        }
+    }
+}
+
 } // namespace nblib
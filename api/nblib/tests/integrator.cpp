@@ -44,9 +44,11 @@
  */
 #include "nblib/integrator.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "nblib/exception.h"
 #include "nblib/molecules.h"
 #include "nblib/particletype.h"
 #include "nblib/simulationstate.h"
+#include "nblib/tests/testsystems.h"
 #include "nblib/topology.h"
 #include "nblib/util/internal.h"
 
@@ -132,6 +134,106 @@ TEST(NBlibTest, IntegratorWorks)
     }
 }
 
+TEST(NBlibTest, ThreadedIntegratorMatchesReference)
+{
+    // Not a multiple of the SIMD width, so both the SIMD and the remainder loop are used
+    const int  numParticles = 37;
+    const real dt           = 0.002;
+    Topology   topology     = ArgonTopologyBuilder(numParticles).argonTopology();
+    Box        box(100);
+
+    std::vector<Vec3> x(numParticles), v(numParticles), f(numParticles);
+    for (int i = 0; i < numParticles; i++)
+    {
+        x[i] = Vec3(50.0 + 0.1 * i, 50.0 - 0.05 * i, 50.0 + 0.01 * i);
+        v[i] = Vec3(0.3 - 0.01 * i, 0.02 * i, -0.1);
+        f[i] = Vec3(1.0 * i, -2.0, 0.5 * (i % 5));
+    }
+
+    const real invMass = 1.0 / topology.getParticleTypes()[0].mass();
+
+    std::vector<Vec3> xReference(x), vReference(v);
+    for (int i = 0; i < numParticles; i++)
+    {
+        vReference[i] += f[i] * dt * invMass;
+        xReference[i] += vReference[i] * dt;
+    }
+
+    gmx::test::FloatingPointTolerance tolerance =
+            gmx::test::relativeToleranceAsFloatingPoint(1, 1e-6);
+    for (int numThreads : { 1, 3 })
+    {
+        std::vector<Vec3> xTest(x), vTest(v);
+        LeapFrog          integrator(topology, box, numThreads);
+        integrator.integrate(dt, xTest, vTest, f);
+        for (int i = 0; i < numParticles; i++)
+        {
+            for (int d = 0; d < dimSize; d++)
+            {
+                EXPECT_REAL_EQ_TOL(xReference[i][d], xTest[i][d], tolerance);
+                EXPECT_REAL_EQ_TOL(vReference[i][d], vTest[i][d], tolerance);
+            }
+        }
+    }
+}
+
+TEST(NBlibTest, IntegratorTemperatureCouplingScalesVelocities)
+{
+    const int  numParticles = 20;
+    const real dt           = 0.002;
+    const real couplingTime = 0.1;
+    const real referenceT   = 300;
+    Topology   topology     = ArgonTopologyBuilder(numParticles).argonTopology();
+    Box        box(100);
+
+    const real mass = topology.getParticleTypes()[0].mass();
+
+    std::vector<Vec3> x(numParticles, Vec3{ 1, 1, 1 });
+    std::vector<Vec3> v(numParticles);
+    std::vector<Vec3> f(numParticles, Vec3{ 0, 0, 0 });
+    for (int i = 0; i < numParticles; i++)
+    {
+        v[i] = Vec3((i % 2 == 0) ? 0.2 : -0.2, 0.1, -0.3);
+    }
+
+    double twiceKineticEnergy = 0;
+    for (const Vec3& velocity : v)
+    {
+        twiceKineticEnergy += mass * velocity.norm2();
+    }
+    const real temperature = twiceKineticEnergy / (dimSize * numParticles * BOLTZ);
+    const real lambda = std::sqrt(1.0 + (dt / couplingTime) * (referenceT / temperature - 1.0));
+    ASSERT_GT(lambda, 0.8);
+    ASSERT_LT(lambda, 1.25);
+
+    std::vector<Vec3> v0(v);
+    LeapFrog          integrator(topology, box, 2);
+    integrator.setTemperatureCoupling(referenceT, couplingTime);
+    integrator.integrate(dt, x, v, f);
+
+    gmx::test::FloatingPointTolerance tolerance =
+            gmx::test::relativeToleranceAsFloatingPoint(1, 1e-5);
+    for (int i = 0; i < numParticles; i++)
+    {
+        for (int d = 0; d < dimSize; d++)
+        {
+            EXPECT_REAL_EQ_TOL(lambda * v0[i][d], v[i][d], tolerance);
+        }
+    }
+}
+
+TEST(NBlibTest, IntegratorThrowsOnInvalidSettings)
+{
+    Topology topology = ArgonTopologyBuilder(4).argonTopology();
+    Box      box(10);
+
+    EXPECT_THROW(LeapFrog(topology, box, 0), InputException);
+
+    LeapFrog integrator(topology, box);
+    EXPECT_THROW(integrator.setTemperatureCoupling(300, 0), InputException);
+    EXPECT_THROW(integrator.setTemperatureCoupling(-1, 0.1), InputException);
+}
+
 } // namespace
 } // namespace test
 } // namespace nblib
@@ -0,0 +1,214 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * This implements tests of the listed forces calculator
+ */
+#include <cmath>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/utilities.h"
+#include "gromacs/math/vec.h"
+#include "nblib/bondtypes.h"
+#include "nblib/listedforcecalculator.h"
+#include "nblib/tests/testsystems.h"
+#include "nblib/topology.h"
+
+#include "testutils/testasserts.h"
+
+namespace nblib
+{
+namespace test
+{
+namespace
+{
+
+//! Returns a simulation state with a chain molecule of four particles with the listed interactions
+template<class... InteractionAdders>
+SimulationState chainSimulationState(const std::vector<Vec3>& coordinates, InteractionAdders&&... addInteractions)
+{
+    ArAtom       arAtom;
+    ParticleType Ar(arAtom.particleTypeName, arAtom.mass);
+
+    Molecule chain(MoleculeName("Chain"));
+    for (size_t i = 0; i < coordinates.size(); i++)
+    {
+        chain.addParticle(ParticleName("C" + std::to_string(i + 1)), Ar);
+    }
+    (addInteractions(chain), ...);
+
+    ParticleTypesInteractions interactions;
+    interactions.add(arAtom.particleTypeName, arAtom.c6, arAtom.c12);
+
+    TopologyBuilder topologyBuilder;
+    topologyBuilder.addMolecule(chain, 1);
+    topologyBuilder.addParticleTypesInteractions(interactions);
+
+    std::vector<Vec3> zeros(coordinates.size(), Vec3{ 0, 0, 0 });
+    return SimulationState(coordinates, zeros, zeros, Box(3.0), topologyBuilder.buildTopology());
+}
+
+//! Computes the listed forces of \p simState
+std::vector<Vec3> listedForces(SimulationState& simState, const NBKernelOptions& options = NBKernelOptions())
+{
+    ListedForceCalculator calculator(simState, options);
+    std::vector<Vec3>     forces(simState.coordinates().size(), Vec3{ 0, 0, 0 });
+    calculator.compute(simState.coordinates(), forces);
+    return forces;
+}
+
+//! Checks that \p forces match \p referenceForces
+void compareForces(const std::vector<Vec3>& referenceForces, const std::vector<Vec3>& forces)
+{
+    ASSERT_EQ(referenceForces.size(), forces.size());
+    for (size_t i = 0; i < forces.size(); i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(referenceForces[i][d], forces[i][d],
+                               gmx::test::relativeToleranceAsFloatingPoint(100, 1e-4));
+        }
+    }
+}
+
+TEST(NBlibTest, ListedForceCalculatorComputesBondForces)
+{
+    const HarmonicBondType bond(ForceConstant(1000), EquilibriumDistance(0.1));
+
+    auto simState = chainSimulationState({ { 1, 1, 1 }, { 1.2, 1, 1 } }, [&bond](Molecule& chain) {
+        chain.addInteraction(ParticleName("C1"), ParticleName("C2"), bond);
+    });
+
+    // The stretched bond pulls the particles together with force k (r - r0)
+    compareForces({ { 100, 0, 0 }, { -100, 0, 0 } }, listedForces(simState));
+}
+
+TEST(NBlibTest, ListedForceCalculatorUsesPeriodicImages)
+{
+    const HarmonicBondType bond(ForceConstant(1000), EquilibriumDistance(0.05));
+
+    // The particles are 0.1 apart over the periodic boundary in x
+    auto simState = chainSimulationState({ { 0.05, 1, 1 }, { 2.95, 1, 1 } }, [&bond](Molecule& chain) {
+        chain.addInteraction(ParticleName("C1"), ParticleName("C2"), bond);
+    });
+
+    compareForces({ { -50, 0, 0 }, { 50, 0, 0 } }, listedForces(simState));
+}
+
+TEST(NBlibTest, ListedForceCalculatorComputesAngleForces)
+{
+    const HarmonicAngleType angle(ForceConstant(100), Degrees(60));
+
+    // A right angle with arms of length 0.1 at particle C2
+    auto simState = chainSimulationState({ { 1.1, 1, 1 }, { 1, 1, 1 }, { 1, 1.1, 1 } },
+                                         [&angle](Molecule& chain) {
+                                             chain.addInteraction(ParticleName("C1"), ParticleName("C2"),
+                                                                  ParticleName("C3"), angle);
+                                         });
+
+    // The arms are pushed towards each other with force k (theta - theta0) / r
+    const real f = 100 * (M_PI / 2 - M_PI / 3) / 0.1;
+    compareForces({ { 0, f, 0 }, { -f, -f, 0 }, { f, 0, 0 } }, listedForces(simState));
+}
+
+TEST(NBlibTest, ListedForceCalculatorComputesDihedralForces)
+{
+    const ProperDihedralType dihedral(Degrees(0), ForceConstant(10), Multiplicity(1));
+    const auto               addDihedral = [&dihedral](Molecule& chain) {
+        chain.addInteraction(ParticleName("C1"), ParticleName("C2"), ParticleName("C3"),
+                             ParticleName("C4"), dihedral);
+    };
+
+    // A trans dihedral is at the minimum of the potential, so there are no forces
+    auto transState = chainSimulationState(
+            { { 1, 1.1, 1 }, { 1, 1, 1 }, { 1.1, 1, 1 }, { 1.1, 0.9, 1 } }, addDihedral);
+    compareForces(std::vector<Vec3>(4, Vec3{ 0, 0, 0 }), listedForces(transState));
+
+    // At a dihedral of 90 degrees, the outer particles feel a torque of k,
+    // i.e. forces of k divided by their distance from the central bond
+    auto gaucheState = chainSimulationState(
+            { { 1, 1.1, 1 }, { 1, 1, 1 }, { 1.1, 1, 1 }, { 1.1, 1, 1.1 } }, addDihedral);
+    std::vector<Vec3> forces = listedForces(gaucheState);
+
+    EXPECT_REAL_EQ_TOL(10 / 0.1, norm(forces[0]), gmx::test::relativeToleranceAsFloatingPoint(100, 1e-4));
+    EXPECT_REAL_EQ_TOL(10 / 0.1, norm(forces[3]), gmx::test::relativeToleranceAsFloatingPoint(100, 1e-4));
+    Vec3 netForce = forces[0] + forces[1] + forces[2] + forces[3];
+    compareForces({ { 0, 0, 0 } }, { netForce });
+}
+
+TEST(NBlibTest, ListedForceCalculatorAddsToForces)
+{
+    const HarmonicBondType bond(ForceConstant(1000), EquilibriumDistance(0.1));
+
+    auto simState = chainSimulationState({ { 1, 1, 1 }, { 1.2, 1, 1 } }, [&bond](Molecule& chain) {
+        chain.addInteraction(ParticleName("C1"), ParticleName("C2"), bond);
+    });
+
+    ListedForceCalculator calculator(simState, NBKernelOptions());
+    std::vector<Vec3>     forces = { { 1, 2, 3 }, { 4, 5, 6 } };
+    calculator.compute(simState.coordinates(), forces);
+
+    compareForces({ { 101, 2, 3 }, { -96, 5, 6 } }, forces);
+}
+
+TEST(NBlibTest, ListedForceCalculatorForcesDoNotDependOnThreads)
+{
+    const HarmonicBondType   bond(ForceConstant(1000), EquilibriumDistance(0.1));
+    const HarmonicAngleType  angle(ForceConstant(100), Degrees(110));
+    const ProperDihedralType dihedral(Degrees(0), ForceConstant(10), Multiplicity(3));
+
+    auto simState = chainSimulationState(
+            { { 1, 1.1, 1 }, { 1, 1, 1 }, { 1.12, 1, 1 }, { 1.1, 0.95, 1.1 } },
+            [&](Molecule& chain) {
+                chain.addInteraction(ParticleName("C1"), ParticleName("C2"), bond);
+                chain.addInteraction(ParticleName("C2"), ParticleName("C3"), bond);
+                chain.addInteraction(ParticleName("C3"), ParticleName("C4"), bond);
+                chain.addInteraction(ParticleName("C1"), ParticleName("C2"), ParticleName("C3"), angle);
+                chain.addInteraction(ParticleName("C2"), ParticleName("C3"), ParticleName("C4"), angle);
+                chain.addInteraction(ParticleName("C1"), ParticleName("C2"), ParticleName("C3"),
+                                     ParticleName("C4"), dihedral);
+            });
+
+    NBKernelOptions threadedOptions;
+    threadedOptions.numOpenMPThreads = 2;
+
+    compareForces(listedForces(simState), listedForces(simState, threadedOptions));
+}
+
+} // namespace
+} // namespace test
+} // namespace nblib
@@ -206,6 +206,42 @@ TEST(NBlibTest, MoleculeNoThrowsSameParticleTypeName)
     EXPECT_NO_THROW(molecule.addParticle(ParticleName("U2"), atom2));
 }
 
+TEST(NBlibTest, CanConstructListedInteractionsFromNames)
+{
+    WaterMoleculeBuilder waterMolecule;
+    Molecule             water = waterMolecule.waterMolecule();
+
+    HarmonicBondType  bond(ForceConstant(345000), EquilibriumDistance(0.1));
+    HarmonicAngleType angle(ForceConstant(383), Degrees(109.47));
+    water.addInteraction(ParticleName("Oxygen"), ParticleName("H1"), bond);
+    water.addInteraction(ParticleName("Oxygen"), ResidueName("SOL"), ParticleName("H2"),
+                         ResidueName("SOL"), bond);
+    water.addInteraction(ParticleName("H1"), ParticleName("Oxygen"), ParticleName("H2"), angle);
+
+    ListedInteractionData interactions = water.getListedInteractions();
+
+    // Bonds with identical parameters share them
+    ASSERT_EQ(interactions.harmonicBonds.size(), 2);
+    ASSERT_EQ(interactions.harmonicBonds.parameters.size(), 1);
+    EXPECT_EQ(interactions.harmonicBonds.parameters[0], bond);
+    EXPECT_EQ(interactions.harmonicBonds.particleIndices[0], (std::array<int, 2>{ 0, 1 }));
+    EXPECT_EQ(interactions.harmonicBonds.particleIndices[1], (std::array<int, 2>{ 0, 2 }));
+
+    ASSERT_EQ(interactions.harmonicAngles.size(), 1);
+    EXPECT_EQ(interactions.harmonicAngles.particleIndices[0], (std::array<int, 3>{ 1, 0, 2 }));
+    EXPECT_EQ(interactions.properDihedrals.size(), 0);
+}
+
+TEST(NBlibTest, ListedInteractionWithUnknownParticleThrows)
+{
+    WaterMoleculeBuilder waterMolecule;
+    Molecule             water = waterMolecule.waterMolecule();
+
+    water.addInteraction(ParticleName("Oxygen"), ParticleName("H3"),
+                         HarmonicBondType(ForceConstant(345000), EquilibriumDistance(0.1)));
+    EXPECT_THROW(water.getListedInteractions(), InputException);
+}
+
 } // namespace
 } // namespace test
 } // namespace nblib
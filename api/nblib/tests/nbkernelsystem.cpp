@@ -42,9 +42,17 @@
  * \author Sebastian Keller <keller@cscs.ch>
  * \author Artem Zhmurov <zhmurov@gmail.com>
  */
+#include <cmath>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include "gromacs/ewald/ewald_utils.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/pbcutil/pbc.h"
 #include "gromacs/topology/exclusionblocks.h"
+#include "nblib/exception.h"
 #include "nblib/forcecalculator.h"
 #include "nblib/gmxsetup.h"
 #include "nblib/integrator.h"
@@ -52,6 +60,8 @@
 #include "nblib/tests/testsystems.h"
 #include "nblib/topology.h"
 
+#include "testutils/testasserts.h"
+
 namespace nblib
 {
 namespace test
@@ -202,6 +212,464 @@ TEST(NBlibTest, ArgonForcesAreCorrect)
     forcesOutputTest.testVectors(testForces, "Argon forces");
 }
 
+TEST(NBlibTest, ArgonForcesAreCorrectInTriclinicBox)
+{
+    auto options        = NBKernelOptions();
+    options.nbnxmSimd   = SimdKernels::SimdNo;
+    options.coulombType = CoulombType::Cutoff;
+
+    // A rhombic dodecahedron small enough that most pairs interact across its faces
+    ArgonSimulationStateBuilder argonSystemBuilder;
+    argonSystemBuilder.box() = Box(4, 4, 4, 60, 60, 90);
+
+    auto simState        = argonSystemBuilder.setupSimulationState();
+    auto forceCalculator = ForceCalculator(simState, options);
+
+    gmx::ArrayRef<Vec3> testForces(simState.forces());
+    forceCalculator.compute(simState.coordinates(), simState.forces());
+
+    // Reference forces from all pairs with the minimum image convention
+    const ArAtom             argon;
+    const real               cutoff2 = options.pairlistCutoff * options.pairlistCutoff;
+    const std::vector<Vec3>& x       = simState.coordinates();
+    std::vector<Vec3>        referenceForces(x.size(), Vec3{ 0, 0, 0 });
+    t_pbc                    pbc;
+    set_pbc(&pbc, PbcType::Xyz, simState.box().legacyMatrix());
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        for (size_t j = 0; j < x.size(); j++)
+        {
+            Vec3 dx;
+            pbc_dx_aiuc(&pbc, x[i], x[j], dx);
+            const real r2 = norm2(dx);
+            if (i != j && r2 < cutoff2)
+            {
+                const real rinv6 = 1 / (r2 * r2 * r2);
+                referenceForces[i] += (12 * argon.c12 * rinv6 - 6 * argon.c6) * rinv6 / r2 * dx;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        for (int d = 0; d < dimSize; d++)
+        {
+            EXPECT_REAL_EQ_TOL(referenceForces[i][d], testForces[i][d],
+                               gmx::test::relativeToleranceAsFloatingPoint(referenceForces[i][d], 1e-4));
+        }
+    }
+}
+
+TEST(NBlibTest, AutomaticPairlistUpdateNeedsBuffer)
+{
+    auto options                       = NBKernelOptions();
+    options.nbnxmSimd                  = SimdKernels::SimdNo;
+    options.useAutomaticPairlistUpdate = true;
+    options.pairlistBuffer             = 0;
+
+    SpcMethanolSimulationStateBuilder spcMethanolSystemBuilder;
+
+    auto simState = spcMethanolSystemBuilder.setupSimulationState();
+    EXPECT_THROW(ForceCalculator(simState, options), InputException);
+}
+
+/*!
+ * Particles on a lattice are moved by increasing distances, so that the pairlist
+ * of the calculator with automatic updates is first kept, then pruned and finally
+ * rebuilt. The forces should match those of a calculator set up from scratch.
+ */
+TEST(NBlibTest, AutomaticPairlistUpdateGivesFreshForces)
+{
+    auto options        = NBKernelOptions();
+    options.nbnxmSimd   = SimdKernels::SimdNo;
+    options.coulombType = CoulombType::Cutoff;
+
+    auto automaticOptions                       = options;
+    automaticOptions.useAutomaticPairlistUpdate = true;
+
+    constexpr int  numPerDim = 5;
+    constexpr real spacing   = 0.6;
+    const Box      box(numPerDim * spacing);
+
+    const std::vector<Vec3> startCoordinates = perturbedLattice(numPerDim, spacing, 0);
+    std::vector<Vec3>       zeros(startCoordinates.size(), Vec3{ 0, 0, 0 });
+    SimulationState         simState(startCoordinates, zeros, zeros, box,
+                                     ArgonTopologyBuilder(startCoordinates.size()).argonTopology());
+
+    auto automaticCalculator = ForceCalculator(simState, automaticOptions);
+
+    // The first computation prunes the list. With the default buffer of 0.1 nm, the list is
+    // then pruned when a particle moved 0.0125 nm and rebuilt when a particle moved 0.05 nm.
+    // The displacement of a particle is between 1 and sqrt(2) times the displacement factor.
+    struct ExpectedUpdate
+    {
+        real displacement;
+        bool prune;
+        bool rebuild;
+    };
+    for (const ExpectedUpdate& expected : { ExpectedUpdate{ 0, true, false },
+                                            ExpectedUpdate{ 0.005, false, false },
+                                            ExpectedUpdate{ 0.02, true, false },
+                                            ExpectedUpdate{ 0.04, true, true },
+                                            ExpectedUpdate{ 0.15, true, true } })
+    {
+        std::vector<Vec3>& x = simState.coordinates();
+        x                    = perturbedLattice(numPerDim, spacing, expected.displacement);
+        put_atoms_in_box(PbcType::Xyz, box.legacyMatrix(), x);
+
+        const int64_t numRebuilds = automaticCalculator.numPairlistRebuilds();
+        const int64_t numPrunes   = automaticCalculator.numPairlistPrunes();
+
+        std::vector<Vec3> automaticForces(x.size());
+        automaticCalculator.compute(x, automaticForces);
+
+        EXPECT_EQ(expected.rebuild, automaticCalculator.numPairlistRebuilds() > numRebuilds)
+                << "for displacement " << expected.displacement;
+        EXPECT_EQ(expected.prune, automaticCalculator.numPairlistPrunes() > numPrunes)
+                << "for displacement " << expected.displacement;
+
+        ForceCalculator(simState, options).compute(x, simState.forces());
+        expectForcesMatch(simState.forces(), automaticForces, 1e-5);
+    }
+}
+
+/*!
+ * A lattice of particles with alternating charges is displaced, so that many pairs are
+ * within the cut-off and interact over periodic boundaries. The energies and the virial
+ * should match sums over all pairs within the cut-off.
+ */
+TEST(NBlibTest, EnergiesAndVirialMatchPairSums)
+{
+    auto options        = NBKernelOptions();
+    options.nbnxmSimd   = SimdKernels::SimdNo;
+    options.coulombType = CoulombType::Cutoff;
+
+    constexpr int  numPerDim = 4;
+    constexpr real spacing   = 0.6;
+    constexpr real charge    = 0.5;
+    const Box      box(numPerDim * spacing);
+
+    ArAtom         arAtom;
+    constexpr int  numParticles = numPerDim * numPerDim * numPerDim;
+    const Topology topology =
+            chargedLatticeTopology(numParticles, charge, arAtom.c6, arAtom.c12);
+
+    std::vector<Vec3> coordinates = perturbedLattice(numPerDim, spacing, 0.1);
+    put_atoms_in_box(PbcType::Xyz, box.legacyMatrix(), coordinates);
+
+    std::vector<Vec3> zeros(numParticles, Vec3{ 0, 0, 0 });
+    SimulationState   simState(coordinates, zeros, zeros, box, topology);
+    ForceCalculator   forceCalculator(simState, options);
+
+    std::vector<Vec3>          forces(numParticles);
+    NonBondedEnergiesAndVirial energiesAndVirial =
+            forceCalculator.computeEnergiesAndVirial(coordinates, forces);
+
+    // Sum over all pairs with the minimum image convention, the box is larger than twice the cut-off
+    const real cutoff = options.pairlistCutoff;
+    const real c6     = arAtom.c6;
+    const real c12    = arAtom.c12;
+    t_pbc      pbc;
+    set_pbc(&pbc, PbcType::Xyz, box.legacyMatrix());
+
+    double ljEnergy         = 0;
+    double coulombEnergy    = 0;
+    double virial[DIM][DIM] = { { 0 } };
+    double virialScale      = 0;
+    for (int i = 0; i < numParticles; i++)
+    {
+        for (int j = i + 1; j < numParticles; j++)
+        {
+            rvec dx;
+            pbc_dx(&pbc, coordinates[i], coordinates[j], dx);
+            const real r2 = norm2(dx);
+            if (r2 >= cutoff * cutoff)
+            {
+                continue;
+            }
+            const real   r       = std::sqrt(r2);
+            const real   qq      = ONE_4PI_EPS0 * topology.getCharges()[i] * topology.getCharges()[j];
+            const double rinv6   = 1.0 / gmx::power6(r);
+            const double ljShift = c12 / gmx::power12(cutoff) - c6 / gmx::power6(cutoff);
+
+            ljEnergy += c12 * rinv6 * rinv6 - c6 * rinv6 - ljShift;
+            // With epsilon_rf = 1 the reaction-field correction only shifts the potential
+            coulombEnergy += qq * (1 / r - 1 / cutoff);
+
+            // The scalar force divided by r, acting along dx on particle i
+            const double fScal = (12 * c12 * rinv6 * rinv6 - 6 * c6 * rinv6) / r2 + qq / (r2 * r);
+            for (int d = 0; d < DIM; d++)
+            {
+                for (int n = 0; n < DIM; n++)
+                {
+                    virial[d][n] -= 0.5 * dx[d] * fScal * dx[n];
+                }
+            }
+            virialScale = std::max(virialScale, std::abs(0.5 * fScal * r2));
+        }
+    }
+
+    // As in mdrun, the kernels include the reaction-field self-interaction of each particle
+    for (int i = 0; i < numParticles; i++)
+    {
+        coulombEnergy -= 0.5 * ONE_4PI_EPS0 * gmx::square(topology.getCharges()[i]) / cutoff;
+    }
+
+    EXPECT_REAL_EQ_TOL(ljEnergy, energiesAndVirial.ljEnergy,
+                       gmx::test::relativeToleranceAsFloatingPoint(ljEnergy, 1e-4));
+    EXPECT_REAL_EQ_TOL(coulombEnergy, energiesAndVirial.coulombEnergy,
+                       gmx::test::relativeToleranceAsFloatingPoint(coulombEnergy, 1e-4));
+    for (int d = 0; d < DIM; d++)
+    {
+        for (int n = 0; n < DIM; n++)
+        {
+            EXPECT_REAL_EQ_TOL(virial[d][n], energiesAndVirial.virial[d][n],
+                               gmx::test::relativeToleranceAsFloatingPoint(virialScale, 1e-4));
+        }
+    }
+
+    // The forces are the same as those computed without energies and virial
+    std::vector<Vec3> referenceForces(numParticles);
+    forceCalculator.compute(coordinates, referenceForces);
+    for (int i = 0; i < numParticles; i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(referenceForces[i][d], forces[i][d], gmx::test::defaultRealTolerance());
+        }
+    }
+}
+
+/*! \brief Returns the Ewald energy of point charges and adds their Ewald forces to \p forces
+ *
+ * Computes the real-space sum within \p cutoff, the reciprocal-space sum over all wave vectors
+ * with components up to \p maxWaveNumber times 2 pi / box size, and the self-energy.
+ */
+double ewaldSum(gmx::ArrayRef<const Vec3> coordinates,
+                gmx::ArrayRef<const real> charges,
+                real                      boxSize,
+                real                      cutoff,
+                real                      ewaldCoeff,
+                int                       maxWaveNumber,
+                std::vector<gmx::DVec>*   forces)
+{
+    const int    numParticles = coordinates.size();
+    const double beta         = ewaldCoeff;
+    const double volume       = gmx::power3(double(boxSize));
+
+    double energy = 0;
+    for (int i = 0; i < numParticles; i++)
+    {
+        energy -= ONE_4PI_EPS0 * beta * M_2_SQRTPI * 0.5 * gmx::square(charges[i]);
+
+        for (int j = i + 1; j < numParticles; j++)
+        {
+            gmx::DVec dx;
+            for (int d = 0; d < DIM; d++)
+            {
+                dx[d] = coordinates[i][d] - coordinates[j][d];
+                dx[d] -= boxSize * std::round(dx[d] / boxSize);
+            }
+            const double r = norm(dx);
+            if (r >= cutoff)
+            {
+                continue;
+            }
+            const double qq = ONE_4PI_EPS0 * charges[i] * charges[j];
+            energy += qq * std::erfc(beta * r) / r;
+            const double fScal = qq
+                                 * (std::erfc(beta * r) / r
+                                    + beta * M_2_SQRTPI * std::exp(-gmx::square(beta * r)))
+                                 / gmx::square(r);
+            (*forces)[i] += fScal * dx;
+            (*forces)[j] -= fScal * dx;
+        }
+    }
+
+    const double waveNumberUnit = 2 * M_PI / boxSize;
+    for (int kx = -maxWaveNumber; kx <= maxWaveNumber; kx++)
+    {
+        for (int ky = -maxWaveNumber; ky <= maxWaveNumber; ky++)
+        {
+            for (int kz = -maxWaveNumber; kz <= maxWaveNumber; kz++)
+            {
+                if (kx == 0 && ky == 0 && kz == 0)
+                {
+                    continue;
+                }
+                const gmx::DVec k      = waveNumberUnit * gmx::DVec(kx, ky, kz);
+                const double    k2     = norm2(k);
+                const double    factor = 4 * M_PI / k2 * std::exp(-k2 / (4 * gmx::square(beta)));
+
+                // The structure factor
+                double sCos = 0;
+                double sSin = 0;
+                for (int i = 0; i < numParticles; i++)
+                {
+                    const double kx_i = k.dot(coordinates[i].toDVec());
+                    sCos += charges[i] * std::cos(kx_i);
+                    sSin += charges[i] * std::sin(kx_i);
+                }
+                energy += ONE_4PI_EPS0 / (2 * volume) * factor * (sCos * sCos + sSin * sSin);
+
+                for (int i = 0; i < numParticles; i++)
+                {
+                    const double kx_i = k.dot(coordinates[i].toDVec());
+                    // Im[exp(i k x_i) S*(k)]
+                    const double imaginary = std::sin(kx_i) * sCos - std::cos(kx_i) * sSin;
+                    (*forces)[i] += (ONE_4PI_EPS0 / volume * factor * charges[i] * imaginary) * k;
+                }
+            }
+        }
+    }
+
+    return energy;
+}
+
+/*!
+ * The complete PME electrostatics of a displaced lattice of particles with alternating
+ * charges should match a converged Ewald summation.
+ */
+TEST(NBlibTest, PmeMeshGivesEwaldSum)
+{
+    // The PME settings are finer than the defaults, so the PME error is well below the tolerance
+    auto options              = NBKernelOptions();
+    options.nbnxmSimd         = SimdKernels::SimdNo;
+    options.coulombType       = CoulombType::Pme;
+    options.usePmeMesh        = true;
+    options.pmeOrder          = 5;
+    options.pmeFourierSpacing = 0.08;
+
+    constexpr int  numPerDim = 4;
+    constexpr real spacing   = 0.6;
+    constexpr real charge    = 0.5;
+    constexpr real boxSize   = numPerDim * spacing;
+    const Box      box(boxSize);
+
+    // Only the electrostatics are tested
+    constexpr int  numParticles = numPerDim * numPerDim * numPerDim;
+    const Topology topology     = chargedLatticeTopology(numParticles, charge, C6(0), C12(0));
+
+    // The first half of the particles is positive, place them on alternating lattice sites
+    const std::vector<Vec3> lattice = perturbedLattice(numPerDim, spacing, 0.05);
+    std::vector<Vec3>       coordinates(numParticles);
+    int                     numPositive = 0;
+    int                     numNegative = 0;
+    for (int i = 0; i < numParticles; i++)
+    {
+        const int x     = i / (numPerDim * numPerDim);
+        const int y     = (i / numPerDim) % numPerDim;
+        const int z     = i % numPerDim;
+        const int index = ((x + y + z) % 2 == 0) ? numPositive++ : numParticles / 2 + numNegative++;
+
+        coordinates[index] = lattice[i];
+    }
+
+    std::vector<Vec3> zeros(numParticles, Vec3{ 0, 0, 0 });
+    SimulationState   simState(coordinates, zeros, zeros, box, topology);
+    ForceCalculator   forceCalculator(simState, options);
+
+    std::vector<Vec3>          forces(numParticles);
+    NonBondedEnergiesAndVirial energiesAndVirial =
+            forceCalculator.computeEnergiesAndVirial(coordinates, forces);
+
+    std::vector<gmx::DVec> referenceForces(numParticles, gmx::DVec{ 0, 0, 0 });
+    const double           referenceEnergy =
+            ewaldSum(coordinates, topology.getCharges(), boxSize, options.pairlistCutoff,
+                     calc_ewaldcoeff_q(options.pairlistCutoff, 1e-5), 10, &referenceForces);
+
+    // The accuracy is limited by the PME grid spacing and interpolation order
+    EXPECT_REAL_EQ_TOL(referenceEnergy, energiesAndVirial.coulombEnergy,
+                       gmx::test::relativeToleranceAsFloatingPoint(referenceEnergy, 1e-3));
+
+    std::vector<Vec3> ewaldForces;
+    for (const gmx::DVec& force : referenceForces)
+    {
+        ewaldForces.push_back(force.toRVec());
+    }
+    expectForcesMatch(ewaldForces, forces, 1e-3);
+
+    // Without the mesh, the forces differ from the Ewald sum
+    options.usePmeMesh = false;
+    std::vector<Vec3> shortRangeForces(numParticles);
+    ForceCalculator(simState, options).compute(coordinates, shortRangeForces);
+    real maxDifference = 0;
+    for (int i = 0; i < numParticles; i++)
+    {
+        maxDifference = std::max(maxDifference, norm(shortRangeForces[i] - forces[i]));
+    }
+    EXPECT_GT(maxDifference, 0.05 * maxForceNorm(ewaldForces));
+}
+
+TEST(NBlibTest, PmeMeshNeedsPme)
+{
+    auto options        = NBKernelOptions();
+    options.nbnxmSimd   = SimdKernels::SimdNo;
+    options.coulombType = CoulombType::ReactionField;
+    options.usePmeMesh  = true;
+
+    ArgonSimulationStateBuilder argonSystemBuilder;
+    SimulationState             simState = argonSystemBuilder.setupSimulationState();
+    EXPECT_THROW(ForceCalculator(simState, options), InputException);
+}
+
+TEST(NBlibTest, GridOrderedForcesMatchParticleOrder)
+{
+    auto options      = NBKernelOptions();
+    options.nbnxmSimd = SimdKernels::SimdNo;
+
+    SpcMethanolSimulationStateBuilder spcMethanolSystemBuilder;
+
+    SimulationState simState        = spcMethanolSystemBuilder.setupSimulationState();
+    ForceCalculator forceCalculator = ForceCalculator(simState, options);
+
+    std::vector<Vec3> forces(simState.topology().numParticles());
+    forceCalculator.compute(simState.coordinates(), forces);
+
+    gmx::ArrayRef<const int> gridOrder = forceCalculator.gridOrder();
+    std::vector<Vec3>        gridCoordinates(gridOrder.size(), Vec3{ 0, 0, 0 });
+    for (size_t g = 0; g < gridOrder.size(); g++)
+    {
+        if (gridOrder[g] >= 0)
+        {
+            gridCoordinates[g] = simState.coordinates()[gridOrder[g]];
+        }
+    }
+
+    // The grid ordered forces overwrite the buffer, including the filler positions
+    std::vector<Vec3> gridForces(gridOrder.size(), Vec3{ 1, 1, 1 });
+    forceCalculator.computeInGridOrder(gridCoordinates, gridForces);
+
+    gmx::test::FloatingPointTolerance tolerance = gmx::test::relativeToleranceAsFloatingPoint(1, 1e-5);
+    for (size_t g = 0; g < gridOrder.size(); g++)
+    {
+        const Vec3 reference = gridOrder[g] >= 0 ? forces[gridOrder[g]] : Vec3{ 0, 0, 0 };
+        for (int d = 0; d < dimSize; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference[d], gridForces[g][d], tolerance);
+        }
+    }
+
+    std::vector<Vec3> tooFewForces(gridOrder.size() - 1);
+    EXPECT_THROW(forceCalculator.computeInGridOrder(gridCoordinates, tooFewForces), InputException);
+}
+
+TEST(NBlibTest, GridOrderedForcesNeedFixedPairlist)
+{
+    auto options                       = NBKernelOptions();
+    options.nbnxmSimd                  = SimdKernels::SimdNo;
+    options.coulombType                = CoulombType::Cutoff;
+    options.useAutomaticPairlistUpdate = true;
+
+    ArgonSimulationStateBuilder argonSystemBuilder;
+    SimulationState             simState = argonSystemBuilder.setupSimulationState();
+    ForceCalculator             forceCalculator(simState, options);
+
+    std::vector<Vec3> gridCoordinates(forceCalculator.gridOrder().size(), Vec3{ 0, 0, 0 });
+    std::vector<Vec3> gridForces(gridCoordinates.size());
+    EXPECT_THROW(forceCalculator.computeInGridOrder(gridCoordinates, gridForces), InputException);
+}
+
 } // namespace
 } // namespace test
 } // namespace nblib
@@ -43,6 +43,8 @@
  */
 #include "nblib/tests/testhelpers.h"
 
+#include <algorithm>
+
 namespace nblib
 {
 namespace test
@@ -66,5 +68,33 @@ bool operator==(const Box& a, const Box& b)
     return true;
 }
 
+real maxForceNorm(gmx::ArrayRef<const Vec3> forces)
+{
+    real forceScale = 0;
+    for (const Vec3& force : forces)
+    {
+        forceScale = std::max(forceScale, norm(force));
+    }
+    return forceScale;
+}
+
+void expectForcesMatch(gmx::ArrayRef<const Vec3> referenceForces,
+                       gmx::ArrayRef<const Vec3> forces,
+                       const double              relativeTolerance)
+{
+    ASSERT_EQ(referenceForces.size(), forces.size());
+
+    const real forceScale = maxForceNorm(referenceForces);
+    const auto tolerance  = gmx::test::relativeToleranceAsFloatingPoint(forceScale, relativeTolerance);
+    for (size_t i = 0; i < referenceForces.size(); i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(referenceForces[i][d], forces[i][d], tolerance)
+                    << "for particle " << i << ", dimension " << d;
+        }
+    }
+}
+
 } // namespace test
 } // namespace nblib
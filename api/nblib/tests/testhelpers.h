@@ -61,6 +61,19 @@ namespace test
 //! Compare between two instances of the Box object
 bool operator==(const Box& a, const Box& b);
 
+//! Returns the largest norm of the \p forces
+real maxForceNorm(gmx::ArrayRef<const Vec3> forces);
+
+/*! \brief Expects that \p forces match \p referenceForces
+ *
+ * The tolerance is \p relativeTolerance times the largest reference force, so that
+ * small forces that result from cancellations are not compared with a tighter tolerance
+ * than the computation can provide.
+ */
+void expectForcesMatch(gmx::ArrayRef<const Vec3> referenceForces,
+                       gmx::ArrayRef<const Vec3> forces,
+                       double                    relativeTolerance);
+
 /*! \internal \brief
  *  Simple test harness for checking 3D vectors like coordinates, velocities,
  *  forces against reference data
@@ -104,6 +104,45 @@ private:
     std::map<ParticleTypeName, C12>          c12_;
 };
 
+std::vector<Vec3> perturbedLattice(const int numPerDim, const real spacing, const real displacement)
+{
+    std::vector<Vec3> coordinates;
+    for (int i = 0; i < numPerDim * numPerDim * numPerDim; i++)
+    {
+        const Vec3 latticePoint = spacing
+                                  * Vec3{ i / (numPerDim * numPerDim) + real(0.5),
+                                          (i / numPerDim) % numPerDim + real(0.5),
+                                          i % numPerDim + real(0.5) };
+        const Vec3 direction = { std::sin(real(i)), std::cos(real(i)), std::sin(real(2 * i)) };
+        coordinates.push_back(latticePoint + displacement * direction);
+    }
+
+    return coordinates;
+}
+
+Topology chargedLatticeTopology(const int  numParticles,
+                                const real charge,
+                                const C6   c6,
+                                const C12  c12)
+{
+    ArAtom       arAtom;
+    ParticleType argon(arAtom.particleTypeName, arAtom.mass);
+    Molecule     positive(MoleculeName("Positive"));
+    positive.addParticle(ParticleName("P"), Charge(charge), argon);
+    Molecule negative(MoleculeName("Negative"));
+    negative.addParticle(ParticleName("N"), Charge(-charge), argon);
+
+    ParticleTypesInteractions interactions;
+    interactions.add(arAtom.particleTypeName, c6, c12);
+
+    TopologyBuilder topologyBuilder;
+    topologyBuilder.addMolecule(positive, numParticles / 2);
+    topologyBuilder.addMolecule(negative, numParticles / 2);
+    topologyBuilder.addParticleTypesInteractions(interactions);
+
+    return topologyBuilder.buildTopology();
+}
+
 std::unordered_map<std::string, Charge> Charges{ { "Ow", Charge(-0.82) },
                                                  { "Hw", Charge(+0.41) },
                                                  { "OMet", Charge(-0.574) },
@@ -46,6 +46,7 @@
 #define NBLIB_TESTSYSTEMS_H
 
 #include <cmath>
+#include <vector>
 
 #include "nblib/box.h"
 #include "nblib/molecules.h"
@@ -56,6 +57,22 @@
 namespace nblib
 {
 
+/*! \brief Returns the coordinates of a cubic lattice of numPerDim^3 displaced particles
+ *
+ * The lattice points are at the centres of cubic cells with edge \p spacing, numbered with z
+ * running fastest. Particle i is displaced from its lattice point by \p displacement times
+ * (sin i, cos i, sin 2i), so the displacements differ in length and direction between
+ * particles, but are reproducible. The coordinates are not put in the box.
+ */
+std::vector<Vec3> perturbedLattice(int numPerDim, real spacing, real displacement);
+
+/*! \brief Returns the topology of numParticles argon particles with charges of alternating sign
+ *
+ * The first half of the particles have charge \p charge, the second half -\p charge.
+ * All particles interact with the Lennard-Jones parameters \p c6 and \p c12.
+ */
+Topology chargedLatticeTopology(int numParticles, real charge, C6 c6, C12 c12);
+
 //! \internal \brief Parameters from gromos43A1
 struct ArAtom
 {
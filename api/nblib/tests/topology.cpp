@@ -221,6 +221,31 @@ TEST(NBlibTest, toGmxExclusionBlockWorks)
     }
 }
 
+TEST(NBlibTest, TopologyHasListedInteractions)
+{
+    WaterMoleculeBuilder waterMolecule;
+    Molecule             water = waterMolecule.waterMolecule();
+    water.addInteraction(ParticleName("Oxygen"), ParticleName("H1"),
+                         HarmonicBondType(ForceConstant(345000), EquilibriumDistance(0.1)));
+
+    // The nonbonded parameters are irrelevant here
+    ParticleTypesInteractions interactions;
+    interactions.add(ParticleTypeName("Ow"), C6(0), C12(0));
+    interactions.add(ParticleTypeName("H"), C6(0), C12(0));
+
+    TopologyBuilder topologyBuilder;
+    topologyBuilder.addMolecule(water, 2);
+    topologyBuilder.addParticleTypesInteractions(interactions);
+    Topology topology = topologyBuilder.buildTopology();
+
+    // The bonds of the second molecule are offset by the size of the first
+    ListedInteractionData listedInteractions = topology.getListedInteractions();
+    ASSERT_EQ(listedInteractions.harmonicBonds.size(), 2);
+    EXPECT_EQ(listedInteractions.harmonicBonds.parameters.size(), 1);
+    EXPECT_EQ(listedInteractions.harmonicBonds.particleIndices[0], (std::array<int, 2>{ 0, 1 }));
+    EXPECT_EQ(listedInteractions.harmonicBonds.particleIndices[1], (std::array<int, 2>{ 3, 4 }));
+}
+
 } // namespace
 } // namespace test
 } // namespace nblib
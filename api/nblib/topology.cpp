@@ -100,6 +100,50 @@ gmx::ListOfLists<int> TopologyBuilder::createExclusionsListOfLists() const
     return exclusionsListOfListsGlobal;
 }
 
+//! Adds the interactions of one molecule to \p list, with particle indices offset by \p particleOffset
+template<class InteractionType>
+static void appendListedInteractions(const ListedInteractionList<InteractionType>& moleculeList,
+                                     const int                                     particleOffset,
+                                     ListedInteractionList<InteractionType>*       list)
+{
+    for (size_t i = 0; i < moleculeList.size(); i++)
+    {
+        auto particleIndices = moleculeList.particleIndices[i];
+        for (int& particleIndex : particleIndices)
+        {
+            particleIndex += particleOffset;
+        }
+        list->add(particleIndices, moleculeList.parameters[moleculeList.parameterIndices[i]]);
+    }
+}
+
+ListedInteractionData TopologyBuilder::createListedInteractions() const
+{
+    ListedInteractionData listedInteractions;
+
+    int particleNumberOffset = 0;
+    for (const auto& molNumberTuple : molecules_)
+    {
+        const Molecule&             molecule             = std::get<0>(molNumberTuple);
+        const int                   numMols              = std::get<1>(molNumberTuple);
+        const ListedInteractionData moleculeInteractions = molecule.getListedInteractions();
+
+        for (int i = 0; i < numMols; ++i)
+        {
+            appendListedInteractions(moleculeInteractions.harmonicBonds, particleNumberOffset,
+                                     &listedInteractions.harmonicBonds);
+            appendListedInteractions(moleculeInteractions.harmonicAngles, particleNumberOffset,
+                                     &listedInteractions.harmonicAngles);
+            appendListedInteractions(moleculeInteractions.properDihedrals, particleNumberOffset,
+                                     &listedInteractions.properDihedrals);
+
+            particleNumberOffset += molecule.numParticlesInMolecule();
+        }
+    }
+
+    return listedInteractions;
+}
+
 template<typename T, class Extractor>
 std::vector<T> TopologyBuilder::extractParticleTypeQuantity(Extractor&& extractor)
 {
@@ -137,6 +181,8 @@ Topology TopologyBuilder::buildTopology()
         return data.charge_;
     });
 
+    topology_.listedInteractions_ = createListedInteractions();
+
     // map unique ParticleTypes to IDs
     std::unordered_map<std::string, int> nameToId;
     for (auto& name_particleType_tuple : particleTypes_)
@@ -256,4 +302,9 @@ gmx::ListOfLists<int> Topology::getGmxExclusions() const
     return exclusions_;
 }
 
+ListedInteractionData Topology::getListedInteractions() const
+{
+    return listedInteractions_;
+}
+
 } // namespace nblib
@@ -47,6 +47,7 @@
 
 #include <vector>
 
+#include "nblib/bondtypes.h"
 #include "nblib/interactions.h"
 #include "nblib/molecules.h"
 #include "nblib/topologyhelpers.h"
@@ -88,6 +89,9 @@ public:
     //! Returns exclusions in proper, performant, GROMACS layout
     gmx::ListOfLists<int> getGmxExclusions() const;
 
+    //! Returns the listed interactions of all molecules, with particle indices in the global space
+    ListedInteractionData getListedInteractions() const;
+
     //! Returns the unique ID of a specific particle belonging to a molecule in the global space
     int sequenceID(MoleculeName moleculeName, int moleculeNr, ResidueName residueName, ParticleName particleName) const;
 
@@ -112,6 +116,8 @@ private:
     std::vector<real> charges_;
     //! Information about exclusions.
     gmx::ListOfLists<int> exclusions_;
+    //! Listed interactions of all particles
+    ListedInteractionData listedInteractions_;
     //! Associate molecule, residue and particle names with sequence numbers
     detail::ParticleSequencer particleSequencer_;
     //! Map that should hold all nonbonded interactions for all particle types
@@ -164,6 +170,9 @@ private:
     //! Builds a GROMACS-compliant performant exclusions list aggregating exclusions from all molecules
     gmx::ListOfLists<int> createExclusionsListOfLists() const;
 
+    //! Aggregates the listed interactions from all molecules, offset to global particle indices
+    ListedInteractionData createListedInteractions() const;
+
     //! Helper function to extract quantities like mass, charge, etc from the system
     template<typename T, class Extractor>
     std::vector<T> extractParticleTypeQuantity(Extractor&& extractor);
@@ -174,29 +174,22 @@ void EnsemblePotential::callback(gmx::Vector v,
     };
 
     // Every nsteps:
-    //   0. Drop oldest window
     //   1. Reduce historical data for this restraint in this simulation.
-    //   2. Call out to the global reduction for this window.
-    //   3. On update, checkpoint the historical data source.
-    //   4. Update historic windows.
-    //   5. Use handles retained from previous windows to reconstruct the smoothed working histogram
+    //   2. Start the global reduction for this window.
+    //   3. At the next update, complete the reduction, drop the oldest window,
+    //      update historic windows and checkpoint the averaged data if requested.
+    //   4. Use handles retained from previous windows to reconstruct the smoothed working histogram
+    if (pendingMean_.isPending())
+    {
+        // The reduction could proceed while the forces of the last step were computed.
+        Matrix<double> mean(1, state_.nBins);
+        pendingMean_.finish(&mean);
+        addWindow(std::move(mean), resources);
+    }
+
     if (t >= state_.nextWindowUpdateTime)
     {
-        // Get next histogram array, recycling old one if available.
         Matrix<double> new_window = Matrix<double>(1, state_.nBins);
-        Matrix<double> temp_window(1, state_.nBins);
-        if (state_.windows.size() == state_.nWindows)
-        {
-            // Recycle the oldest window.
-            // \todo wrap this in a helper class that manages a buffer we can shuffle through.
-            state_.windows[0].swap(temp_window);
-            state_.windows.erase(state_.windows.begin());
-        }
-        else
-        {
-            auto new_temp_window = Matrix<double>(1, state_.nBins);
-            temp_window.swap(new_temp_window);
-        }
 
         // Reduce sampled data for this restraint in this simulation, applying a Gaussian blur to fill a grid.
         auto blur = BlurToGrid(0.0,
@@ -214,28 +207,10 @@ void EnsemblePotential::callback(gmx::Vector v,
         // We request a handle each time before using resources to make error handling easier if there is a failure in
         // one of the ensemble member processes and to give more freedom to how resources are managed from step to step.
         auto ensemble = resources.getHandle();
-        // Get global reduction (sum) and checkpoint.
-        assert(temp_window.data() != nullptr);
-        // Todo: in reduce function, give us a mean instead of a sum.
-        ensemble.reduce(new_window,
-                        &temp_window);
-
-        // Update window list with smoothed data.
-        state_.windows.emplace_back(std::move(new_window));
-
-        // Get new histogram difference. Subtract the experimental distribution to get the values to use in our potential.
-        for (auto& bin : state_.histogram)
-        {
-            bin = 0;
-        }
-        for (const auto& window : state_.windows)
-        {
-            for (size_t i = 0;i < window.cols();++i)
-            {
-                state_.histogram.at(i) += (window.vector()->at(i) - state_.experimental.at(i)) / state_.windows.size();
-            }
-        }
-
+        // Start the global average. It is completed at the next update, so that the
+        // ensemble members do not wait for each other in this step.
+        ensemble.startReduce(new_window,
+                             &pendingMean_);
 
         // Note we do not have the integer timestep available here. Therefore, we can't guarantee that updates occur
         // with the same number of MD steps in each interval, and the interval will effectively lose digits as the
@@ -254,6 +229,37 @@ void EnsemblePotential::callback(gmx::Vector v,
 }
 
 
+void EnsemblePotential::addWindow(Matrix<double>&& window,
+                                  const Resources& resources)
+{
+    if (state_.persistMean)
+    {
+        resources.getHandle().persist("mean",
+                                      window);
+    }
+
+    if (state_.windows.size() == state_.nWindows)
+    {
+        // Drop the oldest window.
+        state_.windows.erase(state_.windows.begin());
+    }
+    // Update window list with smoothed data.
+    state_.windows.emplace_back(std::move(window));
+
+    // Get new histogram difference. Subtract the experimental distribution to get the values to use in our potential.
+    for (auto& bin : state_.histogram)
+    {
+        bin = 0;
+    }
+    for (const auto& historicWindow : state_.windows)
+    {
+        for (size_t i = 0;i < historicWindow.cols();++i)
+        {
+            state_.histogram.at(i) += (historicWindow.vector()->at(i) - state_.experimental.at(i)) / state_.windows.size();
+        }
+    }
+}
+
 //
 //
 // HERE is the function that does the calculation of the restraint force.
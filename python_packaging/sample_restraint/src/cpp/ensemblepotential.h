@@ -63,6 +63,9 @@ struct ensemble_input_param_type
     /// Smoothing factor: width of Gaussian interpolation for histogram
     double sigma{0};
 
+    /// Whether to write the ensemble-averaged histogram of each window to disk.
+    bool persistMean{false};
+
     // State data
 
     /// Smoothed historic distribution for this restraint. An element of the array of restraints in this simulation.
@@ -184,8 +187,20 @@ class EnsemblePotential
                       const Resources& resources);
 
     private:
+        /*!
+         * \brief Add an ensemble-averaged histogram to the window history.
+         *
+         * Drops the oldest window if there are already nWindows, and updates the
+         * difference between the smoothed and the experimental histograms.
+         */
+        void addWindow(Matrix<double>&& window,
+                       const Resources& resources);
+
         /// Aggregate data structure holding object state.
         input_param_type state_;
+
+        /// Ensemble average of the last window, completed at the next update.
+        EnsembleMean pendingMean_;
 };
 
 
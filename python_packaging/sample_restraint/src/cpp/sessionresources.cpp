@@ -22,21 +22,65 @@ namespace plugin
 template
 class ::plugin::Matrix<double>;
 
-void ResourcesHandle::reduce(const Matrix<double>& send,
-                             Matrix<double>* receive) const
+EnsembleMean::~EnsembleMean()
 {
-    assert(reduce_);
-    if (*reduce_)
+    if (pending_)
     {
-        (*reduce_)(send,
-               receive);
+        // The reduction must not write to the receive buffer after it is freed.
+        try
+        {
+            reduction_.wait();
+        }
+        catch (const gmxapi::Exception&)
+        {
+            // The Session was closed before the reduction could complete.
+        }
     }
-    else
+}
+
+void EnsembleMean::finish(Matrix<double>* receive)
+{
+    assert(pending_);
+    reduction_.wait();
+    pending_ = false;
+
+    const size_t size = receiveBuffer_.size() - 1;
+    assert(receive->vector()->size() == size);
+    const double numMembers = receiveBuffer_[size];
+    for (size_t i = 0; i < size; ++i)
     {
-        throw gmxapi::ProtocolError("'reduce' functor was not initialized before use.");
+        receive->data()[i] = receiveBuffer_[i] / numMembers;
     }
 }
 
+void ResourcesHandle::startReduce(const Matrix<double>& send,
+                                  EnsembleMean* mean) const
+{
+    assert(session_);
+    assert(!mean->isPending());
+    // Reduce the number of contributing members along with the data, so that
+    // the mean does not depend on how the ensemble was set up.
+    const size_t size = send.vector()->size();
+    mean->sendBuffer_.assign(send.data(), send.data() + size);
+    mean->sendBuffer_.push_back(1.);
+    mean->receiveBuffer_.resize(size + 1);
+    mean->reduction_ = gmxapi::startEnsembleReduce(session_,
+                                                   mean->sendBuffer_.data(),
+                                                   mean->receiveBuffer_.data(),
+                                                   mean->sendBuffer_.size());
+    mean->pending_ = true;
+}
+
+void ResourcesHandle::persist(const std::string& tag,
+                              const Matrix<double>& data) const
+{
+    assert(session_);
+    gmxapi::persistEnsembleData(session_,
+                                tag,
+                                data.data(),
+                                data.vector()->size());
+}
+
 void ResourcesHandle::stop()
 {
     assert(session_);
@@ -51,12 +95,6 @@ ResourcesHandle Resources::getHandle() const
 {
     auto handle = ResourcesHandle();
 
-    if (!bool(reduce_))
-    {
-        throw gmxapi::ProtocolError("reduce operation functor is not set, which should not happen...");
-    }
-    handle.reduce_ = &reduce_;
-
     if (!session_)
     {
         throw gmxapi::ProtocolError("Resources::getHandle() must not be called before setSession() has been called.");
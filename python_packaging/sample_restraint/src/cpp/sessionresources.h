@@ -12,10 +12,12 @@
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <vector>
 
 #include "gmxapi/gromacsfwd.h"
 #include "gmxapi/session.h"
+#include "gmxapi/session/ensemble.h"
 #include "gmxapi/session/resources.h"
 #include "gmxapi/md/mdmodule.h"
 
@@ -86,6 +88,49 @@ class Matrix
 extern template
 class Matrix<double>;
 
+/*!
+ * \brief Ensemble average that may still be in progress.
+ *
+ * Holds the buffers of a split-phase reduction started with
+ * ResourcesHandle::startReduce(), so that the communication can overlap with
+ * MD steps until the owner completes it with finish().
+ *
+ * The receive buffer is written by the reduction, so objects can neither be
+ * copied nor moved, and the destructor completes a pending reduction.
+ */
+class EnsembleMean
+{
+    public:
+        EnsembleMean() = default;
+        EnsembleMean(const EnsembleMean&) = delete;
+        EnsembleMean& operator=(const EnsembleMean&) = delete;
+
+        ~EnsembleMean();
+
+        //! Whether a reduction has been started and not yet finished.
+        bool isPending() const
+        { return pending_; }
+
+        /*!
+         * \brief Complete the reduction and write the ensemble mean to \p receive.
+         *
+         * Blocks until the reduction has finished.
+         *
+         * \param receive destination with as many elements as the matrix that was sent.
+         */
+        void finish(Matrix<double>* receive);
+
+    private:
+        friend class ResourcesHandle;
+
+        //! Local contribution followed by the number of contributing members (1).
+        std::vector<double> sendBuffer_;
+        //! Ensemble sum of sendBuffer_, written by the reduction.
+        std::vector<double> receiveBuffer_;
+        gmxapi::EnsembleReduction reduction_;
+        bool pending_{false};
+};
+
 /*!
  * \brief An active handle to ensemble resources provided by the Context.
  *
@@ -126,13 +171,28 @@ class ResourcesHandle
 {
     public:
         /*!
-         * \brief Ensemble reduce.
+         * \brief Start an ensemble average.
          *
-         * \param send Matrices to be summed across the ensemble using Context resources.
-         * \param receive destination of reduced data instead of updating internal Matrix.
+         * The reduction is performed by the ensemble resources of the Session, which do
+         * not need the Python interpreter, and returns without waiting for the other
+         * ensemble members. The caller completes it later with EnsembleMean::finish().
+         *
+         * \param send Matrices to be averaged across the ensemble using Session resources.
+         * \param mean pending average that receives the reduced data.
          */
-        void reduce(const Matrix<double>& send,
-                    Matrix<double>* receive) const;
+        void startReduce(const Matrix<double>& send,
+                         EnsembleMean* mean) const;
+
+        /*!
+         * \brief Write data to disk.
+         *
+         * The data is copied and written by the Session in the background.
+         *
+         * \param tag label of the data set, used in the file name.
+         * \param data values to write.
+         */
+        void persist(const std::string& tag,
+                     const Matrix<double>& data) const;
 
         /*!
          * \brief Issue a stop condition event.
@@ -143,9 +203,6 @@ class ResourcesHandle
         void stop();
 
         // to be abstracted and hidden...
-        const std::function<void(const Matrix<double>&,
-                                 Matrix<double>*)>* reduce_;
-
         gmxapi::SessionResources* session_;
 };
 
@@ -168,12 +225,8 @@ class Resources
          * potential with external resources.
          *
          * \note If getHandle() is going to be used, setSession() must be called first.
-         *
-         * \param reduce ownership of a function object providing ensemble averaging of a 2D matrix.
          */
-        explicit Resources(std::function<void(const Matrix<double>&,
-                                              Matrix<double>*)>&& reduce) :
-            reduce_(reduce),
+        Resources() :
             session_(nullptr)
         {};
 
@@ -190,8 +243,8 @@ class Resources
          *
          * \return resource handle
          *
-         * In this release, the only facility provided by the resources is a function object for
-         * the ensemble averaging function provided by the Context.
+         * In this release, the only facility provided by the resources is the ensemble
+         * averaging provided by the Session.
          */
         ResourcesHandle getHandle() const;
 
@@ -203,10 +256,6 @@ class Resources
         void setSession(gmxapi::SessionResources* session);
 
     private:
-        //! bound function object to provide ensemble reduce facility.
-        std::function<void(const Matrix<double>&,
-                           Matrix<double>*)> reduce_;
-
         // Raw pointer to the session in which these resources live.
         gmxapi::SessionResources* session_;
 };
@@ -61,7 +61,8 @@ std::unique_ptr<EnsembleRestraintBuilder> createEnsembleBuilder(const py::object
             .add_input("sample_period", &data_t::samplePeriod)
             .add_input("nwindows", &data_t::nWindows)
             .add_input("k", &data_t::sigma)
-            .add_input("sigma", &data_t::sigma);
+            .add_input("sigma", &data_t::sigma)
+            .add_optional_input("persist_mean", &data_t::persistMean);
     return builder;
 }
 
@@ -154,31 +154,9 @@ public:
             setter(&params_, parameter_dict_);
         }
 
-        // Need to capture Python communicator and pybind syntax in closure so
-        // Resources can just call with matrix arguments. This is not the best
-        // way nor the long term solution to "ensemble_update," but demonstrates
-        // that we can provide arbitrary (even Python based) resources to the
-        // client code in the plugin implementation without the plugin knowing
-        // anything about Python.
-
-        // This can be replaced with a subscription and delayed until launch, if necessary.
-        if (!py::hasattr(context_, "ensemble_update"))
-        {
-            throw gmxapi::ProtocolError(
-                    "context does not have 'ensemble_update' feature.");
-        }
-        // make a local copy of the Python object so we can capture it in the lambda
-        auto update = context_.attr("ensemble_update");
-        // Make a callable with standardizeable signature.
-        const std::string name{ name_ };
-        auto functor = [update, name](const plugin::Matrix<double> &send,
-                                      plugin::Matrix<double> *      receive) {
-            update(send, receive, py::str(name));
-        };
-
-        // To use a reduce function on the Python side, we need to provide it with a Python buffer-like object,
-        // so we will create one here. Note: it looks like the SharedData element will be useful after all.
-        auto resources = std::make_shared<plugin::Resources>(std::move(functor));
+        // Ensemble reductions are provided by the Session to which the restraint is bound,
+        // so the plugin does not need to call back into Python during the simulation.
+        auto resources = std::make_shared<plugin::Resources>();
 
         auto potential
                 = PyRestraint<plugin::RestraintModule<plugin::Restraint<PotentialT>>>::create(
@@ -221,6 +199,27 @@ public:
         return *this;
     };
 
+    /*!
+     * \brief Register an input that keeps its default value when it is not provided.
+     *
+     * Example:
+     *
+     *      builder.add_optional_input("persist_mean", &input_param_type::persistMean);
+     */
+    template <typename T>
+    RestraintBuilder &add_optional_input(const std::string &name,
+                                         T PotentialT::input_param_type::*data_ptr)
+    {
+        auto setter = [=](typename PotentialT::input_param_type *p, const py::dict &d) -> void {
+            if (d.contains(name.c_str()))
+            {
+                p->*data_ptr = py::cast<T>(d[name.c_str()]);
+            }
+        };
+        this->setters_.emplace_back(setter);
+        return *this;
+    };
+
     py::dict         parameter_dict_;
     py::object       subscriber_;
     py::object       context_;
@@ -38,9 +38,7 @@ TEST(EnsembleBoundingPotentialPlugin, ForceCalc)
     Vector force{};
 
     // Get a dummy EnsembleResources. We aren't testing that here.
-    auto dummyFunc = [](const plugin::Matrix<double>&, plugin::Matrix<double>*){
-        return;};
-    auto resource = std::make_shared<plugin::Resources>(dummyFunc);
+    auto resource = std::make_shared<plugin::Resources>();
 
     // Define a reference distribution with a triangular peak at the 1.0 bin.
     const std::vector<double>
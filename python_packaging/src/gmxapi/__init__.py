@@ -41,7 +41,8 @@ in C++ or Python with the same tool kit used to implement this package.
 
 """
 
-__all__ = ['commandline_operation',
+__all__ = ['cache',
+           'commandline_operation',
            'concatenate_lists',
            'function_wrapper',
            'join_arrays',
@@ -52,6 +53,7 @@ __all__ = ['commandline_operation',
            'modify_input',
            'ndarray',
            'read_tpr',
+           'run_concurrently',
            'subgraph',
            'while_loop',
            'NDArray',
@@ -61,7 +63,8 @@ from ._logging import logger
 from .version import __version__
 
 # Import utilities
-from .operation import computed_result, function_wrapper
+from . import cache
+from .operation import computed_result, function_wrapper, run_concurrently
 # Import public types
 from .datamodel import NDArray
 # Import the public operations
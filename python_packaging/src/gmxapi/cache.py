@@ -0,0 +1,274 @@
+#
+# This file is part of the GROMACS molecular simulation package.
+#
+# Copyright (c) 2019,2020, by the GROMACS development team, led by
+# Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+# and including many others, as listed in the AUTHORS file in the
+# top-level source directory and at http://www.gromacs.org.
+#
+# GROMACS is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public License
+# as published by the Free Software Foundation; either version 2.1
+# of the License, or (at your option) any later version.
+#
+# GROMACS is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with GROMACS; if not, see
+# http://www.gnu.org/licenses, or write to the Free Software Foundation,
+# Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+#
+# If you want to redistribute modifications to GROMACS, please
+# consider that scientific software is very special. Version
+# control is crucial - bugs must be traceable. We will be happy to
+# consider code for inclusion in the official distribution, but
+# derived work must not be called official GROMACS. Details are found
+# in the README & COPYING files - if they are missing, get the
+# official version at http://www.gromacs.org.
+#
+# To help us fund GROMACS development, we humbly ask that you cite
+# the research papers on the package. Check out http://www.gromacs.org.
+
+"""On-disk cache of operation results.
+
+When the cache is enabled, operations defined with
+:py:func:`gmxapi.function_wrapper` (including
+:py:func:`gmxapi.commandline_operation`) look up their results before executing.
+Results are identified by the operation name, the compiled code of the
+wrapped function, the input values, and the contents of the input files, so a
+workflow that is run again repeats only the work for which the input or the
+implementation has changed.
+
+Files are identified from the input of an operation. Input strings naming
+existing regular files are treated as input files. Output files must be declared
+with an input named ``output_files``, mapping command line flags (or other keys)
+to file names, as done by :py:func:`gmxapi.commandline.cli`. Copies of the output
+files are stored in the cache and are restored on a cache hit if the files are
+missing or have changed.
+
+Cached operations are assumed to depend only on their input and input files.
+Changes in other functions that the wrapped function calls are not detected.
+Results are only stored if all declared output files exist.
+
+Example::
+
+    import gmxapi as gmx
+    gmx.cache.enable('gmxapi-cache')
+
+"""
+
+__all__ = ['current', 'disable', 'enable', 'ResultCache']
+
+import collections.abc
+import hashlib
+import inspect
+import os
+import pickle
+import shutil
+import tempfile
+import types
+import typing
+
+from gmxapi import datamodel
+from gmxapi import exceptions
+from gmxapi import logger as root_logger
+
+# Module-level logger
+logger = root_logger.getChild('cache')
+logger.info('Importing {}'.format(__name__))
+
+# Increment when the key generation or the layout of the cache entries changes.
+_format_version = 2
+
+_current_cache = None
+
+
+def _file_hash(path: str) -> str:
+    """Get the SHA-256 hex digest of the contents of a file."""
+    digest = hashlib.sha256()
+    with open(path, 'rb') as fh:
+        for block in iter(lambda: fh.read(1 << 20), b''):
+            digest.update(block)
+    return digest.hexdigest()
+
+
+def _code_fingerprint(code: types.CodeType):
+    """Get a representation of compiled code that changes with the implementation."""
+    return (code.co_code,
+            code.co_names,
+            tuple(_code_fingerprint(const) if isinstance(const, types.CodeType) else repr(const)
+                  for const in code.co_consts))
+
+
+def _implementation_fingerprint(function: typing.Callable):
+    """Get a representation of the implementation of a function for hashing.
+
+    Uses the byte code and constants of functions, including those of nested
+    functions, and the source code of other callables, if available.
+    """
+    code = getattr(function, '__code__', None)
+    if code is not None:
+        return _code_fingerprint(code)
+    try:
+        return inspect.getsource(function)
+    except (OSError, TypeError):
+        logger.debug('Cannot identify the implementation of {} for the result cache.'.format(function))
+        return None
+
+
+def _fingerprint(value):
+    """Get a canonical representation of an input value for hashing."""
+    if isinstance(value, datamodel.NDArray):
+        return 'NDArray', tuple(_fingerprint(item) for item in value._values)
+    if isinstance(value, collections.abc.Mapping):
+        return 'dict', tuple(sorted((str(key), _fingerprint(item)) for key, item in value.items()))
+    if isinstance(value, (list, tuple)):
+        return 'list', tuple(_fingerprint(item) for item in value)
+    if value is None or isinstance(value, (str, bytes, bool, int, float)):
+        return type(value).__name__, repr(value)
+    raise exceptions.ValueError('Cannot identify input of type {} for the result cache.'.format(type(value)))
+
+
+def _strings(value) -> typing.Iterator[str]:
+    """Generate the strings in a (possibly nested) input value."""
+    if isinstance(value, str):
+        yield value
+    elif isinstance(value, datamodel.NDArray):
+        for item in value._values:
+            yield from _strings(item)
+    elif isinstance(value, collections.abc.Mapping):
+        for item in value.values():
+            yield from _strings(item)
+    elif isinstance(value, (list, tuple)):
+        for item in value:
+            yield from _strings(item)
+
+
+def files(inputs: collections.abc.Mapping) -> typing.Tuple[typing.List[str], typing.List[str]]:
+    """Get the input and output files of an operation from its resolved input.
+
+    Returns:
+        Sorted lists of the input file names and the output file names.
+    """
+    output_files = set(_strings(inputs.get('output_files') or {}))
+    input_files = set()
+    for name, value in inputs.items():
+        if name == 'output_files':
+            continue
+        input_files.update(path for path in _strings(value)
+                           if path not in output_files and os.path.isfile(path))
+    return sorted(input_files), sorted(output_files)
+
+
+class ResultCache(object):
+    """Store operation results in a directory, keyed by the operation input.
+
+    Each entry is a subdirectory named by its key, holding the pickled outputs
+    and copies of the output files. Entries are written to a temporary directory
+    and moved into place, so concurrent writers and interrupted runs do not
+    leave partial entries.
+    """
+
+    def __init__(self, directory: str):
+        self.directory = os.path.abspath(directory)
+        os.makedirs(self.directory, exist_ok=True)
+
+    def key(self, operation: str, inputs: collections.abc.Mapping, input_files: typing.Iterable[str] = (),
+            implementation: typing.Callable = None) -> str:
+        """Get the cache key for an operation with the given resolved input.
+
+        Arguments:
+            operation: Fully qualified name of the operation.
+            inputs: Mapping of input names to (resolved) input values.
+            input_files: Names of files whose contents the result depends on.
+            implementation: Function computing the result, so that results are not
+                reused after the function has been changed.
+        """
+        fingerprint = (_format_version,
+                       operation,
+                       _implementation_fingerprint(implementation) if implementation is not None else None,
+                       _fingerprint(dict(inputs)),
+                       tuple((path, _file_hash(path)) for path in sorted(input_files)))
+        return hashlib.sha256(repr(fingerprint).encode('utf-8')).hexdigest()
+
+    def _entry(self, key: str) -> str:
+        return os.path.join(self.directory, key)
+
+    def load(self, key: str) -> typing.Optional[dict]:
+        """Get the cached outputs for *key*, restoring the output files.
+
+        Returns:
+            Mapping of output names to values, or None if there is no usable entry.
+        """
+        entry = self._entry(key)
+        try:
+            with open(os.path.join(entry, 'result.pickle'), 'rb') as fh:
+                outputs, output_files = pickle.load(fh)
+        except FileNotFoundError:
+            return None
+        for index, (path, digest) in enumerate(output_files):
+            if os.path.isfile(path) and _file_hash(path) == digest:
+                continue
+            stored = os.path.join(entry, 'files', str(index))
+            if not os.path.isfile(stored):
+                logger.warning('Cache entry {} is missing output file {}.'.format(key, path))
+                return None
+            logger.debug('Restoring {} from cache entry {}.'.format(path, key))
+            shutil.copyfile(stored, path)
+        return outputs
+
+    def store(self, key: str, outputs: dict, output_files: typing.Iterable[str] = ()) -> bool:
+        """Add the outputs and output files of an operation to the cache.
+
+        Returns:
+            True if the entry was stored, False if an output file does not exist.
+        """
+        output_files = list(output_files)
+        for path in output_files:
+            if not os.path.isfile(path):
+                logger.debug('Not caching result {}: output file {} does not exist.'.format(key, path))
+                return False
+        entry = self._entry(key)
+        staging = tempfile.mkdtemp(dir=self.directory, prefix='.' + key)
+        try:
+            os.mkdir(os.path.join(staging, 'files'))
+            manifest = []
+            for index, path in enumerate(output_files):
+                shutil.copyfile(path, os.path.join(staging, 'files', str(index)))
+                manifest.append((os.path.abspath(path), _file_hash(path)))
+            with open(os.path.join(staging, 'result.pickle'), 'wb') as fh:
+                pickle.dump((dict(outputs), manifest), fh)
+            try:
+                os.rename(staging, entry)
+            except OSError:
+                # Another process or thread stored the same result first.
+                shutil.rmtree(staging)
+        except BaseException:
+            shutil.rmtree(staging, ignore_errors=True)
+            raise
+        return True
+
+
+def enable(directory: str) -> ResultCache:
+    """Cache the results of subsequently executed operations in *directory*.
+
+    Returns:
+        The active ResultCache.
+    """
+    global _current_cache
+    _current_cache = ResultCache(directory)
+    return _current_cache
+
+
+def disable():
+    """Stop using the result cache. The cached results remain on disk."""
+    global _current_cache
+    _current_cache = None
+
+
+def current() -> typing.Optional[ResultCache]:
+    """Get the active ResultCache, or None if caching is not enabled."""
+    return _current_cache
@@ -71,7 +71,8 @@ logger.info('Importing {}'.format(__name__))
 # TODO: Operation returns the output object when called with the shorter signature.
 #
 @gmx.function_wrapper(output={'erroroutput': str, 'returncode': int})
-def cli(command: NDArray, shell: bool, output: OutputCollectionDescription, stdin: str = ''):
+def cli(command: NDArray, shell: bool, output: OutputCollectionDescription, stdin: str = '',
+        output_files: dict = None):
     """Execute a command line program in a subprocess.
 
     Configure an executable in a subprocess. Executes when run in an execution
@@ -90,12 +91,19 @@ def cli(command: NDArray, shell: bool, output: OutputCollectionDescription, stdi
          output: mapping of command line flags to output filename arguments
          shell: unused (provides forward-compatibility)
          stdin (str): String input to send to STDIN (terminal input) of the executable.
+         output_files (dict): mapping of command line flags to the output files written by `command`
 
     Multi-line text sent to *stdin* should be joined into a single string
     (e.g. ``'\n'.join(list_of_strings) + '\n'``).
     If multiple strings are provided to *stdin*, gmxapi will assume an ensemble,
     and will run one operation for each provided string.
 
+    *output_files* does not change the command line. It declares the files that
+    the command writes, so that they can be restored from the result cache
+    (see :py:mod:`gmxapi.cache`) instead of executing the command again.
+    Arguments in *command* naming existing files that are not output files
+    are treated as input files, and their contents identify the cached result.
+
     Only string input (:py:func:str) to *stdin* is currently supported.
     If you have a use case that requires streaming input or binary input,
     please open an issue or contact the author(s).
@@ -371,6 +379,7 @@ def commandline_operation(executable=None,
     cli_args.update(**kwargs)
     if stdin is not None:
         cli_args['stdin'] = str(stdin)
+    cli_args['output_files'] = output_files
 
     ##
     # 3. Merge operations
@@ -165,6 +165,16 @@ void export_context(py::module& m)
     py::class_<PyContext, std::shared_ptr<PyContext>> context(m, "Context");
     context.def(py::init(), "Create a default execution context.");
     context.def("setMDArgs", &PyContext::setMDArgs, "Set MD runtime parameters.");
+    context.def("join_node_ensemble", &PyContext::joinNodeEnsemble,
+                py::call_guard<py::gil_scoped_release>(), py::arg("name"), py::arg("size"),
+                py::arg("rank"),
+                "Join an ensemble of contexts on the same node, communicating through shared "
+                "memory.");
+
+    context.def("set_ensemble_communicator", &PyContext::setEnsembleCommunicator,
+                py::arg("communicator"),
+                "Communicate among ensemble members through an mpi4py communicator, with one "
+                "rank per member. Collectives are issued from threads of the session.");
 
     context.def("add_mdmodule", &PyContext::addMDModule, "Add an MD plugin for the simulation.");
 }
@@ -74,8 +74,11 @@ void export_system(py::module& m)
     // dynamically accessed facet of the Context, which the API client would be
     // required to maintain and to pass to the API.
     py::class_<::gmxapi::Session, std::shared_ptr<::gmxapi::Session>> session(m, "MDSession");
-    session.def("run", &::gmxapi::Session::run, "Run the simulation workflow");
-    session.def("close", &::gmxapi::Session::close,
+    // The GIL is released so that ensemble reductions issued by plugins can
+    // call back into Python from the threads of the Session.
+    session.def("run", &::gmxapi::Session::run, py::call_guard<py::gil_scoped_release>(),
+                "Run the simulation workflow");
+    session.def("close", &::gmxapi::Session::close, py::call_guard<py::gil_scoped_release>(),
                 "Shut down the execution environment and close the session.");
 
     // Export system container class
@@ -50,6 +50,7 @@
 #include "gmxapi/exceptions.h"
 
 #include "gmxapi/gmxapicompat.h"
+#include "gmxapi/system.h"
 #include "gmxapi/compat/mdparams.h"
 #include "gmxapi/compat/tpr.h"
 
@@ -149,6 +150,16 @@ void detail::export_tprfile(pybind11::module& module)
                py::arg("filename").none(false), py::arg("parameters"),
                "Write a new TPR file with the provided data.");
 
+    module.def("from_tpr_contents",
+               [](const GmxMdParams& parameterObject) {
+                   auto tprReadHandle = gmxapicompat::getSourceFileHandle(parameterObject);
+                   auto system        = gmxapicompat::fromTprContents(tprReadHandle);
+                   return std::make_shared<gmxapi::System>(std::move(system));
+               },
+               py::arg("parameters"),
+               "Get a system container that runs the (modified) simulation input in memory, "
+               "without writing a TPR file.");
+
     module.def("copy_tprfile",
                [](const gmxapicompat::TprReadHandle& input, std::string outFile) {
                    return gmxapicompat::copy_tprfile(input, outFile);
@@ -156,6 +167,14 @@ void detail::export_tprfile(pybind11::module& module)
                py::arg("source"), py::arg("destination"),
                "Copy a TPR file from ``source`` to ``destination``.");
 
+    module.def("nsteps_for_end_time",
+               [](int64_t init_step, double dt, double tinit, double end_time) {
+                   return gmxapicompat::nstepsForEndTime(init_step, dt, tinit, end_time);
+               },
+               py::arg("init_step"), py::arg("dt"), py::arg("tinit"), py::arg("end_time"),
+               "Get the value of `nsteps` with which a simulation ends at ``end_time``, "
+               "rounded as by ``rewrite_tprfile``.");
+
     module.def("rewrite_tprfile",
                [](std::string input, std::string output, double end_time) {
                    return gmxapicompat::rewrite_tprfile(input, output, end_time);
@@ -51,17 +51,21 @@ The framework ensures that an Operation instance is executed no more than once.
 
 __all__ = ['computed_result',
            'function_wrapper',
+           'run_concurrently',
            ]
 
 import abc
 import collections
+import concurrent.futures
 import functools
 import inspect
+import os
 import typing
 import weakref
 from contextlib import contextmanager
 
 import gmxapi as gmx
+from gmxapi import cache
 from gmxapi import datamodel
 from gmxapi import exceptions
 from gmxapi import logger as root_logger
@@ -122,14 +126,17 @@ class OutputData(object):
 
     def data(self, member: int = None):
         """Access the raw data for localized output for the ensemble or the specified member."""
+        if member is not None:
+            if not self.member_done(member):
+                raise exceptions.ApiError('Attempt to read before data has been published.')
+            if self._data[member] is None:
+                raise exceptions.ApiError('Data marked "done" but contains null value.')
+            return self._data[member]
         if not self.done:
             raise exceptions.ApiError('Attempt to read before data has been published.')
         if self._data is None or None in self._data:
             raise exceptions.ApiError('Data marked "done" but contains null value.')
-        if member is not None:
-            return self._data[member]
-        else:
-            return self._data
+        return self._data
 
     def set(self, value, member: int):
         """Set local data and mark as completed.
@@ -142,6 +149,10 @@ class OutputData(object):
             self._data[member] = self._description.dtype(value)
         self._done[member] = True
 
+    def member_done(self, member: int) -> bool:
+        """Completion status of this output for one ensemble member."""
+        return self._done[member]
+
     def reset(self):
         """Reinitialize the data store.
 
@@ -456,9 +467,12 @@ class InputCollectionDescription(collections.OrderedDict):
         except TypeError as e:
             raise exceptions.UsageError('Could not bind operation parameters to function signature.') from e
         assert 'output' not in bound_arguments.arguments
+        provided = set(bound_arguments.arguments)
         bound_arguments.apply_defaults()
         assert 'input' not in bound_arguments.arguments
-        input_kwargs = collections.OrderedDict([pair for pair in bound_arguments.arguments.items()])
+        # A default of None is not a data source. The DataEdge resolves it from the signature.
+        input_kwargs = collections.OrderedDict([(name, value) for name, value in bound_arguments.arguments.items()
+                                                if name in provided or value is not None])
         if 'output' in input_kwargs:
             input_kwargs.pop('output')
         return DataSourceCollection(**input_kwargs)
@@ -1630,8 +1644,9 @@ class DataEdge(object):
         self.sink_terminal = sink_terminal
         for name in sink_terminal.inputs:
             if name not in source_collection:
-                if hasattr(sink_terminal.inputs[name], 'default'):
-                    self.adapters[name] = self.ConstantResolver(sink_terminal.inputs[name])
+                default = sink_terminal.inputs.signature.parameters[name].default
+                if default is not inspect.Parameter.empty:
+                    self.adapters[name] = self.ConstantResolver(default)
                 else:
                     # TODO: Initialize with multiple DataSourceCollections?
                     raise exceptions.ValueError('No source or default for required input "{}".'.format(name))
@@ -1899,6 +1914,17 @@ class ResourceManager(SourceResource[_OutputDataProxyType, _PublishingDataProxyT
     def is_done(self, name):
         return self._data[name].done
 
+    def published_output(self, member: int) -> typing.Optional[typing.Dict[str, typing.Any]]:
+        """Get the output published by one ensemble member.
+
+        Returns:
+            Mapping of output names to the values published for *member*, or
+            None if some output has not been published for *member*.
+        """
+        if not all(data.member_done(member) for data in self._data.values()):
+            return None
+        return {name: data.data(member) for name, data in self._data.items()}
+
     def get(self, name: str):
         """
 
@@ -1941,66 +1967,99 @@ class ResourceManager(SourceResource[_OutputDataProxyType, _PublishingDataProxyT
         # TODO: Handle checking just the ensemble members this resource manager is responsible for.
         # TODO: Replace with a managed observer pattern. Update once when input is available in the Context.
         if not self.done():
-            # Note: This check could also be encapsulated in a run_once decorator that
-            # could even set a data descriptor to change behavior.
-            self.__operation_entrance_counter += 1
-            if self.__operation_entrance_counter > 1:
-                raise exceptions.ProtocolError('Bug detected: resource manager tried to execute operation twice.')
-            if not self.done():
-                # Note! This is a detail of the ResourceManager in a SerialContext
-                # TODO: rewrite with the pattern that this block is directing and then resolving an operation in the
-                #  operation's library/implementation context.
-                publishing_resources = self.publishing_resources()
-                for i in range(self.ensemble_width):
-                    # TODO: rewrite the following expression as a call to a resource factory.
-                    # TODO: Consider whether the resource_factory behavior should be normalized
-                    #  to always use `with` blocks to indicate the lifetime of a resource handle.
-                    #  That implies that an operation handle can expire, but the operation handle
-                    #  could be "yield"ed
-                    #  from within the `with` block to keep the resource scope alive until the resulting
-                    #  generator is exhausted. Not sure what that looks like or what the use case would be.
-                    with self.local_input(i) as input:
-                        # Note: Resources are marked "done" by the publishing system
-                        # before the following context manager finishes exiting.
-                        with publishing_resources(ensemble_member=i) as output:
-                            # self._runner(*input.args, output=output, **input.kwargs)
-                            ####
-                            # Here we can make _runner a thing that accepts session resources, and
-                            # is created by specializable builders. Separate out the expression of
-                            # inputs.
-                            #
-                            # resource_builder = OperationDetails.ResourcesBuilder(context)
-                            # runner_builder = OperationDetails.RunnerBuilder(context)
-                            # input_resource_director = self._input_resource_factory.director(input)
-                            # output_resource_director = self._publishing_resource_factory.director(output)
-                            # input_resource_director(resource_builder, runner_builder)
-                            # output_resource_director(resource_builder, runner_builder)
-                            # resources = resource_builder.build()
-                            # runner = runner_builder.build()
-                            # runner(resources)
-                            #
-                            # This resource factory signature might need to be inverted or broken up
-                            # into a builder for consistency. I.e.
-                            # option 1: Make the input and output resources with separate factories and add_resource on
-                            # the runner builder.
-                            # option 2: Pass resource_builder to input_director and then output_director.
-                            error_message = 'Got {} while executing {} for operation {}.'
-                            try:
-                                resources = self._resource_factory(input=input, output=output)
-                            except exceptions.TypeError as e:
-                                message = error_message.format(e, self._resource_factory, self.operation_id)
-                                raise exceptions.ApiError(message) from e
-
-                            runner = self._runner_director(resources)
-                            try:
-                                runner()
-                            except Exception as e:
-                                message = error_message.format(e, runner, self.operation_id)
-                                raise exceptions.ApiError(message) from e
-            if not self.done():
-                message = 'update_output implementation failed to update all outputs for {}.'
-                message = message.format(self.operation_id)
-                raise exceptions.ApiError(message)
+            for update_member in self.member_updates():
+                update_member()
+            self.check_updated()
+
+    def member_updates(self) -> typing.List[typing.Callable[[], None]]:
+        """Get the tasks that execute the bound operation for each ensemble member.
+
+        Claims the single execution of the operation allowed in the lifetime of
+        this resource manager. The tasks for different ensemble members are
+        independent, so they may be called in any order, including concurrently
+        from different threads, once the input of the operation is available.
+        After all tasks have been called, check_updated() checks the output.
+
+        Used internally to implement update_output() and the concurrent execution
+        of work graphs (see run_concurrently()).
+
+        Returns:
+            One callable per ensemble member, or an empty list if the output is up to date.
+
+        Raises:
+            exceptions.ProtocolError if the operation execution was already claimed.
+        """
+        if self.done():
+            return []
+        # Note: This check could also be encapsulated in a run_once decorator that
+        # could even set a data descriptor to change behavior.
+        self.__operation_entrance_counter += 1
+        if self.__operation_entrance_counter > 1:
+            raise exceptions.ProtocolError('Bug detected: resource manager tried to execute operation twice.')
+        # Note! This is a detail of the ResourceManager in a SerialContext
+        # TODO: rewrite with the pattern that this block is directing and then resolving an operation in the
+        #  operation's library/implementation context.
+        publishing_resources = self.publishing_resources()
+        return [functools.partial(self.__update_member, publishing_resources, i) for i in range(self.ensemble_width)]
+
+    def check_updated(self):
+        """Check that the operation published all of its outputs.
+
+        Raises:
+            exceptions.ApiError if operation runner failed to publish output.
+        """
+        if not self.done():
+            message = 'update_output implementation failed to update all outputs for {}.'
+            message = message.format(self.operation_id)
+            raise exceptions.ApiError(message)
+
+    def __update_member(self, publishing_resources, i: int):
+        """Execute the bound operation for ensemble member *i*."""
+        # TODO: rewrite the following expression as a call to a resource factory.
+        # TODO: Consider whether the resource_factory behavior should be normalized
+        #  to always use `with` blocks to indicate the lifetime of a resource handle.
+        #  That implies that an operation handle can expire, but the operation handle
+        #  could be "yield"ed
+        #  from within the `with` block to keep the resource scope alive until the resulting
+        #  generator is exhausted. Not sure what that looks like or what the use case would be.
+        with self.local_input(i) as input:
+            # Note: Resources are marked "done" by the publishing system
+            # before the following context manager finishes exiting.
+            with publishing_resources(ensemble_member=i) as output:
+                # self._runner(*input.args, output=output, **input.kwargs)
+                ####
+                # Here we can make _runner a thing that accepts session resources, and
+                # is created by specializable builders. Separate out the expression of
+                # inputs.
+                #
+                # resource_builder = OperationDetails.ResourcesBuilder(context)
+                # runner_builder = OperationDetails.RunnerBuilder(context)
+                # input_resource_director = self._input_resource_factory.director(input)
+                # output_resource_director = self._publishing_resource_factory.director(output)
+                # input_resource_director(resource_builder, runner_builder)
+                # output_resource_director(resource_builder, runner_builder)
+                # resources = resource_builder.build()
+                # runner = runner_builder.build()
+                # runner(resources)
+                #
+                # This resource factory signature might need to be inverted or broken up
+                # into a builder for consistency. I.e.
+                # option 1: Make the input and output resources with separate factories and add_resource on
+                # the runner builder.
+                # option 2: Pass resource_builder to input_director and then output_director.
+                error_message = 'Got {} while executing {} for operation {}.'
+                try:
+                    resources = self._resource_factory(input=input, output=output)
+                except exceptions.TypeError as e:
+                    message = error_message.format(e, self._resource_factory, self.operation_id)
+                    raise exceptions.ApiError(message) from e
+
+                runner = self._runner_director(resources)
+                try:
+                    runner()
+                except Exception as e:
+                    message = error_message.format(e, runner, self.operation_id)
+                    raise exceptions.ApiError(message) from e
 
     def future(self, name: str, description: ResultDescription):
         """Retrieve a Future for a named output.
@@ -2183,6 +2242,142 @@ def wrapped_function_runner(function, output_description: OutputCollectionDescri
                                     output_description=OutputCollectionDescription(data=return_type))
 
 
+def _futures_in(source) -> typing.Iterator[Future]:
+    """Generate the Futures in a data source of a DataSourceCollection."""
+    if isinstance(source, Future):
+        yield source
+    elif isinstance(source, EnsembleDataSource):
+        yield from _futures_in(source.source)
+    elif isinstance(source, datamodel.NDArray):
+        for item in source._values:
+            yield from _futures_in(item)
+    elif isinstance(source, (list, tuple)):
+        for item in source:
+            yield from _futures_in(item)
+
+
+def _upstream_resource_managers(resource_manager: SourceResource) -> typing.Set[ResourceManager]:
+    """Get the resource managers of the operations that provide input to *resource_manager*.
+
+    Proxied data is resolved by the consumer of the proxy, so the sources of a
+    ProxyResourceManager are reported instead of the proxy itself.
+    """
+    futures = []
+    if isinstance(resource_manager, ResourceManager):
+        for source in resource_manager._input_edge.source_collection.values():
+            futures.extend(_futures_in(source))
+    elif isinstance(resource_manager, ProxyResourceManager):
+        futures.append(resource_manager._proxied_future)
+    upstream = set()
+    for future in futures:
+        if isinstance(future.resource_manager, ResourceManager):
+            upstream.add(future.resource_manager)
+        else:
+            upstream.update(_upstream_resource_managers(future.resource_manager))
+    return upstream
+
+
+def run_concurrently(*operations, max_workers: int = None):
+    """Bring operations up to date, executing independent work concurrently.
+
+    Normally, operations execute one after the other in the calling thread as
+    results are requested and data dependencies are resolved recursively.
+    run_concurrently() finds all operations that the given operation handles
+    or Futures depend on and executes each one in a pool of worker threads as
+    soon as its input is available. The ensemble members of an operation are
+    independent, so they are executed concurrently as well. Results are then
+    retrieved as usual with ``result()``.
+
+    Worker threads are well suited to operations that wait on other processes,
+    such as commandline_operation. Python code in function_wrapper operations
+    still only executes in one thread at a time.
+
+    Arguments:
+        operations: Operation handles or Futures, or lists of them.
+        max_workers: Maximum number of tasks executed at the same time. Defaults to the number of CPUs.
+
+    Raises:
+        exceptions.ApiError if an operation fails. Tasks that have not started are then cancelled.
+        exceptions.ValueError if *max_workers* is not a positive integer.
+    """
+    if max_workers is None:
+        max_workers = os.cpu_count() or 1
+    if not isinstance(max_workers, int) or max_workers < 1:
+        raise exceptions.ValueError('max_workers must be a positive integer.')
+
+    # Find the work graph nodes, and for each node the nodes it still waits for.
+    requested = []
+    for operation in operations:
+        if isinstance(operation, (list, tuple)):
+            requested.extend(operation)
+        else:
+            requested.append(operation)
+    nodes = set()
+    for operation in requested:
+        if hasattr(operation, 'resource_manager'):
+            resource_manager = operation.resource_manager
+        elif hasattr(operation, 'output'):
+            resource_manager = operation.output._resource_instance
+        else:
+            raise exceptions.ValueError('Cannot run {}. Provide operation handles or Futures.'.format(operation))
+        if isinstance(resource_manager, ResourceManager):
+            nodes.add(resource_manager)
+        else:
+            nodes.update(_upstream_resource_managers(resource_manager))
+    waiting_for = {}
+    unexplored = list(nodes)
+    while unexplored:
+        node = unexplored.pop()
+        if node in waiting_for:
+            continue
+        waiting_for[node] = {upstream for upstream in _upstream_resource_managers(node) if not upstream.done()}
+        unexplored.extend(waiting_for[node])
+    consumers = collections.defaultdict(list)
+    for node, upstream_nodes in waiting_for.items():
+        for upstream in upstream_nodes:
+            consumers[upstream].append(node)
+
+    # Resource managers that customize update_output() are executed as a whole.
+    # The others are split into independent tasks for their ensemble members.
+    def tasks(node: ResourceManager) -> typing.List[typing.Callable[[], None]]:
+        if type(node).update_output is ResourceManager.update_output:
+            return node.member_updates()
+        else:
+            return [node.update_output]
+
+    with concurrent.futures.ThreadPoolExecutor(max_workers=max_workers) as executor:
+        remaining_tasks = {}
+        running = {}
+        ready = [node for node, upstream_nodes in waiting_for.items() if not upstream_nodes]
+        while ready or running:
+            for node in ready:
+                node_tasks = tasks(node) if not node.done() else []
+                remaining_tasks[node] = len(node_tasks)
+                for task in node_tasks:
+                    running[executor.submit(task)] = node
+            ready = [node for node in ready if remaining_tasks[node] == 0]
+            finished = list(ready)
+            ready = []
+            if running:
+                completed, _ = concurrent.futures.wait(running, return_when=concurrent.futures.FIRST_COMPLETED)
+                for task in completed:
+                    node = running.pop(task)
+                    if task.exception() is not None:
+                        for pending in running:
+                            pending.cancel()
+                        raise task.exception()
+                    remaining_tasks[node] -= 1
+                    if remaining_tasks[node] == 0:
+                        finished.append(node)
+            for node in finished:
+                if isinstance(node, ResourceManager) and type(node).update_output is ResourceManager.update_output:
+                    node.check_updated()
+                for consumer in consumers[node]:
+                    waiting_for[consumer].discard(node)
+                    if not waiting_for[consumer]:
+                        ready.append(consumer)
+
+
 # TODO: Refactor in terms of reference to a node in a Context.
 #  ResourceManager is an implementation detail of how the Context
 #  manages a node.
@@ -2769,9 +2964,32 @@ def function_wrapper(output: dict = None):
                 After the first call, output data has been published and is trivially
                 available through the output_data_proxy()
 
+                If the result cache is enabled (see gmxapi.cache), the cached
+                output is published instead of executing the function, if
+                available, and new output is added to the cache.
+
                 Overrides OperationDetailsBase.__call__().
                 """
+                result_cache = cache.current()
+                if result_cache is None:
+                    self._runner(resources)
+                    return
+
+                inputs = resources.input()
+                input_files, output_files = cache.files(inputs)
+                key = result_cache.key(self.__basename, inputs, input_files, implementation=function)
+                output = resources.output()
+                outputs = result_cache.load(key)
+                if outputs is not None:
+                    logger.info('Using cached result {} for {}.'.format(key, self.__basename))
+                    for name, value in outputs.items():
+                        setattr(output, name, value)
+                    return
+
                 self._runner(resources)
+                outputs = output._resource_instance.published_output(output._client_identifier)
+                if outputs is not None:
+                    result_cache.store(key, outputs, output_files)
 
             @classmethod
             def make_uid(cls, input):
@@ -2837,7 +3055,9 @@ def function_wrapper(output: dict = None):
                     if name != 'output':
                         expected = cls.signature()[name]
                         got = type(value)
-                        if got != expected:
+                        # An input left at a default of None is passed through as-is.
+                        default = cls.signature().signature.parameters[name].default
+                        if got != expected and not (value is None and default is None):
                             raise exceptions.TypeError(
                                 'Expected {} but got {} for {} resource {}.'.format(expected,
                                                                                     got,
@@ -40,8 +40,15 @@
  */
 #include "pycontext.h"
 
+#include <cstdint>
+
+#include <memory>
+
+#include "pybind11/numpy.h"
+
 #include "gmxapi/gmxapi.h"
 #include "gmxapi/md.h"
+#include "gmxapi/session/ensemble.h"
 
 
 namespace py = pybind11;
@@ -55,6 +62,107 @@ void PyContext::setMDArgs(const MDArgs& mdArgs)
     context_->setMDArgs(mdArgs);
 }
 
+void PyContext::joinNodeEnsemble(const std::string& name, int size, int rank)
+{
+    assert(context_);
+    context_->joinNodeEnsemble(name, size, rank);
+}
+
+namespace
+{
+
+/*!
+ * \brief Ensemble communicator backed by an mpi4py communicator.
+ *
+ * Used for ensembles whose members are not on the same node, since the
+ * Python package is not built with an MPI library. Collectives are issued
+ * from threads of the Session, so they acquire the GIL.
+ */
+class PyEnsembleCommunicator : public gmxapi::EnsembleCommunicator
+{
+public:
+    explicit PyEnsembleCommunicator(py::object communicator) :
+        communicator_(new py::object(std::move(communicator)),
+                      [](py::object* c) {
+                          py::gil_scoped_acquire gil;
+                          delete c;
+                      }),
+        size_(communicator_->attr("Get_size")().cast<int>()),
+        rank_(communicator_->attr("Get_rank")().cast<int>())
+    {
+    }
+
+    [[nodiscard]] int size() const override { return size_; }
+
+    [[nodiscard]] int rank() const override { return rank_; }
+
+protected:
+    void allReduceData(const void* send, void* recv, size_t count, DataType type) override
+    {
+        switch (type)
+        {
+            case DataType::Int32:
+                allReduce(static_cast<const int32_t*>(send), static_cast<int32_t*>(recv), count);
+                break;
+            case DataType::Int64:
+                allReduce(static_cast<const int64_t*>(send), static_cast<int64_t*>(recv), count);
+                break;
+            case DataType::Float:
+                allReduce(static_cast<const float*>(send), static_cast<float*>(recv), count);
+                break;
+            case DataType::Double:
+                allReduce(static_cast<const double*>(send), static_cast<double*>(recv), count);
+                break;
+        }
+    }
+
+    void broadcastBytes(void* buffer, size_t numBytes, int root) override
+    {
+        py::gil_scoped_acquire gil;
+        auto                   array = wrap(static_cast<uint8_t*>(buffer), numBytes);
+        communicator_->attr("Bcast")(array, py::arg("root") = root);
+    }
+
+    void allGatherBytes(const void* send, void* recv, size_t numBytes) override
+    {
+        py::gil_scoped_acquire gil;
+        // Copy the contribution, so that it does not alias the receive buffer.
+        py::array_t<uint8_t> sendArray(numBytes, static_cast<const uint8_t*>(send));
+        auto                 recvArray = wrap(static_cast<uint8_t*>(recv), numBytes * size_);
+        communicator_->attr("Allgather")(sendArray, recvArray);
+    }
+
+private:
+    //! Wrap \p count elements of \p buffer in a numpy array without copying.
+    template<typename T>
+    static py::array_t<T> wrap(T* buffer, size_t count)
+    {
+        py::capsule noOwner(buffer, [](void*) {});
+        return py::array_t<T>(count, buffer, noOwner);
+    }
+
+    template<typename T>
+    void allReduce(const T* send, T* recv, size_t count)
+    {
+        py::gil_scoped_acquire gil;
+        // Copy the contribution, since send and recv may be the same buffer.
+        py::array_t<T> sendArray(count, send);
+        communicator_->attr("Allreduce")(sendArray, wrap(recv, count));
+    }
+
+    std::shared_ptr<py::object> communicator_;
+    int                         size_;
+    int                         rank_;
+};
+
+} // namespace
+
+void PyContext::setEnsembleCommunicator(py::object communicator)
+{
+    assert(context_);
+    context_->setEnsembleCommunicator(std::make_shared<PyEnsembleCommunicator>(std::move(communicator)));
+}
+
 std::shared_ptr<gmxapi::Session> PyContext::launch(const gmxapi::Workflow& work)
 {
     assert(context_);
@@ -64,6 +64,8 @@ class PyContext
 public:
     PyContext();
     void                             setMDArgs(const MDArgs& mdArgs);
+    void joinNodeEnsemble(const std::string& name, int size, int rank);
+    void setEnsembleCommunicator(pybind11::object communicator);
     std::shared_ptr<gmxapi::Session> launch(const gmxapi::Workflow& work);
     std::shared_ptr<gmxapi::Context> get() const;
 
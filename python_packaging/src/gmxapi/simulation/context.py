@@ -46,6 +46,7 @@ import importlib
 import os
 import warnings
 import tempfile
+import uuid
 
 from gmxapi import exceptions
 from gmxapi import logger as root_logger
@@ -147,9 +148,26 @@ def _md(context, element):
             def launch(rank=None):
                 assert not rank is None
 
-                # Copy and update, if required by `end_time` parameter.
+                # Workaround to give access to plugin potentials used in a context.
+                pycontext = element.workspec._context
+
                 temp_filename = None
-                if 'end_time' in self.runtime_params:
+                if rank in pycontext.simulation_input:
+                    # The (modified) input is held in memory. Launch from it without a TPR file.
+                    parameters = pycontext.simulation_input[rank]
+                    if 'end_time' in self.runtime_params:
+                        values = parameters.extract()
+                        # Round as rewrite_tprfile() does for the file-based input.
+                        nsteps = _gmxapi.nsteps_for_end_time(
+                            init_step=values['init-step'],
+                            dt=values['dt'],
+                            tinit=values['tinit'],
+                            end_time=self.runtime_params['end_time'])
+                        parameters.set(key='nsteps', value=nsteps)
+                    logger.info('Loading simulation input for member {} from memory.'.format(rank))
+                    system = _gmxapi.from_tpr_contents(parameters)
+                elif 'end_time' in self.runtime_params:
+                    # Copy and update, as required by `end_time` parameter.
                     # Note that mkstemp returns a file descriptor as the first part of the tuple.
                     # We can make this cleaner in 0.0.7 with a separate node that manages the
                     # altered input.
@@ -158,17 +176,15 @@ def _md(context, element):
                     _gmxapi.rewrite_tprfile(source=infile[rank],
                                          destination=temp_filename,
                                          end_time=self.runtime_params['end_time'])
-                    tpr_file = temp_filename
+                    logger.info('Loading TPR file: {}'.format(temp_filename))
+                    system = _gmxapi.from_tpr(temp_filename)
                 else:
-                    tpr_file = infile[rank]
+                    logger.info('Loading TPR file: {}'.format(infile[rank]))
+                    system = _gmxapi.from_tpr(infile[rank])
 
-                logger.info('Loading TPR file: {}'.format(tpr_file))
-                system = _gmxapi.from_tpr(tpr_file)
                 dag.nodes[name]['system'] = system
                 mdargs = _gmxapi.MDArgs()
                 mdargs.set(self.runtime_params)
-                # Workaround to give access to plugin potentials used in a context.
-                pycontext = element.workspec._context
                 pycontext.potentials = potential_list
                 context = pycontext._api_object
                 context.setMDArgs(mdargs)
@@ -177,7 +193,7 @@ def _md(context, element):
                 dag.nodes[name]['session'] = system.launch(context)
                 dag.nodes[name]['close'] = dag.nodes[name]['session'].close
 
-                if 'end_time' in self.runtime_params:
+                if temp_filename is not None:
                     def special_close():
                         dag.nodes[name]['session'].close()
                         logger.debug("Unlinking temporary TPR file {}.".format(temp_filename))
@@ -275,6 +291,34 @@ def _get_mpi_ensemble_communicator(session_communicator, ensemble_size):
     return ensemble_communicator
 
 
+def _set_library_ensemble_communicator(api_context, ensemble_communicator):
+    """Give the ensemble communicator of a session to the library Context.
+
+    Must be called on all ranks in `ensemble_communicator`. Ensemble members on
+    the same node join a node ensemble, which communicates through shared memory
+    without calling back into Python. Otherwise, the library Context
+    communicates through `ensemble_communicator`.
+    """
+    from mpi4py import MPI
+
+    size = ensemble_communicator.Get_size()
+    rank = ensemble_communicator.Get_rank()
+    node_communicator = ensemble_communicator.Split_type(MPI.COMM_TYPE_SHARED)
+    on_one_node = node_communicator.Get_size() == size
+    node_communicator.Free()
+    if on_one_node:
+        # The shared memory segment needs a name that is unique on the node.
+        name = None
+        if rank == 0:
+            name = 'gmxapi-ensemble-{}-{}'.format(os.getpid(), uuid.uuid4().hex[:8])
+        name = ensemble_communicator.bcast(name, root=0)
+        logger.debug('Joining node ensemble {} as member {} of {}.'.format(name, rank, size))
+        api_context.join_node_ensemble(name, size, rank)
+    else:
+        logger.debug('Using the session ensemble communicator for member {} of {}.'.format(rank, size))
+        api_context.set_ensemble_communicator(ensemble_communicator)
+
+
 class _DummyCommunicator(object):
     """Placeholder class for trivial communication resources.
 
@@ -588,6 +632,11 @@ class Context(object):
         # is subject to change.
         self.rank = None
 
+        # Simulation input held in memory, keyed by ensemble member. For members
+        # listed here, the MD operation launches from the input in memory instead
+        # of reading the TPR file named in the work specification.
+        self.simulation_input = {}
+
         # `work_width` notes the required width of an array of synchronous tasks to perform the specified work.
         # As work elements are processed, self.work_width will be increased as appropriate.
         self.work_width = None
@@ -889,6 +938,10 @@ class Context(object):
         # For gmxapi 0.0.6, all ranks have a session_ensemble_communicator
         self._session_ensemble_communicator = _get_ensemble_communicator(self._session_communicator, self.work_width)
         self.__ensemble_update = _get_ensemble_update(self)
+        # MD plugins communicate through the ensemble communicator of the library Context.
+        if self._session_ensemble_communicator is not None \
+                and self._session_ensemble_communicator.Get_size() > 1:
+            _set_library_ensemble_communicator(self._api_object, self._session_ensemble_communicator)
 
         # launch() is currently a method of gmx.core.MDSystem and returns a gmxapi::Session.
         # MDSystem objects are obtained from gmx.core.from_tpr(). They also provide add_potential().
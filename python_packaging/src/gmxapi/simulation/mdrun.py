@@ -161,7 +161,7 @@ class LegacyImplementationSubscription(object):
         # Configure and run a gmxapi 0.0.7 session.
         # 0. Determine ensemble width.
         # 1. Choose, create/check working directories.
-        # 2. Create source TPR.
+        # 2. Prepare (modified) simulation input in memory.
         # 3. Create workspec.
         # 3.5 Add plugin potentials, if any.
         # 4. Run.
@@ -205,10 +205,16 @@ class LegacyImplementationSubscription(object):
                         # If there are any other key word arguments to process from the gmxapi.mdrun
                         # factory call, do it here.
 
-                    # TODO: We should really name this file with a useful input-dependent tag.
-                    tprfile = os.path.join(self.workdir, 'topol.tpr')
-
-                    expected_working_files = [tprfile]
+                    # The modified input stays in memory and is launched without writing a TPR file.
+                    sim_input = fileio.read_tpr(source_file)
+                    for key, value in parameters.items():
+                        try:
+                            sim_input.parameters.set(key=key, value=value)
+                        except _gmxapi.Exception as e:
+                            raise exceptions.ApiError(
+                                'Bug encountered. Unknown error when trying to set simulation '
+                                'parameter {} to {}'.format(key, value)
+                            ) from e
 
                     if os.path.exists(self.workdir):
                         if os.path.isdir(self.workdir):
@@ -216,44 +222,30 @@ class LegacyImplementationSubscription(object):
                             # It is unspecified by the API, but at least through gmxapi 0.1,
                             # all simulations are initialized with a checkpoint file named state.cpt
                             # (see src/api/cpp/context.cpp)
-                            checkpoint_file = os.path.join(self.workdir, 'state.cpp')
-                            expected_working_files.append(checkpoint_file)
-
-                            for file in expected_working_files:
-                                if not os.path.exists(file):
-                                    raise exceptions.ApiError(
-                                        'Cannot determine working directory state: {}'.format(self.workdir))
+                            checkpoint_file = os.path.join(self.workdir, 'state.cpt')
+                            if not os.path.exists(checkpoint_file):
+                                raise exceptions.ApiError(
+                                    'Cannot determine working directory state: {}'.format(self.workdir))
                         else:
                             raise exceptions.ApiError(
                                 'Chosen working directory path exists but is not a directory: {}'.format(self.workdir))
                     else:
-                        # Build the working directory and input files.
+                        # Build the working directory.
                         os.mkdir(self.workdir)
-                        sim_input = fileio.read_tpr(source_file)
-                        for key, value in parameters.items():
-                            try:
-                                sim_input.parameters.set(key=key, value=value)
-                            except _gmxapi.Exception as e:
-                                raise exceptions.ApiError(
-                                    'Bug encountered. Unknown error when trying to set simulation '
-                                    'parameter {} to {}'.format(key, value)
-                                ) from e
-
-                        fileio.write_tpr_file(output=tprfile, input=sim_input)
-                    logger.info('Created {} on rank {}'.format(tprfile, context_rank))
+                    logger.info('Prepared input for {} on rank {}'.format(self.workdir, context_rank))
 
                     # Gather the actual outputs from the ensemble members.
+                    parameters = sim_input.parameters.extract()
                     if hasattr(ensemble_comm, 'allgather'):
                         # We should not assume that abspath expands the same on different MPI ranks.
                         workdir_list = ensemble_comm.allgather(self.workdir)
-                        tpr_filenames = ensemble_comm.allgather(tprfile)
-                        parameters = fileio.read_tpr(tprfile).parameters.extract()
+                        tpr_filenames = ensemble_comm.allgather(source_file)
                         parameters_dict_list = ensemble_comm.allgather(parameters)
                     else:
-                        workdir_list = [os.path.abspath(workdir) for workdir in workdir_list]
-                        # TODO: If we use better input file names, they need to be updated in multiple places.
-                        tpr_filenames = [os.path.join(workdir, 'topol.tpr') for workdir in workdir_list]
-                        parameters_dict_list = [fileio.read_tpr(tprfile).parameters.extract() for tprfile in tpr_filenames]
+                        # Without an ensemble communicator, there is only one member.
+                        workdir_list = [self.workdir]
+                        tpr_filenames = [source_file]
+                        parameters_dict_list = [parameters]
 
                     logger.debug('Context rank {} acknowledges working directories {}'.format(context_rank,
                                                                                              workdir_list))
@@ -269,6 +261,7 @@ class LegacyImplementationSubscription(object):
                     work = workflow.from_tpr(tpr_filenames, **kwargs)
                     self.workspec = work.workspec
                     context = LegacyContext(work=self.workspec, workdir_list=workdir_list, communicator=ensemble_comm)
+                    context.simulation_input[ensemble_rank] = sim_input.parameters
                     self.simulation_module_context = context
                     # Go ahead and execute immediately. No need for lazy initialization in this basic case.
                     with self.simulation_module_context as session:
@@ -210,5 +210,52 @@ def test_failure(cleandir):
         filewriter2.run()
 
 
+def test_cached_result(cleandir):
+    """With the result cache, the command is only executed again if the input changes."""
+    input_file = os.path.join(cleandir, 'input')
+    output_file = os.path.join(cleandir, 'output')
+    counter = os.path.join(cleandir, 'counter')
+    with open(input_file, 'w') as fh:
+        fh.write('first line\n')
+
+    # Make a shell script that records each execution.
+    scriptname = os.path.join(cleandir, 'clicommand.sh')
+    with open(scriptname, 'w') as fh:
+        fh.write('\n'.join(['#!' + shutil.which('bash'),
+                            '#     clicommand.sh -i inputfile -o outputfile',
+                            'echo run >> ' + counter,
+                            'cat $2 > $4\n']))
+    os.chmod(scriptname, stat.S_IRWXU)
+
+    def run_count():
+        with open(counter, 'r') as fh:
+            return len(fh.readlines())
+
+    def copy_file():
+        operation = gmx.commandline_operation(scriptname,
+                                              input_files={'-i': input_file},
+                                              output_files={'-o': output_file})
+        assert operation.output.returncode.result() == 0
+        assert operation.output.file['-o'].result() == output_file
+        with open(output_file, 'r') as fh:
+            return fh.read()
+
+    gmx.cache.enable(os.path.join(cleandir, 'cache'))
+    try:
+        assert copy_file() == 'first line\n'
+        assert run_count() == 1
+        # Output files are restored from the cache.
+        os.unlink(output_file)
+        assert copy_file() == 'first line\n'
+        assert run_count() == 1
+        # Changed input files are detected.
+        with open(input_file, 'w') as fh:
+            fh.write('second line\n')
+        assert copy_file() == 'second line\n'
+        assert run_count() == 2
+    finally:
+        gmx.cache.disable()
+
+
 if __name__ == '__main__':
     unittest.main()
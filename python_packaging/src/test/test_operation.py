@@ -41,6 +41,7 @@ import os
 import shutil
 import stat
 import tempfile
+import threading
 import unittest
 
 import gmxapi as gmx
@@ -129,5 +130,82 @@ class OperationPipelineTestCase(unittest.TestCase):
             assert lines[1] == line2
 
 
+class ConcurrentExecutionTestCase(unittest.TestCase):
+    """Test concurrent execution of independent operations."""
+
+    def test_dependencies(self):
+        """Execute a diamond-shaped graph and check that data flows as expected."""
+        @gmx.function_wrapper()
+        def add(a: int, b: int) -> int:
+            return a + b
+
+        top = add(1, 2)
+        left = add(top.output.data, 10)
+        right = add(top.output.data, 100)
+        bottom = add(left.output.data, right.output.data)
+        gmx.run_concurrently(bottom, max_workers=2)
+        assert bottom.output.data.result() == 116
+        assert left.output.data.result() == 13
+        assert right.output.data.result() == 103
+
+    def test_independent_work_overlaps(self):
+        """Independent operations and ensemble members must be able to run at the same time."""
+        barrier = threading.Barrier(4, timeout=60)
+
+        @gmx.function_wrapper()
+        def rendezvous(value: int) -> int:
+            # Raises BrokenBarrierError if fewer than 4 tasks are executing at once.
+            barrier.wait()
+            return value
+
+        ensemble = rendezvous(value=[1, 2])
+        single = [rendezvous(value=3), rendezvous(value=4)]
+        gmx.run_concurrently(ensemble, single, max_workers=4)
+        assert ensemble.output.data.result() == [1, 2]
+        assert [op.output.data.result() for op in single] == [3, 4]
+
+    def test_errors(self):
+        with self.assertRaises(gmx.exceptions.ValueError):
+            gmx.run_concurrently(gmx.make_constant(1), max_workers=0)
+
+        @gmx.function_wrapper()
+        def fail(value: int) -> int:
+            raise RuntimeError('Failure in operation.')
+
+        @gmx.function_wrapper()
+        def downstream(value: int) -> int:
+            return value
+
+        consumer = downstream(fail(1).output.data)
+        with self.assertRaises(gmx.exceptions.ApiError):
+            gmx.run_concurrently(consumer)
+
+
+class ResultCacheTestCase(unittest.TestCase):
+    """Test the on-disk cache of operation results."""
+
+    def test_function_results(self):
+        calls = []
+
+        @gmx.function_wrapper()
+        def scale(value: float, factor: float) -> float:
+            calls.append(value)
+            return value * factor
+
+        with tempfile.TemporaryDirectory() as directory:
+            gmx.cache.enable(directory)
+            try:
+                assert scale(2., 3.).output.data.result() == 6.
+                assert scale(2., 3.).output.data.result() == 6.
+                assert len(calls) == 1
+                # Ensemble members are cached separately.
+                assert scale([2., 4.], 3.).output.data.result() == [6., 12.]
+                assert calls == [2., 4.]
+            finally:
+                gmx.cache.disable()
+            assert scale(2., 3.).output.data.result() == 6.
+            assert len(calls) == 3
+
+
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,159 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "gromacs/restraint/restraintpotential.h"
+#include "gromacs/utility/exceptions.h"
+
+#include "gmxapi/context.h"
+#include "gmxapi/md.h"
+#include "gmxapi/session.h"
+#include "gmxapi/session/ensemble.h"
+#include "gmxapi/session/resources.h"
+#include "gmxapi/status.h"
+#include "gmxapi/system.h"
+#include "gmxapi/md/mdmodule.h"
+
+#include "testingconfiguration.h"
+
+namespace gmxapi
+{
+
+namespace testing
+{
+
+namespace
+{
+
+/*!
+ * \brief Restraint that reduces a counter over the ensemble with split-phase reductions.
+ *
+ * Each evaluation completes the reduction started by the previous one
+ * before starting the next, so the communication overlaps with an MD step.
+ */
+class SplitPhaseReducer : public gmx::IRestraintPotential
+{
+public:
+    gmx::PotentialPointData evaluate(gmx::Vector /* r_site */, gmx::Vector /* r_ref */, double /* t */) override
+    {
+        pending_.wait();
+        if (numStarted_ > 0)
+        {
+            results_.push_back(recv_[0]);
+        }
+        ++numStarted_;
+        const std::vector<double> send = { static_cast<double>(numStarted_) };
+        pending_ = gmxapi::startEnsembleReduce(resources_, send.data(), recv_.data(), send.size());
+        return { { 0., 0., 0. }, 0. };
+    }
+
+    std::vector<int> sites() const override { return { { 0, 1 } }; }
+
+    void bindSession(gmxapi::SessionResources* resources) override { resources_ = resources; }
+
+    //! Number of reductions started.
+    int numStarted_ = 0;
+    //! Results of the completed reductions.
+    std::vector<double> results_;
+
+private:
+    gmxapi::SessionResources* resources_ = nullptr;
+    gmxapi::EnsembleReduction pending_;
+    std::vector<double>       recv_ = std::vector<double>(1);
+};
+
+//! Wrap a SplitPhaseReducer for testing purposes.
+class SplitPhaseReducerModule : public gmxapi::MDModule
+{
+public:
+    const char* name() const override { return "SplitPhaseReducer"; }
+
+    std::shared_ptr<gmx::IRestraintPotential> getRestraint() override { return restraint_; }
+
+    //! Restraint to provide to the simulator.
+    std::shared_ptr<SplitPhaseReducer> restraint_ = std::make_shared<SplitPhaseReducer>();
+};
+
+/*!
+ * \brief Check that ensemble reductions started in one step can be completed in the next.
+ */
+TEST_F(GmxApiTest, SplitPhaseEnsembleReduce)
+{
+    const int nsteps = 3;
+    makeTprFile(nsteps);
+    auto system  = gmxapi::fromTprFile(runner_.tprFileName_);
+    auto context = std::make_shared<gmxapi::Context>(gmxapi::createContext());
+
+    gmxapi::MDArgs args = makeMdArgs();
+    context->setMDArgs(args);
+    // Emulate an ensemble of two identical members.
+    std::atomic<int> numReduced{ 0 };
+    context->setEnsembleReduce([&numReduced](const double* send, double* recv, size_t size) {
+        for (size_t i = 0; i < size; ++i)
+        {
+            recv[i] = 2 * send[i];
+        }
+        ++numReduced;
+    });
+
+    auto module  = std::make_shared<SplitPhaseReducerModule>();
+    auto session = system.launch(context);
+    EXPECT_TRUE(session);
+    gmxapi::addSessionRestraint(session.get(), module);
+
+    gmxapi::Status status;
+    ASSERT_NO_THROW(status = session->run());
+    EXPECT_TRUE(status.success());
+    status = session->close();
+    EXPECT_TRUE(status.success());
+
+    // Closing the session completes the last reduction.
+    const auto& restraint = *module->restraint_;
+    EXPECT_EQ(numReduced, restraint.numStarted_);
+    ASSERT_EQ(restraint.results_.size(), static_cast<size_t>(restraint.numStarted_ - 1));
+    for (size_t i = 0; i < restraint.results_.size(); ++i)
+    {
+        EXPECT_EQ(restraint.results_[i], 2.0 * (i + 1));
+    }
+}
+
+} // end anonymous namespace
+
+} // end namespace testing
+
+} // end namespace gmxapi
@@ -33,6 +33,7 @@
  * the research papers on the package. Check out http://www.gromacs.org.
  */
 #include <memory>
+#include <string>
 
 #include "testingconfiguration.h"
 #include "gmxapi/context.h"
@@ -95,9 +96,13 @@ public:
     /*! \cond
      * Implement gmxapi::MDModule interface.
      */
-    SimpleApiModule() : restraint_(std::make_shared<NullRestraint>()) {}
+    explicit SimpleApiModule(std::string name = "SimpleApiModule") :
+        name_(std::move(name)),
+        restraint_(std::make_shared<NullRestraint>())
+    {
+    }
 
-    const char* name() const override { return "SimpleApiModule"; }
+    const char* name() const override { return name_.c_str(); }
 
     std::shared_ptr<gmx::IRestraintPotential> getRestraint() override { return restraint_; }
     //! \endcond
@@ -110,6 +115,8 @@ public:
     bool hasBeenCalled() const { return restraint_->hasBeenCalled(); }
 
 private:
+    //! Name of the module.
+    std::string name_;
     //! restraint to provide to client or MD simulator, as well as to use to implement hasBeenCalled.
     std::shared_ptr<NullRestraint> restraint_;
 };
@@ -146,6 +153,49 @@ TEST_F(GmxApiTest, ApiRunnerRestrainedMD)
     }
 }
 
+/*!
+ * \brief Check that the time spent in each restraint can be queried.
+ *
+ * The names of the restraints only differ after the characters shown in the log file.
+ */
+TEST_F(GmxApiTest, ApiRunnerReportsModuleTimings)
+{
+    makeTprFile(2);
+    auto system = gmxapi::fromTprFile(runner_.tprFileName_);
+
+    auto           context = std::make_shared<gmxapi::Context>(gmxapi::createContext());
+    gmxapi::MDArgs args    = makeMdArgs();
+    context->setMDArgs(args);
+
+    auto first   = std::make_shared<SimpleApiModule>("SimpleApiModuleWithLongName1");
+    auto second  = std::make_shared<SimpleApiModule>("SimpleApiModuleWithLongName2");
+    auto session = system.launch(context);
+    gmxapi::addSessionRestraint(session.get(), first);
+    gmxapi::addSessionRestraint(session.get(), second);
+    EXPECT_TRUE(session->moduleTimings().empty());
+
+    gmxapi::Status status;
+    ASSERT_NO_THROW(status = session->run());
+    EXPECT_TRUE(status.success());
+    status = session->close();
+    EXPECT_TRUE(status.success());
+
+    // The timings remain available after the session is closed.
+    const auto timings = session->moduleTimings();
+    ASSERT_EQ(timings.size(), 2);
+    EXPECT_EQ(timings[0].name, first->name());
+    EXPECT_EQ(timings[1].name, second->name());
+    for (const gmxapi::ModuleTiming& timing : timings)
+    {
+        // One evaluation and one update per step, for steps 0 to 2.
+        EXPECT_EQ(timing.numEvaluations, 3);
+        EXPECT_EQ(timing.numUpdates, 3);
+        EXPECT_EQ(timing.numReductions, 0);
+        EXPECT_GE(timing.evaluationSeconds, 0);
+        EXPECT_GE(timing.updateSeconds, 0);
+    }
+}
+
 } // end anonymous namespace
 
 } // end namespace testing
@@ -32,6 +32,8 @@
  * To help us fund GROMACS development, we humbly ask that you cite
  * the research papers on the package. Check out http://www.gromacs.org.
  */
+#include <cstdio>
+
 #include <memory>
 
 #include "testingconfiguration.h"
@@ -39,6 +41,8 @@
 #include "gmxapi/session.h"
 #include "gmxapi/status.h"
 #include "gmxapi/system.h"
+#include "gmxapi/compat/mdparams.h"
+#include "gmxapi/compat/tpr.h"
 
 #include "gromacs/mdlib/sighandler.h"
 #include "gromacs/mdtypes/iforceprovider.h"
@@ -175,6 +179,64 @@ TEST_F(GmxApiTest, RunnerContinuedMD)
     }
 }
 
+/*!
+ * \brief Test that a context launches several sessions with the same arguments.
+ */
+TEST_F(GmxApiTest, RunnerRepeatedLaunch)
+{
+    makeTprFile(2);
+    auto context = std::make_shared<gmxapi::Context>(gmxapi::createContext());
+    context->setMDArgs(makeMdArgs());
+
+    auto system = gmxapi::fromTprFile(runner_.tprFileName_);
+    for (int segment = 0; segment < 3; ++segment)
+    {
+        auto session = system.launch(context);
+        ASSERT_TRUE(session != nullptr);
+        gmxapi::Status status;
+        ASSERT_NO_THROW(status = session->run());
+        EXPECT_TRUE(status.success());
+        ASSERT_NO_THROW(status = session->close());
+        EXPECT_TRUE(status.success());
+    }
+}
+
+/*!
+ * \brief Test that a simulation runs from modified TPR contents without a new TPR file.
+ */
+TEST_F(GmxApiTest, RunnerInMemoryInput)
+{
+    makeTprFile(2);
+    auto tprReadHandle = gmxapicompat::readTprFile(runner_.tprFileName_);
+    auto params        = gmxapicompat::getMdParams(*tprReadHandle);
+    gmxapicompat::setParam(params.get(), "nsteps", int64_t(4));
+    auto system = gmxapicompat::fromTprContents(*tprReadHandle);
+    // The simulation input must not be read from disk again.
+    ASSERT_EQ(std::remove(runner_.tprFileName_.c_str()), 0);
+
+    auto context = std::make_shared<gmxapi::Context>(gmxapi::createContext());
+    context->setMDArgs(makeMdArgs());
+    auto session = system.launch(context);
+    ASSERT_TRUE(session != nullptr);
+    gmxapi::Status status;
+    ASSERT_NO_THROW(status = session->run());
+    EXPECT_TRUE(status.success());
+    ASSERT_NO_THROW(status = session->close());
+    EXPECT_TRUE(status.success());
+}
+
+/*!
+ * \brief Test that an end time half way between two steps rounds away from zero.
+ *
+ * Clients that set nsteps from an end time must agree with rewrite_tprfile().
+ */
+TEST(GmxApiCompatTest, NstepsForEndTimeRoundsHalfStepsUp)
+{
+    EXPECT_EQ(gmxapicompat::nstepsForEndTime(0, 1.0, 0.0, 2.5), 3);
+    EXPECT_EQ(gmxapicompat::nstepsForEndTime(0, 1.0, 0.0, 3.5), 4);
+    EXPECT_EQ(gmxapicompat::nstepsForEndTime(10, 0.5, 1.0, 11.0), 10);
+}
+
 } // end anonymous namespace
 
 } // end namespace testing
@@ -0,0 +1,197 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+#include "config.h"
+
+#include <cstdint>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef HAVE_UNISTD_H
+#    include <fcntl.h>
+#    include <unistd.h>
+#    include <sys/mman.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/sysinfo.h"
+
+#include "gmxapi/context.h"
+#include "gmxapi/exceptions.h"
+#include "gmxapi/session/ensemble.h"
+
+#include "context_impl.h"
+
+namespace gmxapi
+{
+
+namespace testing
+{
+
+namespace
+{
+
+//! Name of the node ensembles of this test process.
+std::string nodeEnsembleName()
+{
+    return "gmxapi-test-ensemble-" + std::to_string(gmx_getpid());
+}
+
+/*! \brief Run \p function as each member of a node ensemble of \p size members on threads.
+ *
+ * Member 0 joins last, after \p delay.
+ */
+template<typename Function>
+void runNodeEnsemble(int size, const Function& function, std::chrono::milliseconds delay = {})
+{
+    const std::string        name = nodeEnsembleName();
+    std::vector<std::thread> members;
+    for (int rank = size - 1; rank >= 0; --rank)
+    {
+        if (rank == 0)
+        {
+            std::this_thread::sleep_for(delay);
+        }
+        members.emplace_back([&name, size, rank, &function]() {
+            auto communicator = createNodeEnsembleCommunicator(name, size, rank);
+            function(communicator.get());
+        });
+    }
+    for (auto& member : members)
+    {
+        member.join();
+    }
+}
+
+TEST(EnsembleCommunicatorTest, SingleMemberCopies)
+{
+    auto                communicator = createSingleMemberEnsembleCommunicator();
+    std::vector<double> send         = { 1.0, 2.0 };
+    std::vector<double> recv(2);
+    communicator->allReduce(send.data(), recv.data(), send.size());
+    EXPECT_EQ(recv, send);
+    EXPECT_ANY_THROW(communicator->broadcast(recv.data(), recv.size(), 1));
+}
+
+TEST(EnsembleCommunicatorTest, ContextRejectsNullClientCommunicator)
+{
+    auto context = createContext();
+    EXPECT_THROW(context.setEnsembleCommunicator(std::shared_ptr<EnsembleCommunicator>()), UsageError);
+}
+
+TEST(EnsembleCommunicatorTest, RejectsInvalidRank)
+{
+    EXPECT_ANY_THROW(createNodeEnsembleCommunicator("gmxapi-test-invalid", 2, 2));
+}
+
+#ifdef HAVE_UNISTD_H
+TEST(EnsembleCommunicatorTest, NodeEnsembleCollectives)
+{
+    const int size = 3;
+    // Larger than the buffer of a member, so that collectives proceed in chunks.
+    const size_t     numElements = 300000;
+    std::vector<int> reduced(size), broadcast(size), gathered(size), reducedInPlace(size);
+    runNodeEnsemble(size, [&](EnsembleCommunicator* communicator) {
+        const int rank = communicator->rank();
+        EXPECT_EQ(size, communicator->size());
+
+        std::vector<double> send(numElements, rank + 1.0);
+        std::vector<double> recv(numElements);
+        communicator->allReduce(send.data(), recv.data(), numElements);
+        reduced[rank] = std::all_of(recv.begin(), recv.end(), [](double v) { return v == 6.0; });
+
+        std::vector<int32_t> counts = { rank, 1 };
+        communicator->allReduce(counts.data(), counts.data(), counts.size());
+        reducedInPlace[rank] = (counts == std::vector<int32_t>{ 3, size });
+
+        std::vector<int64_t> values(numElements, rank == 1 ? 42 : 0);
+        communicator->broadcast(values.data(), values.size(), 1);
+        broadcast[rank] = std::all_of(values.begin(), values.end(), [](int64_t v) { return v == 42; });
+
+        const std::vector<float> mine = { float(rank), float(10 * rank) };
+        std::vector<float>       all(size * mine.size());
+        communicator->allGather(mine.data(), all.data(), mine.size());
+        gathered[rank] = (all == std::vector<float>{ 0, 0, 1, 10, 2, 20 });
+    });
+    for (int rank = 0; rank < size; ++rank)
+    {
+        EXPECT_TRUE(reduced[rank]) << "rank " << rank;
+        EXPECT_TRUE(reducedInPlace[rank]) << "rank " << rank;
+        EXPECT_TRUE(broadcast[rank]) << "rank " << rank;
+        EXPECT_TRUE(gathered[rank]) << "rank " << rank;
+    }
+}
+
+TEST(EnsembleCommunicatorTest, NodeEnsembleReplacesStaleSegment)
+{
+    // Leave behind a segment of the right size in which no counter is zero,
+    // as a run that crashed during a collective might.
+    const std::string name        = "/" + nodeEnsembleName();
+    const size_t      segmentSize = (2 << 20) + 256;
+    const int         fd = shm_open(name.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(0, ftruncate(fd, segmentSize));
+    void* segment = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(MAP_FAILED, segment);
+    std::fill_n(static_cast<char*>(segment), segmentSize, ~0);
+    munmap(segment, segmentSize);
+
+    const int        size = 2;
+    std::vector<int> reduced(size);
+    // Let the other member attach to the stale segment before member 0 replaces it.
+    runNodeEnsemble(size,
+                    [&](EnsembleCommunicator* communicator) {
+                        const int rank = communicator->rank();
+                        int32_t   sum  = rank + 1;
+                        communicator->allReduce(&sum, &sum, 1);
+                        reduced[rank] = (sum == 3);
+                    },
+                    std::chrono::milliseconds(100));
+    EXPECT_TRUE(reduced[0]);
+    EXPECT_TRUE(reduced[1]);
+}
+#endif
+
+} // end anonymous namespace
+
+} // end namespace testing
+
+} // end namespace gmxapi
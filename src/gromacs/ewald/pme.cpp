@@ -82,6 +82,7 @@
 
 #include <algorithm>
 #include <list>
+#include <memory>
 
 #include "gromacs/domdec/domdec.h"
 #include "gromacs/ewald/ewald_utils.h"
@@ -1693,6 +1694,25 @@ void gmx_pme_destroy(gmx_pme_t* pme)
     delete pme;
 }
 
+std::shared_ptr<t_commrec> gmx_pme_make_single_rank_commrec()
+{
+    // Value-initialized, so that there is no domain decomposition and no MPI buffers
+    auto cr = std::make_shared<t_commrec>();
+
+    cr->mpiDefaultCommunicator    = MPI_COMM_NULL;
+    cr->sizeOfDefaultCommunicator = 1;
+    cr->rankInDefaultCommunicator = 0;
+    cr->nnodes                    = 1;
+    cr->npmenodes                 = 0;
+    cr->nodeid                    = 0;
+    cr->sim_nodeid                = 0;
+    cr->mpi_comm_mysim            = MPI_COMM_NULL;
+    cr->mpi_comm_mygroup          = MPI_COMM_NULL;
+    cr->duty                      = (DUTY_PP | DUTY_PME);
+
+    return cr;
+}
+
 void gmx_pme_reinit_atoms(gmx_pme_t* pme, const int numAtoms, const real* chargesA, const real* chargesB)
 {
     if (pme->gpu != nullptr)
@@ -49,6 +49,7 @@
 #ifndef GMX_EWALD_PME_H
 #define GMX_EWALD_PME_H
 
+#include <memory>
 #include <string>
 
 #include "gromacs/gpu_utils/devicebuffer_datatype.h"
@@ -167,6 +168,15 @@ void gmx_pme_reinit(gmx_pme_t**       pmedata,
 /*! \brief Destroys the PME data structure.*/
 void gmx_pme_destroy(gmx_pme_t* pme);
 
+/*! \brief Returns a communication record for PME on a single rank without MPI
+ *
+ * The record describes one rank with both PP and PME duties. It is meant for
+ * callers of gmx_pme_init() and gmx_pme_do() outside mdrun, which do not set up
+ * a communication record themselves. The record can be used and freed without
+ * including the MPI headers.
+ */
+std::shared_ptr<t_commrec> gmx_pme_make_single_rank_commrec();
+
 /*! \brief Do a PME calculation on a CPU for the long range electrostatics and/or LJ.
  *
  * Computes the PME forces and the energy and viral, when requested,
@@ -0,0 +1,368 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements the encoding and reading of distributed XTC (DXTC) trajectories.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "dxtcio.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "gromacs/fileio/xdrf.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/stringutil.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Magic number of the file header, "DXTC" in ASCII
+const int c_dxtcFileMagic = 0x44585443;
+//! Magic number of each frame header
+const int c_dxtcFrameMagic = 0x44585446;
+//! The version of the format
+const int c_dxtcVersion = 1;
+//! The number of bytes of the frame header before the block sizes
+const int c_frameHeaderSize = 4 + 8 + 4 + 9 * 4 + 4;
+
+/*! \brief Returns an upper bound for the number of bytes of XTC compressed coordinates
+ *
+ * The compression uses at most 1.2*3 integers per atom, we add space
+ * for the headers and for the chunk index of large frames.
+ */
+size_t maxCompressedSize(int numAtoms)
+{
+    return 16 * static_cast<size_t>(numAtoms) + 1024;
+}
+
+//! Serializes or deserializes ranges of global atom indices
+bool xdrRanges(XDR* xdrs, std::vector<Range<int>>* ranges)
+{
+    int numRanges = ranges->size();
+    if (xdr_int(xdrs, &numRanges) == 0 || numRanges < 0)
+    {
+        return false;
+    }
+    ranges->resize(numRanges);
+    for (auto& range : *ranges)
+    {
+        int begin = *range.begin();
+        int size  = range.size();
+        if (xdr_int(xdrs, &begin) == 0 || xdr_int(xdrs, &size) == 0 || begin < 0 || size < 0)
+        {
+            return false;
+        }
+        range = Range<int>(begin, begin + size);
+    }
+    return true;
+}
+
+//! Compresses sorted atom indices into ranges of consecutive indices
+std::vector<Range<int>> makeRanges(ArrayRef<const int> sortedIndices)
+{
+    std::vector<Range<int>> ranges;
+    for (size_t i = 0; i < sortedIndices.size();)
+    {
+        size_t j = i + 1;
+        while (j < sortedIndices.size() && sortedIndices[j] == sortedIndices[j - 1] + 1)
+        {
+            j++;
+        }
+        ranges.emplace_back(sortedIndices[i], sortedIndices[i] + static_cast<int>(j - i));
+        i = j;
+    }
+    return ranges;
+}
+
+//! Returns \p buffer truncated to the data written to \p xdrs, throws when encoding failed
+std::vector<char> finishEncoding(XDR* xdrs, bool success, std::vector<char> buffer)
+{
+    GMX_RELEASE_ASSERT(success, "The DXTC encoding buffer should be large enough");
+    buffer.resize(xdr_getpos(xdrs));
+    xdr_destroy(xdrs);
+    return buffer;
+}
+
+} // namespace
+
+std::vector<char> encodeDxtcFileHeader(int numAtomsGlobal, ArrayRef<const Range<int>> selection)
+{
+    std::vector<Range<int>> ranges(selection.begin(), selection.end());
+    int                     numAtoms = numAtomsGlobal;
+    if (!selection.empty())
+    {
+        numAtoms = 0;
+        for (const auto& range : selection)
+        {
+            numAtoms += range.size();
+        }
+    }
+
+    std::vector<char> buffer(5 * 4 + 8 * selection.size());
+    XDR               xdrs;
+    xdrmem_create(&xdrs, buffer.data(), buffer.size(), XDR_ENCODE);
+    int  magic   = c_dxtcFileMagic;
+    int  version = c_dxtcVersion;
+    bool success = (xdr_int(&xdrs, &magic) != 0 && xdr_int(&xdrs, &version) != 0
+                    && xdr_int(&xdrs, &numAtomsGlobal) != 0 && xdr_int(&xdrs, &numAtoms) != 0
+                    && xdrRanges(&xdrs, &ranges));
+
+    return finishEncoding(&xdrs, success, std::move(buffer));
+}
+
+int dxtcFrameHeaderSize(int numBlocks)
+{
+    return c_frameHeaderSize + 4 * numBlocks;
+}
+
+std::vector<char> encodeDxtcFrameHeader(int64_t step, real time, const matrix box, ArrayRef<const int> blockSizes)
+{
+    std::vector<char> buffer(dxtcFrameHeaderSize(blockSizes.size()));
+    XDR               xdrs;
+    xdrmem_create(&xdrs, buffer.data(), buffer.size(), XDR_ENCODE);
+    int  magic   = c_dxtcFrameMagic;
+    bool success = (xdr_int(&xdrs, &magic) != 0 && xdr_int64(&xdrs, &step) != 0
+                    && xdr_real(&xdrs, &time) != 0);
+    for (int d = 0; d < DIM; d++)
+    {
+        for (int e = 0; e < DIM; e++)
+        {
+            real value = box[d][e];
+            success    = success && xdr_real(&xdrs, &value) != 0;
+        }
+    }
+    int numBlocks = blockSizes.size();
+    success       = success && xdr_int(&xdrs, &numBlocks) != 0;
+    for (int blockSize : blockSizes)
+    {
+        success = success && xdr_int(&xdrs, &blockSize) != 0;
+    }
+
+    return finishEncoding(&xdrs, success, std::move(buffer));
+}
+
+std::vector<char> encodeDxtcBlock(ArrayRef<const int> globalAtomIndices, ArrayRef<const RVec> x, real precision)
+{
+    GMX_RELEASE_ASSERT(globalAtomIndices.size() == x.size(),
+                       "We need coordinates for all atoms in a block");
+
+    std::vector<int> order(globalAtomIndices.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [globalAtomIndices](int a, int b) { return globalAtomIndices[a] < globalAtomIndices[b]; });
+    std::vector<int>  sortedIndices(order.size());
+    std::vector<real> sortedX(DIM * order.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        sortedIndices[i] = globalAtomIndices[order[i]];
+        for (int d = 0; d < DIM; d++)
+        {
+            sortedX[DIM * i + d] = x[order[i]][d];
+        }
+    }
+    std::vector<Range<int>> ranges = makeRanges(sortedIndices);
+
+    int               numAtoms = sortedIndices.size();
+    std::vector<char> buffer(2 * 4 + 8 * ranges.size() + maxCompressedSize(numAtoms));
+    XDR               xdrs;
+    xdrmem_create(&xdrs, buffer.data(), buffer.size(), XDR_ENCODE);
+    bool success = (xdr_int(&xdrs, &numAtoms) != 0 && xdrRanges(&xdrs, &ranges));
+    if (success && numAtoms > 0)
+    {
+        success = (xdr3drcoord(&xdrs, sortedX.data(), &numAtoms, &precision) != 0);
+    }
+
+    return finishEncoding(&xdrs, success, std::move(buffer));
+}
+
+DxtcReader::DxtcReader(const std::string& filename) : filename_(filename), fp_(nullptr)
+{
+    fp_ = std::fopen(filename.c_str(), "rb");
+    if (fp_ == nullptr)
+    {
+        GMX_THROW(FileIOError("Could not open DXTC file '" + filename + "' for reading"));
+    }
+
+    XDR xdrs;
+    xdrstdio_create(&xdrs, fp_, XDR_DECODE);
+    int  magic   = 0;
+    int  version = 0;
+    bool success = (xdr_int(&xdrs, &magic) != 0 && magic == c_dxtcFileMagic
+                    && xdr_int(&xdrs, &version) != 0 && version == c_dxtcVersion
+                    && xdr_int(&xdrs, &numAtomsGlobal_) != 0 && xdr_int(&xdrs, &numAtoms_) != 0
+                    && xdrRanges(&xdrs, &selection_));
+    xdr_destroy(&xdrs);
+
+    int numSelected = 0;
+    for (const auto& range : selection_)
+    {
+        success = success && (range.empty() || *range.end() <= numAtomsGlobal_);
+        selectionFrameIndex_.push_back(numSelected);
+        numSelected += range.size();
+    }
+    if (!success || (selection_.empty() ? numAtomsGlobal_ : numSelected) != numAtoms_)
+    {
+        std::fclose(fp_);
+        GMX_THROW(FileIOError("File '" + filename + "' is not a valid DXTC file"));
+    }
+}
+
+DxtcReader::~DxtcReader()
+{
+    std::fclose(fp_);
+}
+
+int DxtcReader::frameIndex(int globalAtomIndex) const
+{
+    if (selection_.empty())
+    {
+        return globalAtomIndex < numAtomsGlobal_ ? globalAtomIndex : -1;
+    }
+    auto range = std::upper_bound(
+            selection_.begin(), selection_.end(), globalAtomIndex,
+            [](int index, const Range<int>& range) { return index < *range.begin(); });
+    if (range == selection_.begin() || !(--range)->isInRange(globalAtomIndex))
+    {
+        return -1;
+    }
+    return selectionFrameIndex_[range - selection_.begin()] + globalAtomIndex - *range->begin();
+}
+
+bool DxtcReader::readNextFrame(int64_t* step, real* time, matrix box, ArrayRef<RVec> x)
+{
+    GMX_RELEASE_ASSERT(x.ssize() == numAtoms_, "The coordinate buffer should match the frame size");
+
+    XDR xdrs;
+    xdrstdio_create(&xdrs, fp_, XDR_DECODE);
+    int magic = 0;
+    if (xdr_int(&xdrs, &magic) == 0)
+    {
+        xdr_destroy(&xdrs);
+        if (std::feof(fp_))
+        {
+            return false;
+        }
+        GMX_THROW(FileIOError("Error reading DXTC file '" + filename_ + "'"));
+    }
+    bool success = (magic == c_dxtcFrameMagic && xdr_int64(&xdrs, step) != 0
+                    && xdr_real(&xdrs, time) != 0);
+    for (int d = 0; d < DIM; d++)
+    {
+        for (int e = 0; e < DIM; e++)
+        {
+            success = success && xdr_real(&xdrs, &box[d][e]) != 0;
+        }
+    }
+    int numBlocks = 0;
+    success       = success && xdr_int(&xdrs, &numBlocks) != 0 && numBlocks >= 0;
+    std::vector<int> blockSizes(success ? numBlocks : 0);
+    for (int& blockSize : blockSizes)
+    {
+        success = success && xdr_int(&xdrs, &blockSize) != 0 && blockSize >= 0;
+    }
+    xdr_destroy(&xdrs);
+
+    std::vector<char>       buffer;
+    std::vector<Range<int>> ranges;
+    std::vector<real>       blockX;
+    int                     numAtomsRead = 0;
+    for (int b = 0; b < numBlocks && success; b++)
+    {
+        buffer.resize(blockSizes[b]);
+        if (blockSizes[b] > 0 && std::fread(buffer.data(), blockSizes[b], 1, fp_) != 1)
+        {
+            success = false;
+            break;
+        }
+        xdrmem_create(&xdrs, buffer.data(), buffer.size(), XDR_DECODE);
+        int numAtoms = 0;
+        success      = (xdr_int(&xdrs, &numAtoms) != 0 && numAtoms >= 0
+                   && numAtomsRead + numAtoms <= numAtoms_ && xdrRanges(&xdrs, &ranges));
+        int numAtomsInRanges = 0;
+        for (const auto& range : ranges)
+        {
+            numAtomsInRanges += range.size();
+        }
+        success = success && numAtomsInRanges == numAtoms;
+        if (success && numAtoms > 0)
+        {
+            blockX.resize(DIM * numAtoms);
+            int  numAtomsCompressed = numAtoms;
+            real precision          = 0;
+            success = (xdr3drcoord(&xdrs, blockX.data(), &numAtomsCompressed, &precision) != 0
+                       && numAtomsCompressed == numAtoms);
+        }
+        xdr_destroy(&xdrs);
+
+        /* Scatter the atoms to their place in the frame. All atoms in
+         * a range are consecutive in the selection, so we only need
+         * to look up the first atom of each range.
+         */
+        int i = 0;
+        for (size_t r = 0; r < ranges.size() && success; r++)
+        {
+            const int first = frameIndex(*ranges[r].begin());
+            const int last  = frameIndex(*ranges[r].end() - 1);
+            if (first < 0 || last - first != ranges[r].size() - 1)
+            {
+                success = false;
+                break;
+            }
+            for (int a = first; a <= last; a++, i++)
+            {
+                x[a] = { blockX[DIM * i], blockX[DIM * i + 1], blockX[DIM * i + 2] };
+            }
+        }
+        numAtomsRead += numAtoms;
+    }
+
+    if (!success || numAtomsRead != numAtoms_)
+    {
+        GMX_THROW(FileIOError(formatString("Incomplete or corrupt frame in DXTC file '%s'",
+                                           filename_.c_str())));
+    }
+
+    return true;
+}
+
+} // namespace gmx
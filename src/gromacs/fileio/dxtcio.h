@@ -0,0 +1,155 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares the encoding and reading of distributed XTC (DXTC) trajectories.
+ *
+ * A DXTC file holds compressed coordinate frames like XTC, but each frame
+ * consists of independently compressed blocks. Each block contains a set
+ * of atoms, stored as ranges of global atom indices, and their XTC
+ * compressed coordinates. This allows each domain-decomposition rank to
+ * compress its home atoms and write them at its own offset in the file,
+ * without collecting the whole system on one rank.
+ *
+ * The file starts with a header that lists the global atom count and the
+ * selection of atoms written. Each frame starts with a header that holds
+ * the step, time, box and the byte sizes of the blocks, so the blocks of
+ * a frame, and the frames, can be located without decompressing.
+ * All data is stored with XDR, so the files are portable.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_DXTCIO_H
+#define GMX_FILEIO_DXTCIO_H
+
+#include <cstdint>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/range.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+/*! \brief Returns the encoded file header of a DXTC file
+ *
+ * \param[in] numAtomsGlobal  The number of atoms in the system
+ * \param[in] selection       Sorted, non-overlapping ranges of global atom indices
+ *                            that are written, all atoms are written when empty
+ */
+std::vector<char> encodeDxtcFileHeader(int numAtomsGlobal, ArrayRef<const Range<int>> selection);
+
+/*! \brief Returns the encoded header of a DXTC frame
+ *
+ * \param[in] step        The MD step
+ * \param[in] time        The time
+ * \param[in] box         The box
+ * \param[in] blockSizes  The sizes in bytes of the encoded blocks that follow the header
+ */
+std::vector<char> encodeDxtcFrameHeader(int64_t step, real time, const matrix box, ArrayRef<const int> blockSizes);
+
+//! Returns the size in bytes of an encoded frame header for \p numBlocks blocks
+int dxtcFrameHeaderSize(int numBlocks);
+
+/*! \brief Returns an encoded block with compressed coordinates of a set of atoms
+ *
+ * The atoms are stored in order of global index, so consecutive atoms
+ * usually end up in ranges and are close in space, which improves the
+ * compression. All atoms should be part of the selection of the file.
+ *
+ * \param[in] globalAtomIndices  The global indices of the atoms, in any order
+ * \param[in] x                  The coordinates of the atoms
+ * \param[in] precision          The XTC compression precision
+ */
+std::vector<char> encodeDxtcBlock(ArrayRef<const int> globalAtomIndices, ArrayRef<const RVec> x, real precision);
+
+/*! \libinternal
+ * \brief Reads frames from a DXTC file and assembles them in the order of the selection
+ */
+class DxtcReader
+{
+public:
+    /*! \brief Opens the file and reads its header
+     *
+     * \throws FileIOError when the file can not be opened or is not a DXTC file
+     */
+    explicit DxtcReader(const std::string& filename);
+
+    ~DxtcReader();
+
+    //! Returns the number of atoms in a frame
+    int numAtoms() const { return numAtoms_; }
+
+    //! Returns the number of atoms in the system that was written
+    int numAtomsGlobal() const { return numAtomsGlobal_; }
+
+    /*! \brief Reads the next frame
+     *
+     * \param[out] step  The MD step
+     * \param[out] time  The time
+     * \param[out] box   The box
+     * \param[out] x     The coordinates, should have size numAtoms()
+     * \returns false when the end of the file was reached
+     * \throws FileIOError when the frame is corrupt or incomplete
+     */
+    bool readNextFrame(int64_t* step, real* time, matrix box, ArrayRef<RVec> x);
+
+private:
+    //! Returns the index in the frame of the atom with global index \p globalAtomIndex
+    int frameIndex(int globalAtomIndex) const;
+
+    //! The name of the file
+    std::string filename_;
+    //! The file
+    FILE* fp_;
+    //! The number of atoms in the system
+    int numAtomsGlobal_ = 0;
+    //! The number of atoms in a frame
+    int numAtoms_ = 0;
+    //! The selection of global atom indices in the frames, empty when all atoms are written
+    std::vector<Range<int>> selection_;
+    //! The frame index of the first atom of each range in \p selection_
+    std::vector<int> selectionFrameIndex_;
+};
+
+} // namespace gmx
+
+#endif
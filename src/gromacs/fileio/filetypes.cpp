@@ -56,7 +56,7 @@ enum
 /* To support multiple file types with one general (eg TRX) we have
  * these arrays.
  */
-static const int trxs[] = { efXTC, efTRR, efCPT, efGRO, efG96, efPDB, efTNG };
+static const int trxs[] = { efXTC, efTRR, efCPT, efGRO, efG96, efPDB, efTNG, efDXTC };
 #define NTRXS asize(trxs)
 
 static const int trcompressed[] = { efXTC, efTNG };
@@ -99,6 +99,7 @@ static const t_deffile deffile[efNR] = {
       "Compressed trajectory (tng format or portable xdr format)", NTRCOMPRESSED, trcompressed },
     { eftXDR, ".xtc", "traj", nullptr, "Compressed trajectory (portable xdr format): xtc" },
     { eftTNG, ".tng", "traj", nullptr, "Trajectory file (tng format)" },
+    { eftXDR, ".dxtc", "traj", nullptr, "Distributed compressed trajectory (portable xdr format)" },
     { eftXDR, ".edr", "ener", nullptr, "Energy file" },
     { eftGEN, ".???", "conf", "-c", "Structure file", NSTXS, stxs },
     { eftGEN, ".???", "out", "-o", "Structure file", NSTOS, stos },
@@ -265,7 +266,7 @@ const char* ftp2defopt(int ftp)
 
 int fn2ftp(const char* fn)
 {
-    int         i, len;
+    int         i;
     const char* feptr;
     const char* eptr;
 
@@ -274,12 +275,9 @@ int fn2ftp(const char* fn)
         return efNR;
     }
 
-    len = std::strlen(fn);
-    if ((len >= 4) && (fn[len - 4] == '.'))
-    {
-        feptr = &(fn[len - 4]);
-    }
-    else
+    /* Extensions are usually three characters, but not all are */
+    feptr = std::strrchr(fn, '.');
+    if (feptr == nullptr || std::strpbrk(feptr, "/\\") != nullptr)
     {
         return efNR;
     }
@@ -50,6 +50,7 @@ enum GromacsFileType
     efCOMPRESSED,
     efXTC,
     efTNG,
+    efDXTC,
     efEDR,
     efSTX,
     efSTO,
@@ -43,8 +43,10 @@
 
 #include <cerrno>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
 #include <vector>
 
 #if HAVE_IO_H
@@ -58,6 +60,7 @@
 
 #include "gromacs/fileio/filetypes.h"
 #include "gromacs/fileio/md5.h"
+#include "gromacs/fileio/xtcindex.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/mutex.h"
@@ -400,6 +403,74 @@ int gmx_fio_fp_close(t_fileio* fio)
     return rc;
 }
 
+t_fileio* gmx_fio_open_memory(const char* fn)
+{
+    t_fileio* fio = new t_fileio{};
+    tMPI_Lock_init(&(fio->mtx));
+    fio->iFTP = fn2ftp(fn);
+    if (!ftp_is_xdr(fio->iFTP))
+    {
+        gmx_incons("gmx_fio_open_memory can only be used for XDR files");
+    }
+    fio->fn = gmx_strdup(fn);
+
+#if HAVE_OPEN_MEMSTREAM
+    fio->fp = open_memstream(&fio->memoryBuffer, &fio->memoryBufferSize);
+#else
+    /* Without open_memstream, a temporary file is the closest we can get */
+    fio->fp = std::tmpfile();
+#endif
+    if (fio->fp == nullptr)
+    {
+        gmx_fatal(FARGS, "Cannot open an in-memory file for '%s'", fn);
+    }
+    fio->xdrmode = XDR_ENCODE;
+    snew(fio->xdr, 1);
+    xdrstdio_create(fio->xdr, fio->fp, fio->xdrmode);
+
+    fio->bRead      = FALSE;
+    fio->bReadWrite = FALSE;
+    fio->bDouble    = (sizeof(real) == sizeof(double));
+
+    return fio;
+}
+
+std::vector<char> gmx_fio_close_memory(t_fileio* fio)
+{
+    std::vector<char> contents;
+
+    xdr_destroy(fio->xdr);
+    sfree(fio->xdr);
+
+#if HAVE_OPEN_MEMSTREAM
+    /* The buffer is only guaranteed to hold all data after closing */
+    bool ok = (std::fclose(fio->fp) == 0);
+    if (ok)
+    {
+        contents.assign(fio->memoryBuffer, fio->memoryBuffer + fio->memoryBufferSize);
+    }
+    std::free(fio->memoryBuffer);
+#else
+    bool ok = (std::fflush(fio->fp) == 0);
+    if (ok)
+    {
+        contents.resize(gmx_ftell(fio->fp));
+        std::rewind(fio->fp);
+        ok = (std::fread(contents.data(), 1, contents.size(), fio->fp) == contents.size());
+    }
+    ok = (std::fclose(fio->fp) == 0) && ok;
+#endif
+    if (!ok)
+    {
+        gmx_fatal(FARGS, "Cannot write the in-memory file for '%s'", fio->fn);
+    }
+
+    sfree(fio->fn);
+    delete fio;
+
+    return contents;
+}
+
 FILE* gmx_fio_fopen(const char* fn, const char* mode)
 {
     FILE*     ret;
@@ -768,8 +839,28 @@ int xtc_seek_time(t_fileio* fio, real time, int natoms, gmx_bool bSeekForwardOnl
 {
     int ret;
 
+    /* An existing frame index lets us seek without searching the file */
+    const gmx::XtcFrameIndex index = gmx::XtcFrameIndex::read(gmx_fio_getname(fio));
+
     gmx_fio_lock(fio);
-    ret = xdr_xtc_seek_time(time, fio->fp, fio->xdr, natoms, bSeekForwardOnly);
+    int frame = index.numFrames();
+    if (index.timesAreIncreasing())
+    {
+        frame = index.firstFrameAtOrAfterTime(time);
+        if (bSeekForwardOnly)
+        {
+            frame = std::max(frame, index.firstFrameAtOrAfter(gmx_ftell(fio->fp)));
+        }
+    }
+    if (frame < index.numFrames())
+    {
+        ret = gmx_fseek(fio->fp, index.frames()[frame].offset, SEEK_SET);
+    }
+    else
+    {
+        /* The time is not in the index, or there is no index */
+        ret = xdr_xtc_seek_time(time, fio->fp, fio->xdr, natoms, bSeekForwardOnly);
+    }
     gmx_fio_unlock(fio);
 
     return ret;
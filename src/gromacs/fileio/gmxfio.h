@@ -81,6 +81,18 @@ int gmx_fio_fp_close(t_fileio* fp);
  * Returns 0 on success.
  */
 
+t_fileio* gmx_fio_open_memory(const char* fn);
+/* Open an in-memory XDR file for writing, for a file type deduced
+ * from the file name. The file name is only used for the type and in
+ * messages. The file is not in the list of open files, so it is not
+ * included in gmx_fio_get_output_file_positions() and
+ * gmx_fio_all_output_fsync(). Close it with gmx_fio_close_memory().
+ */
+
+std::vector<char> gmx_fio_close_memory(t_fileio* fio);
+/* Close a file opened with gmx_fio_open_memory() and return its contents.
+ * The routine will exit when the contents could not be written.
+ */
 
 /* Open a file, return a stream, record the entry in internal FIO object */
 FILE* gmx_fio_fopen(const char* fn, const char* mode);
@@ -171,6 +183,10 @@ int gmx_fio_get_file_md5(t_fileio* fio, gmx_off_t offset, std::array<unsigned ch
 
 
 int xtc_seek_time(t_fileio* fio, real time, int natoms, gmx_bool bSeekForwardOnly);
+/* Seek to the first frame at or after time in an XTC file.
+ * Uses the frame index file when it exists, searches the file otherwise.
+ * Returns 0 on success.
+ */
 
 
 #endif
@@ -68,6 +68,8 @@ struct t_fileio
     XDR*        xdr;     /* the xdr data pointer */
     enum xdr_op xdrmode; /* the xdr mode */
     int         iFTP;    /* the file type identifier */
+    char*       memoryBuffer;     /* the contents of an in-memory file */
+    size_t      memoryBufferSize; /* the size of memoryBuffer */
 
     t_fileio *next, *prev; /* next and previous file pointers in the
                               linked list */
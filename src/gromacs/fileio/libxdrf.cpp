@@ -39,15 +39,19 @@
 
 #include <climits>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 
 #include <algorithm>
+#include <vector>
 
 #include "gromacs/fileio/xdr_datatype.h"
 #include "gromacs/fileio/xdrf.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 
 /* This is just for clarity - it can never be anything but 4! */
 #define XDR_INT_SIZE 4
@@ -369,6 +373,656 @@ static void receiveints(int buf[], const int num_of_ints, int num_of_bits, const
     nums[0] = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
 }
 
+/*____________________________________________________________________________
+ |
+ | encodeAtoms/decodeAtoms - compress or decompress a range of atoms
+ |
+ | These routines contain the main loops of xdr3dfcoord. The state of the
+ | run-length and small-difference encoding is passed in and out, so that
+ | a frame can be processed in chunks of atoms. Chunks always start at the
+ | start of an iteration of the loop, i.e. never within a run of atoms.
+ |
+ | For large frames the writer determines the encoder state at the start of
+ | each chunk with a pass that does not produce output, compresses the chunks
+ | in parallel and concatenates the resulting bits. This produces exactly
+ | the same bit stream as compressing the whole frame in one go. After the
+ | bit stream an index is appended, within the same opaque block, that lists
+ | the bit offset and decoder state at the start of each chunk. Readers that
+ | do not know about the index stop decoding after the last atom and never
+ | look at it, readers that do can decompress the chunks in parallel.
+ |
+ */
+
+//! The number of atoms per chunk used by xdr3dfcoord
+static const int c_xtcAtomsPerChunk = 16384;
+
+//! The number of bytes in one entry of the chunk index
+static const int c_xtcChunkIndexEntrySize = 20;
+
+//! Marks the end of the chunk index, and thereby its presence
+static const char c_xtcChunkIndexMagic[] = "XTCCHUNK";
+
+//! The number of bytes in the magic marker, without the terminating zero
+static const int c_xtcChunkIndexMagicSize = sizeof(c_xtcChunkIndexMagic) - 1;
+
+//! Parameters of the coordinate compression that are constant within a frame
+struct XtcCoordinateEncoding
+{
+    //! The minimum integer coordinate values
+    int minint[3];
+    //! The ranges of the integer coordinate values
+    unsigned int sizeint[3];
+    //! The number of bits per coordinate, used when bitsize is zero
+    unsigned int bitsizeint[3];
+    //! The number of bits for a full coordinate triplet, zero for large ranges
+    unsigned int bitsize;
+    //! The smallest value smallidx is allowed to take
+    int minidx;
+    //! The largest value smallidx is allowed to take
+    int maxidx;
+    //! Half the largest small difference
+    int larger;
+};
+
+//! The state of the encoder at the start of an iteration over atoms
+struct XtcEncoderState
+{
+    //! The index of the next atom to compress
+    int atom;
+    //! The index in magicints for the current size of small differences
+    int smallidx;
+    //! Half the size of small differences one step smaller
+    int smaller;
+    //! Half the current size of small differences
+    int smallnum;
+    //! The length of the last run written, -1 before the first run
+    int prevrun;
+    //! The last compressed coordinates
+    int prevcoord[3];
+};
+
+//! The state of the decoder at the start of an iteration over atoms
+struct XtcDecoderState
+{
+    //! The index of the next atom to decompress
+    int atom;
+    //! The index in magicints for the current size of small differences
+    int smallidx;
+    //! Half the size of small differences one step smaller
+    int smaller;
+    //! Half the current size of small differences
+    int smallnum;
+    //! The length of the last run read
+    int run;
+};
+
+//! The start of a chunk in the compressed bit stream
+struct XtcChunkStart
+{
+    //! The offset in bits from the start of the stream
+    int64_t bitOffset;
+    //! The decoder state at this offset
+    XtcDecoderState state;
+};
+
+/*! \brief Compresses atoms from \p state->atom until the first iteration
+ * that starts at or after \p endAtom
+ *
+ * The coordinates in \p ip are not modified. When \p buf is nullptr no
+ * output is produced, which is used to determine the encoder state at
+ * the start of chunks.
+ */
+static void encodeAtoms(int                          buf[],
+                        const int*                   ip,
+                        int                          numAtoms,
+                        int                          endAtom,
+                        const XtcCoordinateEncoding& enc,
+                        XtcEncoderState*             state)
+{
+    int          i        = state->atom;
+    int          smallidx = state->smallidx;
+    int          smaller  = state->smaller;
+    int          smallnum = state->smallnum;
+    int          prevrun  = state->prevrun;
+    int          prevcoord[3], interchanged[3];
+    unsigned int sizeint[3], sizesmall[3];
+    unsigned int tmpcoord[30];
+    int          is_small, is_smaller, run, k;
+
+    for (k = 0; k < 3; k++)
+    {
+        prevcoord[k] = state->prevcoord[k];
+        /* sendints takes non-const sizes */
+        sizeint[k] = enc.sizeint[k];
+    }
+    sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+    while (i < endAtom)
+    {
+        is_small             = 0;
+        const int* thiscoord = ip + i * 3;
+        if (smallidx < enc.maxidx && i >= 1 && std::abs(thiscoord[0] - prevcoord[0]) < enc.larger
+            && std::abs(thiscoord[1] - prevcoord[1]) < enc.larger
+            && std::abs(thiscoord[2] - prevcoord[2]) < enc.larger)
+        {
+            is_smaller = 1;
+        }
+        else if (smallidx > enc.minidx)
+        {
+            is_smaller = -1;
+        }
+        else
+        {
+            is_smaller = 0;
+        }
+        if (i + 1 < numAtoms)
+        {
+            if (std::abs(thiscoord[0] - thiscoord[3]) < smallnum
+                && std::abs(thiscoord[1] - thiscoord[4]) < smallnum
+                && std::abs(thiscoord[2] - thiscoord[5]) < smallnum)
+            {
+                /* interchange first with second atom for better
+                 * compression of water molecules, the first atom
+                 * is then the first in the run below
+                 */
+                interchanged[0] = thiscoord[0];
+                interchanged[1] = thiscoord[1];
+                interchanged[2] = thiscoord[2];
+                thiscoord       = thiscoord + 3;
+                is_small        = 1;
+            }
+        }
+        tmpcoord[0] = thiscoord[0] - enc.minint[0];
+        tmpcoord[1] = thiscoord[1] - enc.minint[1];
+        tmpcoord[2] = thiscoord[2] - enc.minint[2];
+        if (buf != nullptr)
+        {
+            if (enc.bitsize == 0)
+            {
+                sendbits(buf, enc.bitsizeint[0], tmpcoord[0]);
+                sendbits(buf, enc.bitsizeint[1], tmpcoord[1]);
+                sendbits(buf, enc.bitsizeint[2], tmpcoord[2]);
+            }
+            else
+            {
+                sendints(buf, 3, enc.bitsize, sizeint, tmpcoord);
+            }
+        }
+        prevcoord[0] = thiscoord[0];
+        prevcoord[1] = thiscoord[1];
+        prevcoord[2] = thiscoord[2];
+        i++;
+        thiscoord = is_small ? interchanged : ip + i * 3;
+
+        run = 0;
+        if (is_small == 0 && is_smaller == -1)
+        {
+            is_smaller = 0;
+        }
+        while (is_small && run < 8 * 3)
+        {
+            if (is_smaller == -1
+                && (SQR(thiscoord[0] - prevcoord[0]) + SQR(thiscoord[1] - prevcoord[1])
+                            + SQR(thiscoord[2] - prevcoord[2])
+                    >= smaller * smaller))
+            {
+                is_smaller = 0;
+            }
+
+            tmpcoord[run++] = thiscoord[0] - prevcoord[0] + smallnum;
+            tmpcoord[run++] = thiscoord[1] - prevcoord[1] + smallnum;
+            tmpcoord[run++] = thiscoord[2] - prevcoord[2] + smallnum;
+
+            prevcoord[0] = thiscoord[0];
+            prevcoord[1] = thiscoord[1];
+            prevcoord[2] = thiscoord[2];
+
+            i++;
+            thiscoord = ip + i * 3;
+            is_small  = 0;
+            if (i < numAtoms && abs(thiscoord[0] - prevcoord[0]) < smallnum
+                && abs(thiscoord[1] - prevcoord[1]) < smallnum
+                && abs(thiscoord[2] - prevcoord[2]) < smallnum)
+            {
+                is_small = 1;
+            }
+        }
+        if (run != prevrun || is_smaller != 0)
+        {
+            prevrun = run;
+            if (buf != nullptr)
+            {
+                sendbits(buf, 1, 1); /* flag the change in run-length */
+                sendbits(buf, 5, run + is_smaller + 1);
+            }
+        }
+        else if (buf != nullptr)
+        {
+            sendbits(buf, 1, 0); /* flag the fact that runlength did not change */
+        }
+        if (buf != nullptr)
+        {
+            for (k = 0; k < run; k += 3)
+            {
+                sendints(buf, 3, smallidx, sizesmall, &tmpcoord[k]);
+            }
+        }
+        if (is_smaller != 0)
+        {
+            smallidx += is_smaller;
+            if (is_smaller < 0)
+            {
+                smallnum = smaller;
+                smaller  = magicints[smallidx - 1] / 2;
+            }
+            else
+            {
+                smaller  = smallnum;
+                smallnum = magicints[smallidx] / 2;
+            }
+            sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+        }
+    }
+    state->atom     = i;
+    state->smallidx = smallidx;
+    state->smaller  = smaller;
+    state->smallnum = smallnum;
+    state->prevrun  = prevrun;
+    for (k = 0; k < 3; k++)
+    {
+        state->prevcoord[k] = prevcoord[k];
+    }
+}
+
+/*! \brief Decompresses atoms from \p state->atom until the first iteration
+ * that starts at or after \p endAtom
+ *
+ * The integer coordinates are stored in \p ip, the coordinates in \p fp.
+ */
+static void decodeAtoms(int                          buf[],
+                        int*                         ip,
+                        float*                       fp,
+                        int                          endAtom,
+                        const XtcCoordinateEncoding& enc,
+                        float                        inv_precision,
+                        XtcDecoderState*             state)
+{
+    int          i        = state->atom;
+    int          smallidx = state->smallidx;
+    int          smaller  = state->smaller;
+    int          smallnum = state->smallnum;
+    int          run      = state->run;
+    float*       lfp      = fp + i * 3;
+    unsigned int sizesmall[3];
+    int          prevcoord[3];
+    int          flag, is_smaller, k, tmp;
+
+    sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+    while (i < endAtom)
+    {
+        int* thiscoord = ip + i * 3;
+
+        if (enc.bitsize == 0)
+        {
+            thiscoord[0] = receivebits(buf, enc.bitsizeint[0]);
+            thiscoord[1] = receivebits(buf, enc.bitsizeint[1]);
+            thiscoord[2] = receivebits(buf, enc.bitsizeint[2]);
+        }
+        else
+        {
+            receiveints(buf, 3, enc.bitsize, enc.sizeint, thiscoord);
+        }
+
+        i++;
+        thiscoord[0] += enc.minint[0];
+        thiscoord[1] += enc.minint[1];
+        thiscoord[2] += enc.minint[2];
+
+        prevcoord[0] = thiscoord[0];
+        prevcoord[1] = thiscoord[1];
+        prevcoord[2] = thiscoord[2];
+
+
+        flag       = receivebits(buf, 1);
+        is_smaller = 0;
+        if (flag == 1)
+        {
+            run        = receivebits(buf, 5);
+            is_smaller = run % 3;
+            run -= is_smaller;
+            is_smaller--;
+        }
+        if (run > 0)
+        {
+            thiscoord += 3;
+            for (k = 0; k < run; k += 3)
+            {
+                receiveints(buf, 3, smallidx, sizesmall, thiscoord);
+                i++;
+                thiscoord[0] += prevcoord[0] - smallnum;
+                thiscoord[1] += prevcoord[1] - smallnum;
+                thiscoord[2] += prevcoord[2] - smallnum;
+                if (k == 0)
+                {
+                    /* interchange first with second atom for better
+                     * compression of water molecules
+                     */
+                    tmp          = thiscoord[0];
+                    thiscoord[0] = prevcoord[0];
+                    prevcoord[0] = tmp;
+                    tmp          = thiscoord[1];
+                    thiscoord[1] = prevcoord[1];
+                    prevcoord[1] = tmp;
+                    tmp          = thiscoord[2];
+                    thiscoord[2] = prevcoord[2];
+                    prevcoord[2] = tmp;
+                    *lfp++       = prevcoord[0] * inv_precision;
+                    *lfp++       = prevcoord[1] * inv_precision;
+                    *lfp++       = prevcoord[2] * inv_precision;
+                }
+                else
+                {
+                    prevcoord[0] = thiscoord[0];
+                    prevcoord[1] = thiscoord[1];
+                    prevcoord[2] = thiscoord[2];
+                }
+                *lfp++ = thiscoord[0] * inv_precision;
+                *lfp++ = thiscoord[1] * inv_precision;
+                *lfp++ = thiscoord[2] * inv_precision;
+            }
+        }
+        else
+        {
+            *lfp++ = thiscoord[0] * inv_precision;
+            *lfp++ = thiscoord[1] * inv_precision;
+            *lfp++ = thiscoord[2] * inv_precision;
+        }
+        smallidx += is_smaller;
+        if (is_smaller < 0)
+        {
+            smallnum = smaller;
+            if (smallidx > FIRSTIDX)
+            {
+                smaller = magicints[smallidx - 1] / 2;
+            }
+            else
+            {
+                smaller = 0;
+            }
+        }
+        else if (is_smaller > 0)
+        {
+            smaller  = smallnum;
+            smallnum = magicints[smallidx] / 2;
+        }
+        sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+    }
+    state->atom     = i;
+    state->smallidx = smallidx;
+    state->smaller  = smaller;
+    state->smallnum = smallnum;
+    state->run      = run;
+}
+
+//! Returns the decoder state at the start of a chunk from the index data
+static XtcDecoderState decoderStateAtChunkStart(int atom, int smallidx, int run)
+{
+    XtcDecoderState state;
+    state.atom     = atom;
+    state.smallidx = smallidx;
+    state.smaller  = magicints[std::max(FIRSTIDX, smallidx - 1)] / 2;
+    state.smallnum = magicints[smallidx] / 2;
+    state.run      = run;
+    return state;
+}
+
+//! Appends \p value to \p bytes in big-endian order
+static void appendBigEndian(std::vector<unsigned char>* bytes, uint64_t value, int numBytes)
+{
+    for (int b = numBytes - 1; b >= 0; b--)
+    {
+        bytes->push_back(static_cast<unsigned char>(value >> (8 * b)));
+    }
+}
+
+//! Returns the big-endian value of \p numBytes bytes starting at \p bytes
+static uint64_t readBigEndian(const unsigned char* bytes, int numBytes)
+{
+    uint64_t value = 0;
+    for (int b = 0; b < numBytes; b++)
+    {
+        value = (value << 8) | bytes[b];
+    }
+    return value;
+}
+
+//! Returns the number of bytes in the index for \p numChunks chunks
+static int64_t chunkIndexSize(int64_t numChunks)
+{
+    return (numChunks - 1) * c_xtcChunkIndexEntrySize + 4 + c_xtcChunkIndexMagicSize;
+}
+
+/*! \brief Compresses the atoms in chunks, stores the result and the chunk
+ * index in \p bytes
+ *
+ * The chunks are compressed in parallel with up to \p numThreads OpenMP
+ * threads. The output does not depend on the number of threads.
+ *
+ * \param[in]  ip            The integer coordinates
+ * \param[in]  numAtoms      The number of atoms
+ * \param[in]  atomsPerChunk The minimum number of atoms per chunk
+ * \param[in]  enc           The encoding parameters
+ * \param[in]  initialState  The encoder state at the first atom
+ * \param[in]  buf           Buffer for serial compression, as used by xdr3dfcoord
+ * \param[in]  numThreads    The maximum number of OpenMP threads to use
+ * \param[out] bytes         The compressed bit stream followed by the chunk index
+ */
+static void encodeChunks(const int*                   ip,
+                         int                          numAtoms,
+                         int                          atomsPerChunk,
+                         const XtcCoordinateEncoding& enc,
+                         const XtcEncoderState&       initialState,
+                         int                          buf[],
+                         int                          numThreads,
+                         std::vector<unsigned char>*  bytes)
+{
+    const int numChunks = numAtoms / atomsPerChunk;
+    numThreads          = std::min(numThreads, numChunks);
+
+    std::vector<XtcEncoderState> chunkStates(numChunks);
+    std::vector<int64_t>         chunkBitOffsets(numChunks + 1);
+    XtcEncoderState              state = initialState;
+    if (numThreads <= 1)
+    {
+        /* Compress serially into buf, only keep track of the chunk starts */
+        buf[0] = buf[1] = buf[2] = 0;
+        for (int c = 0; c < numChunks; c++)
+        {
+            chunkStates[c]     = state;
+            chunkBitOffsets[c] = buf[0] * int64_t(8) + buf[1];
+            encodeAtoms(buf, ip, numAtoms, c + 1 < numChunks ? (c + 1) * atomsPerChunk : numAtoms,
+                        enc, &state);
+        }
+        chunkBitOffsets[numChunks] = buf[0] * int64_t(8) + buf[1];
+
+        const unsigned char* cbuf = reinterpret_cast<unsigned char*>(buf) + 3 * sizeof(*buf);
+        bytes->assign(cbuf, cbuf + (chunkBitOffsets[numChunks] + 7) / 8);
+    }
+    else
+    {
+        /* Determine the encoder state at the start of each chunk */
+        chunkStates[0] = state;
+        for (int c = 1; c < numChunks; c++)
+        {
+            encodeAtoms(nullptr, ip, numAtoms, c * atomsPerChunk, enc, &state);
+            chunkStates[c] = state;
+        }
+
+        std::vector<std::vector<int>> chunkBufs(numChunks);
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+        for (int c = 0; c < numChunks; c++)
+        {
+            try
+            {
+                const int endAtom = (c + 1 < numChunks ? chunkStates[c + 1].atom : numAtoms);
+                /* The last run can extend at most 8 atoms beyond endAtom */
+                const int numCoords = (endAtom - chunkStates[c].atom + 8) * 3;
+                chunkBufs[c].resize(3 + static_cast<int>(numCoords * 1.2), 0);
+
+                XtcEncoderState chunkState = chunkStates[c];
+                encodeAtoms(chunkBufs[c].data(), ip, numAtoms, endAtom, enc, &chunkState);
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+        }
+
+        /* Concatenate the bits of the chunks */
+        chunkBitOffsets[0] = 0;
+        for (int c = 0; c < numChunks; c++)
+        {
+            chunkBitOffsets[c + 1] =
+                    chunkBitOffsets[c] + chunkBufs[c][0] * int64_t(8) + chunkBufs[c][1];
+        }
+        bytes->assign((chunkBitOffsets[numChunks] + 7) / 8, 0);
+        for (int c = 0; c < numChunks; c++)
+        {
+            const unsigned char* cbuf =
+                    reinterpret_cast<unsigned char*>(chunkBufs[c].data()) + 3 * sizeof(int);
+            const int numChunkBytes = chunkBufs[c][0] + (chunkBufs[c][1] != 0 ? 1 : 0);
+            const int shift         = chunkBitOffsets[c] % 8;
+            unsigned char* dest     = bytes->data() + chunkBitOffsets[c] / 8;
+            for (int b = 0; b < numChunkBytes; b++)
+            {
+                /* Unused bits in the last byte of a chunk are zero */
+                unsigned char value = cbuf[b];
+                if (b == numChunkBytes - 1 && chunkBufs[c][1] != 0)
+                {
+                    value &= static_cast<unsigned char>(0xff << (8 - chunkBufs[c][1]));
+                }
+                dest[b] |= value >> shift;
+                if (shift > 0 && static_cast<unsigned char>(value << (8 - shift)) != 0)
+                {
+                    dest[b + 1] |= static_cast<unsigned char>(value << (8 - shift));
+                }
+            }
+        }
+    }
+
+    /* Append the index for chunks 1 and up, their number and the magic marker */
+    for (int c = 1; c < numChunks; c++)
+    {
+        appendBigEndian(bytes, chunkBitOffsets[c], 8);
+        appendBigEndian(bytes, chunkStates[c].atom, 4);
+        appendBigEndian(bytes, chunkStates[c].smallidx, 4);
+        appendBigEndian(bytes, chunkStates[c].prevrun, 4);
+    }
+    appendBigEndian(bytes, numChunks, 4);
+    bytes->insert(bytes->end(), c_xtcChunkIndexMagic,
+                  c_xtcChunkIndexMagic + c_xtcChunkIndexMagicSize);
+}
+
+/*! \brief Returns the chunk starts from the index after the compressed
+ * bit stream, or an empty list when there is no valid index
+ *
+ * \param[in] bytes    The compressed data as read from file
+ * \param[in] numBytes The number of bytes in \p bytes
+ * \param[in] numAtoms The number of atoms in the frame
+ * \param[in] smallidx The initial smallidx of the frame
+ */
+static std::vector<XtcChunkStart>
+readChunkIndex(const unsigned char* bytes, int numBytes, int numAtoms, int smallidx)
+{
+    std::vector<XtcChunkStart> chunkStarts;
+    if (numBytes < c_xtcChunkIndexMagicSize + 4
+        || std::memcmp(bytes + numBytes - c_xtcChunkIndexMagicSize, c_xtcChunkIndexMagic,
+                       c_xtcChunkIndexMagicSize)
+                   != 0)
+    {
+        return chunkStarts;
+    }
+    const int64_t numChunks =
+            readBigEndian(bytes + numBytes - c_xtcChunkIndexMagicSize - 4, 4);
+    const int64_t indexSize = chunkIndexSize(numChunks);
+    if (numChunks < 2 || numChunks > numAtoms || indexSize > numBytes)
+    {
+        return chunkStarts;
+    }
+    const int64_t        numStreamBits = (numBytes - indexSize) * 8;
+    const unsigned char* entry         = bytes + numBytes - indexSize;
+
+    chunkStarts.push_back({ 0, decoderStateAtChunkStart(0, smallidx, 0) });
+    for (int64_t c = 1; c < numChunks; c++, entry += c_xtcChunkIndexEntrySize)
+    {
+        const int64_t bitOffset     = readBigEndian(entry, 8);
+        const int     atom          = static_cast<int32_t>(readBigEndian(entry + 8, 4));
+        const int     chunkSmallidx = static_cast<int32_t>(readBigEndian(entry + 12, 4));
+        const int     run           = static_cast<int32_t>(readBigEndian(entry + 16, 4));
+        if (bitOffset <= chunkStarts.back().bitOffset || bitOffset >= numStreamBits
+            || atom <= chunkStarts.back().state.atom || atom >= numAtoms || chunkSmallidx < FIRSTIDX
+            || chunkSmallidx >= LASTIDX || run < 0 || run > 8 * 3 || run % 3 != 0)
+        {
+            chunkStarts.clear();
+            return chunkStarts;
+        }
+        chunkStarts.push_back({ bitOffset, decoderStateAtChunkStart(atom, chunkSmallidx, run) });
+    }
+    return chunkStarts;
+}
+
+/*! \brief Decompresses the chunks listed in \p chunkStarts in parallel
+ *
+ * \param[in]  bytes          The compressed data as read from file
+ * \param[in]  numStreamBytes The number of bytes in the compressed bit stream
+ * \param[in]  chunkStarts    The chunk starts, as returned by readChunkIndex
+ * \param[in]  numAtoms       The number of atoms in the frame
+ * \param[in]  enc            The encoding parameters
+ * \param[in]  inv_precision  The inverse of the precision
+ * \param[in]  numThreads     The maximum number of OpenMP threads to use
+ * \param[out] ip             The integer coordinates
+ * \param[out] fp             The coordinates
+ */
+static void decodeChunks(const unsigned char*              bytes,
+                         int64_t                           numStreamBytes,
+                         const std::vector<XtcChunkStart>& chunkStarts,
+                         int                               numAtoms,
+                         const XtcCoordinateEncoding&      enc,
+                         float                             inv_precision,
+                         int                               numThreads,
+                         int*                              ip,
+                         float*                            fp)
+{
+    const int numChunks = chunkStarts.size();
+    numThreads          = std::min(numThreads, numChunks);
+
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+    for (int c = 0; c < numChunks; c++)
+    {
+        try
+        {
+            const int endAtom = (c + 1 < numChunks ? chunkStarts[c + 1].state.atom : numAtoms);
+            const int64_t firstByte = chunkStarts[c].bitOffset / 8;
+            /* Decoding never reads beyond the byte that contains the next chunk start */
+            const int64_t endByte =
+                    (c + 1 < numChunks ? (chunkStarts[c + 1].bitOffset + 7) / 8 : numStreamBytes);
+
+            std::vector<int> chunkBuf(3 + (endByte - firstByte) / sizeof(int) + 1, 0);
+            std::memcpy(chunkBuf.data() + 3, bytes + firstByte, endByte - firstByte);
+            /* Set up receivebits as if the bits before the chunk start in
+             * the first byte have already been read.
+             */
+            const int bitInByte = chunkStarts[c].bitOffset % 8;
+            if (bitInByte != 0)
+            {
+                chunkBuf[0] = 1;
+                chunkBuf[1] = 8 - bitInByte;
+                chunkBuf[2] = bytes[firstByte];
+            }
+
+            XtcDecoderState state = chunkStarts[c].state;
+            decodeAtoms(chunkBuf.data(), ip, fp, endAtom, enc, inv_precision, &state);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR;
+    }
+}
+
 /*____________________________________________________________________________
  |
  | xdr3dfcoord - read or write compressed 3d coordinates to xdr file.
@@ -397,6 +1051,17 @@ static void receiveints(int buf[], const int num_of_ints, int num_of_bits, const
  */
 
 int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
+{
+    return xdr3dfcoord(xdrs, fp, size, precision, gmx_omp_get_max_threads());
+}
+
+int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision, int numThreads)
+{
+    return xdr3dfcoord_chunked(xdrs, fp, size, precision, c_xtcAtomsPerChunk, numThreads);
+}
+
+int xdr3dfcoord_chunked(XDR* xdrs, float* fp, int* size, float* precision, int atomsPerChunk,
+                        int numThreads)
 {
     int*     ip  = nullptr;
     int*     buf = nullptr;
@@ -408,15 +1073,11 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
     int      prealloc_ip[3 * 16], prealloc_buf[3 * 20];
     int      we_should_free = 0;
 
-    int          minint[3], maxint[3], mindiff, *lip, diff;
-    int          lint1, lint2, lint3, oldlint1, oldlint2, oldlint3, smallidx;
-    int          minidx, maxidx;
-    unsigned     sizeint[3], sizesmall[3], bitsizeint[3], size3, *luip;
-    int          flag, k;
-    int          smallnum, smaller, larger, i, is_small, is_smaller, run, prevrun;
-    float *      lfp, lf;
-    int          tmp, *thiscoord, prevcoord[3];
-    unsigned int tmpcoord[30];
+    int      minint[3], maxint[3], mindiff, *lip, diff;
+    int      lint1, lint2, lint3, oldlint1, oldlint2, oldlint3, smallidx;
+    unsigned sizeint[3], bitsizeint[3], size3;
+    int      i, k;
+    float *  lfp, lf;
 
     int          bufsize, lsize;
     unsigned int bitsize;
@@ -426,10 +1087,9 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
 
     bRead         = (xdrs->x_op == XDR_DECODE);
     bitsizeint[0] = bitsizeint[1] = bitsizeint[2] = 0;
-    prevcoord[0] = prevcoord[1] = prevcoord[2] = 0;
 
-    // The static analyzer warns about garbage values for thiscoord[] further
-    // down. It might be thrown off by all the reinterpret_casts, but we might
+    // The static analyzer warns about garbage values for the coordinates in
+    // encodeAtoms(). It might be thrown off by all the reinterpret_casts, but we might
     // as well make sure the small preallocated buffer is zero-initialized.
     for (i = 0; i < static_cast<int>(prealloc_size); i++)
     {
@@ -481,7 +1141,6 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
         buf[0] = buf[1] = buf[2] = 0;
         minint[0] = minint[1] = minint[2] = INT_MAX;
         maxint[0] = maxint[1] = maxint[2] = INT_MIN;
-        prevrun                           = -1;
         lfp                               = fp;
         lip                               = ip;
         mindiff                           = INT_MAX;
@@ -607,7 +1266,6 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
         {
             bitsize = sizeofints(3, sizeint);
         }
-        luip     = reinterpret_cast<unsigned int*>(ip);
         smallidx = FIRSTIDX;
         while (smallidx < LASTIDX && magicints[smallidx] < mindiff)
         {
@@ -623,137 +1281,46 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
             return 0;
         }
 
-        maxidx       = std::min(LASTIDX, smallidx + 8);
-        minidx       = maxidx - 8; /* often this equal smallidx */
-        smaller      = magicints[std::max(FIRSTIDX, smallidx - 1)] / 2;
-        smallnum     = magicints[smallidx] / 2;
-        sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
-        larger                                     = magicints[maxidx] / 2;
-        i                                          = 0;
-        while (i < *size)
+        XtcCoordinateEncoding enc;
+        for (k = 0; k < 3; k++)
         {
-            is_small  = 0;
-            thiscoord = reinterpret_cast<int*>(luip) + i * 3;
-            if (smallidx < maxidx && i >= 1 && std::abs(thiscoord[0] - prevcoord[0]) < larger
-                && std::abs(thiscoord[1] - prevcoord[1]) < larger
-                && std::abs(thiscoord[2] - prevcoord[2]) < larger)
-            {
-                is_smaller = 1;
-            }
-            else if (smallidx > minidx)
-            {
-                is_smaller = -1;
-            }
-            else
-            {
-                is_smaller = 0;
-            }
-            if (i + 1 < *size)
-            {
-                if (std::abs(thiscoord[0] - thiscoord[3]) < smallnum
-                    && std::abs(thiscoord[1] - thiscoord[4]) < smallnum
-                    && std::abs(thiscoord[2] - thiscoord[5]) < smallnum)
-                {
-                    /* interchange first with second atom for better
-                     * compression of water molecules
-                     */
-                    tmp          = thiscoord[0];
-                    thiscoord[0] = thiscoord[3];
-                    thiscoord[3] = tmp;
-                    tmp          = thiscoord[1];
-                    thiscoord[1] = thiscoord[4];
-                    thiscoord[4] = tmp;
-                    tmp          = thiscoord[2];
-                    thiscoord[2] = thiscoord[5];
-                    thiscoord[5] = tmp;
-                    is_small     = 1;
-                }
-            }
-            tmpcoord[0] = thiscoord[0] - minint[0];
-            tmpcoord[1] = thiscoord[1] - minint[1];
-            tmpcoord[2] = thiscoord[2] - minint[2];
-            if (bitsize == 0)
-            {
-                sendbits(buf, bitsizeint[0], tmpcoord[0]);
-                sendbits(buf, bitsizeint[1], tmpcoord[1]);
-                sendbits(buf, bitsizeint[2], tmpcoord[2]);
-            }
-            else
-            {
-                sendints(buf, 3, bitsize, sizeint, tmpcoord);
-            }
-            prevcoord[0] = thiscoord[0];
-            prevcoord[1] = thiscoord[1];
-            prevcoord[2] = thiscoord[2];
-            thiscoord    = thiscoord + 3;
-            i++;
-
-            run = 0;
-            if (is_small == 0 && is_smaller == -1)
-            {
-                is_smaller = 0;
-            }
-            while (is_small && run < 8 * 3)
-            {
-                if (is_smaller == -1
-                    && (SQR(thiscoord[0] - prevcoord[0]) + SQR(thiscoord[1] - prevcoord[1])
-                                + SQR(thiscoord[2] - prevcoord[2])
-                        >= smaller * smaller))
-                {
-                    is_smaller = 0;
-                }
-
-                tmpcoord[run++] = thiscoord[0] - prevcoord[0] + smallnum;
-                tmpcoord[run++] = thiscoord[1] - prevcoord[1] + smallnum;
-                tmpcoord[run++] = thiscoord[2] - prevcoord[2] + smallnum;
-
-                prevcoord[0] = thiscoord[0];
-                prevcoord[1] = thiscoord[1];
-                prevcoord[2] = thiscoord[2];
+            enc.minint[k]     = minint[k];
+            enc.sizeint[k]    = sizeint[k];
+            enc.bitsizeint[k] = bitsizeint[k];
+        }
+        enc.bitsize = bitsize;
+        enc.maxidx  = std::min(LASTIDX, smallidx + 8);
+        enc.minidx  = enc.maxidx - 8; /* often this equal smallidx */
+        enc.larger  = magicints[enc.maxidx] / 2;
+
+        XtcEncoderState state;
+        state.atom     = 0;
+        state.smallidx = smallidx;
+        state.smaller  = magicints[std::max(FIRSTIDX, smallidx - 1)] / 2;
+        state.smallnum = magicints[smallidx] / 2;
+        state.prevrun  = -1;
+        for (k = 0; k < 3; k++)
+        {
+            state.prevcoord[k] = 0;
+        }
 
-                i++;
-                thiscoord = thiscoord + 3;
-                is_small  = 0;
-                if (i < *size && abs(thiscoord[0] - prevcoord[0]) < smallnum
-                    && abs(thiscoord[1] - prevcoord[1]) < smallnum
-                    && abs(thiscoord[2] - prevcoord[2]) < smallnum)
-                {
-                    is_small = 1;
-                }
-            }
-            if (run != prevrun || is_smaller != 0)
-            {
-                prevrun = run;
-                sendbits(buf, 1, 1); /* flag the change in run-length */
-                sendbits(buf, 5, run + is_smaller + 1);
-            }
-            else
-            {
-                sendbits(buf, 1, 0); /* flag the fact that runlength did not change */
-            }
-            for (k = 0; k < run; k += 3)
-            {
-                sendints(buf, 3, smallidx, sizesmall, &tmpcoord[k]);
-            }
-            if (is_smaller != 0)
-            {
-                smallidx += is_smaller;
-                if (is_smaller < 0)
-                {
-                    smallnum = smaller;
-                    smaller  = magicints[smallidx - 1] / 2;
-                }
-                else
-                {
-                    smaller  = smallnum;
-                    smallnum = magicints[smallidx] / 2;
-                }
-                sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
-            }
+        std::vector<unsigned char> chunkedBytes;
+        unsigned char*             bytes;
+        if (atomsPerChunk > 0 && *size >= 2 * atomsPerChunk)
+        {
+            encodeChunks(ip, *size, atomsPerChunk, enc, state, buf, numThreads, &chunkedBytes);
+            buf[0] = chunkedBytes.size();
+            bytes  = chunkedBytes.data();
         }
-        if (buf[1] != 0)
+        else
         {
-            buf[0]++;
+            buf[0] = buf[1] = buf[2] = 0;
+            encodeAtoms(buf, ip, *size, *size, enc, &state);
+            if (buf[1] != 0)
+            {
+                buf[0]++;
+            }
+            bytes = reinterpret_cast<unsigned char*>(&(buf[3]));
         }
         /* buf[0] holds the length in bytes */
         if (xdr_int(xdrs, &(buf[0])) == 0)
@@ -768,7 +1335,7 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
 
 
         rc = errval
-             * (xdr_opaque(xdrs, reinterpret_cast<char*>(&(buf[3])), static_cast<unsigned int>(buf[0])));
+             * (xdr_opaque(xdrs, reinterpret_cast<char*>(bytes), static_cast<unsigned int>(buf[0])));
         if (we_should_free)
         {
             free(ip);
@@ -865,10 +1432,6 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
             return 0;
         }
 
-        smaller      = magicints[std::max(FIRSTIDX, smallidx - 1)] / 2;
-        smallnum     = magicints[smallidx] / 2;
-        sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
-
         /* buf[0] holds the length in bytes */
 
         if (xdr_int(xdrs, &(buf[0])) == 0)
@@ -893,111 +1456,35 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
         }
 
 
-        buf[0] = buf[1] = buf[2] = 0;
-
-        lfp           = fp;
-        inv_precision = 1.0 / *precision;
-        run           = 0;
-        i             = 0;
-        lip           = ip;
-        while (i < lsize)
+        XtcCoordinateEncoding enc;
+        for (k = 0; k < 3; k++)
         {
-            thiscoord = reinterpret_cast<int*>(lip) + i * 3;
-
-            if (bitsize == 0)
-            {
-                thiscoord[0] = receivebits(buf, bitsizeint[0]);
-                thiscoord[1] = receivebits(buf, bitsizeint[1]);
-                thiscoord[2] = receivebits(buf, bitsizeint[2]);
-            }
-            else
-            {
-                receiveints(buf, 3, bitsize, sizeint, thiscoord);
-            }
-
-            i++;
-            thiscoord[0] += minint[0];
-            thiscoord[1] += minint[1];
-            thiscoord[2] += minint[2];
-
-            prevcoord[0] = thiscoord[0];
-            prevcoord[1] = thiscoord[1];
-            prevcoord[2] = thiscoord[2];
+            enc.minint[k]     = minint[k];
+            enc.sizeint[k]    = sizeint[k];
+            enc.bitsizeint[k] = bitsizeint[k];
+        }
+        enc.bitsize   = bitsize;
+        inv_precision = 1.0 / *precision;
 
+        /* Decompress in parallel when the data contains a chunk index */
+        std::vector<XtcChunkStart> chunkStarts;
+        const unsigned char*       bytes = reinterpret_cast<unsigned char*>(&(buf[3]));
+        if (atomsPerChunk > 0 && numThreads > 1)
+        {
+            chunkStarts = readChunkIndex(bytes, buf[0], lsize, smallidx);
+        }
+        if (!chunkStarts.empty())
+        {
+            const int64_t numStreamBytes = buf[0] - chunkIndexSize(chunkStarts.size());
+            decodeChunks(bytes, numStreamBytes, chunkStarts, lsize, enc, inv_precision, numThreads,
+                         ip, fp);
+        }
+        else
+        {
+            buf[0] = buf[1] = buf[2] = 0;
 
-            flag       = receivebits(buf, 1);
-            is_smaller = 0;
-            if (flag == 1)
-            {
-                run        = receivebits(buf, 5);
-                is_smaller = run % 3;
-                run -= is_smaller;
-                is_smaller--;
-            }
-            if (run > 0)
-            {
-                thiscoord += 3;
-                for (k = 0; k < run; k += 3)
-                {
-                    receiveints(buf, 3, smallidx, sizesmall, thiscoord);
-                    i++;
-                    thiscoord[0] += prevcoord[0] - smallnum;
-                    thiscoord[1] += prevcoord[1] - smallnum;
-                    thiscoord[2] += prevcoord[2] - smallnum;
-                    if (k == 0)
-                    {
-                        /* interchange first with second atom for better
-                         * compression of water molecules
-                         */
-                        tmp          = thiscoord[0];
-                        thiscoord[0] = prevcoord[0];
-                        prevcoord[0] = tmp;
-                        tmp          = thiscoord[1];
-                        thiscoord[1] = prevcoord[1];
-                        prevcoord[1] = tmp;
-                        tmp          = thiscoord[2];
-                        thiscoord[2] = prevcoord[2];
-                        prevcoord[2] = tmp;
-                        *lfp++       = prevcoord[0] * inv_precision;
-                        *lfp++       = prevcoord[1] * inv_precision;
-                        *lfp++       = prevcoord[2] * inv_precision;
-                    }
-                    else
-                    {
-                        prevcoord[0] = thiscoord[0];
-                        prevcoord[1] = thiscoord[1];
-                        prevcoord[2] = thiscoord[2];
-                    }
-                    *lfp++ = thiscoord[0] * inv_precision;
-                    *lfp++ = thiscoord[1] * inv_precision;
-                    *lfp++ = thiscoord[2] * inv_precision;
-                }
-            }
-            else
-            {
-                *lfp++ = thiscoord[0] * inv_precision;
-                *lfp++ = thiscoord[1] * inv_precision;
-                *lfp++ = thiscoord[2] * inv_precision;
-            }
-            smallidx += is_smaller;
-            if (is_smaller < 0)
-            {
-                smallnum = smaller;
-                if (smallidx > FIRSTIDX)
-                {
-                    smaller = magicints[smallidx - 1] / 2;
-                }
-                else
-                {
-                    smaller = 0;
-                }
-            }
-            else if (is_smaller > 0)
-            {
-                smaller  = smallnum;
-                smallnum = magicints[smallidx] / 2;
-            }
-            sizesmall[0] = sizesmall[1] = sizesmall[2] = magicints[smallidx];
+            XtcDecoderState state = decoderStateAtChunkStart(0, smallidx, 0);
+            decodeAtoms(buf, ip, fp, lsize, enc, inv_precision, &state);
         }
     }
     if (we_should_free)
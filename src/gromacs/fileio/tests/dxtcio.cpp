@@ -0,0 +1,273 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for encoding and reading distributed XTC (DXTC) files.
+ *
+ * \ingroup module_fileio
+ */
+
+#include "gmxpre.h"
+
+#include "gromacs/fileio/dxtcio.h"
+
+#include <cmath>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/oenv.h"
+#include "gromacs/fileio/trxio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/exceptions.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+class DxtcTest : public ::testing::Test
+{
+public:
+    DxtcTest()
+    {
+        /* A chain of atoms, so consecutive atoms are close */
+        for (int a = 0; a < c_numAtomsGlobal; a++)
+        {
+            x_.emplace_back(0.15F * a, 1.0F + std::sin(0.3F * a), 2.0F + std::cos(0.7F * a));
+        }
+    }
+
+    /*! \brief Writes frames with the atoms distributed over blocks like over DD ranks
+     *
+     * Atom \c a is in block <tt>(a / 7 + frame) % numBlocks</tt>, so the blocks
+     * contain several ranges of atoms and the distribution changes each frame.
+     */
+    void write(ArrayRef<const Range<int>> selection, int numBlocks, int numFrames)
+    {
+        std::ofstream     stream(filename_, std::ios::binary);
+        std::vector<char> header = encodeDxtcFileHeader(c_numAtomsGlobal, selection);
+        stream.write(header.data(), header.size());
+        for (int frame = 0; frame < numFrames; frame++)
+        {
+            std::vector<std::vector<char>> blocks;
+            std::vector<int>               blockSizes;
+            for (int b = 0; b < numBlocks; b++)
+            {
+                /* Add the atoms in reverse order, the block should sort them */
+                std::vector<int>  indices;
+                std::vector<RVec> x;
+                for (int a = c_numAtomsGlobal - 1; a >= 0; a--)
+                {
+                    if ((a / 7 + frame) % numBlocks == b && isSelected(selection, a))
+                    {
+                        indices.push_back(a);
+                        x.push_back(frameCoordinates(a, frame));
+                    }
+                }
+                blocks.push_back(encodeDxtcBlock(indices, x, c_precision));
+                blockSizes.push_back(blocks.back().size());
+            }
+            matrix box = { { 5, 0, 0 }, { 0, 6, 0 }, { 1, 2, 7.0F + frame } };
+            header     = encodeDxtcFrameHeader(10 * frame, 0.02F * frame, box, blockSizes);
+            EXPECT_EQ(dxtcFrameHeaderSize(numBlocks), static_cast<int>(header.size()));
+            stream.write(header.data(), header.size());
+            for (const auto& block : blocks)
+            {
+                stream.write(block.data(), block.size());
+            }
+        }
+    }
+
+    //! Reads the frames and checks them against the written coordinates
+    void readAndCheck(ArrayRef<const Range<int>> selection, int numAtoms, int numFrames)
+    {
+        DxtcReader reader(filename_);
+        EXPECT_EQ(c_numAtomsGlobal, reader.numAtomsGlobal());
+        ASSERT_EQ(numAtoms, reader.numAtoms());
+
+        std::vector<RVec> x(numAtoms);
+        int64_t           step;
+        real              time;
+        matrix            box;
+        for (int frame = 0; frame < numFrames; frame++)
+        {
+            ASSERT_TRUE(reader.readNextFrame(&step, &time, box, x));
+            EXPECT_EQ(10 * frame, step);
+            EXPECT_FLOAT_EQ(0.02F * frame, time);
+            EXPECT_FLOAT_EQ(7.0F + frame, box[ZZ][ZZ]);
+            EXPECT_FLOAT_EQ(2.0F, box[ZZ][YY]);
+            int i = 0;
+            for (int a = 0; a < c_numAtomsGlobal; a++)
+            {
+                if (isSelected(selection, a))
+                {
+                    const RVec ref = frameCoordinates(a, frame);
+                    for (int d = 0; d < DIM; d++)
+                    {
+                        ASSERT_NEAR(ref[d], x[i][d], 0.6 / c_precision) << "atom " << a;
+                    }
+                    i++;
+                }
+            }
+        }
+        EXPECT_FALSE(reader.readNextFrame(&step, &time, box, x));
+    }
+
+    //! Returns whether atom \p a is in \p selection, all atoms are when it is empty
+    static bool isSelected(ArrayRef<const Range<int>> selection, int a)
+    {
+        if (selection.empty())
+        {
+            return true;
+        }
+        for (const auto& range : selection)
+        {
+            if (range.isInRange(a))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //! Returns the coordinates of atom \p a in \p frame
+    RVec frameCoordinates(int a, int frame) const
+    {
+        RVec x = x_[a];
+        x[XX] += 0.01F * frame;
+        return x;
+    }
+
+    //! The number of atoms in the system
+    static constexpr int c_numAtomsGlobal = 1000;
+    //! The compression precision
+    static constexpr real c_precision = 1000;
+
+    std::vector<RVec> x_;
+    TestFileManager   fileManager_;
+    std::string       filename_ = fileManager_.getTemporaryFilePath("traj.dxtc");
+};
+
+TEST_F(DxtcTest, WritesAndReadsAllAtoms)
+{
+    write({}, 4, 3);
+    readAndCheck({}, c_numAtomsGlobal, 3);
+}
+
+TEST_F(DxtcTest, WritesAndReadsSelection)
+{
+    const std::vector<Range<int>> selection = { { 3, 17 }, { 100, 101 }, { 400, 900 } };
+    write(selection, 3, 2);
+    readAndCheck(selection, 515, 2);
+}
+
+TEST_F(DxtcTest, WritesAndReadsEmptyBlocks)
+{
+    // Blocks 143 and up stay empty with our distribution of the atoms
+    write({}, 160, 1);
+    readAndCheck({}, c_numAtomsGlobal, 1);
+}
+
+TEST_F(DxtcTest, ReadsFramesWithTrajectoryReader)
+{
+    write({}, 4, 3);
+
+    gmx_output_env_t* oenv;
+    output_env_init_default(&oenv);
+    t_trxstatus* status;
+    t_trxframe   fr;
+    ASSERT_TRUE(read_first_frame(oenv, &status, filename_.c_str(), &fr, TRX_NEED_X));
+    int frame = 0;
+    do
+    {
+        ASSERT_EQ(c_numAtomsGlobal, fr.natoms);
+        EXPECT_TRUE(fr.bX && fr.bBox && fr.bStep && fr.bTime);
+        EXPECT_EQ(10 * frame, fr.step);
+        EXPECT_FLOAT_EQ(7.0F + frame, fr.box[ZZ][ZZ]);
+        for (int a = 0; a < c_numAtomsGlobal; a++)
+        {
+            const RVec ref = frameCoordinates(a, frame);
+            for (int d = 0; d < DIM; d++)
+            {
+                ASSERT_NEAR(ref[d], fr.x[a][d], 0.6 / c_precision) << "atom " << a;
+            }
+        }
+        frame++;
+    } while (read_next_frame(oenv, status, &fr));
+    EXPECT_EQ(3, frame);
+    close_trx(status);
+    done_frame(&fr);
+    output_env_done(oenv);
+}
+
+TEST_F(DxtcTest, ThrowsOnMissingAtoms)
+{
+    std::ofstream     stream(filename_, std::ios::binary);
+    std::vector<char> header = encodeDxtcFileHeader(c_numAtomsGlobal, {});
+    stream.write(header.data(), header.size());
+    std::vector<int>  indices    = { 0, 1, 2 };
+    std::vector<char> block      = encodeDxtcBlock(indices, constArrayRefFromArray(x_.data(), 3), c_precision);
+    std::vector<int>  blockSizes = { static_cast<int>(block.size()) };
+    matrix            box        = { { 0 } };
+    header                       = encodeDxtcFrameHeader(0, 0, box, blockSizes);
+    stream.write(header.data(), header.size());
+    stream.write(block.data(), block.size());
+    stream.close();
+
+    DxtcReader        reader(filename_);
+    std::vector<RVec> x(c_numAtomsGlobal);
+    int64_t           step;
+    real              time;
+    EXPECT_THROW(reader.readNextFrame(&step, &time, box, x), FileIOError);
+}
+
+TEST_F(DxtcTest, ThrowsOnInvalidFile)
+{
+    std::ofstream(filename_) << "not a trajectory";
+    EXPECT_THROW(DxtcReader reader(filename_), FileIOError);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
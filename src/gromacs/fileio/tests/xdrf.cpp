@@ -0,0 +1,177 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for chunked compression of coordinates with xdr3dfcoord.
+ *
+ * \ingroup module_fileio
+ */
+
+#include "gmxpre.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/gmxfio_xdr.h"
+#include "gromacs/fileio/xdrf.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The number of bytes before the byte count of the compressed data
+const int c_headerSize = 36;
+
+class XdrCoordinateCompressionTest : public ::testing::Test
+{
+public:
+    XdrCoordinateCompressionTest()
+    {
+        /* Water-like molecules on a distorted lattice, so that both
+         * the run-length and the small-difference encoding are used.
+         */
+        const int   numMolecules = 7000;
+        const float spacing      = 0.31;
+        for (int m = 0; m < numMolecules; m++)
+        {
+            const float o[3] = { (m % 20) * spacing + 0.05F * std::sin(0.7F * m),
+                                 ((m / 20) % 20) * spacing + 0.05F * std::cos(1.3F * m),
+                                 (m / 400) * spacing + 0.05F * std::sin(2.1F * m) };
+            coordinates_.insert(coordinates_.end(), o, o + 3);
+            coordinates_.insert(coordinates_.end(), { o[0] + 0.1F, o[1], o[2] });
+            coordinates_.insert(coordinates_.end(), { o[0] - 0.033F, o[1] + 0.094F, o[2] });
+        }
+    }
+
+    //! Writes the coordinates to \p filename compressing in chunks of \p atomsPerChunk atoms
+    void write(const std::string& filename, int atomsPerChunk, int numThreads = 1)
+    {
+        t_fileio* file      = gmx_fio_open(filename.c_str(), "w");
+        int       numAtoms  = coordinates_.size() / 3;
+        float     precision = 1000;
+        EXPECT_EQ(1, xdr3dfcoord_chunked(gmx_fio_getxdr(file), coordinates_.data(), &numAtoms,
+                                         &precision, atomsPerChunk, numThreads));
+        gmx_fio_close(file);
+    }
+
+    //! Returns the coordinates read from \p filename
+    std::vector<float> read(const std::string& filename, int atomsPerChunk, int numThreads)
+    {
+        std::vector<float> coordinates(coordinates_.size());
+        t_fileio*          file      = gmx_fio_open(filename.c_str(), "r");
+        int                numAtoms  = 0;
+        float              precision = 0;
+        EXPECT_EQ(1, xdr3dfcoord_chunked(gmx_fio_getxdr(file), coordinates.data(), &numAtoms,
+                                         &precision, atomsPerChunk, numThreads));
+        EXPECT_EQ(coordinates_.size(), 3 * static_cast<size_t>(numAtoms));
+        gmx_fio_close(file);
+        return coordinates;
+    }
+
+    //! Returns the contents of \p filename
+    static std::vector<char> contents(const std::string& filename)
+    {
+        std::ifstream stream(filename, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(stream),
+                                 std::istreambuf_iterator<char>());
+    }
+
+    std::vector<float> coordinates_;
+    TestFileManager    fileManager_;
+    // Make sure the file extension is one that gmx_fio_open will
+    // recognize to open as binary.
+    std::string serialFilename_  = fileManager_.getTemporaryFilePath("serial.xtc");
+    std::string chunkedFilename_ = fileManager_.getTemporaryFilePath("chunked.xtc");
+};
+
+TEST_F(XdrCoordinateCompressionTest, ChunkedDataStartsWithSerialData)
+{
+    write(serialFilename_, 0);
+    const std::vector<char> serial = contents(serialFilename_);
+
+    for (int numThreads : { 1, 4 })
+    {
+        SCOPED_TRACE("with " + std::to_string(numThreads) + " threads");
+        write(chunkedFilename_, 1000, numThreads);
+        const std::vector<char> chunked = contents(chunkedFilename_);
+
+        // The header, apart from the byte count, and the compressed
+        // data of a serial write are identical, the chunk index follows
+        ASSERT_GT(serial.size(), c_headerSize + 4U);
+        ASSERT_GT(chunked.size(), serial.size());
+        EXPECT_TRUE(std::equal(serial.begin(), serial.begin() + c_headerSize, chunked.begin()));
+        const auto* count          = reinterpret_cast<const unsigned char*>(&serial[c_headerSize]);
+        const int   numSerialBytes = (count[0] << 24) | (count[1] << 16) | (count[2] << 8) | count[3];
+        EXPECT_TRUE(std::equal(serial.begin() + c_headerSize + 4,
+                               serial.begin() + c_headerSize + 4 + numSerialBytes,
+                               chunked.begin() + c_headerSize + 4));
+    }
+}
+
+TEST_F(XdrCoordinateCompressionTest, ChunkedDataIsReadCorrectly)
+{
+    write(serialFilename_, 0);
+    write(chunkedFilename_, 1000);
+    const std::vector<float> reference = read(serialFilename_, 0, 1);
+    for (size_t i = 0; i < reference.size(); i++)
+    {
+        ASSERT_NEAR(coordinates_[i], reference[i], 0.001F) << "at coordinate " << i;
+    }
+
+    for (int numThreads : { 1, 4 })
+    {
+        SCOPED_TRACE("with " + std::to_string(numThreads) + " threads");
+        EXPECT_EQ(reference, read(chunkedFilename_, 1000, numThreads));
+        EXPECT_EQ(reference, read(chunkedFilename_, 0, numThreads));
+        EXPECT_EQ(reference, read(serialFilename_, 1000, numThreads));
+    }
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
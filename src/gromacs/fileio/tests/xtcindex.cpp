@@ -0,0 +1,256 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the frame index of XTC files.
+ *
+ * \ingroup module_fileio
+ */
+
+#include "gmxpre.h"
+
+#include "gromacs/fileio/xtcindex.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/utility/futil.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+class XtcFrameIndexTest : public ::testing::Test
+{
+public:
+    /*! \brief Writes an XTC file and returns the offset, step and time of each frame
+     *
+     * The number of compressed bytes differs between frames.
+     */
+    static std::vector<XtcFrameIndexEntry>
+    writeXtcFile(const std::string& filename, int numAtoms, int numFrames)
+    {
+        const matrix                    box = { { 5, 0, 0 }, { 0, 5, 0 }, { 0, 0, 5 } };
+        std::vector<XtcFrameIndexEntry> frames;
+        std::vector<RVec>               x(numAtoms);
+        t_fileio*                       fio = open_xtc(filename.c_str(), "w");
+        for (int frame = 0; frame < numFrames; frame++)
+        {
+            for (int a = 0; a < numAtoms; a++)
+            {
+                x[a] = { 0.01_real * a * (frame + 1), 0.5_real * frame, 0.003_real * a * a };
+            }
+            const int64_t step = 100 * frame;
+            const real    time = 0.2_real * frame;
+            frames.push_back({ gmx_fio_ftell(fio), step, static_cast<float>(time) });
+            EXPECT_NE(0, write_xtc(fio, numAtoms, step, time, box, as_rvec_array(x.data()), 1000));
+        }
+        close_xtc(fio);
+        return frames;
+    }
+
+    //! Checks that \p index holds \p frames
+    static void checkFrames(const std::vector<XtcFrameIndexEntry>& frames,
+                            const XtcFrameIndex&                   index)
+    {
+        ASSERT_EQ(static_cast<int>(frames.size()), index.numFrames());
+        for (int i = 0; i < index.numFrames(); i++)
+        {
+            EXPECT_EQ(frames[i].offset, index.frames()[i].offset);
+            EXPECT_EQ(frames[i].step, index.frames()[i].step);
+            EXPECT_EQ(frames[i].time, index.frames()[i].time);
+        }
+    }
+
+    //! Handles temporary files
+    TestFileManager fileManager_;
+};
+
+TEST_F(XtcFrameIndexTest, BuildsIndexOfCompressedFrames)
+{
+    const std::string filename = fileManager_.getTemporaryFilePath("compressed.xtc");
+    const auto        frames   = writeXtcFile(filename, 500, 7);
+
+    checkFrames(frames, XtcFrameIndex::build(filename));
+}
+
+TEST_F(XtcFrameIndexTest, BuildsIndexOfUncompressedFrames)
+{
+    const std::string filename = fileManager_.getTemporaryFilePath("small.xtc");
+    const auto        frames   = writeXtcFile(filename, 5, 4);
+
+    checkFrames(frames, XtcFrameIndex::build(filename));
+}
+
+TEST_F(XtcFrameIndexTest, BuildStopsAtIncompleteFrame)
+{
+    const std::string filename = fileManager_.getTemporaryFilePath("incomplete.xtc");
+    auto              frames   = writeXtcFile(filename, 500, 5);
+    ASSERT_EQ(0, gmx_truncate(filename, frames[4].offset + 40));
+    frames.pop_back();
+
+    checkFrames(frames, XtcFrameIndex::build(filename));
+}
+
+TEST_F(XtcFrameIndexTest, WritesAndReadsIndex)
+{
+    const std::string filename = fileManager_.getTemporaryFilePath("traj.xtc");
+    fileManager_.getTemporaryFilePath("traj.xtc.idx");
+    const auto frames = writeXtcFile(filename, 500, 6);
+
+    EXPECT_EQ(0, XtcFrameIndex::read(filename).numFrames());
+    EXPECT_TRUE(XtcFrameIndex::build(filename).write(filename));
+    checkFrames(frames, XtcFrameIndex::read(filename));
+    checkFrames(frames, XtcFrameIndex::readOrBuild(filename));
+}
+
+TEST_F(XtcFrameIndexTest, ReadOrBuildWritesIndex)
+{
+    const std::string filename = fileManager_.getTemporaryFilePath("built.xtc");
+    fileManager_.getTemporaryFilePath("built.xtc.idx");
+    const auto frames = writeXtcFile(filename, 500, 3);
+
+    checkFrames(frames, XtcFrameIndex::readOrBuild(filename));
+    checkFrames(frames, XtcFrameIndex::read(filename));
+}
+
+TEST_F(XtcFrameIndexTest, ReadOrBuildKeepsIndexOfRunningSimulation)
+{
+    const std::string filename = fileManager_.getTemporaryFilePath("running.xtc");
+    fileManager_.getTemporaryFilePath("running.xtc.idx");
+    XtcFrameIndexWriter writer(filename, false, 0);
+    const auto          frames = writeXtcFile(filename, 500, 3);
+
+    // The frames are written, but not yet added to the index by the simulation
+    checkFrames(frames, XtcFrameIndex::readOrBuild(filename));
+    EXPECT_EQ(0, XtcFrameIndex::read(filename).numFrames());
+
+    for (const auto& frame : frames)
+    {
+        writer.addFrame(frame.offset, frame.step, frame.time);
+    }
+    checkFrames(frames, XtcFrameIndex::read(filename));
+}
+
+TEST_F(XtcFrameIndexTest, ReadIgnoresFramesTruncatedFromXtcFile)
+{
+    const std::string filename = fileManager_.getTemporaryFilePath("truncated.xtc");
+    fileManager_.getTemporaryFilePath("truncated.xtc.idx");
+    auto frames = writeXtcFile(filename, 500, 6);
+    EXPECT_TRUE(XtcFrameIndex::build(filename).write(filename));
+
+    ASSERT_EQ(0, gmx_truncate(filename, frames[4].offset));
+    frames.resize(4);
+    checkFrames(frames, XtcFrameIndex::read(filename));
+}
+
+TEST_F(XtcFrameIndexTest, ReadRejectsIndexOfOtherFile)
+{
+    const std::string filename = fileManager_.getTemporaryFilePath("overwritten.xtc");
+    fileManager_.getTemporaryFilePath("overwritten.xtc.idx");
+    writeXtcFile(filename, 500, 6);
+    EXPECT_TRUE(XtcFrameIndex::build(filename).write(filename));
+
+    writeXtcFile(filename, 800, 6);
+    EXPECT_EQ(0, XtcFrameIndex::read(filename).numFrames());
+}
+
+TEST_F(XtcFrameIndexTest, WriterTruncatesIndexWhenAppending)
+{
+    const std::string filename = fileManager_.getTemporaryFilePath("appended.xtc");
+    fileManager_.getTemporaryFilePath("appended.xtc.idx");
+    const auto frames = writeXtcFile(filename, 500, 5);
+    {
+        XtcFrameIndexWriter writer(filename, false, 0);
+        for (const auto& frame : frames)
+        {
+            writer.addFrame(frame.offset, frame.step, frame.time);
+        }
+    }
+    checkFrames(frames, XtcFrameIndex::read(filename));
+
+    // A restart from a checkpoint truncates the XTC file after the third frame
+    ASSERT_EQ(0, gmx_truncate(filename, frames[3].offset));
+    {
+        XtcFrameIndexWriter writer(filename, true, frames[3].offset);
+    }
+    // Writing the same frames again makes the XTC file match the old index again
+    writeXtcFile(filename, 500, 5);
+    checkFrames({ frames.begin(), frames.begin() + 3 }, XtcFrameIndex::read(filename));
+}
+
+TEST_F(XtcFrameIndexTest, WriterBuildsMissingIndexWhenAppending)
+{
+    const std::string filename = fileManager_.getTemporaryFilePath("noindex.xtc");
+    fileManager_.getTemporaryFilePath("noindex.xtc.idx");
+    const auto frames = writeXtcFile(filename, 500, 4);
+    ASSERT_EQ(0, gmx_truncate(filename, frames[3].offset));
+    {
+        XtcFrameIndexWriter writer(filename, true, frames[3].offset);
+        writer.addFrame(frames[3].offset, frames[3].step, frames[3].time);
+    }
+    writeXtcFile(filename, 500, 4);
+    checkFrames(frames, XtcFrameIndex::read(filename));
+}
+
+TEST_F(XtcFrameIndexTest, FindsFramesByOffsetAndTime)
+{
+    const std::string filename = fileManager_.getTemporaryFilePath("search.xtc");
+    const auto        frames   = writeXtcFile(filename, 500, 6);
+    XtcFrameIndex     index    = XtcFrameIndex::build(filename);
+
+    EXPECT_TRUE(index.timesAreIncreasing());
+    EXPECT_EQ(0, index.firstFrameAtOrAfter(0));
+    EXPECT_EQ(2, index.firstFrameAtOrAfter(frames[2].offset));
+    EXPECT_EQ(3, index.firstFrameAtOrAfter(frames[2].offset + 1));
+    EXPECT_EQ(6, index.firstFrameAtOrAfter(frames[5].offset + 1));
+    EXPECT_EQ(0, index.firstFrameAtOrAfterTime(-1));
+    EXPECT_EQ(3, index.firstFrameAtOrAfterTime(0.5));
+    EXPECT_EQ(6, index.firstFrameAtOrAfterTime(10));
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -3330,6 +3330,78 @@ PartialDeserializedTprFile read_tpx_state(const char* fn, t_inputrec* ir, t_stat
     return partialDeserializedTpr;
 }
 
+InMemoryTpr serializeTprToMemory(const t_inputrec* ir, const t_state* state, const gmx_mtop_t* mtop)
+{
+    GMX_RELEASE_ASSERT(mtop != nullptr, "Need a topology to serialize");
+    TpxFileHeader header = populateTpxHeader(*state, ir, mtop);
+    // Use the byte order of the TPR body, so that the sections can be concatenated
+    // into a body that can be deserialized from memory as usual.
+    gmx::InMemorySerializer topologySerializer(gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian);
+    do_tpx_mtop(&topologySerializer, &header, const_cast<gmx_mtop_t*>(mtop));
+    auto topology = std::make_shared<const std::vector<char>>(topologySerializer.finishAndGetBuffer());
+
+    return serializeTprToMemory(ir, state, std::move(topology));
+}
+
+InMemoryTpr serializeTprToMemory(const t_inputrec*                        ir,
+                                 const t_state*                           state,
+                                 std::shared_ptr<const std::vector<char>> topology)
+{
+    GMX_RELEASE_ASSERT(ir != nullptr, "Need simulation parameters to serialize");
+    GMX_RELEASE_ASSERT(topology != nullptr, "Need a serialized topology");
+    InMemoryTpr tpr;
+    tpr.header      = populateTpxHeader(*state, ir, nullptr);
+    tpr.header.bTop = true;
+
+    gmx::InMemorySerializer stateSerializer(gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian);
+    do_tpx_state_first(&stateSerializer, &tpr.header, const_cast<t_state*>(state));
+    do_tpx_state_second(&stateSerializer, &tpr.header, const_cast<t_state*>(state), nullptr, nullptr);
+    tpr.state = stateSerializer.finishAndGetBuffer();
+
+    gmx::InMemorySerializer inputRecordSerializer(gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian);
+    do_tpx_ir(&inputRecordSerializer, &tpr.header, const_cast<t_inputrec*>(ir));
+    tpr.inputRecord = inputRecordSerializer.finishAndGetBuffer();
+
+    // sizeOfTprBody stays zero, as from populateTpxHeader(), because the sections
+    // are not one body. readTprFromMemory() sets it for the body it assembles.
+    tpr.topology = std::move(topology);
+
+    return tpr;
+}
+
+PartialDeserializedTprFile readTprFromMemory(const InMemoryTpr& tpr, t_inputrec* ir, t_state* state, gmx_mtop_t* mtop)
+{
+    GMX_RELEASE_ASSERT(tpr.topology != nullptr, "Need a serialized topology");
+    PartialDeserializedTprFile partialDeserializedTpr;
+    partialDeserializedTpr.header = tpr.header;
+    TpxFileHeader* header         = &partialDeserializedTpr.header;
+
+    gmx::InMemoryDeserializer stateDeserializer(tpr.state, header->isDouble,
+                                                gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian);
+    gmx::InMemoryDeserializer topologyDeserializer(*tpr.topology, header->isDouble,
+                                                   gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian);
+    gmx::InMemoryDeserializer inputRecordDeserializer(
+            tpr.inputRecord, header->isDouble, gmx::EndianSwapBehavior::SwapIfHostIsLittleEndian);
+
+    // Same order as do_tpx_body(), but each part is read from its own section.
+    do_tpx_state_first(&stateDeserializer, header, state);
+    do_tpx_mtop(&topologyDeserializer, header, mtop);
+    do_tpx_state_second(&stateDeserializer, header, state, nullptr, nullptr);
+    partialDeserializedTpr.pbcType = do_tpx_ir(&inputRecordDeserializer, header, ir);
+    do_tpx_finalize(header, ir, state, mtop);
+
+    // Other ranks only need the topology and the input record, which are
+    // already serialized in the order do_tpx_body() expects without a state.
+    partialDeserializedTpr.body.reserve(tpr.topology->size() + tpr.inputRecord.size());
+    partialDeserializedTpr.body.insert(partialDeserializedTpr.body.end(), tpr.topology->begin(),
+                                       tpr.topology->end());
+    partialDeserializedTpr.body.insert(partialDeserializedTpr.body.end(), tpr.inputRecord.begin(),
+                                       tpr.inputRecord.end());
+    header->sizeOfTprBody = partialDeserializedTpr.body.size();
+
+    return partialDeserializedTpr;
+}
+
 PbcType read_tpx(const char* fn, t_inputrec* ir, matrix box, int* natoms, rvec* x, rvec* v, gmx_mtop_t* mtop)
 {
     t_fileio* fio;
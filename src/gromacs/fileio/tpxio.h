@@ -40,6 +40,7 @@
 
 #include <cstdio>
 
+#include <memory>
 #include <vector>
 
 #include "gromacs/math/vectypes.h"
@@ -118,6 +119,28 @@ struct PartialDeserializedTprFile
     PbcType pbcType = PbcType::Unset;
 };
 
+/*! \libinternal
+ * \brief
+ * Contents of a TPR file serialized in memory, in separately owned sections.
+ *
+ * The serialized molecular topology is usually the bulk of the data and is
+ * held in an immutable buffer of shared ownership, so that the input of
+ * simulations that differ only in parameters or state (e.g. the members of
+ * an ensemble) can be prepared and handed to mdrun without writing,
+ * re-serializing or copying the topology.
+ */
+struct InMemoryTpr
+{
+    //! Header describing the serialized contents.
+    TpxFileHeader header;
+    //! The serialized global topology, shared between inputs.
+    std::shared_ptr<const std::vector<char>> topology;
+    //! The serialized box, coupling state, coordinates and velocities.
+    std::vector<char> state;
+    //! The serialized simulation parameters.
+    std::vector<char> inputRecord;
+};
+
 /*
  * These routines handle reading and writing of preprocessed
  * topology files in any of the following formats:
@@ -171,6 +194,47 @@ PbcType completeTprDeserialization(PartialDeserializedTprFile* partialDeserializ
                                    t_inputrec*                 ir,
                                    gmx_mtop_t*                 mtop);
 
+/*! \brief
+ * Serialize simulation input to memory, without writing a TPR file.
+ *
+ * \param[in] ir Simulation parameters.
+ * \param[in] state Global state.
+ * \param[in] mtop Global topology.
+ * \returns Serialized contents, with a newly created topology buffer.
+ */
+InMemoryTpr serializeTprToMemory(const t_inputrec* ir, const t_state* state, const gmx_mtop_t* mtop);
+
+/*! \brief
+ * Serialize simulation input to memory, reusing a serialized topology.
+ *
+ * Only the parameters and the state are serialized. It is the caller's
+ * responsibility that \p topology was serialized for the same system
+ * as \p state, e.g. by an earlier call of the overload above.
+ *
+ * \param[in] ir Simulation parameters.
+ * \param[in] state Global state.
+ * \param[in] topology Serialized global topology to share.
+ * \returns Serialized contents, sharing ownership of \p topology.
+ */
+InMemoryTpr serializeTprToMemory(const t_inputrec*                        ir,
+                                 const t_state*                           state,
+                                 std::shared_ptr<const std::vector<char>> topology);
+
+/*! \brief
+ * Set up a simulation from simulation input serialized in memory.
+ *
+ * Equivalent to read_tpx_state() for the contents of \p tpr. The
+ * returned body for communication to other ranks is assembled from
+ * the serialized sections, without serializing \p mtop again.
+ *
+ * \param[in] tpr Serialized simulation input.
+ * \param[out] ir Input parameters to be set.
+ * \param[out] state State variables for the simulation.
+ * \param[out] mtop Global simulation topology.
+ * \returns Struct with header and body in char vector.
+ */
+PartialDeserializedTprFile readTprFromMemory(const InMemoryTpr& tpr, t_inputrec* ir, t_state* state, gmx_mtop_t* mtop);
+
 /*! \brief
  * Read a file to set up a simulation and close it after reading.
  *
@@ -45,8 +45,11 @@
 #include <cmath>
 #include <cstring>
 
+#include <algorithm>
+
 #include "gromacs/fileio/checkpoint.h"
 #include "gromacs/fileio/confio.h"
+#include "gromacs/fileio/dxtcio.h"
 #include "gromacs/fileio/filetypes.h"
 #include "gromacs/fileio/g96io.h"
 #include "gromacs/fileio/gmxfio.h"
@@ -59,6 +62,7 @@
 #include "gromacs/fileio/tpxio.h"
 #include "gromacs/fileio/trrio.h"
 #include "gromacs/fileio/xdrf.h"
+#include "gromacs/fileio/xtcindex.h"
 #include "gromacs/fileio/xtcio.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdtypes/md_enums.h"
@@ -66,6 +70,7 @@
 #include "gromacs/topology/symtab.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/trajectory/trajectoryframe.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
@@ -90,10 +95,12 @@ struct t_trxstatus
     t_trxframe*          xframe;
     t_fileio*            fio;
     gmx_tng_trajectory_t tng;
+    gmx::DxtcReader*     dxtcReader; /* Reader for DXTC files, which are not opened with fio */
     int                  natoms;
     double               DT, BOX[3];
     gmx_bool             bReadBox;
     char*                persistent_line; /* Persistent line for reading g96 trajectories */
+    gmx::XtcFrameIndex*  xtcFrameIndex;   /* Frame index for skipping XTC frames, read on first use */
 #if GMX_USE_PLUGINS
     gmx_vmdplugin_t* vmdplugin;
 #endif
@@ -167,6 +174,8 @@ static void status_init(t_trxstatus* status)
     status->tf              = 0;
     status->persistent_line = nullptr;
     status->tng             = nullptr;
+    status->dxtcReader      = nullptr;
+    status->xtcFrameIndex   = nullptr;
 }
 
 
@@ -599,11 +608,13 @@ void close_trx(t_trxstatus* status)
         return;
     }
     gmx_tng_close(&status->tng);
+    delete status->dxtcReader;
     if (status->fio)
     {
         gmx_fio_close(status->fio);
     }
     sfree(status->persistent_line);
+    delete status->xtcFrameIndex;
 #if GMX_USE_PLUGINS
     sfree(status->vmdplugin);
 #endif
@@ -767,6 +778,116 @@ static int pdb_first_x(t_trxstatus* status, FILE* fp, t_trxframe* fr)
     return fr->natoms;
 }
 
+/*! \brief Seeks to the next XTC frame that will not be skipped
+ *
+ * With -b or -dt most frames might be skipped. Reading those would
+ * decompress them, so instead we look up the next frame to read in the
+ * frame index. With -dt the index is built when it does not exist yet.
+ * With only -b a binary search of the file, which reads a few frame
+ * headers, is cheaper than building an index, so without a usable
+ * index -b is handled by searching the file.
+ */
+static void xtc_seek_next_frame(t_trxstatus* status, t_trxframe* fr)
+{
+    if (status->xtcFrameIndex == nullptr)
+    {
+        const char* filename = gmx_fio_getname(status->fio);
+        if (bTimeSet(TDELTA) && !(status->flags & TRX_DONT_SKIP))
+        {
+            status->xtcFrameIndex = new gmx::XtcFrameIndex(gmx::XtcFrameIndex::readOrBuild(filename));
+        }
+        else
+        {
+            status->xtcFrameIndex = new gmx::XtcFrameIndex(gmx::XtcFrameIndex::read(filename));
+        }
+    }
+    const gmx::XtcFrameIndex& index = *status->xtcFrameIndex;
+    const bool                bSeekBegin = (bTimeSet(TBEGIN) && (status->tf < rTimeValue(TBEGIN)));
+
+    if (index.numFrames() == 0 || !index.timesAreIncreasing())
+    {
+        if (bSeekBegin)
+        {
+            if (xtc_seek_time(status->fio, rTimeValue(TBEGIN), fr->natoms, TRUE))
+            {
+                gmx_fatal(FARGS,
+                          "Specified frame (time %f) doesn't exist or file "
+                          "corrupt/inconsistent.",
+                          rTimeValue(TBEGIN));
+            }
+            initcount(status);
+        }
+        return;
+    }
+
+    const int currentFrame = index.firstFrameAtOrAfter(gmx_fio_ftell(status->fio));
+    if (currentFrame == index.numFrames())
+    {
+        /* Frames after the indexed ones are read one by one */
+        return;
+    }
+    int frame = currentFrame;
+    if (bSeekBegin)
+    {
+        frame = std::max(frame, index.firstFrameAtOrAfterTime(rTimeValue(TBEGIN)));
+    }
+    if (!(status->flags & TRX_DONT_SKIP))
+    {
+        /* Skip the frames that read_next_frame() would skip after reading them */
+        while (frame < index.numFrames()
+               && check_times2(index.frames()[frame].time, status->t0, fr->bDouble) < 0)
+        {
+            frame++;
+        }
+    }
+    if (frame == index.numFrames())
+    {
+        /* Read the last indexed frame, so unindexed frames are still found */
+        frame = std::max(currentFrame, index.numFrames() - 1);
+    }
+    if (frame > currentFrame)
+    {
+        gmx_fio_seek(status->fio, index.frames()[frame].offset);
+    }
+
+    if (bSeekBegin)
+    {
+        initcount(status);
+    }
+    else
+    {
+        /* Count the skipped frames as if they were read */
+        status->__frame += frame - currentFrame;
+    }
+}
+
+/*! \brief Reads the next frame of a DXTC file into \p fr, which should have x allocated
+ *
+ * The frames are assembled from the blocks written by all ranks, in the
+ * order of the atoms in the selection that was written. As with XTC, an
+ * incomplete last frame, e.g. of a run that was killed, ends the trajectory.
+ */
+static bool dxtc_next_frame(t_trxstatus* status, t_trxframe* fr)
+{
+    bool bRet = false;
+    try
+    {
+        bRet = status->dxtcReader->readNextFrame(
+                &fr->step, &fr->time, fr->box,
+                gmx::arrayRefFromArray(reinterpret_cast<gmx::RVec*>(fr->x), fr->natoms));
+    }
+    catch (const gmx::FileIOError&)
+    {
+        fr->not_ok = DATA_NOT_OK;
+    }
+    fr->bStep = bRet;
+    fr->bTime = bRet;
+    fr->bX    = bRet;
+    fr->bBox  = bRet;
+
+    return bRet;
+}
+
 bool read_next_frame(const gmx_output_env_t* oenv, t_trxstatus* status, t_trxframe* fr)
 {
     real     pt;
@@ -786,6 +907,10 @@ bool read_next_frame(const gmx_output_env_t* oenv, t_trxstatus* status, t_trxfra
             /* Special treatment for TNG files */
             ftp = efTNG;
         }
+        else if (status->dxtcReader)
+        {
+            ftp = efDXTC;
+        }
         else
         {
             ftp = gmx_fio_getftp(status->fio);
@@ -805,16 +930,9 @@ bool read_next_frame(const gmx_output_env_t* oenv, t_trxstatus* status, t_trxfra
                 break;
             }
             case efXTC:
-                if (bTimeSet(TBEGIN) && (status->tf < rTimeValue(TBEGIN)))
+                if (bTimeSet(TBEGIN) || (bTimeSet(TDELTA) && !(status->flags & TRX_DONT_SKIP)))
                 {
-                    if (xtc_seek_time(status->fio, rTimeValue(TBEGIN), fr->natoms, TRUE))
-                    {
-                        gmx_fatal(FARGS,
-                                  "Specified frame (time %f) doesn't exist or file "
-                                  "corrupt/inconsistent.",
-                                  rTimeValue(TBEGIN));
-                    }
-                    initcount(status);
+                    xtc_seek_next_frame(status, fr);
                 }
                 bRet = (read_next_xtc(status->fio, fr->natoms, &fr->step, &fr->time, fr->box, fr->x,
                                       &fr->prec, &bOK)
@@ -832,6 +950,7 @@ bool read_next_frame(const gmx_output_env_t* oenv, t_trxstatus* status, t_trxfra
                 }
                 break;
             case efTNG: bRet = gmx_read_next_tng_frame(status->tng, fr, nullptr, 0); break;
+            case efDXTC: bRet = dxtc_next_frame(status, fr); break;
             case efPDB: bRet = pdb_next_x(status, gmx_fio_getfp(status->fio), fr); break;
             case efGRO: bRet = gro_next_x_or_v(gmx_fio_getfp(status->fio), fr); break;
             default:
@@ -904,6 +1023,11 @@ bool read_first_frame(const gmx_output_env_t* oenv, t_trxstatus** status, const
         /* Special treatment for TNG files */
         gmx_tng_open(fn, 'r', &(*status)->tng);
     }
+    else if (efDXTC == ftp)
+    {
+        /* DXTC files are read with their own reader */
+        (*status)->dxtcReader = new gmx::DxtcReader(fn);
+    }
     else
     {
         fio = (*status)->fio = gmx_fio_open(fn, "r");
@@ -976,6 +1100,21 @@ bool read_first_frame(const gmx_output_env_t* oenv, t_trxstatus** status, const
             }
             bFirst = FALSE;
             break;
+        case efDXTC:
+            fr->natoms = (*status)->dxtcReader->numAtoms();
+            snew(fr->x, fr->natoms);
+            if (!dxtc_next_frame(*status, fr))
+            {
+                fr->not_ok = DATA_NOT_OK;
+                fr->natoms = 0;
+                printincomp(*status, fr);
+            }
+            else
+            {
+                printcount(*status, oenv, fr->time, FALSE);
+            }
+            bFirst = FALSE;
+            break;
         case efPDB:
             pdb_first_x(*status, gmx_fio_getfp(fio), fr);
             if (fr->natoms)
@@ -55,9 +55,28 @@
 #    include <rpc/xdr.h>
 #endif
 
-/* Read or write reduced precision *float* coordinates */
+/* Read or write reduced precision *float* coordinates. Large frames are
+ * (de)compressed using the maximum number of OpenMP threads of the calling thread.
+ */
 int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision);
 
+/* As xdr3dfcoord, but (de)compresses using at most numThreads OpenMP threads.
+ * Callers that are not OpenMP master threads, e.g. a std::thread, should
+ * pass the thread count explicitly.
+ */
+int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision, int numThreads);
+
+/* As xdr3dfcoord, but frames of at least 2*atomsPerChunk atoms are written
+ * in chunks of atomsPerChunk atoms that are compressed using at most
+ * numThreads OpenMP threads, followed by an index of the chunks.
+ * The coordinate data is identical to that written by a serial compression.
+ * When reading, chunks are decompressed in parallel when an index is present
+ * and numThreads > 1. With atomsPerChunk=0 frames are written without index
+ * and read serially.
+ */
+int xdr3dfcoord_chunked(XDR* xdrs, float* fp, int* size, float* precision, int atomsPerChunk,
+                        int numThreads);
+
 
 /* Read or write a *real* value (stored as float) */
 int xdr_real(XDR* xdrs, real* r);
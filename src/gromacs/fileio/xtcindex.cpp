@@ -0,0 +1,471 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements the frame index of XTC files.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "xtcindex.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/sysinfo.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Magic number of the index file, "XTCI" in ASCII
+const uint32_t c_xtcIndexMagic = 0x58544349;
+//! The version of the index file format
+const uint32_t c_xtcIndexVersion = 1;
+//! The number of bytes of the index file header
+const int c_xtcIndexHeaderSize = 8;
+//! The number of bytes of one index entry
+const int c_xtcIndexEntrySize = 20;
+//! The XTC frame magic number, must match XTC_MAGIC in xtcio.cpp
+const int c_xtcMagic = 1995;
+//! The number of bytes of the XTC frame header with magic number, atom count, step and time
+const int c_xtcFrameHeaderSize = 16;
+//! The number of bytes of the box and second atom count that follow the frame header
+const int c_xtcBoxSize = 9 * 4 + 4;
+/*! \brief The number of bytes of the precision, integer ranges, small index
+ * and byte count of compressed coordinates */
+const int c_xtcCompressionHeaderSize = 4 + 6 * 4 + 4 + 4;
+//! XTC files store frames with at most this many atoms as uncompressed floats
+const int c_xtcMaxUncompressedAtoms = 9;
+
+//! Appends \p value with \p numBytes bytes in big-endian order
+void appendBigEndian(std::vector<unsigned char>* bytes, uint64_t value, int numBytes)
+{
+    for (int i = numBytes - 1; i >= 0; i--)
+    {
+        bytes->push_back(static_cast<unsigned char>(value >> (8 * i)));
+    }
+}
+
+//! Returns the value of \p numBytes bytes in big-endian order
+uint64_t readBigEndian(const unsigned char* bytes, int numBytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < numBytes; i++)
+    {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+//! Returns the float with the IEEE bit pattern \p bits
+float floatFromBits(uint32_t bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+//! Returns the IEEE bit pattern of \p value
+uint32_t bitsFromFloat(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+//! Returns the size of the file \p fp, or -1 on error
+int64_t fileSize(FILE* fp)
+{
+    if (gmx_fseek(fp, 0, SEEK_END) != 0)
+    {
+        return -1;
+    }
+    return gmx_ftell(fp);
+}
+
+//! Reads \p numBytes bytes at \p offset in \p fp, returns whether that succeeded
+bool readBytesAt(FILE* fp, int64_t offset, unsigned char* bytes, int numBytes)
+{
+    return gmx_fseek(fp, offset, SEEK_SET) == 0
+           && std::fread(bytes, 1, numBytes, fp) == static_cast<size_t>(numBytes);
+}
+
+/*! \brief Reads the header of the XTC frame at \p offset
+ *
+ * Returns whether there is a valid frame header, \p entry and
+ * \p numAtoms are only set when there is.
+ */
+bool readXtcFrameHeader(FILE* fp, int64_t offset, XtcFrameIndexEntry* entry, int* numAtoms)
+{
+    unsigned char header[c_xtcFrameHeaderSize];
+    if (!readBytesAt(fp, offset, header, c_xtcFrameHeaderSize)
+        || static_cast<int32_t>(readBigEndian(header, 4)) != c_xtcMagic)
+    {
+        return false;
+    }
+    *numAtoms = static_cast<int32_t>(readBigEndian(header + 4, 4));
+    if (*numAtoms < 0)
+    {
+        return false;
+    }
+    entry->offset = offset;
+    // XTC stores the step as a signed 32-bit integer
+    entry->step = static_cast<int32_t>(readBigEndian(header + 8, 4));
+    entry->time = floatFromBits(readBigEndian(header + 12, 4));
+    return true;
+}
+
+/*! \brief Reads the headers of the XTC frame at \p offset and returns its size in bytes
+ *
+ * Returns -1 when the frame is corrupt or does not end before \p xtcFileSize.
+ */
+int64_t readXtcFrame(FILE* fp, int64_t offset, int64_t xtcFileSize, XtcFrameIndexEntry* entry)
+{
+    int numAtoms;
+    if (!readXtcFrameHeader(fp, offset, entry, &numAtoms))
+    {
+        return -1;
+    }
+
+    // Skip the box and check the atom count that starts the coordinates
+    int64_t       size = c_xtcFrameHeaderSize + c_xtcBoxSize;
+    unsigned char numAtomsBytes[4];
+    if (!readBytesAt(fp, offset + size - 4, numAtomsBytes, 4)
+        || static_cast<int32_t>(readBigEndian(numAtomsBytes, 4)) != numAtoms)
+    {
+        return -1;
+    }
+
+    if (numAtoms <= c_xtcMaxUncompressedAtoms)
+    {
+        size += 3 * 4 * static_cast<int64_t>(numAtoms);
+    }
+    else
+    {
+        unsigned char compressionHeader[c_xtcCompressionHeaderSize];
+        if (!readBytesAt(fp, offset + size, compressionHeader, c_xtcCompressionHeaderSize))
+        {
+            return -1;
+        }
+        const int32_t byteCount = static_cast<int32_t>(
+                readBigEndian(compressionHeader + c_xtcCompressionHeaderSize - 4, 4));
+        if (byteCount < 0)
+        {
+            return -1;
+        }
+        // XDR pads opaque data to a multiple of 4 bytes
+        size += c_xtcCompressionHeaderSize + (static_cast<int64_t>(byteCount) + 3) / 4 * 4;
+    }
+
+    return (offset + size <= xtcFileSize) ? size : -1;
+}
+
+//! Returns whether the frame header at \p entry.offset in \p fp matches \p entry
+bool entryMatchesFrame(FILE* fp, const XtcFrameIndexEntry& entry)
+{
+    XtcFrameIndexEntry frame;
+    int                numAtoms;
+    return readXtcFrameHeader(fp, entry.offset, &frame, &numAtoms) && frame.step == entry.step
+           && bitsFromFloat(frame.time) == bitsFromFloat(entry.time);
+}
+
+//! Returns whether \p header is a valid index file header
+bool isValidIndexHeader(const unsigned char* header)
+{
+    return readBigEndian(header, 4) == c_xtcIndexMagic
+           && readBigEndian(header + 4, 4) == c_xtcIndexVersion;
+}
+
+/*! \brief Returns whether \p indexFilename is a valid index file without complete entries
+ *
+ * This is the state of the index file of a simulation that has not
+ * written a frame yet.
+ */
+bool isIndexFileWithoutEntries(const std::string& indexFilename)
+{
+    FILE* fp = std::fopen(indexFilename.c_str(), "rb");
+    if (fp == nullptr)
+    {
+        return false;
+    }
+    unsigned char header[c_xtcIndexHeaderSize];
+    const bool    withoutEntries =
+            (std::fread(header, 1, c_xtcIndexHeaderSize, fp) == c_xtcIndexHeaderSize
+             && isValidIndexHeader(header)
+             && fileSize(fp) < c_xtcIndexHeaderSize + c_xtcIndexEntrySize);
+    std::fclose(fp);
+    return withoutEntries;
+}
+
+//! Returns the index file header
+std::vector<unsigned char> encodeIndexHeader()
+{
+    std::vector<unsigned char> bytes;
+    appendBigEndian(&bytes, c_xtcIndexMagic, 4);
+    appendBigEndian(&bytes, c_xtcIndexVersion, 4);
+    return bytes;
+}
+
+//! Appends the encoded \p entry to \p bytes
+void encodeIndexEntry(const XtcFrameIndexEntry& entry, std::vector<unsigned char>* bytes)
+{
+    appendBigEndian(bytes, entry.offset, 8);
+    appendBigEndian(bytes, entry.step, 8);
+    appendBigEndian(bytes, bitsFromFloat(entry.time), 4);
+}
+
+//! Writes all of \p bytes to \p fp, returns whether that succeeded
+bool writeBytes(FILE* fp, const std::vector<unsigned char>& bytes)
+{
+    return std::fwrite(bytes.data(), 1, bytes.size(), fp) == bytes.size();
+}
+
+} // namespace
+
+std::string xtcFrameIndexFilename(const std::string& xtcFilename)
+{
+    return xtcFilename + ".idx";
+}
+
+XtcFrameIndex XtcFrameIndex::read(const std::string& xtcFilename)
+{
+    XtcFrameIndex index;
+
+    FILE* indexFile = std::fopen(xtcFrameIndexFilename(xtcFilename).c_str(), "rb");
+    if (indexFile == nullptr)
+    {
+        return index;
+    }
+    unsigned char header[c_xtcIndexHeaderSize];
+    const bool    validHeader =
+            (std::fread(header, 1, c_xtcIndexHeaderSize, indexFile) == c_xtcIndexHeaderSize
+             && isValidIndexHeader(header));
+    std::vector<unsigned char> entryBytes;
+    if (validHeader)
+    {
+        unsigned char buffer[4096];
+        size_t        numBytesRead;
+        while ((numBytesRead = std::fread(buffer, 1, sizeof(buffer), indexFile)) > 0)
+        {
+            entryBytes.insert(entryBytes.end(), buffer, buffer + numBytesRead);
+        }
+    }
+    std::fclose(indexFile);
+
+    FILE* xtcFile = std::fopen(xtcFilename.c_str(), "rb");
+    if (xtcFile == nullptr)
+    {
+        return index;
+    }
+    const int64_t xtcFileSize = fileSize(xtcFile);
+
+    // An incomplete last entry is ignored by the integer division
+    const size_t numEntries = entryBytes.size() / c_xtcIndexEntrySize;
+    for (size_t i = 0; i < numEntries; i++)
+    {
+        const unsigned char* bytes = entryBytes.data() + i * c_xtcIndexEntrySize;
+        XtcFrameIndexEntry   entry;
+        entry.offset = readBigEndian(bytes, 8);
+        entry.step   = readBigEndian(bytes + 8, 8);
+        entry.time   = floatFromBits(readBigEndian(bytes + 16, 4));
+        if (entry.offset >= xtcFileSize
+            || (!index.frames_.empty() && entry.offset <= index.frames_.back().offset))
+        {
+            // The XTC file was truncated or the index is corrupt
+            break;
+        }
+        index.frames_.push_back(entry);
+    }
+
+    if (!index.frames_.empty()
+        && (index.frames_.front().offset != 0 || !entryMatchesFrame(xtcFile, index.frames_.front())
+            || !entryMatchesFrame(xtcFile, index.frames_.back())))
+    {
+        index.frames_.clear();
+    }
+    std::fclose(xtcFile);
+
+    return index;
+}
+
+XtcFrameIndex XtcFrameIndex::build(const std::string& xtcFilename)
+{
+    FILE* xtcFile = std::fopen(xtcFilename.c_str(), "rb");
+    if (xtcFile == nullptr)
+    {
+        GMX_THROW(FileIOError("Could not open XTC file '" + xtcFilename + "' for reading"));
+    }
+    const int64_t xtcFileSize = fileSize(xtcFile);
+
+    XtcFrameIndex      index;
+    XtcFrameIndexEntry entry;
+    int64_t            offset = 0;
+    while (offset < xtcFileSize)
+    {
+        const int64_t frameSize = readXtcFrame(xtcFile, offset, xtcFileSize, &entry);
+        if (frameSize < 0)
+        {
+            break;
+        }
+        index.frames_.push_back(entry);
+        offset += frameSize;
+    }
+    std::fclose(xtcFile);
+
+    return index;
+}
+
+XtcFrameIndex XtcFrameIndex::readOrBuild(const std::string& xtcFilename)
+{
+    XtcFrameIndex index = read(xtcFilename);
+    if (index.frames_.empty())
+    {
+        index = build(xtcFilename);
+        /* mdrun appends to the index file of a running simulation, and that
+         * file is valid as soon as it exists. So we only replace index files
+         * that are invalid, and leave files without entries alone.
+         */
+        if (!isIndexFileWithoutEntries(xtcFrameIndexFilename(xtcFilename)))
+        {
+            index.write(xtcFilename);
+        }
+    }
+    return index;
+}
+
+bool XtcFrameIndex::write(const std::string& xtcFilename) const
+{
+    /* Write to a temporary file that is renamed, so other processes
+     * never read a partially written index file.
+     */
+    const std::string filename          = xtcFrameIndexFilename(xtcFilename);
+    const std::string temporaryFilename = formatString("%s.%d.tmp", filename.c_str(), gmx_getpid());
+    FILE*             fp                = std::fopen(temporaryFilename.c_str(), "wb");
+    if (fp == nullptr)
+    {
+        return false;
+    }
+    std::vector<unsigned char> bytes = encodeIndexHeader();
+    for (const auto& entry : frames_)
+    {
+        encodeIndexEntry(entry, &bytes);
+    }
+    const bool written = writeBytes(fp, bytes);
+    if (std::fclose(fp) != 0 || !written
+        || gmx_file_rename(temporaryFilename.c_str(), filename.c_str()) != 0)
+    {
+        std::remove(temporaryFilename.c_str());
+        return false;
+    }
+    return true;
+}
+
+int XtcFrameIndex::firstFrameAtOrAfter(int64_t offset) const
+{
+    auto frame = std::lower_bound(
+            frames_.begin(), frames_.end(), offset,
+            [](const XtcFrameIndexEntry& entry, int64_t value) { return entry.offset < value; });
+    return frame - frames_.begin();
+}
+
+bool XtcFrameIndex::timesAreIncreasing() const
+{
+    return std::is_sorted(frames_.begin(), frames_.end(),
+                          [](const XtcFrameIndexEntry& a, const XtcFrameIndexEntry& b) {
+                              return a.time < b.time;
+                          });
+}
+
+int XtcFrameIndex::firstFrameAtOrAfterTime(real time) const
+{
+    auto frame = std::lower_bound(
+            frames_.begin(), frames_.end(), time,
+            [](const XtcFrameIndexEntry& entry, real value) { return entry.time < value; });
+    return frame - frames_.begin();
+}
+
+XtcFrameIndexWriter::XtcFrameIndexWriter(const std::string& xtcFilename,
+                                         bool               append,
+                                         int64_t            xtcFileSize) :
+    filename_(xtcFrameIndexFilename(xtcFilename))
+{
+    XtcFrameIndex index;
+    if (append && xtcFileSize > 0)
+    {
+        // Entries beyond the size of the truncated XTC file are dropped by read()
+        index = XtcFrameIndex::read(xtcFilename);
+        if (index.numFrames() == 0)
+        {
+            index = XtcFrameIndex::build(xtcFilename);
+        }
+    }
+    if (!index.write(xtcFilename))
+    {
+        gmx_file("Cannot write XTC frame index file " + filename_);
+    }
+    fp_ = gmx_ffopen(filename_, "ab");
+}
+
+XtcFrameIndexWriter::~XtcFrameIndexWriter()
+{
+    if (fp_ != nullptr)
+    {
+        gmx_ffclose(fp_);
+    }
+}
+
+void XtcFrameIndexWriter::addFrame(int64_t offset, int64_t step, real time)
+{
+    std::vector<unsigned char> bytes;
+    encodeIndexEntry({ offset, step, static_cast<float>(time) }, &bytes);
+    // Flush, so readers of a running simulation see complete entries
+    if (!writeBytes(fp_, bytes) || std::fflush(fp_) != 0)
+    {
+        gmx_file("Cannot write XTC frame index file " + filename_
+                 + "; maybe you are out of disk space?");
+    }
+}
+
+} // namespace gmx
@@ -0,0 +1,188 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares the frame index of XTC files.
+ *
+ * XTC files have no table of contents, so finding a frame by time or
+ * number requires a binary search with re-synchronization on frame
+ * headers, and counting frames requires reading the whole file. The
+ * frame index stores the file offset, step and time of each frame in a
+ * sidecar file with the name of the XTC file followed by ".idx". It can
+ * be written while the XTC file is written, or be built by reading only
+ * the frame headers of an existing file.
+ *
+ * The index file starts with a magic number and a version, followed by
+ * one entry per frame with the 64-bit offset, the 64-bit step and the
+ * single precision time. All values are stored in XDR (big-endian) byte
+ * order, so the files are portable. An incomplete last entry, left by
+ * an interrupted writer, is ignored.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_XTCINDEX_H
+#define GMX_FILEIO_XTCINDEX_H
+
+#include <cstdint>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+//! Returns the name of the frame index file of \p xtcFilename
+std::string xtcFrameIndexFilename(const std::string& xtcFilename);
+
+/*! \libinternal
+ * \brief The location, step and time of one frame in an XTC file
+ */
+struct XtcFrameIndexEntry
+{
+    //! The offset of the frame header in bytes
+    int64_t offset;
+    //! The MD step
+    int64_t step;
+    //! The time, with the precision stored in the XTC file
+    float time;
+};
+
+/*! \libinternal
+ * \brief The offsets, steps and times of the frames in an XTC file
+ */
+class XtcFrameIndex
+{
+public:
+    /*! \brief Reads the index file of \p xtcFilename
+     *
+     * Entries of frames that start beyond the end of the XTC file, which
+     * was truncated or overwritten, are ignored. The index is checked
+     * against the frame headers of the first and last remaining frames.
+     * Returns an empty index when the index file does not exist or does
+     * not match the XTC file.
+     */
+    static XtcFrameIndex read(const std::string& xtcFilename);
+
+    /*! \brief Builds the index of \p xtcFilename by reading only the frame headers
+     *
+     * Frames after the first incomplete or corrupt frame are not indexed.
+     *
+     * \throws FileIOError when the XTC file can not be opened
+     */
+    static XtcFrameIndex build(const std::string& xtcFilename);
+
+    /*! \brief Reads the index of \p xtcFilename, or builds it when needed
+     *
+     * A built index is written to the index file, so later readers can
+     * use it. Failing to write the index file is not an error, as the
+     * XTC file can be in a directory that is not writable. An index file
+     * without entries is not replaced, as it can belong to a simulation
+     * that appends to it with XtcFrameIndexWriter.
+     *
+     * \throws FileIOError when the XTC file can not be opened
+     */
+    static XtcFrameIndex readOrBuild(const std::string& xtcFilename);
+
+    /*! \brief Writes the index to the index file of \p xtcFilename, returns whether that succeeded
+     *
+     * The index is written to a temporary file that replaces the index
+     * file, so concurrent readers see either the old or the new index.
+     */
+    bool write(const std::string& xtcFilename) const;
+
+    //! Returns the indexed frames, in file order
+    ArrayRef<const XtcFrameIndexEntry> frames() const { return frames_; }
+
+    //! Returns the number of indexed frames
+    int numFrames() const { return frames_.size(); }
+
+    //! Returns the index of the first frame starting at or after \p offset, numFrames() when none
+    int firstFrameAtOrAfter(int64_t offset) const;
+
+    //! Returns whether the frame times increase with the frame index, as needed for time searches
+    bool timesAreIncreasing() const;
+
+    /*! \brief Returns the index of the first frame with time \p time or later
+     *
+     * Requires timesAreIncreasing(). Returns numFrames() when there is no such frame.
+     */
+    int firstFrameAtOrAfterTime(real time) const;
+
+private:
+    //! The indexed frames
+    std::vector<XtcFrameIndexEntry> frames_;
+};
+
+/*! \libinternal
+ * \brief Appends frames to the index file of an XTC file while the XTC file is written
+ */
+class XtcFrameIndexWriter
+{
+public:
+    /*! \brief Opens the index file of \p xtcFilename
+     *
+     * When appending, the entries of frames that start at or after
+     * \p xtcFileSize, which were truncated from the XTC file, are removed.
+     * When there is no matching index of the existing frames, it is built.
+     *
+     * \param[in] xtcFilename  The name of the XTC file
+     * \param[in] append       Whether frames are appended to an existing XTC file
+     * \param[in] xtcFileSize  The size of the XTC file when appending
+     */
+    XtcFrameIndexWriter(const std::string& xtcFilename, bool append, int64_t xtcFileSize);
+
+    ~XtcFrameIndexWriter();
+
+    /*! \brief Adds a frame that was written at \p offset in the XTC file
+     *
+     * Calls gmx_file() when the entry can not be written.
+     */
+    void addFrame(int64_t offset, int64_t step, real time);
+
+private:
+    //! The name of the index file
+    std::string filename_;
+    //! The index file, nullptr when no index is written
+    FILE* fp_ = nullptr;
+};
+
+} // namespace gmx
+
+#endif
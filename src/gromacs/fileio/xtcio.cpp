@@ -47,6 +47,7 @@
 #include "gromacs/math/vec.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 #define XTC_MAGIC 1995
@@ -138,7 +139,13 @@ static int xtc_header(XDR* xd, int* magic, int* natoms, int64_t* step, real* tim
     return result;
 }
 
-static int xtc_coord(XDR* xd, int* natoms, rvec* box, rvec* x, real* prec, gmx_bool bRead)
+static int xtc_coord(XDR*     xd,
+                     int*     natoms,
+                     rvec*    box,
+                     rvec*    x,
+                     real*    prec,
+                     gmx_bool bRead,
+                     int      numThreads)
 {
     int i, j, result;
 #if GMX_DOUBLE
@@ -176,7 +183,7 @@ static int xtc_coord(XDR* xd, int* natoms, rvec* box, rvec* x, real* prec, gmx_b
         }
         fprec = *prec;
     }
-    result = XTC_CHECK("x", xdr3dfcoord(xd, ftmp, natoms, &fprec));
+    result = XTC_CHECK("x", xdr3dfcoord(xd, ftmp, natoms, &fprec, numThreads));
 
     /* Copy from temp. array if reading */
     if (bRead)
@@ -191,7 +198,7 @@ static int xtc_coord(XDR* xd, int* natoms, rvec* box, rvec* x, real* prec, gmx_b
     }
     sfree(ftmp);
 #else
-    result = XTC_CHECK("x", xdr3dfcoord(xd, x[0], natoms, prec));
+    result = XTC_CHECK("x", xdr3dfcoord(xd, x[0], natoms, prec, numThreads));
 #endif
 
     return result;
@@ -199,6 +206,18 @@ static int xtc_coord(XDR* xd, int* natoms, rvec* box, rvec* x, real* prec, gmx_b
 
 
 int write_xtc(t_fileio* fio, int natoms, int64_t step, real time, const rvec* box, const rvec* x, real prec)
+{
+    return write_xtc(fio, natoms, step, time, box, x, prec, gmx_omp_get_max_threads());
+}
+
+int write_xtc(t_fileio*   fio,
+              int         natoms,
+              int64_t     step,
+              real        time,
+              const rvec* box,
+              const rvec* x,
+              real        prec,
+              int         numThreads)
 {
     int      magic_number = XTC_MAGIC;
     XDR*     xd;
@@ -221,8 +240,8 @@ int write_xtc(t_fileio* fio, int natoms, int64_t step, real time, const rvec* bo
     }
 
     /* write data */
-    bOK = xtc_coord(xd, &natoms, const_cast<rvec*>(box), const_cast<rvec*>(x), &prec,
-                    FALSE); /* bOK will be 1 if writing went well */
+    bOK = xtc_coord(xd, &natoms, const_cast<rvec*>(box), const_cast<rvec*>(x), &prec, FALSE,
+                    numThreads); /* bOK will be 1 if writing went well */
 
     if (bOK)
     {
@@ -253,7 +272,7 @@ int read_first_xtc(t_fileio* fio, int* natoms, int64_t* step, real* time, matrix
 
     snew(*x, *natoms);
 
-    *bOK = (xtc_coord(xd, natoms, box, *x, prec, TRUE) != 0);
+    *bOK = (xtc_coord(xd, natoms, box, *x, prec, TRUE, gmx_omp_get_max_threads()) != 0);
 
     return static_cast<int>(*bOK);
 }
@@ -281,7 +300,7 @@ int read_next_xtc(t_fileio* fio, int natoms, int64_t* step, real* time, matrix b
         gmx_fatal(FARGS, "Frame contains more atoms (%d) than expected (%d)", n, natoms);
     }
 
-    *bOK = (xtc_coord(xd, &natoms, box, x, prec, TRUE) != 0);
+    *bOK = (xtc_coord(xd, &natoms, box, x, prec, TRUE, gmx_omp_get_max_threads()) != 0);
 
     return static_cast<int>(*bOK);
 }
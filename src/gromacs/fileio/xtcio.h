@@ -78,4 +78,14 @@ int read_next_xtc(struct t_fileio* fio, int natoms, int64_t* step, real* time, m
 int write_xtc(struct t_fileio* fio, int natoms, int64_t step, real time, const rvec* box, const rvec* x, real prec);
 /* Write a frame to xtc file */
 
+int write_xtc(struct t_fileio* fio,
+              int              natoms,
+              int64_t          step,
+              real             time,
+              const rvec*      box,
+              const rvec*      x,
+              real             prec,
+              int              numThreads);
+/* As write_xtc, but compresses large frames using at most numThreads OpenMP threads */
+
 #endif
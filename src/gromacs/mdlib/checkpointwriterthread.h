@@ -0,0 +1,94 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ *
+ * \brief Declares the CheckpointWriterThread class for writing checkpoints in the background
+ *
+ * \ingroup module_mdlib
+ * \inlibraryapi
+ */
+#ifndef GMX_MDLIB_CHECKPOINTWRITERTHREAD_H
+#define GMX_MDLIB_CHECKPOINTWRITERTHREAD_H
+
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace gmx
+{
+
+/*! \libinternal
+ * \brief Writes checkpoint files to disk on a background thread
+ *
+ * Writing a checkpoint involves fsyncing all output files and
+ * renaming files, which can stall a run for a long time on a
+ * heavily loaded parallel file system. This class lets the master
+ * rank serialize the checkpoint to memory and continue with the
+ * simulation while a thread writes, fsyncs and renames the files.
+ *
+ * At most one checkpoint is written at a time: starting a new one
+ * first waits for the previous one to complete.
+ */
+class CheckpointWriterThread
+{
+public:
+    //! Destructor, waits for the checkpoint that is being written
+    ~CheckpointWriterThread();
+
+    /*! \brief Waits for the previous checkpoint, then calls \p writeFunction on a thread
+     *
+     * \param[in] writeFunction  Writes a checkpoint, returns an error message
+     *                           on failure and an empty string on success
+     *
+     * Calls gmx_file() when writing the previous checkpoint failed.
+     */
+    void startWriting(std::function<std::string()> writeFunction);
+
+    /*! \brief Blocks until the checkpoint that is being written is complete
+     *
+     * Calls gmx_file() when writing the checkpoint failed.
+     */
+    void waitForCheckpoint();
+
+private:
+    //! The thread writing the current checkpoint, not joinable when none is written
+    std::thread thread_;
+    //! The error message of the last write, set by the writer thread
+    std::string errorMessage_;
+};
+
+} // namespace gmx
+
+#endif
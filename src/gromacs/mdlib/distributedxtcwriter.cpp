@@ -0,0 +1,178 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ *
+ * \brief Implements the DistributedXtcWriter class.
+ *
+ * \ingroup module_mdlib
+ */
+
+#include "gmxpre.h"
+
+#include "distributedxtcwriter.h"
+
+#include "config.h"
+
+#include <vector>
+
+#include "gromacs/fileio/dxtcio.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxassert.h"
+
+namespace gmx
+{
+
+DistributedXtcWriter::DistributedXtcWriter(const std::string&         filename,
+                                           MPI_Comm                   comm,
+                                           int                        numAtomsGlobal,
+                                           ArrayRef<const Range<int>> selection,
+                                           real                       precision) :
+    filename_(filename),
+    comm_(comm),
+    precision_(precision)
+{
+#if GMX_MPI
+    MPI_Comm_rank(comm_, &rank_);
+    MPI_Comm_size(comm_, &numRanks_);
+#endif
+
+    std::vector<char> header;
+    if (rank_ == 0)
+    {
+        header = encodeDxtcFileHeader(numAtomsGlobal, selection);
+    }
+    offset_ = header.size();
+
+#if GMX_LIB_MPI
+    if (rank_ == 0)
+    {
+        make_backup(filename_);
+    }
+    MPI_Barrier(comm_);
+    if (MPI_File_open(comm_, filename_.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file_)
+                != MPI_SUCCESS
+        || MPI_File_set_size(file_, 0) != MPI_SUCCESS)
+    {
+        gmx_file("Cannot open DXTC file '" + filename_ + "' for writing");
+    }
+    writeAt(0, header.data(), header.size());
+#else
+    /* Rank 0 creates the file, the other ranks open it after that */
+    if (rank_ == 0)
+    {
+        fp_ = gmx_ffopen(filename_, "wb");
+        writeAt(0, header.data(), header.size());
+    }
+#    if GMX_MPI
+    MPI_Barrier(comm_);
+#    endif
+    if (rank_ != 0)
+    {
+        fp_ = gmx_ffopen(filename_, "r+b");
+    }
+#endif
+
+#if GMX_MPI
+    MPI_Bcast(&offset_, 1, MPI_INT64_T, 0, comm_);
+#endif
+}
+
+DistributedXtcWriter::~DistributedXtcWriter()
+{
+#if GMX_LIB_MPI
+    MPI_File_close(&file_);
+#else
+    gmx_ffclose(fp_);
+#endif
+}
+
+void DistributedXtcWriter::writeAt(int64_t offset, const char* data, int size)
+{
+#if GMX_LIB_MPI
+    MPI_Status status;
+    if (MPI_File_write_at_all(file_, offset, const_cast<char*>(data), size, MPI_BYTE, &status) != MPI_SUCCESS)
+    {
+        gmx_file("Cannot write trajectory; maybe you are out of disk space?");
+    }
+#else
+    if (size > 0
+        && (gmx_fseek(fp_, offset, SEEK_SET) != 0 || std::fwrite(data, size, 1, fp_) != 1
+            || std::fflush(fp_) != 0))
+    {
+        gmx_file("Cannot write trajectory; maybe you are out of disk space?");
+    }
+#endif
+}
+
+void DistributedXtcWriter::writeFrame(int64_t              step,
+                                      real                 time,
+                                      const matrix         box,
+                                      ArrayRef<const int>  globalAtomIndices,
+                                      ArrayRef<const RVec> x)
+{
+    std::vector<char> block     = encodeDxtcBlock(globalAtomIndices, x, precision_);
+    int               blockSize = block.size();
+
+    /* Rank 0 needs all block sizes for the frame header, the other
+     * ranks only need the offset of their block and the frame size.
+     */
+    std::vector<int> blockSizes(rank_ == 0 ? numRanks_ : 0, blockSize);
+    int64_t          blockSize64 = blockSize;
+    int64_t          blockEnd    = blockSize64;
+#if GMX_MPI
+    MPI_Gather(&blockSize, 1, MPI_INT, blockSizes.data(), 1, MPI_INT, 0, comm_);
+    MPI_Scan(&blockSize64, &blockEnd, 1, MPI_INT64_T, MPI_SUM, comm_);
+#endif
+    int64_t frameSize = dxtcFrameHeaderSize(numRanks_) + blockEnd;
+#if GMX_MPI
+    MPI_Bcast(&frameSize, 1, MPI_INT64_T, numRanks_ - 1, comm_);
+#endif
+
+    if (rank_ == 0)
+    {
+        /* Write the frame header together with our block */
+        std::vector<char> header = encodeDxtcFrameHeader(step, time, box, blockSizes);
+        block.insert(block.begin(), header.begin(), header.end());
+        writeAt(offset_, block.data(), block.size());
+    }
+    else
+    {
+        writeAt(offset_ + dxtcFrameHeaderSize(numRanks_) + blockEnd - blockSize, block.data(), blockSize);
+    }
+    offset_ += frameSize;
+}
+
+} // namespace gmx
@@ -0,0 +1,133 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ *
+ * \brief Declares the DistributedXtcWriter class for writing compressed
+ * coordinates from all domain-decomposition ranks in parallel
+ *
+ * \ingroup module_mdlib
+ * \inlibraryapi
+ */
+#ifndef GMX_MDLIB_DISTRIBUTEDXTCWRITER_H
+#define GMX_MDLIB_DISTRIBUTEDXTCWRITER_H
+
+#include <cstdint>
+#include <cstdio>
+
+#include <string>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/gmxmpi.h"
+#include "gromacs/utility/range.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+/*! \libinternal
+ * \brief Writes compressed coordinate frames to a DXTC file from all ranks
+ *
+ * Writing XTC frames requires collecting the coordinates of the whole
+ * system on the master rank, which needs memory and communication
+ * bandwidth for the whole system on one rank and serializes the
+ * compression. With this class each rank compresses the atoms it has
+ * and writes them as one block of a DXTC frame, see dxtcio.h.
+ * The ranks only communicate the sizes of their blocks.
+ *
+ * With an MPI library, the blocks are written with collective MPI-IO.
+ * Otherwise each rank writes its block at its own offset in the file.
+ *
+ * All methods are collective over the communicator.
+ */
+class DistributedXtcWriter
+{
+public:
+    /*! \brief Creates the file and writes its header
+     *
+     * \param[in] filename        The name of the file, which is overwritten
+     * \param[in] comm            The communicator of the ranks that write
+     * \param[in] numAtomsGlobal  The number of atoms in the system
+     * \param[in] selection       Ranges of global atom indices that are written,
+     *                            all atoms when empty, only used on rank 0
+     * \param[in] precision       The XTC compression precision
+     */
+    DistributedXtcWriter(const std::string&         filename,
+                         MPI_Comm                   comm,
+                         int                        numAtomsGlobal,
+                         ArrayRef<const Range<int>> selection,
+                         real                       precision);
+
+    //! Closes the file
+    ~DistributedXtcWriter();
+
+    /*! \brief Compresses and writes the atoms of this rank as part of a frame
+     *
+     * \param[in] step               The MD step
+     * \param[in] time               The time
+     * \param[in] box                The box, only used on rank 0
+     * \param[in] globalAtomIndices  The global indices of the atoms of this rank
+     * \param[in] x                  The coordinates of the atoms of this rank
+     */
+    void writeFrame(int64_t step, real time, const matrix box, ArrayRef<const int> globalAtomIndices, ArrayRef<const RVec> x);
+
+private:
+    //! Writes \p size bytes of \p data at \p offset in the file, collective with MPI-IO
+    void writeAt(int64_t offset, const char* data, int size);
+
+    //! The name of the file
+    std::string filename_;
+    //! The communicator of the writing ranks
+    MPI_Comm comm_;
+    //! Our rank in \p comm_
+    int rank_ = 0;
+    //! The number of ranks in \p comm_
+    int numRanks_ = 1;
+    //! The XTC compression precision
+    real precision_;
+    //! The file offset of the next frame
+    int64_t offset_ = 0;
+#if GMX_LIB_MPI
+    //! The file opened with MPI-IO
+    MPI_File file_;
+#else
+    //! The file opened on this rank
+    FILE* fp_ = nullptr;
+#endif
+};
+
+} // namespace gmx
+
+#endif
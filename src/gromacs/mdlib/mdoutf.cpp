@@ -37,6 +37,12 @@
 
 #include "mdoutf.h"
 
+#include <cstdio>
+#include <cstdlib>
+
+#include <string>
+#include <vector>
+
 #include "config.h"
 
 #include "gromacs/commandline/filenm.h"
@@ -46,10 +52,15 @@
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/fileio/tngio.h"
 #include "gromacs/fileio/trrio.h"
+#include "gromacs/fileio/xtcindex.h"
 #include "gromacs/fileio/xtcio.h"
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/mdlib/checkpointwriterthread.h"
+#include "gromacs/mdlib/distributedxtcwriter.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdlib/trajectory_writing.h"
+#include "gromacs/mdlib/xtcwriterthread.h"
 #include "gromacs/mdrunutility/handlerestart.h"
 #include "gromacs/mdrunutility/multisim.h"
 #include "gromacs/mdtypes/awh_history.h"
@@ -68,6 +79,7 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/baseversion.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/path.h"
 #include "gromacs/utility/pleasecite.h"
 #include "gromacs/utility/programcontext.h"
 #include "gromacs/utility/smalloc.h"
@@ -77,6 +89,9 @@ struct gmx_mdoutf
 {
     t_fileio*                     fp_trn;
     t_fileio*                     fp_xtc;
+    gmx::XtcWriterThread*         xtcWriterThread; /* only set with asynchronous XTC output */
+    gmx::XtcFrameIndexWriter*     xtcFrameIndexWriter; /* only set when writing an XTC frame index */
+    gmx::DistributedXtcWriter*    distributedXtcWriter; /* only set with distributed XTC output */
     gmx_tng_trajectory_t          tng;
     gmx_tng_trajectory_t          tng_low_prec;
     int                           x_compression_precision; /* only used by XTC output */
@@ -97,6 +112,7 @@ struct gmx_mdoutf
     const gmx::MdModulesNotifier* mdModulesNotifier;
     bool                          simulationsShareState;
     MPI_Comm                      mastersComm;
+    gmx::CheckpointWriterThread*  checkpointWriterThread; /* only set with asynchronous checkpointing */
 };
 
 
@@ -123,12 +139,17 @@ gmx_mdoutf_t init_mdoutf(FILE*                         fplog,
 
     snew(of, 1);
 
-    of->fp_trn       = nullptr;
-    of->fp_ene       = nullptr;
-    of->fp_xtc       = nullptr;
-    of->tng          = nullptr;
-    of->tng_low_prec = nullptr;
-    of->fp_dhdl      = nullptr;
+    of->fp_trn               = nullptr;
+    of->fp_ene               = nullptr;
+    of->fp_xtc               = nullptr;
+    of->xtcWriterThread      = nullptr;
+    of->xtcFrameIndexWriter  = nullptr;
+    of->distributedXtcWriter = nullptr;
+    of->tng                  = nullptr;
+    of->tng_low_prec         = nullptr;
+    of->fp_dhdl              = nullptr;
+
+    of->checkpointWriterThread = nullptr;
 
     of->eIntegrator             = ir->eI;
     of->bExpanded               = ir->bExpanded;
@@ -147,10 +168,29 @@ gmx_mdoutf_t init_mdoutf(FILE*                         fplog,
         of->mastersComm = ms->mastersComm_;
     }
 
+    /* With distributed XTC output each DD rank writes the compressed
+     * coordinates of its home atoms to a DXTC file, instead of the master
+     * writing an XTC file. The DXTC file is not part of the checkpointed
+     * output files, so we use this only without appending.
+     */
+    const bool useDistributedXtcOutput =
+            (EI_DYNAMICS(ir->eI) && ir->nstxout_compressed > 0 && DOMAINDECOMP(cr)
+             && fn2ftp(ftp2fn(efCOMPRESSED, nfile, fnm)) == efXTC && !restartWithAppending
+             && getenv("GMX_DISTRIBUTED_XTC_OUTPUT") != nullptr);
+
     if (MASTER(cr))
     {
         of->bKeepAndNumCPT = mdrunOptions.checkpointOptions.keepAndNumberCheckpointFiles;
 
+        /* The MPI barrier before renaming checkpoint files of simulations
+         * that share state cannot be called from a thread, so these
+         * always write checkpoints synchronously.
+         */
+        if (getenv("GMX_ASYNC_CHECKPOINT") != nullptr && !simulationsShareState && !GMX_FAHCORE)
+        {
+            of->checkpointWriterThread = new gmx::CheckpointWriterThread;
+        }
+
         filemode = restartWithAppending ? appendMode : writeMode;
 
         if (EI_DYNAMICS(ir->eI) && ir->nstxout_compressed > 0)
@@ -159,7 +199,23 @@ gmx_mdoutf_t init_mdoutf(FILE*                         fplog,
             filename = ftp2fn(efCOMPRESSED, nfile, fnm);
             switch (fn2ftp(filename))
             {
-                case efXTC: of->fp_xtc = open_xtc(filename, filemode); break;
+                case efXTC:
+                    if (useDistributedXtcOutput)
+                    {
+                        break;
+                    }
+                    of->fp_xtc = open_xtc(filename, filemode);
+                    if (getenv("GMX_XTC_FRAME_INDEX") != nullptr)
+                    {
+                        of->xtcFrameIndexWriter = new gmx::XtcFrameIndexWriter(
+                                filename, restartWithAppending, gmx_fio_ftell(of->fp_xtc));
+                    }
+                    if (getenv("GMX_ASYNC_XTC_OUTPUT") != nullptr)
+                    {
+                        of->xtcWriterThread = new gmx::XtcWriterThread(
+                                of->fp_xtc, of->x_compression_precision, of->xtcFrameIndexWriter);
+                    }
+                    break;
                 case efTNG:
                     gmx_tng_open(filename, filemode[0], &of->tng_low_prec);
                     if (filemode[0] == 'w')
@@ -243,6 +299,42 @@ gmx_mdoutf_t init_mdoutf(FILE*                         fplog,
         }
     }
 
+    if (useDistributedXtcOutput)
+    {
+        /* The selection is only needed on the master rank, which writes the header */
+        std::vector<gmx::Range<int>> selection;
+        if (MASTER(cr) && of->natoms_x_compressed != of->natoms_global)
+        {
+            for (int a = 0; a < top_global->natoms; a++)
+            {
+                if (getGroupType(top_global->groups, SimulationAtomGroupType::CompressedPositionOutput, a) == 0)
+                {
+                    if (selection.empty() || *selection.back().end() != a)
+                    {
+                        selection.emplace_back(a, a + 1);
+                    }
+                    else
+                    {
+                        selection.back() = gmx::Range<int>(*selection.back().begin(), a + 1);
+                    }
+                }
+            }
+        }
+        const std::string filename =
+                gmx::Path::stripExtension(ftp2fn(efCOMPRESSED, nfile, fnm)) + ".dxtc";
+        if (fplog)
+        {
+            fprintf(fplog,
+                    "Writing compressed coordinates from all %d DD ranks to %s,\n"
+                    "which GROMACS tools read and gmx trjconv converts to XTC\n",
+                    cr->dd->nnodes, filename.c_str());
+        }
+        of->groups               = &top_global->groups;
+        of->distributedXtcWriter = new gmx::DistributedXtcWriter(
+                filename, cr->dd->mpi_comm_all, top_global->natoms, selection,
+                of->x_compression_precision);
+    }
+
     if (bCiteTng)
     {
         please_cite(fplog, "Lundborg2014");
@@ -278,10 +370,98 @@ static void mpiBarrierBeforeRename(const bool applyMpiBarrierBeforeRename, MPI_C
 #endif
     }
 }
+/*! \brief Fsyncs all output files and moves the temporary checkpoint file to \p fn
+ *
+ * Closes \p fp, which should be the opened temporary checkpoint file
+ * \p fntemp. Returns an error message on failure, an empty string otherwise.
+ */
+static std::string finish_checkpoint_file(t_fileio*   fp,
+                                          const char* fn,
+                                          const char* fntemp,
+                                          gmx_bool    bNumberAndKeep,
+                                          bool        applyMpiBarrierBeforeRename,
+                                          MPI_Comm    mpiBarrierCommunicator)
+{
+    char      buf[STRLEN];
+    t_fileio* ret;
+
+    /* we really, REALLY, want to make sure to physically write the checkpoint,
+       and all the files it depends on, out to disk. Because we've
+       opened the checkpoint with gmx_fio_open(), it's in our list
+       of open files.  */
+    ret = gmx_fio_all_output_fsync();
+
+    if (ret)
+    {
+        sprintf(buf, "Cannot fsync '%s'; maybe you are out of disk space?", gmx_fio_getname(ret));
+
+        if (getenv(GMX_IGNORE_FSYNC_FAILURE_ENV) == nullptr)
+        {
+            gmx_fio_close(fp);
+            return buf;
+        }
+        else
+        {
+            gmx_warning("%s", buf);
+        }
+    }
+
+    if (gmx_fio_close(fp) != 0)
+    {
+        return "Cannot read/write checkpoint; corrupt file, or maybe you are out of disk space?";
+    }
+
+    /* we don't move the checkpoint if the user specified they didn't want it,
+       or if the fsyncs failed */
+#if !GMX_NO_RENAME
+    if (!bNumberAndKeep && !ret)
+    {
+        if (gmx_fexist(fn))
+        {
+            /* Rename the previous checkpoint file */
+            mpiBarrierBeforeRename(applyMpiBarrierBeforeRename, mpiBarrierCommunicator);
+
+            std::strcpy(buf, fn);
+            buf[std::strlen(fn) - std::strlen(ftp2ext(fn2ftp(fn))) - 1] = '\0';
+            std::strcat(buf, "_prev");
+            std::strcat(buf, fn + std::strlen(fn) - std::strlen(ftp2ext(fn2ftp(fn))) - 1);
+            if (!GMX_FAHCORE)
+            {
+                /* we copy here so that if something goes wrong between now and
+                 * the rename below, there's always a state.cpt.
+                 * If renames are atomic (such as in POSIX systems),
+                 * this copying should be unneccesary.
+                 */
+                gmx_file_copy(fn, buf, FALSE);
+                /* We don't really care if this fails:
+                 * there's already a new checkpoint.
+                 */
+            }
+            else
+            {
+                gmx_file_rename(fn, buf);
+            }
+        }
+
+        /* Rename the checkpoint file from the temporary to the final name */
+        mpiBarrierBeforeRename(applyMpiBarrierBeforeRename, mpiBarrierCommunicator);
+
+        if (gmx_file_rename(fntemp, fn) != 0)
+        {
+            return "Cannot rename checkpoint file; maybe you are out of disk space?";
+        }
+    }
+#endif /* GMX_NO_RENAME */
+
+    return std::string();
+}
+
 /*! \brief Write a checkpoint to the filename
  *
  * Appends the _step<step>.cpt with bNumberAndKeep, otherwise moves
  * the previous checkpoint filename with suffix _prev.cpt.
+ * With \p checkpointWriterThread, the checkpoint is serialized to memory
+ * and the thread writes it to disk, fsyncs the output files and renames.
  */
 static void write_checkpoint(const char*                     fn,
                              gmx_bool                        bNumberAndKeep,
@@ -300,13 +480,13 @@ static void write_checkpoint(const char*                     fn,
                              const gmx::MdModulesNotifier&   mdModulesNotifier,
                              gmx::WriteCheckpointDataHolder* modularSimulatorCheckpointData,
                              bool                            applyMpiBarrierBeforeRename,
-                             MPI_Comm                        mpiBarrierCommunicator)
+                             MPI_Comm                        mpiBarrierCommunicator,
+                             gmx::CheckpointWriterThread*    checkpointWriterThread)
 {
     t_fileio* fp;
     char*     fntemp; /* the temporary checkpoint file name */
     int       npmenodes;
     char      buf[1024], suffix[5 + STEPSTRSIZE], sbuf[STEPSTRSIZE];
-    t_fileio* ret;
 
     if (DOMAINDECOMP(cr))
     {
@@ -342,7 +522,14 @@ static void write_checkpoint(const char*                     fn,
     /* Get offsets for open files */
     auto outputfiles = gmx_fio_get_output_file_positions();
 
-    fp = gmx_fio_open(fntemp, "w");
+    if (checkpointWriterThread == nullptr)
+    {
+        fp = gmx_fio_open(fntemp, "w");
+    }
+    else
+    {
+        fp = gmx_fio_open_memory(fntemp);
+    }
 
     /* We can check many more things now (CPU, acceleration, etc), but
      * it is highly unlikely to have two separate builds with exactly
@@ -397,73 +584,36 @@ static void write_checkpoint(const char*                     fn,
     write_checkpoint_data(fp, headerContents, bExpanded, elamstats, state, observablesHistory,
                           mdModulesNotifier, &outputfiles, modularSimulatorCheckpointData);
 
-    /* we really, REALLY, want to make sure to physically write the checkpoint,
-       and all the files it depends on, out to disk. Because we've
-       opened the checkpoint with gmx_fio_open(), it's in our list
-       of open files.  */
-    ret = gmx_fio_all_output_fsync();
-
-    if (ret)
+    if (checkpointWriterThread == nullptr)
     {
-        char buf[STRLEN];
-        sprintf(buf, "Cannot fsync '%s'; maybe you are out of disk space?", gmx_fio_getname(ret));
-
-        if (getenv(GMX_IGNORE_FSYNC_FAILURE_ENV) == nullptr)
-        {
-            gmx_file(buf);
-        }
-        else
+        std::string errorMessage = finish_checkpoint_file(fp, fn, fntemp, bNumberAndKeep,
+                                                          applyMpiBarrierBeforeRename,
+                                                          mpiBarrierCommunicator);
+        if (!errorMessage.empty())
         {
-            gmx_warning("%s", buf);
+            gmx_file(errorMessage);
         }
     }
-
-    if (gmx_fio_close(fp) != 0)
-    {
-        gmx_file("Cannot read/write checkpoint; corrupt file, or maybe you are out of disk space?");
-    }
-
-    /* we don't move the checkpoint if the user specified they didn't want it,
-       or if the fsyncs failed */
-#if !GMX_NO_RENAME
-    if (!bNumberAndKeep && !ret)
+    else
     {
-        if (gmx_fexist(fn))
-        {
-            /* Rename the previous checkpoint file */
-            mpiBarrierBeforeRename(applyMpiBarrierBeforeRename, mpiBarrierCommunicator);
-
-            std::strcpy(buf, fn);
-            buf[std::strlen(fn) - std::strlen(ftp2ext(fn2ftp(fn))) - 1] = '\0';
-            std::strcat(buf, "_prev");
-            std::strcat(buf, fn + std::strlen(fn) - std::strlen(ftp2ext(fn2ftp(fn))) - 1);
-            if (!GMX_FAHCORE)
-            {
-                /* we copy here so that if something goes wrong between now and
-                 * the rename below, there's always a state.cpt.
-                 * If renames are atomic (such as in POSIX systems),
-                 * this copying should be unneccesary.
-                 */
-                gmx_file_copy(fn, buf, FALSE);
-                /* We don't really care if this fails:
-                 * there's already a new checkpoint.
-                 */
-            }
-            else
-            {
-                gmx_file_rename(fn, buf);
-            }
-        }
-
-        /* Rename the checkpoint file from the temporary to the final name */
-        mpiBarrierBeforeRename(applyMpiBarrierBeforeRename, mpiBarrierCommunicator);
-
-        if (gmx_file_rename(fntemp, fn) != 0)
-        {
-            gmx_file("Cannot rename checkpoint file; maybe you are out of disk space?");
-        }
+        /* Only the slow file system operations are left to the writer thread */
+        std::vector<char> contents     = gmx_fio_close_memory(fp);
+        std::string       fnString     = fn;
+        std::string       fntempString = fntemp;
+        checkpointWriterThread->startWriting(
+                [fnString, fntempString, bNumberAndKeep, contents = std::move(contents)]() {
+                    t_fileio* fp = gmx_fio_open(fntempString.c_str(), "w");
+                    if (std::fwrite(contents.data(), 1, contents.size(), gmx_fio_getfp(fp))
+                        != contents.size())
+                    {
+                        gmx_fio_close(fp);
+                        return std::string(
+                                "Cannot write checkpoint; maybe you are out of disk space?");
+                    }
+                    return finish_checkpoint_file(fp, fnString.c_str(), fntempString.c_str(),
+                                                  bNumberAndKeep, false, MPI_COMM_NULL);
+                });
     }
-#endif /* GMX_NO_RENAME */
 
     sfree(fntemp);
 
@@ -487,6 +637,11 @@ void mdoutf_write_checkpoint(gmx_mdoutf_t                    of,
                              ObservablesHistory*             observablesHistory,
                              gmx::WriteCheckpointDataHolder* modularSimulatorCheckpointData)
 {
+    if (of->xtcWriterThread)
+    {
+        /* The checkpoint stores the XTC file position, so all frames should be written */
+        of->xtcWriterThread->waitForQueuedFrames();
+    }
     fflush_tng(of->tng);
     fflush_tng(of->tng_low_prec);
     /* Write the checkpoint file.
@@ -500,7 +655,46 @@ void mdoutf_write_checkpoint(gmx_mdoutf_t                    of,
                      DOMAINDECOMP(cr) ? cr->dd->nnodes : cr->nnodes, of->eIntegrator,
                      of->simulation_part, of->bExpanded, of->elamstats, step, t, state_global,
                      observablesHistory, *(of->mdModulesNotifier), modularSimulatorCheckpointData,
-                     of->simulationsShareState, of->mastersComm);
+                     of->simulationsShareState, of->mastersComm, of->checkpointWriterThread);
+}
+
+/*! \brief Writes the compressed coordinates of our home atoms as part of a DXTC frame
+ *
+ * Must be called on all DD ranks.
+ */
+static void write_distributed_xtc(const gmx_domdec_t* dd, gmx_mdoutf_t of, int64_t step, double t, const t_state* state_local)
+{
+    gmx::ArrayRef<const int> homeAtoms;
+    if (state_local->ddp_count == dd->ddp_count)
+    {
+        /* The local state and DD are in sync, use the DD indices */
+        homeAtoms = gmx::constArrayRefFromArray(dd->globalAtomGroupIndices.data(), dd->ncg_home);
+    }
+    else if (state_local->ddp_count_cg_gl == state_local->ddp_count)
+    {
+        /* The DD is out of sync with the local state, use the indices stored with the state */
+        homeAtoms = state_local->cg_gl;
+    }
+    else
+    {
+        gmx_incons(
+                "Attempted to write a state for which the atom distribution "
+                "is unknown");
+    }
+
+    std::vector<int>       globalAtomIndices;
+    std::vector<gmx::RVec> x;
+    globalAtomIndices.reserve(homeAtoms.size());
+    x.reserve(homeAtoms.size());
+    for (gmx::index i = 0; i < homeAtoms.ssize(); i++)
+    {
+        if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, homeAtoms[i]) == 0)
+        {
+            globalAtomIndices.push_back(homeAtoms[i]);
+            x.push_back(state_local->x[i]);
+        }
+    }
+    of->distributedXtcWriter->writeFrame(step, t, state_local->box, globalAtomIndices, x);
 }
 
 void mdoutf_write_to_trajectory_files(FILE*                           fplog,
@@ -526,7 +720,8 @@ void mdoutf_write_to_trajectory_files(FILE*                           fplog,
         }
         else
         {
-            if (mdof_flags & (MDOF_X | MDOF_X_COMPRESSED))
+            if ((mdof_flags & MDOF_X)
+                || ((mdof_flags & MDOF_X_COMPRESSED) && of->distributedXtcWriter == nullptr))
             {
                 auto globalXRef = MASTER(cr) ? state_global->x : gmx::ArrayRef<gmx::RVec>();
                 dd_collect_vec(cr->dd, state_local->ddp_count, state_local->ddp_count_cg_gl,
@@ -539,6 +734,10 @@ void mdoutf_write_to_trajectory_files(FILE*                           fplog,
                                state_local->cg_gl, state_local->v, globalVRef);
             }
         }
+        if ((mdof_flags & MDOF_X_COMPRESSED) && of->distributedXtcWriter)
+        {
+            write_distributed_xtc(cr->dd, of, step, t, state_local);
+        }
         f_global = of->f_global;
         if (mdof_flags & MDOF_F)
         {
@@ -594,7 +793,7 @@ void mdoutf_write_to_trajectory_files(FILE*                           fplog,
                                state_local->box, natoms, x, v, f);
             }
         }
-        if (mdof_flags & MDOF_X_COMPRESSED)
+        if ((mdof_flags & MDOF_X_COMPRESSED) && of->distributedXtcWriter == nullptr)
         {
             rvec* xxtc = nullptr;
 
@@ -621,14 +820,31 @@ void mdoutf_write_to_trajectory_files(FILE*                           fplog,
                     }
                 }
             }
-            if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t, state_local->box, xxtc,
-                          of->x_compression_precision)
-                == 0)
+            if (of->xtcWriterThread)
+            {
+                /* The writer thread compresses and writes a copy of the frame */
+                of->xtcWriterThread->writeFrame(
+                        step, t, state_local->box,
+                        gmx::arrayRefFromArray(reinterpret_cast<gmx::RVec*>(xxtc),
+                                               of->natoms_x_compressed));
+            }
+            else
             {
-                gmx_fatal(FARGS,
-                          "XTC error. This indicates you are out of disk space, or a "
-                          "simulation with major instabilities resulting in coordinates "
-                          "that are NaN or too large to be represented in the XTC format.\n");
+                /* With TNG output there is no XTC file, and no index */
+                const gmx_off_t offset = of->xtcFrameIndexWriter ? gmx_fio_ftell(of->fp_xtc) : 0;
+                if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t, state_local->box, xxtc,
+                              of->x_compression_precision, gmx_omp_nthreads_get(emntDefault))
+                    == 0)
+                {
+                    gmx_fatal(FARGS,
+                              "XTC error. This indicates you are out of disk space, or a "
+                              "simulation with major instabilities resulting in coordinates "
+                              "that are NaN or too large to be represented in the XTC format.\n");
+                }
+                if (of->xtcFrameIndexWriter)
+                {
+                    of->xtcFrameIndexWriter->addFrame(offset, step, t);
+                }
             }
             gmx_fwrite_tng(of->tng_low_prec, TRUE, step, t, state_local->lambda[efptFEP],
                            state_local->box, of->natoms_x_compressed, xxtc, nullptr, nullptr);
@@ -689,10 +905,23 @@ void mdoutf_tng_close(gmx_mdoutf_t of)
 
 void done_mdoutf(gmx_mdoutf_t of)
 {
+    if (of->checkpointWriterThread)
+    {
+        /* The final checkpoint should be complete before mdrun exits */
+        of->checkpointWriterThread->waitForCheckpoint();
+        delete of->checkpointWriterThread;
+    }
     if (of->fp_ene != nullptr)
     {
         done_ener_file(of->fp_ene);
     }
+    if (of->xtcWriterThread)
+    {
+        of->xtcWriterThread->waitForQueuedFrames();
+        delete of->xtcWriterThread;
+    }
+    delete of->xtcFrameIndexWriter;
+    delete of->distributedXtcWriter;
     if (of->fp_xtc)
     {
         close_xtc(of->fp_xtc);
@@ -614,7 +614,7 @@ static void computeSpecialForces(FILE*                          fplog,
      */
     if (stepWork.computeForces)
     {
-        gmx::ForceProviderInput  forceProviderInput(x, *mdatoms, t, box, *cr);
+        gmx::ForceProviderInput  forceProviderInput(x, *mdatoms, t, step, box, *cr);
         gmx::ForceProviderOutput forceProviderOutput(forceWithVirial, enerd);
 
         /* Collect forces from modules */
@@ -0,0 +1,104 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the CheckpointWriterThread class
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "gromacs/mdlib/checkpointwriterthread.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace gmx
+{
+
+namespace test
+{
+namespace
+{
+
+TEST(CheckpointWriterThreadTest, WaitsForCheckpoint)
+{
+    bool written = false;
+
+    CheckpointWriterThread writerThread;
+    writerThread.startWriting([&written]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        written = true;
+        return std::string();
+    });
+    writerThread.waitForCheckpoint();
+    EXPECT_TRUE(written);
+}
+
+TEST(CheckpointWriterThreadTest, WritesCheckpointsInOrder)
+{
+    const int        numCheckpoints = 4;
+    std::vector<int> order;
+
+    {
+        CheckpointWriterThread writerThread;
+        for (int i = 0; i < numCheckpoints; i++)
+        {
+            writerThread.startWriting([&order, i]() {
+                // Earlier checkpoints take longer, so overlapping writes would reorder them
+                std::this_thread::sleep_for(std::chrono::milliseconds(10 * (numCheckpoints - i)));
+                order.push_back(i);
+                return std::string();
+            });
+        }
+    }
+
+    EXPECT_EQ((std::vector<int>{ 0, 1, 2, 3 }), order);
+}
+
+TEST(CheckpointWriterThreadTest, WaitingWithoutCheckpointReturns)
+{
+    CheckpointWriterThread writerThread;
+    writerThread.waitForCheckpoint();
+    writerThread.waitForCheckpoint();
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
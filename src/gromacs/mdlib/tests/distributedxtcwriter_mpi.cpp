@@ -0,0 +1,141 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for writing DXTC files from several ranks with DistributedXtcWriter.
+ *
+ * \ingroup module_mdlib
+ */
+
+#include "gmxpre.h"
+
+#include "gromacs/mdlib/distributedxtcwriter.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/dxtcio.h"
+#include "gromacs/utility/basenetwork.h"
+#include "gromacs/utility/gmxmpi.h"
+
+#include "testutils/mpitest.h"
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The number of atoms in the system
+const int c_numAtomsGlobal = 1234;
+
+//! Returns the coordinates of atom \p a in \p frame
+RVec coordinates(int a, int frame)
+{
+    return { 0.1F * (a % 50), 0.1F * (a / 50) + 0.01F * frame, 0.003F * a };
+}
+
+class DistributedXtcWriterTest : public ::testing::Test
+{
+public:
+    TestFileManager fileManager_;
+    std::string     filename_ = fileManager_.getTemporaryFilePath("traj.dxtc");
+};
+
+TEST_F(DistributedXtcWriterTest, FramesAreAssembledFromAllRanks)
+{
+    GMX_MPI_TEST(4);
+    const int numFrames = 3;
+    const int rank      = gmx_node_rank();
+
+    /* Atoms 1000 and up are not written, rank 3 has no atoms to write */
+    const std::vector<Range<int>> selection = { { 0, 1000 } };
+    {
+        DistributedXtcWriter writer(filename_, MPI_COMM_WORLD, c_numAtomsGlobal, selection, 1000);
+        for (int frame = 0; frame < numFrames; frame++)
+        {
+            /* Distribute the atoms differently each frame */
+            std::vector<int>  indices;
+            std::vector<RVec> x;
+            for (int a = 0; a < c_numAtomsGlobal; a++)
+            {
+                const int atomRank = (a < 1000 ? (a / 10 + frame) % 3 : -1);
+                if (atomRank == rank)
+                {
+                    indices.push_back(a);
+                    x.push_back(coordinates(a, frame));
+                }
+            }
+            matrix box = { { 3, 0, 0 }, { 0, 4, 0 }, { 0, 0, 5.0F + frame } };
+            writer.writeFrame(100 * frame, 0.5F * frame, box, indices, x);
+        }
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    if (rank == 0)
+    {
+        DxtcReader reader(filename_);
+        ASSERT_EQ(1000, reader.numAtoms());
+        std::vector<RVec> x(reader.numAtoms());
+        int64_t           step;
+        real              time;
+        matrix            box;
+        for (int frame = 0; frame < numFrames; frame++)
+        {
+            ASSERT_TRUE(reader.readNextFrame(&step, &time, box, x));
+            EXPECT_EQ(100 * frame, step);
+            EXPECT_FLOAT_EQ(0.5F * frame, time);
+            EXPECT_FLOAT_EQ(5.0F + frame, box[ZZ][ZZ]);
+            for (int a = 0; a < reader.numAtoms(); a++)
+            {
+                const RVec ref = coordinates(a, frame);
+                for (int d = 0; d < DIM; d++)
+                {
+                    ASSERT_NEAR(ref[d], x[a][d], 0.001) << "atom " << a << " frame " << frame;
+                }
+            }
+        }
+        EXPECT_FALSE(reader.readNextFrame(&step, &time, box, x));
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
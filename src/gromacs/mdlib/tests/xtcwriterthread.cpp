@@ -0,0 +1,153 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the XtcWriterThread class
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "gromacs/mdlib/xtcwriterthread.h"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/xtcindex.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vec.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+
+namespace test
+{
+namespace
+{
+
+//! Returns the contents of a binary file
+std::string fileContents(const std::string& filename)
+{
+    std::ifstream stream(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+//! Returns coordinates for frame \p frame that differ between frames
+std::vector<RVec> frameCoordinates(int frame, int numAtoms)
+{
+    std::vector<RVec> x(numAtoms);
+    for (int i = 0; i < numAtoms; i++)
+    {
+        x[i] = { 0.01_real * i, 0.1_real * frame + 0.002_real * i, 1.0_real - 0.001_real * i };
+    }
+    return x;
+}
+
+TEST(XtcWriterThreadTest, WritesSameFileAsSynchronousOutput)
+{
+    TestFileManager   fileManager;
+    const std::string asyncFilename = fileManager.getTemporaryFilePath("async.xtc");
+    const std::string syncFilename  = fileManager.getTemporaryFilePath("sync.xtc");
+    const int         numAtoms      = 1000;
+    const int         numFrames     = 5;
+    const real        precision     = 1000;
+    const matrix      box           = { { 3, 0, 0 }, { 0, 3, 0 }, { 0, 0, 3 } };
+
+    t_fileio* asyncFile = open_xtc(asyncFilename.c_str(), "w");
+    {
+        XtcWriterThread writerThread(asyncFile, precision, nullptr);
+        for (int frame = 0; frame < numFrames; frame++)
+        {
+            writerThread.writeFrame(10 * frame, 0.02_real * frame, box, frameCoordinates(frame, numAtoms));
+        }
+        writerThread.waitForQueuedFrames();
+    }
+    close_xtc(asyncFile);
+
+    t_fileio* syncFile = open_xtc(syncFilename.c_str(), "w");
+    for (int frame = 0; frame < numFrames; frame++)
+    {
+        std::vector<RVec> x = frameCoordinates(frame, numAtoms);
+        ASSERT_NE(0, write_xtc(syncFile, numAtoms, 10 * frame, 0.02_real * frame, box,
+                               as_rvec_array(x.data()), precision));
+    }
+    close_xtc(syncFile);
+
+    const std::string asyncContents = fileContents(asyncFilename);
+    EXPECT_FALSE(asyncContents.empty());
+    EXPECT_EQ(fileContents(syncFilename), asyncContents);
+}
+
+TEST(XtcWriterThreadTest, WritesFrameIndex)
+{
+    TestFileManager   fileManager;
+    const std::string filename  = fileManager.getTemporaryFilePath("indexed.xtc");
+    const int         numAtoms  = 100;
+    const int         numFrames = 4;
+    const matrix      box       = { { 3, 0, 0 }, { 0, 3, 0 }, { 0, 0, 3 } };
+    fileManager.getTemporaryFilePath("indexed.xtc.idx");
+
+    t_fileio* file = open_xtc(filename.c_str(), "w");
+    {
+        XtcFrameIndexWriter frameIndexWriter(filename, false, 0);
+        XtcWriterThread     writerThread(file, 1000, &frameIndexWriter);
+        for (int frame = 0; frame < numFrames; frame++)
+        {
+            writerThread.writeFrame(10 * frame, 0.02_real * frame, box, frameCoordinates(frame, numAtoms));
+        }
+        writerThread.waitForQueuedFrames();
+    }
+    close_xtc(file);
+
+    const XtcFrameIndex index = XtcFrameIndex::read(filename);
+    const XtcFrameIndex built = XtcFrameIndex::build(filename);
+    ASSERT_EQ(numFrames, index.numFrames());
+    ASSERT_EQ(numFrames, built.numFrames());
+    for (int frame = 0; frame < numFrames; frame++)
+    {
+        EXPECT_EQ(built.frames()[frame].offset, index.frames()[frame].offset);
+        EXPECT_EQ(10 * frame, index.frames()[frame].step);
+    }
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
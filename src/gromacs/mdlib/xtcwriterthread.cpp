@@ -0,0 +1,155 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ *
+ * \brief Implements the XtcWriterThread class.
+ *
+ * \ingroup module_mdlib
+ */
+
+#include "gmxpre.h"
+
+#include "xtcwriterthread.h"
+
+#include <algorithm>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/xtcindex.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/utility/fatalerror.h"
+
+namespace gmx
+{
+
+XtcWriterThread::XtcWriterThread(t_fileio*            fio,
+                                 real                 precision,
+                                 XtcFrameIndexWriter* frameIndexWriter) :
+    fio_(fio),
+    precision_(precision),
+    frameIndexWriter_(frameIndexWriter),
+    thread_(&XtcWriterThread::threadMain, this)
+{
+}
+
+XtcWriterThread::~XtcWriterThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopRequested_ = true;
+    }
+    queueChanged_.notify_all();
+    thread_.join();
+}
+
+void XtcWriterThread::checkForWriteError() const
+{
+    if (writeFailed_)
+    {
+        gmx_fatal(FARGS,
+                  "XTC error. This indicates you are out of disk space, or a "
+                  "simulation with major instabilities resulting in coordinates "
+                  "that are NaN or too large to be represented in the XTC format.\n");
+    }
+}
+
+void XtcWriterThread::writeFrame(int64_t step, real time, const matrix box, ArrayRef<const RVec> x)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        queueChanged_.wait(lock, [this]() {
+            return numQueuedFrames_ < static_cast<int>(frames_.size());
+        });
+        checkForWriteError();
+    }
+
+    // The buffer to fill is not queued, so the writer thread does not access it
+    Frame& frame = frames_[nextFrameToFill_];
+    frame.step   = step;
+    frame.time   = time;
+    copy_mat(box, frame.box);
+    frame.x.resize(x.size());
+    std::copy(x.begin(), x.end(), frame.x.begin());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        nextFrameToFill_ = (nextFrameToFill_ + 1) % frames_.size();
+        numQueuedFrames_++;
+    }
+    queueChanged_.notify_all();
+}
+
+void XtcWriterThread::waitForQueuedFrames()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    queueChanged_.wait(lock, [this]() { return numQueuedFrames_ == 0; });
+    checkForWriteError();
+}
+
+void XtcWriterThread::threadMain()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        queueChanged_.wait(lock, [this]() { return numQueuedFrames_ > 0 || stopRequested_; });
+        if (numQueuedFrames_ == 0)
+        {
+            return;
+        }
+
+        // Compress and write without holding the lock, so the master can fill the other buffer
+        const Frame& frame = frames_[nextFrameToWrite_];
+        lock.unlock();
+        const gmx_off_t offset = gmx_fio_ftell(fio_);
+
+        // This is not an OpenMP thread, so compress serially instead of using
+        // the default OpenMP thread count, which would oversubscribe the cores
+        const bool writeSucceeded = (write_xtc(fio_, frame.x.size(), frame.step, frame.time, frame.box,
+                                               as_rvec_array(frame.x.data()), precision_, 1)
+                                     != 0);
+        if (writeSucceeded && frameIndexWriter_)
+        {
+            frameIndexWriter_->addFrame(offset, frame.step, frame.time);
+        }
+        lock.lock();
+
+        writeFailed_      = writeFailed_ || !writeSucceeded;
+        nextFrameToWrite_ = (nextFrameToWrite_ + 1) % frames_.size();
+        numQueuedFrames_--;
+        queueChanged_.notify_all();
+    }
+}
+
+} // namespace gmx
@@ -0,0 +1,154 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ *
+ * \brief Declares the XtcWriterThread class for writing XTC frames in the background
+ *
+ * \ingroup module_mdlib
+ * \inlibraryapi
+ */
+#ifndef GMX_MDLIB_XTCWRITERTHREAD_H
+#define GMX_MDLIB_XTCWRITERTHREAD_H
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/real.h"
+
+struct t_fileio;
+
+namespace gmx
+{
+
+class XtcFrameIndexWriter;
+
+/*! \libinternal
+ * \brief Compresses and writes XTC frames on a background thread
+ *
+ * XTC compression of large systems takes a significant fraction of
+ * the run time when the master rank does it inside the MD step.
+ * This class lets the master rank copy a frame to one of two buffers
+ * and continue with the integration while a writer thread compresses
+ * and writes the other. The master rank only waits when both buffers
+ * are still in use.
+ *
+ * Code that needs the file to be up to date, such as checkpointing,
+ * which stores the file positions, must call waitForQueuedFrames()
+ * first. While the writer thread exists, no other code should write
+ * to the XTC file.
+ */
+class XtcWriterThread
+{
+public:
+    /*! \brief Constructor, starts the writer thread
+     *
+     * \param[in] fio               The opened XTC file, should outlive this object
+     * \param[in] precision         The XTC compression precision
+     * \param[in] frameIndexWriter  Writes the frame index of the XTC file, can be nullptr,
+     *                              should outlive this object
+     */
+    XtcWriterThread(t_fileio* fio, real precision, XtcFrameIndexWriter* frameIndexWriter);
+
+    //! Destructor, writes all queued frames and stops the writer thread
+    ~XtcWriterThread();
+
+    /*! \brief Copies a frame and queues it for writing
+     *
+     * Blocks only while both frame buffers are still in use.
+     * Calls gmx_fatal() when writing a previous frame failed.
+     */
+    void writeFrame(int64_t step, real time, const matrix box, ArrayRef<const RVec> x);
+
+    /*! \brief Blocks until all queued frames have been written
+     *
+     * Calls gmx_fatal() when writing a frame failed.
+     */
+    void waitForQueuedFrames();
+
+private:
+    //! Frame data owned by either the master or the writer thread
+    struct Frame
+    {
+        //! The MD step
+        int64_t step = 0;
+        //! The time
+        real time = 0;
+        //! The box
+        matrix box = { { 0 } };
+        //! The coordinates
+        std::vector<RVec> x;
+    };
+
+    //! The loop run by the writer thread
+    void threadMain();
+
+    //! Calls gmx_fatal() when writing failed, should be called with mutex_ locked
+    void checkForWriteError() const;
+
+    //! The XTC file
+    t_fileio* fio_;
+    //! The XTC compression precision
+    real precision_;
+    //! Writes the frame index, nullptr when no index is written
+    XtcFrameIndexWriter* frameIndexWriter_;
+    //! The two frame buffers
+    std::array<Frame, 2> frames_;
+    //! The buffer that the next frame is copied to
+    int nextFrameToFill_ = 0;
+    //! The buffer that the writer thread writes next
+    int nextFrameToWrite_ = 0;
+    //! The number of frames that are queued or being written
+    int numQueuedFrames_ = 0;
+    //! Whether writing a frame failed
+    bool writeFailed_ = false;
+    //! Whether the writer thread should exit when the queue is empty
+    bool stopRequested_ = false;
+    //! Protects the frame queue state
+    std::mutex mutex_;
+    //! Signals a change in the queue state
+    std::condition_variable queueChanged_;
+    //! The writer thread, declared last so it starts after the other members are initialized
+    std::thread thread_;
+};
+
+} // namespace gmx
+
+#endif
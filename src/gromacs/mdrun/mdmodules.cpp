@@ -182,6 +182,10 @@ void MDModules::subscribeToPreProcessingNotifications()
 void MDModules::subscribeToSimulationSetupNotifications()
 {
     impl_->densityFitting_->subscribeToSimulationSetupNotifications(&impl_->notifier_);
+    for (auto&& module : impl_->modules_)
+    {
+        module->subscribeToSimulationSetupNotifications(&impl_->notifier_);
+    }
 }
 
 void MDModules::add(std::shared_ptr<gmx::IMDModule> module)
@@ -925,10 +925,26 @@ int Mdrunner::mdrunner()
     // There is nothing unique about restraints at this point as far as the
     // Mdrunner is concerned. The Mdrunner should just be getting a sequence of
     // factory functions from the SimulationContext on which to call mdModules_->add().
-    // TODO: capture all restraints into a single RestraintModule, passed to the runner builder.
-    for (auto&& restraint : restraintManager_->getRestraints())
-    {
-        auto module = RestraintMDModule::create(restraint, restraint->sites());
+    // All restraints are captured into a single RestraintMDModule so that their
+    // sites can be gathered with one collective per step.
+    RestraintMDModule* restraintModule = nullptr;
+    if (restraintManager_->countRestraints() > 0)
+    {
+        const auto restraints        = restraintManager_->getRestraints();
+        const auto evaluationPeriods = restraintManager_->getEvaluationPeriods();
+        const auto names             = restraintManager_->getNames();
+        const bool useRestraintImpulses =
+                std::any_of(evaluationPeriods.begin(), evaluationPeriods.end(),
+                            [](int evaluationPeriod) { return evaluationPeriod > 1; });
+        if (useRestraintImpulses && (inputrec->eI != eiMD || doRerun))
+        {
+            // Like multiple time-stepping, applying impulses requires the leap-frog integrator.
+            gmx_fatal(FARGS,
+                      "Restraints with an evaluation period larger than 1 step are only "
+                      "supported with the md integrator and without -rerun");
+        }
+        auto module     = RestraintMDModule::create(restraints, evaluationPeriods, names);
+        restraintModule = module.get();
         mdModules_->add(std::move(module));
     }
 
@@ -1422,6 +1438,7 @@ int Mdrunner::mdrunner()
         mdModulesNotifier.notify(&atomSets);
         mdModulesNotifier.notify(inputrec->pbcType);
         mdModulesNotifier.notify(SimulationTimeStep{ inputrec->delta_t });
+        mdModulesNotifier.notify(SimulationWallcycle{ wcycle });
         /* Initiate forcerecord */
         fr                 = new t_forcerec;
         fr->forceProviders = mdModules_->initForceProviders();
@@ -1762,6 +1779,13 @@ int Mdrunner::mdrunner()
     finish_run(fplog, mdlog, cr, inputrec.get(), &nrnb, wcycle, walltime_accounting,
                fr ? fr->nbv.get() : nullptr, pmedata, EI_DYNAMICS(inputrec->eI) && !isMultiSim(ms));
 
+    // Let API clients query the time spent in their restraints.
+    if (restraintModule != nullptr && MASTER(cr))
+    {
+        restraintManager_->setTimings(restraintModule->timings(
+                walltime_accounting_get_time_since_reset(walltime_accounting)));
+    }
+
     // clean up cycle counter
     wallcycle_destroy(wcycle);
 
@@ -1861,7 +1885,9 @@ Mdrunner::~Mdrunner()
     }
 };
 
-void Mdrunner::addPotential(std::shared_ptr<gmx::IRestraintPotential> puller, const std::string& name)
+void Mdrunner::addPotential(std::shared_ptr<gmx::IRestraintPotential> puller,
+                            const std::string&                        name,
+                            int                                       evaluationPeriod)
 {
     GMX_ASSERT(restraintManager_, "Mdrunner must have a restraint manager.");
     // Not sure if this should be logged through the md logger or something else,
@@ -1870,7 +1896,13 @@ void Mdrunner::addPotential(std::shared_ptr<gmx::IRestraintPotential> puller, co
 
     // When multiple restraints are used, it may be wasteful to register them separately.
     // Maybe instead register an entire Restraint Manager as a force provider.
-    restraintManager_->addToSpec(std::move(puller), name);
+    restraintManager_->addToSpec(std::move(puller), name, evaluationPeriod);
+}
+
+std::vector<RestraintTiming> Mdrunner::restraintTimings() const
+{
+    GMX_ASSERT(restraintManager_, "Mdrunner must have a restraint manager.");
+    return restraintManager_->getTimings();
 }
 
 Mdrunner::Mdrunner(std::unique_ptr<MDModules> mdModules) : mdModules_(std::move(mdModules)) {}
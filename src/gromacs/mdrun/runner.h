@@ -46,6 +46,7 @@
 
 #include <array>
 #include <memory>
+#include <vector>
 
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/compat/pointers.h"
@@ -75,6 +76,7 @@ namespace gmx
 class MDModules;
 class IRestraintPotential; // defined in restraint/restraintpotential.h
 class RestraintManager;
+struct RestraintTiming;
 class SimulationContext;
 class StopHandlerBuilder;
 
@@ -158,13 +160,24 @@ public:
      *
      * \param restraint MD restraint potential to apply
      * \param name User-friendly plain-text name to uniquely identify the puller
+     * \param evaluationPeriod Number of MD steps between evaluations of the restraint
      *
      * This implementation attaches an object providing the gmx::IRestraintPotential
-     * interface.
+     * interface. See RestraintManager::addToSpec() for the evaluation period.
      * \todo Mdrunner should fetch such resources from the SimulationContext
      * rather than offering this public interface.
      */
-    void addPotential(std::shared_ptr<IRestraintPotential> restraint, const std::string& name);
+    void addPotential(std::shared_ptr<IRestraintPotential> restraint,
+                      const std::string&                   name,
+                      int                                  evaluationPeriod = 1);
+
+    /*!
+     * \brief Get the time spent in each restraint during the last call to mdrunner().
+     *
+     * \return the timings measured on the master rank, in the order the
+     *         restraints were added, or empty without cycle counting.
+     */
+    std::vector<RestraintTiming> restraintTimings() const;
 
     /*! \brief Prepare the thread-MPI communicator to have \c
      * numThreadsToLaunch ranks, by spawning new thread-MPI
@@ -37,23 +37,47 @@
 
 #include "simulationinput.h"
 
+#include <utility>
+
 #include "gromacs/fileio/checkpoint.h"
 #include "gromacs/fileio/tpxio.h"
 #include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/mdtypes/observableshistory.h"
 #include "gromacs/mdtypes/state.h"
+#include "gromacs/utility/gmxassert.h"
 
 namespace gmx
 {
 
+SimulationInput::SimulationInput(const char* tprFilename, const char* cpiFilename) :
+    tprFilename_(tprFilename),
+    cpiFilename_(cpiFilename)
+{
+}
+
+SimulationInput::SimulationInput(std::shared_ptr<const InMemoryTpr> tpr, const char* cpiFilename) :
+    cpiFilename_(cpiFilename),
+    tpr_(std::move(tpr))
+{
+    GMX_RELEASE_ASSERT(tpr_, "Need valid TPR contents.");
+}
+
 void applyGlobalSimulationState(const SimulationInput&      simulationInput,
                                 PartialDeserializedTprFile* partialDeserializedTpr,
                                 t_state*                    globalState,
                                 t_inputrec*                 inputRecord,
                                 gmx_mtop_t*                 molecularTopology)
 {
-    *partialDeserializedTpr = read_tpx_state(simulationInput.tprFilename_.c_str(), inputRecord,
-                                             globalState, molecularTopology);
+    if (simulationInput.tpr_)
+    {
+        *partialDeserializedTpr = readTprFromMemory(*simulationInput.tpr_, inputRecord, globalState,
+                                                    molecularTopology);
+    }
+    else
+    {
+        *partialDeserializedTpr = read_tpx_state(simulationInput.tprFilename_.c_str(), inputRecord,
+                                                 globalState, molecularTopology);
+    }
 }
 
 void applyLocalState(const SimulationInput&         simulationInput,
@@ -57,6 +57,7 @@ struct t_commrec;
 struct t_fileio;
 struct t_inputrec;
 class t_state;
+struct InMemoryTpr;
 struct ObservablesHistory;
 struct PartialDeserializedTprFile;
 
@@ -82,10 +83,29 @@ class SimulationInput
 public:
     SimulationInput(const char* tprFilename, const char* cpiFilename);
 
+    /*! \brief Input held in memory instead of a TPR file.
+     *
+     * The serialized topology is shared with any other holders of \p tpr.
+     */
+    SimulationInput(std::shared_ptr<const InMemoryTpr> tpr, const char* cpiFilename);
+
     std::string tprFilename_;
     std::string cpiFilename_;
+
+    //! In-memory TPR contents, used instead of tprFilename_ when set.
+    std::shared_ptr<const InMemoryTpr> tpr_;
 };
 
+/*! \brief Direct the construction of a SimulationInput from TPR contents in memory.
+ *
+ * \param tpr Serialized simulation input, of which ownership is shared.
+ * \param cpiFilename Checkpoint file to apply, if it exists.
+ *
+ * \see serializeTprToMemory()
+ */
+SimulationInputHandle makeSimulationInput(std::shared_ptr<const InMemoryTpr> tpr,
+                                          const std::string&                 cpiFilename);
+
 /*! \brief Get the global simulation input.
  *
  * Acquire global simulation data structures from the SimulationInput handle.
@@ -40,34 +40,11 @@
 #include <utility>
 
 #include "gromacs/mdrun/legacymdrunoptions.h"
+#include "gromacs/mdrun/simulationinput.h"
 
 namespace gmx
 {
 
-/*! \cond
- * SimulationInput needs much more discussion and refinement before it should be used directly.
- * Use the interface defined in the headers and refer to #3652 for updates.
- *
- * Design note: It is probably sufficient for future versions to compose SimulationInput
- * through a Builder rather than to subclass an Interface or base class. Outside of this
- * translation unit, we should avoid coupling to the class definition until/unless we
- * develop a much better understanding of simulation input portability.
- *
- */
-class SimulationInput
-{
-public:
-    SimulationInput(const char* tprFilename, const char* cpiFilename) :
-        tprFilename_(tprFilename),
-        cpiFilename_(cpiFilename)
-    {
-    }
-
-    std::string tprFilename_;
-    std::string cpiFilename_;
-};
-/*! \endcond */
-
 class detail::SimulationInputHandleImpl final
 {
 public:
@@ -196,4 +173,13 @@ SimulationInputHandle makeSimulationInput(const LegacyMdrunOptions& options)
     return SimulationInputHandle(std::move(impl));
 }
 
+SimulationInputHandle makeSimulationInput(std::shared_ptr<const InMemoryTpr> tpr,
+                                          const std::string&                 cpiFilename)
+{
+    auto simulationInput = std::make_unique<SimulationInput>(std::move(tpr), cpiFilename.c_str());
+    auto impl = std::make_unique<detail::SimulationInputHandleImpl>(std::move(simulationInput));
+
+    return SimulationInputHandle(std::move(impl));
+}
+
 } // end namespace gmx
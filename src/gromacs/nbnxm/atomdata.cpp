@@ -1072,6 +1072,95 @@ void nbnxn_atomdata_copy_x_to_nbat_x(const Nbnxm::GridSet&   gridSet,
     }
 }
 
+//! Returns the index of the x-component of grid position \p a in a buffer with format \p nbatFormat
+template<int nbatFormat>
+static inline int nbatIndex(int a)
+{
+    if constexpr (nbatFormat == nbatX4)
+    {
+        return atom_to_x_index<c_packX4>(a);
+    }
+    else if constexpr (nbatFormat == nbatX8)
+    {
+        return atom_to_x_index<c_packX8>(a);
+    }
+    else
+    {
+        return a * (nbatFormat == nbatXYZQ ? STRIDE_XYZQ : STRIDE_XYZ);
+    }
+}
+
+//! The distance between the components of an atom in a buffer with format \p nbatFormat
+template<int nbatFormat>
+static constexpr int c_nbatComponentStride =
+        (nbatFormat == nbatX4 ? c_packX4 : (nbatFormat == nbatX8 ? c_packX8 : 1));
+
+//! Copies the grid ordered coordinates of grid positions \p a0 to \p a1 - 1 to \p xnb
+template<int nbatFormat>
+static void copyGridOrderedRvecToNbatReal(int a0, int a1, const rvec* x, real* xnb)
+{
+    constexpr int stride = c_nbatComponentStride<nbatFormat>;
+
+    for (int a = a0; a < a1; a++)
+    {
+        const int i = nbatIndex<nbatFormat>(a);
+
+        xnb[i + XX * stride] = x[a][XX];
+        xnb[i + YY * stride] = x[a][YY];
+        xnb[i + ZZ * stride] = x[a][ZZ];
+    }
+}
+
+void nbnxn_atomdata_copy_grid_ordered_x_to_nbat_x(const Nbnxm::GridSet& gridSet,
+                                                  const rvec*           gridOrderedCoordinates,
+                                                  nbnxn_atomdata_t*     nbat)
+{
+    const Nbnxm::Grid& grid       = gridSet.grids()[0];
+    const int          numCellsXY = grid.numColumns();
+
+    const int nth = gmx_omp_nthreads_get(emntPairsearch);
+#pragma omp parallel for num_threads(nth) schedule(static)
+    for (int th = 0; th < nth; th++)
+    {
+        try
+        {
+            const int cxy0 = (numCellsXY * th + nth - 1) / nth;
+            const int cxy1 = (numCellsXY * (th + 1) + nth - 1) / nth;
+
+            for (int cxy = cxy0; cxy < cxy1; cxy++)
+            {
+                /* The filler positions at the end of the column keep the
+                 * coordinates set during pair-list generation.
+                 */
+                const int a0 = grid.firstAtomInColumn(cxy);
+                const int a1 = a0 + grid.numAtomsInColumn(cxy);
+
+                switch (nbat->XFormat)
+                {
+                    case nbatXYZ:
+                        copyGridOrderedRvecToNbatReal<nbatXYZ>(a0, a1, gridOrderedCoordinates,
+                                                               nbat->x().data());
+                        break;
+                    case nbatXYZQ:
+                        copyGridOrderedRvecToNbatReal<nbatXYZQ>(a0, a1, gridOrderedCoordinates,
+                                                                nbat->x().data());
+                        break;
+                    case nbatX4:
+                        copyGridOrderedRvecToNbatReal<nbatX4>(a0, a1, gridOrderedCoordinates,
+                                                              nbat->x().data());
+                        break;
+                    case nbatX8:
+                        copyGridOrderedRvecToNbatReal<nbatX8>(a0, a1, gridOrderedCoordinates,
+                                                              nbat->x().data());
+                        break;
+                    default: gmx_incons("Unsupported nbnxn_atomdata_t format");
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+}
+
 /* Copies (and reorders) the coordinates to nbnxn_atomdata_t on the GPU*/
 void nbnxn_atomdata_x_to_nbat_x_gpu(const Nbnxm::GridSet&   gridSet,
                                     const gmx::AtomLocality locality,
@@ -1421,6 +1510,87 @@ static void nbnxn_atomdata_add_nbat_f_to_f_stdreduce(nbnxn_atomdata_t* nbat, int
 }
 
 
+//! Reduces the force output buffers of all threads into buffer 0
+static void reduceForceOutputBuffers(nbnxn_atomdata_t* nbat, int nth)
+{
+    if (nbat->bUseTreeReduce)
+    {
+        nbnxn_atomdata_add_nbat_f_to_f_treereduce(nbat, nth);
+    }
+    else
+    {
+        nbnxn_atomdata_add_nbat_f_to_f_stdreduce(nbat, nth);
+    }
+}
+
+//! Stores the forces of grid positions \p a0 to \p a1 - 1 in \p f, in grid order
+template<int nbatFormat>
+static void copyNbatRealToGridOrderedRvec(int                      a0,
+                                          int                      a1,
+                                          gmx::ArrayRef<const int> atomIndices,
+                                          const real*              fnb,
+                                          rvec*                    f)
+{
+    constexpr int stride = c_nbatComponentStride<nbatFormat>;
+
+    for (int a = a0; a < a1; a++)
+    {
+        if (atomIndices[a] >= 0)
+        {
+            const int i = nbatIndex<nbatFormat>(a);
+
+            f[a][XX] = fnb[i + XX * stride];
+            f[a][YY] = fnb[i + YY * stride];
+            f[a][ZZ] = fnb[i + ZZ * stride];
+        }
+        else
+        {
+            clear_rvec(f[a]);
+        }
+    }
+}
+
+void reduceForcesInGridOrder(nbnxn_atomdata_t* nbat, const Nbnxm::GridSet& gridSet, rvec* f)
+{
+    gmx::ArrayRef<const int> atomIndices  = gridSet.getLocalAtomorder();
+    const int                numPositions = atomIndices.ssize();
+
+    int nth = gmx_omp_nthreads_get(emntNonbonded);
+
+    if (nbat->out.size() > 1)
+    {
+        reduceForceOutputBuffers(nbat, nth);
+    }
+#pragma omp parallel for num_threads(nth) schedule(static)
+    for (int th = 0; th < nth; th++)
+    {
+        try
+        {
+            const int   a0  = (th * numPositions) / nth;
+            const int   a1  = ((th + 1) * numPositions) / nth;
+            const real* fnb = nbat->out[0].f.data();
+
+            switch (nbat->FFormat)
+            {
+                case nbatXYZ:
+                    copyNbatRealToGridOrderedRvec<nbatXYZ>(a0, a1, atomIndices, fnb, f);
+                    break;
+                case nbatXYZQ:
+                    copyNbatRealToGridOrderedRvec<nbatXYZQ>(a0, a1, atomIndices, fnb, f);
+                    break;
+                case nbatX4:
+                    copyNbatRealToGridOrderedRvec<nbatX4>(a0, a1, atomIndices, fnb, f);
+                    break;
+                case nbatX8:
+                    copyNbatRealToGridOrderedRvec<nbatX8>(a0, a1, atomIndices, fnb, f);
+                    break;
+                default: gmx_incons("Unsupported nbnxn_atomdata_t format");
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+}
+
 /* Add the force array(s) from nbnxn_atomdata_t to f */
 void reduceForces(nbnxn_atomdata_t* nbat, const gmx::AtomLocality locality, const Nbnxm::GridSet& gridSet, rvec* f)
 {
@@ -1447,14 +1617,7 @@ void reduceForces(nbnxn_atomdata_t* nbat, const gmx::AtomLocality locality, cons
         /* Reduce the force thread output buffers into buffer 0, before adding
          * them to the, differently ordered, "real" force buffer.
          */
-        if (nbat->bUseTreeReduce)
-        {
-            nbnxn_atomdata_add_nbat_f_to_f_treereduce(nbat, nth);
-        }
-        else
-        {
-            nbnxn_atomdata_add_nbat_f_to_f_stdreduce(nbat, nth);
-        }
+        reduceForceOutputBuffers(nbat, nth);
     }
 #pragma omp parallel for num_threads(nth) schedule(static)
     for (int th = 0; th < nth; th++)
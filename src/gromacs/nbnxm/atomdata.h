@@ -353,6 +353,20 @@ void nbnxn_atomdata_copy_x_to_nbat_x(const Nbnxm::GridSet& gridSet,
                                      const rvec*           coordinates,
                                      nbnxn_atomdata_t*     nbat);
 
+/*! \brief Copy local coordinates in grid order to xbat layout
+ *
+ * Unlike nbnxn_atomdata_copy_x_to_nbat_x(), the coordinates are not reordered:
+ * \p gridOrderedCoordinates has one entry per local grid position, in the order
+ * given by GridSet::getLocalAtomorder(). Entries for filler positions are not used.
+ *
+ * \param[in] gridSet                 The grids data.
+ * \param[in] gridOrderedCoordinates  Local coordinates in grid order.
+ * \param[in,out] nbat                Data in NBNXM format, holding the output buffer.
+ */
+void nbnxn_atomdata_copy_grid_ordered_x_to_nbat_x(const Nbnxm::GridSet& gridSet,
+                                                  const rvec*           gridOrderedCoordinates,
+                                                  nbnxn_atomdata_t*     nbat);
+
 /*! \brief Transform coordinates to xbat layout on GPU
  *
  * Creates a GPU copy of the coordinates buffer using short-range ordering.
@@ -381,6 +395,18 @@ void nbnxn_atomdata_x_to_nbat_x_gpu(const Nbnxm::GridSet&   gridSet,
  */
 void reduceForces(nbnxn_atomdata_t* nbat, gmx::AtomLocality locality, const Nbnxm::GridSet& gridSet, rvec* totalForce);
 
+/*! \brief Store the computed local forces in grid order in \p gridOrderedForce
+ *
+ * Unlike reduceForces(), the forces are not reordered and \p gridOrderedForce
+ * is overwritten. It has one entry per local grid position, in the order given
+ * by GridSet::getLocalAtomorder(), and gets zero force for filler positions.
+ *
+ * \param[in]  nbat              Atom data in NBNXM format.
+ * \param[in]  gridSet           The grids data.
+ * \param[out] gridOrderedForce  Buffer to store the local forces in grid order
+ */
+void reduceForcesInGridOrder(nbnxn_atomdata_t* nbat, const Nbnxm::GridSet& gridSet, rvec* gridOrderedForce);
+
 //! Add the fshift force stored in nbat to fshift
 void nbnxn_atomdata_add_nbat_fshift_to_fshift(const nbnxn_atomdata_t& nbat, gmx::ArrayRef<gmx::RVec> fshift);
 
@@ -140,6 +140,21 @@ void nonbonded_verlet_t::convertCoordinates(const gmx::AtomLocality        local
     wallcycle_stop(wcycle_, ewcNB_XF_BUF_OPS);
 }
 
+void nonbonded_verlet_t::convertGridOrderedCoordinates(gmx::ArrayRef<const gmx::RVec> coordinates)
+{
+    GMX_ASSERT(coordinates.ssize() == getLocalAtomOrder().ssize(),
+               "Need one coordinate per local grid position");
+
+    wallcycle_start(wcycle_, ewcNB_XF_BUF_OPS);
+    wallcycle_sub_start(wcycle_, ewcsNB_X_BUF_OPS);
+
+    nbnxn_atomdata_copy_grid_ordered_x_to_nbat_x(pairSearch_->gridSet(),
+                                                 as_rvec_array(coordinates.data()), nbat.get());
+
+    wallcycle_sub_stop(wcycle_, ewcsNB_X_BUF_OPS);
+    wallcycle_stop(wcycle_, ewcNB_XF_BUF_OPS);
+}
+
 void nonbonded_verlet_t::convertCoordinatesGpu(const gmx::AtomLocality locality,
                                                const bool              fillLocal,
                                                DeviceBuffer<gmx::RVec> d_x,
@@ -179,6 +194,21 @@ void nonbonded_verlet_t::atomdata_add_nbat_f_to_f(const gmx::AtomLocality  local
     wallcycle_stop(wcycle_, ewcNB_XF_BUF_OPS);
 }
 
+void nonbonded_verlet_t::getGridOrderedForces(gmx::ArrayRef<gmx::RVec> force)
+{
+    GMX_ASSERT(pairlistIsSimple(), "Grid ordered forces are only supported on the CPU");
+    GMX_ASSERT(force.ssize() == getLocalAtomOrder().ssize(),
+               "Need one force per local grid position");
+
+    wallcycle_start(wcycle_, ewcNB_XF_BUF_OPS);
+    wallcycle_sub_start(wcycle_, ewcsNB_F_BUF_OPS);
+
+    reduceForcesInGridOrder(nbat.get(), pairSearch_->gridSet(), as_rvec_array(force.data()));
+
+    wallcycle_sub_stop(wcycle_, ewcsNB_F_BUF_OPS);
+    wallcycle_stop(wcycle_, ewcNB_XF_BUF_OPS);
+}
+
 int nonbonded_verlet_t::getNumAtoms(const gmx::AtomLocality locality)
 {
     int numAtoms = 0;
@@ -280,6 +280,16 @@ public:
      */
     void convertCoordinates(gmx::AtomLocality locality, bool fillLocal, gmx::ArrayRef<const gmx::RVec> coordinates);
 
+    /*!\brief Convert the local coordinates, given in grid order, to NBNXM format
+     *
+     * \p coordinates has one entry per local grid position, in the order given by
+     * getLocalAtomOrder(), so no reordering is needed. Entries for filler positions
+     * are not used.
+     *
+     * \param[in] coordinates  Local coordinates in grid order.
+     */
+    void convertGridOrderedCoordinates(gmx::ArrayRef<const gmx::RVec> coordinates);
+
     /*!\brief Convert the coordinates to NBNXM format on the GPU for the given locality
      *
      * The API function for the transformation of the coordinates from one layout to another in the GPU memory.
@@ -342,6 +352,15 @@ public:
      */
     void atomdata_add_nbat_f_to_f(gmx::AtomLocality locality, gmx::ArrayRef<gmx::RVec> force);
 
+    /*! \brief Store the local forces in nbat, in grid order, in \p force
+     *
+     * \p force has one entry per local grid position, in the order given by
+     * getLocalAtomOrder(). It is overwritten, with zero force for filler positions.
+     *
+     * \param [out] force         Local forces in grid order
+     */
+    void getGridOrderedForces(gmx::ArrayRef<gmx::RVec> force);
+
     /*! \brief Add the forces stored in nbat to total force using GPU buffer opse
      *
      * \param [in]     locality             Local or non-local
@@ -52,6 +52,7 @@
 #include <vector>
 
 #include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/stringutil.h"
 
 namespace gmx
 {
@@ -67,8 +68,11 @@ public:
      *
      * \param restraint Handle to be added to the manager.
      * \param name Identifying string for restraint.
+     * \param evaluationPeriod Number of MD steps between evaluations.
      */
-    void add(std::shared_ptr<::gmx::IRestraintPotential> restraint, const std::string& name);
+    void add(std::shared_ptr<::gmx::IRestraintPotential> restraint,
+             const std::string&                          name,
+             int                                         evaluationPeriod);
 
     /*!
      * \brief Clear registered restraints and reset the manager.
@@ -85,6 +89,15 @@ public:
      */
     std::vector<std::shared_ptr<::gmx::IRestraintPotential>> restraint_;
 
+    //! Number of MD steps between evaluations of each restraint.
+    std::vector<int> evaluationPeriod_;
+
+    //! Name of each restraint.
+    std::vector<std::string> name_;
+
+    //! Timings of the restraints of the last simulation.
+    std::vector<RestraintTiming> timing_;
+
 private:
     //! Regulate initialization of the shared resource when (re)initialized.
     static std::mutex initializationMutex_;
@@ -95,10 +108,18 @@ std::mutex RestraintManager::Impl::initializationMutex_{};
 
 
 void RestraintManager::Impl::add(std::shared_ptr<::gmx::IRestraintPotential> restraint,
-                                 const std::string&                          name)
+                                 const std::string&                          name,
+                                 int                                         evaluationPeriod)
 {
-    (void)name;
+    if (evaluationPeriod < 1)
+    {
+        GMX_THROW(InvalidInputError(formatString(
+                "Restraint %s has evaluation period %d, but it should be at least 1.",
+                name.c_str(), evaluationPeriod)));
+    }
     restraint_.emplace_back(std::move(restraint));
+    evaluationPeriod_.emplace_back(evaluationPeriod);
+    name_.emplace_back(name);
 }
 
 RestraintManager::RestraintManager() : instance_(std::make_shared<RestraintManager::Impl>()){};
@@ -109,6 +130,8 @@ void RestraintManager::Impl::clear() noexcept
 {
     std::lock_guard<std::mutex> lock(initializationMutex_);
     restraint_.resize(0);
+    evaluationPeriod_.resize(0);
+    name_.resize(0);
 }
 
 void RestraintManager::clear() noexcept
@@ -117,9 +140,11 @@ void RestraintManager::clear() noexcept
     instance_->clear();
 }
 
-void RestraintManager::addToSpec(std::shared_ptr<gmx::IRestraintPotential> puller, const std::string& name)
+void RestraintManager::addToSpec(std::shared_ptr<gmx::IRestraintPotential> puller,
+                                 const std::string&                        name,
+                                 int                                       evaluationPeriod)
 {
-    instance_->add(std::move(puller), name);
+    instance_->add(std::move(puller), name, evaluationPeriod);
 }
 
 std::vector<std::shared_ptr<IRestraintPotential>> RestraintManager::getRestraints() const
@@ -127,6 +152,26 @@ std::vector<std::shared_ptr<IRestraintPotential>> RestraintManager::getRestraint
     return instance_->restraint_;
 }
 
+std::vector<int> RestraintManager::getEvaluationPeriods() const
+{
+    return instance_->evaluationPeriod_;
+}
+
+std::vector<std::string> RestraintManager::getNames() const
+{
+    return instance_->name_;
+}
+
+void RestraintManager::setTimings(std::vector<RestraintTiming> timings)
+{
+    instance_->timing_ = std::move(timings);
+}
+
+std::vector<RestraintTiming> RestraintManager::getTimings() const
+{
+    return instance_->timing_;
+}
+
 unsigned long RestraintManager::countRestraints() noexcept
 {
     return instance_->restraint_.size();
@@ -48,6 +48,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "gromacs/restraint/restraintpotential.h"
 #include "gromacs/utility/basedefinitions.h"
@@ -59,6 +60,29 @@ struct pull_t;
 namespace gmx
 {
 
+/*! \libinternal \ingroup module_restraint
+ * \brief Time spent in the call-backs of a restraint during a simulation.
+ *
+ * Measured on the master rank, which makes the update call-backs.
+ */
+struct RestraintTiming
+{
+    //! Name under which the restraint was added.
+    std::string name;
+    //! Number of evaluations of the restraint forces.
+    int numEvaluations = 0;
+    //! Wall time of the force evaluations in seconds.
+    double evaluationSeconds = 0;
+    //! Number of update call-backs.
+    int numUpdates = 0;
+    //! Wall time of the update call-backs in seconds, excluding ensemble reductions.
+    double updateSeconds = 0;
+    //! Number of ensemble reductions waited for in the update call-backs.
+    int numReductions = 0;
+    //! Wall time spent waiting for ensemble reductions in seconds.
+    double reductionSeconds = 0;
+};
+
 /*! \libinternal \ingroup module_restraint
  * \brief Manage the Restraint potentials available for Molecular Dynamics.
  *
@@ -114,8 +138,17 @@ public:
      *
      * \param restraint shared ownership of a restraint potential interface.
      * \param name key by which to reference the restraint.
+     * \param evaluationPeriod number of MD steps between evaluations of the restraint.
+     *
+     * With an evaluation period \p k larger than one, the restraint is evaluated
+     * every \p k steps and its forces are applied as an impulse scaled by \p k,
+     * as for the slow forces with multiple time-stepping.
+     *
+     * \throws InvalidInputError if \p evaluationPeriod is not positive.
      */
-    void addToSpec(std::shared_ptr<gmx::IRestraintPotential> restraint, const std::string& name);
+    void addToSpec(std::shared_ptr<gmx::IRestraintPotential> restraint,
+                   const std::string&                        name,
+                   int                                       evaluationPeriod = 1);
 
     /*!
      * \brief Get a copy of the current set of restraints to be applied.
@@ -130,6 +163,34 @@ public:
      */
     std::vector<std::shared_ptr<IRestraintPotential>> getRestraints() const;
 
+    /*!
+     * \brief Get the evaluation periods of the current set of restraints.
+     *
+     * \return a copy of the evaluation periods, in the same order as getRestraints().
+     */
+    std::vector<int> getEvaluationPeriods() const;
+
+    /*!
+     * \brief Get the names of the current set of restraints.
+     *
+     * \return a copy of the names, in the same order as getRestraints().
+     */
+    std::vector<std::string> getNames() const;
+
+    /*!
+     * \brief Store the timings of the restraints at the end of a simulation.
+     *
+     * \param timings time spent in each restraint, in the same order as getRestraints().
+     */
+    void setTimings(std::vector<RestraintTiming> timings);
+
+    /*!
+     * \brief Get the timings of the restraints of the last simulation.
+     *
+     * \return the timings set with setTimings(), empty if there were none.
+     */
+    std::vector<RestraintTiming> getTimings() const;
+
 private:
     class Impl;
     //! Ownership of the shared reference to the global manager.
@@ -37,36 +37,373 @@
 
 #include "restraintmdmodule.h"
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <numeric>
 
+#include "gromacs/domdec/localatomsetmanager.h"
 #include "gromacs/mdtypes/forceoutput.h"
 #include "gromacs/mdtypes/iforceprovider.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/mdmodulenotification.h"
+#include "gromacs/utility/stringutil.h"
 
 #include "restraintmdmodule_impl.h"
 
 namespace gmx
 {
 
-RestraintForceProvider::RestraintForceProvider(std::shared_ptr<IRestraintPotential> restraint,
-                                               const std::vector<int>&              sites) :
-    restraint_{ std::move(restraint) }
+Site::Site(int globalIndex) : globalIndex_{ globalIndex } {}
+
+Site::Site(const AtomGroupSite& group) : globalIndex_(group.indices), weights_(group.weights)
+{
+    if (globalIndex_.empty())
+    {
+        GMX_THROW(InvalidInputError("Restraint sites require at least one atom."));
+    }
+    if (!weights_.empty() && weights_.size() != globalIndex_.size())
+    {
+        GMX_THROW(InvalidInputError(
+                formatString("Restraint site has %zu atoms but %zu weights.",
+                             globalIndex_.size(), weights_.size())));
+    }
+}
+
+void Site::setLocalAtomSet(const LocalAtomSet& localAtomSet)
+{
+    GMX_ASSERT(localAtomSet.numAtomsGlobal() == globalIndex_.size(),
+               "Local atom set should be constructed from the site atoms.");
+    localAtomSet_ = localAtomSet;
+}
+
+void Site::referenceContribution(const t_commrec& cr, ArrayRef<const RVec> x, double* buffer) const
+{
+    buffer[XX] = 0;
+    buffer[YY] = 0;
+    buffer[ZZ] = 0;
+    forEachHomeAtom(cr, [x, buffer](int localIndex, int collectiveIndex) {
+        if (collectiveIndex == 0)
+        {
+            buffer[XX] = x[localIndex][XX];
+            buffer[YY] = x[localIndex][YY];
+            buffer[ZZ] = x[localIndex][ZZ];
+        }
+    });
+}
+
+void Site::setReference(const double* buffer)
+{
+    reference_     = { static_cast<real>(buffer[XX]), static_cast<real>(buffer[YY]),
+                   static_cast<real>(buffer[ZZ]) };
+    haveReference_ = true;
+}
+
+void Site::localContribution(const t_commrec&     cr,
+                             const t_mdatoms&     mdatoms,
+                             ArrayRef<const RVec> x,
+                             const t_pbc*         pbc,
+                             double*              buffer) const
+{
+    for (int d = 0; d < c_bufferStride; ++d)
+    {
+        buffer[d] = 0;
+    }
+    if (globalIndex_.size() == 1)
+    {
+        // Nothing to weight or make whole. Exactly one rank contributes.
+        forEachHomeAtom(cr, [x, buffer](int localIndex, int gmx_unused collectiveIndex) {
+            buffer[XX] = x[localIndex][XX];
+            buffer[YY] = x[localIndex][YY];
+            buffer[ZZ] = x[localIndex][ZZ];
+            buffer[DIM] = 1;
+        });
+        return;
+    }
+    GMX_ASSERT(haveReference_, "Multi-atom sites need a reference position.");
+    forEachHomeAtom(cr, [this, &mdatoms, x, pbc, buffer](int localIndex, int collectiveIndex) {
+        const real weight = atomWeight(mdatoms, localIndex, collectiveIndex);
+        rvec       dx;
+        pbc_dx(pbc, x[localIndex], reference_, dx);
+        buffer[XX] += weight * dx[XX];
+        buffer[YY] += weight * dx[YY];
+        buffer[ZZ] += weight * dx[ZZ];
+        buffer[DIM] += weight;
+    });
+}
+
+void Site::setPosition(const double* buffer)
+{
+    totalWeight_ = buffer[DIM];
+    if (!(totalWeight_ > 0))
+    {
+        GMX_THROW(InternalError(formatString(
+                "Restraint site with first atom %d has no atoms or zero total weight.", index())));
+    }
+    if (globalIndex_.size() == 1)
+    {
+        position_ = { static_cast<real>(buffer[XX]), static_cast<real>(buffer[YY]),
+                      static_cast<real>(buffer[ZZ]) };
+    }
+    else
+    {
+        for (int d = 0; d < DIM; ++d)
+        {
+            position_[d] = reference_[d] + static_cast<real>(buffer[d] / totalWeight_);
+        }
+        reference_ = position_;
+    }
+}
+
+void Site::spreadForce(const t_commrec& cr, const t_mdatoms& mdatoms, const RVec& f, ArrayRef<RVec> force) const
+{
+    if (globalIndex_.size() == 1)
+    {
+        forEachHomeAtom(cr, [&f, force](int localIndex, int gmx_unused collectiveIndex) {
+            force[localIndex] += f;
+        });
+        return;
+    }
+    const real invTotalWeight = static_cast<real>(1.0 / totalWeight_);
+    forEachHomeAtom(cr, [this, &mdatoms, &f, force, invTotalWeight](int localIndex, int collectiveIndex) {
+        const real scale = atomWeight(mdatoms, localIndex, collectiveIndex) * invTotalWeight;
+        force[localIndex] += scale * f;
+    });
+}
+
+namespace
+{
+
+//! Start the sub-counter \p ewcs, unless the restraint is not timed.
+void startSubCounter(gmx_wallcycle* wcycle, int ewcs)
+{
+    if (ewcs >= 0)
+    {
+        wallcycle_sub_start(wcycle, ewcs);
+    }
+}
+
+//! Stop the sub-counter \p ewcs, unless the restraint is not timed.
+void stopSubCounter(gmx_wallcycle* wcycle, int ewcs)
+{
+    if (ewcs >= 0)
+    {
+        wallcycle_sub_stop(wcycle, ewcs);
+    }
+}
+
+//! Sub-counters of the restraint whose update call-back runs on this thread.
+struct UpdateTiming
+{
+    //! Cycle counting of the simulation, nullptr outside of update call-backs.
+    gmx_wallcycle* wcycle = nullptr;
+    //! Sub-counter of the update call-back.
+    int updateCounter = -1;
+    //! Sub-counter of the ensemble reductions.
+    int reductionCounter = -1;
+};
+
+//! Update call-back timed on this thread, for RestraintReductionTimer.
+thread_local UpdateTiming t_updateTiming;
+
+//! Makes the sub-counters of an update call-back available to RestraintReductionTimer.
+class UpdateTimingScope
+{
+public:
+    UpdateTimingScope(gmx_wallcycle* wcycle, int updateCounter, int reductionCounter)
+    {
+        t_updateTiming = { wcycle, updateCounter, reductionCounter };
+    }
+    ~UpdateTimingScope() { t_updateTiming = {}; }
+
+    UpdateTimingScope(const UpdateTimingScope&) = delete;
+    UpdateTimingScope& operator=(const UpdateTimingScope&) = delete;
+};
+
+} // namespace
+
+RestraintReductionTimer::RestraintReductionTimer()
+{
+    if (t_updateTiming.wcycle != nullptr)
+    {
+        wcycle_           = t_updateTiming.wcycle;
+        updateCounter_    = t_updateTiming.updateCounter;
+        reductionCounter_ = t_updateTiming.reductionCounter;
+        // Nested timers leave the counters to this one.
+        t_updateTiming.wcycle = nullptr;
+        stopSubCounter(wcycle_, updateCounter_);
+        startSubCounter(wcycle_, reductionCounter_);
+    }
+}
+
+RestraintReductionTimer::~RestraintReductionTimer()
+{
+    if (wcycle_ != nullptr)
+    {
+        stopSubCounter(wcycle_, reductionCounter_);
+        // The update call-back continues, so it is not counted twice.
+        if (updateCounter_ >= 0)
+        {
+            wallcycle_sub_start_nocount(wcycle_, updateCounter_);
+        }
+        t_updateTiming.wcycle = wcycle_;
+    }
+}
+
+void RestraintForceProvider::addRestraint(std::shared_ptr<IRestraintPotential>           restraint,
+                                          const std::vector<std::vector<AtomGroupSite>>& sitePaths,
+                                          int                                            evaluationPeriod,
+                                          const std::string&                             name)
+{
+    GMX_ASSERT(restraint, "Valid RestraintForceProviders wrap non-null restraints.");
+    if (evaluationPeriod < 1)
+    {
+        GMX_THROW(InvalidInputError("Restraint evaluation periods should be at least 1 step."));
+    }
+    RestraintEntry entry;
+    entry.usesLocalAtoms   = restraint->usesLocalAtoms();
+    entry.restraint        = std::move(restraint);
+    entry.evaluationPeriod = evaluationPeriod;
+    entry.name = name.empty() ? formatString("Restraint %zu", restraints_.size() + 1) : name;
+    for (const auto& path : sitePaths)
+    {
+        if (path.empty())
+        {
+            continue;
+        }
+        if (path.size() < 2)
+        {
+            GMX_THROW(InvalidInputError(
+                    "Restraints require at least two sites to calculate forces."));
+        }
+        std::vector<size_t> siteSlots;
+        for (const auto& group : path)
+        {
+            // Sites that are shared between restraints are gathered only once per step.
+            const Site site(group);
+            auto       found = std::find_if(sites_.begin(), sites_.end(), [&site](const Site& other) {
+                return site.hasSameDefinition(other);
+            });
+            if (found == sites_.end())
+            {
+                sites_.push_back(site);
+                found = sites_.end() - 1;
+            }
+            siteSlots.push_back(static_cast<size_t>(std::distance(sites_.begin(), found)));
+        }
+        entry.paths.emplace_back(std::move(siteSlots));
+    }
+    const size_t numPairs = entry.paths.size();
+    entry.positions.resize(2 * DIM * numPairs);
+    entry.forcesAndEnergies.resize((DIM + 1) * numPairs);
+    entry.batch.size = numPairs;
+    for (int d = 0; d < DIM; ++d)
+    {
+        entry.batch.r1[d]    = entry.positions.data() + d * numPairs;
+        entry.batch.r2[d]    = entry.positions.data() + (DIM + d) * numPairs;
+        entry.batch.force[d] = entry.forcesAndEnergies.data() + d * numPairs;
+    }
+    entry.batch.energy = entry.forcesAndEnergies.data() + DIM * numPairs;
+    // Moving the entry keeps the buffers, and so the batch view, valid.
+    restraints_.emplace_back(std::move(entry));
+
+    siteBuffer_.resize(Site::c_bufferStride * sites_.size());
+}
+
+void RestraintForceProvider::setLocalAtomSets(LocalAtomSetManager* localAtomSetManager)
+{
+    GMX_ASSERT(localAtomSetManager, "Need a valid LocalAtomSetManager.");
+    for (auto& site : sites_)
+    {
+        site.setLocalAtomSet(localAtomSetManager->add(site.globalIndices()));
+    }
+}
+
+void RestraintForceProvider::selectDueSites(int64_t step)
 {
-    GMX_ASSERT(restraint_, "Valid RestraintForceProviders wrap non-null restraints.");
-    GMX_ASSERT(sites_.empty(), "");
-    for (auto&& site : sites)
+    siteIsDue_.assign(sites_.size(), false);
+    for (const auto& entry : restraints_)
+    {
+        if (step % entry.evaluationPeriod == 0)
+        {
+            for (const auto& path : entry.paths)
+            {
+                for (const size_t slot : path)
+                {
+                    siteIsDue_[slot] = true;
+                }
+            }
+        }
+    }
+    dueSites_.clear();
+    for (size_t i = 0; i < sites_.size(); ++i)
+    {
+        if (siteIsDue_[i])
+        {
+            dueSites_.push_back(i);
+        }
+    }
+}
+
+void RestraintForceProvider::gatherSitePositions(const t_commrec&     cr,
+                                                 const t_mdatoms&     mdatoms,
+                                                 ArrayRef<const RVec> x,
+                                                 const t_pbc*         pbc)
+{
+    // All ranks select the same sites, since the selection only depends on the step.
+    const bool needReferences = std::any_of(dueSites_.begin(), dueSites_.end(), [this](size_t slot) {
+        return sites_[slot].needsReference();
+    });
+    if (needReferences)
+    {
+        // Only happens at the first evaluation of a site: locate the first atom of each site.
+        for (size_t i = 0; i < dueSites_.size(); ++i)
+        {
+            sites_[dueSites_[i]].referenceContribution(cr, x, &siteBuffer_[DIM * i]);
+        }
+        if (DOMAINDECOMP(&cr))
+        {
+            gmx_sumd(static_cast<int>(DIM * dueSites_.size()), siteBuffer_.data(), &cr);
+        }
+        for (size_t i = 0; i < dueSites_.size(); ++i)
+        {
+            if (sites_[dueSites_[i]].needsReference())
+            {
+                sites_[dueSites_[i]].setReference(&siteBuffer_[DIM * i]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < dueSites_.size(); ++i)
+    {
+        sites_[dueSites_[i]].localContribution(cr, mdatoms, x, pbc,
+                                               &siteBuffer_[Site::c_bufferStride * i]);
+    }
+    if (DOMAINDECOMP(&cr))
     {
-        sites_.emplace_back(site);
+        // AllReduce across the ranks of the simulation to get the center-of-mass
+        // of every due site locally available everywhere, with one collective
+        // for all sites of all restraints.
+        gmx_sumd(static_cast<int>(Site::c_bufferStride * dueSites_.size()), siteBuffer_.data(), &cr);
     }
-    if (sites_.size() < 2)
+    for (size_t i = 0; i < dueSites_.size(); ++i)
     {
-        GMX_THROW(InvalidInputError("Restraints require at least two sites to calculate forces."));
+        sites_[dueSites_[i]].setPosition(&siteBuffer_[Site::c_bufferStride * i]);
     }
 }
 
 void RestraintForceProvider::calculateForces(const ForceProviderInput& forceProviderInput,
                                              ForceProviderOutput*      forceProviderOutput)
 {
-    GMX_ASSERT(restraint_, "Restraint must be initialized.");
+    const int64_t step     = forceProviderInput.step_;
+    const auto    isDueNow = [step](const RestraintEntry& entry) {
+        return step % entry.evaluationPeriod == 0;
+    };
+    if (std::none_of(restraints_.begin(), restraints_.end(), isDueNow))
+    {
+        return;
+    }
+    wallcycle_start(wcycle_, ewcRESTRAINT_MODULES);
 
     const auto& mdatoms = forceProviderInput.mdatoms_;
     GMX_ASSERT(mdatoms.homenr >= 0, "number of home atoms must be non-negative.");
@@ -80,40 +417,39 @@ void RestraintForceProvider::calculateForces(const ForceProviderInput& forceProv
     const auto& cr = forceProviderInput.cr_;
     const auto& t  = forceProviderInput.t_;
     // Cooperatively get Cartesian coordinates for center of mass of each site
-    RVec r1 = sites_[0].centerOfMass(cr, static_cast<size_t>(mdatoms.homenr), x, t);
-    // r2 is to be constructed as
-    // r2 = (site[N] - site[N-1]) + (site_{N-1} - site_{N-2}) + ... + (site_2 - site_1) + site_1
-    // where the minimum image convention is applied to each path but not to the overall sum.
-    // It is redundant to pass both r1 and r2 to called code, and potentially confusing, since
-    // r1 may refer to an actual coordinate in the simulation while r2 may be in an expanded
-    // Cartesian coordinate system. Called code should not use r1 and r2 to attempt to identify
-    // sites in the simulation. If we need that functionality, we should do it separately by
-    // allowing called code to look up atoms by tag or global index.
-    RVec r2 = { r1[0], r1[1], r1[2] };
-    rvec dr = { 0, 0, 0 };
-    // Build r2 by following a path of difference vectors that are each presumed to be less than
-    // a half-box apart, in case we are battling periodic boundary conditions along the lines of
-    // a big molecule in a small box.
-    for (size_t i = 0; i < sites_.size() - 1; ++i)
-    {
-        RVec a = sites_[i].centerOfMass(cr, static_cast<size_t>(mdatoms.homenr), x, t);
-        RVec b = sites_[i + 1].centerOfMass(cr, static_cast<size_t>(mdatoms.homenr), x, t);
-        // dr = minimum_image_vector(b - a)
-        pbc_dx(&pbc, b, a, dr);
-        r2[0] += dr[0];
-        r2[1] += dr[1];
-        r2[2] += dr[2];
-    }
-    // In the case of a single-atom site, r1 and r2 are now correct if local or [0,0,0] if not local.
-
-
-    // Master rank update call-back. This needs to be moved to a discrete place in the
+    // of the restraints that are due
+    selectDueSites(step);
+    if (!dueSites_.empty())
+    {
+        gatherSitePositions(cr, mdatoms, x, &pbc);
+    }
+
+    for (auto& entry : restraints_)
+    {
+        if (isDueNow(entry))
+        {
+            preparePairs(&entry, pbc);
+        }
+    }
+
+    // Master rank update call-backs. These need to be moved to a discrete place in the
     // time step to avoid extraneous barriers. The code would be prettier with "futures"...
     if ((cr.dd == nullptr) || MASTER(&cr))
     {
-        restraint_->update(RVec(r1), r2, t);
+        for (const auto& entry : restraints_)
+        {
+            if (isDueNow(entry))
+            {
+                startSubCounter(wcycle_, entry.updateCounter);
+                {
+                    UpdateTimingScope scope(wcycle_, entry.updateCounter, entry.reductionCounter);
+                    entry.restraint->updateBatch(entry.batch, t);
+                }
+                stopSubCounter(wcycle_, entry.updateCounter);
+            }
+        }
     }
-    // All ranks wait for the update to finish.
+    // All ranks wait for the updates to finish.
     // tMPI ranks are depending on structures that may have just been updated.
     if (DOMAINDECOMP(&cr))
     {
@@ -122,30 +458,172 @@ void RestraintForceProvider::calculateForces(const ForceProviderInput& forceProv
         gmx_barrier(cr.mpi_comm_mygroup);
     }
 
-    // Apply restraint on all thread ranks only after any updates have been made.
-    auto result = restraint_->evaluate(RVec(r1), r2, t);
-
-    // This can easily be generalized for pair restraints that apply to selections instead of
-    // individual indices, or to restraints that aren't pair restraints.
-    const int  site1  = static_cast<int>(sites_.front().index());
-    const int* aLocal = &site1;
-    // Set forces using index `site1` if no domain decomposition, otherwise set with local index if available.
     auto& force = forceProviderOutput->forceWithVirial_.force_;
-    if ((cr.dd == nullptr) || (aLocal = cr.dd->ga2la->findHome(site1)))
+    for (const auto& entry : restraints_)
+    {
+        if (!isDueNow(entry))
+        {
+            continue;
+        }
+        // Apply restraint on all thread ranks only after any updates have been made.
+        // All pairs of the restraint are evaluated with a single call.
+        const PairBatch& batch = entry.batch;
+        startSubCounter(wcycle_, entry.evaluationCounter);
+        entry.restraint->evaluateBatch(batch, t);
+        stopSubCounter(wcycle_, entry.evaluationCounter);
+
+        // A restraint that is evaluated every k steps applies an impulse of k times its force.
+        const real impulseScale = entry.evaluationPeriod;
+        for (size_t iPair = 0; iPair < batch.size; ++iPair)
+        {
+            // The force acts on the first site of the pair. The equal and opposite
+            // force is applied at the last site.
+            const RVec f        = { impulseScale * batch.force[XX][iPair],
+                             impulseScale * batch.force[YY][iPair],
+                             impulseScale * batch.force[ZZ][iPair] };
+            const RVec reaction = { -f[XX], -f[YY], -f[ZZ] };
+            sites_[entry.paths[iPair].front()].spreadForce(cr, mdatoms, f, force);
+            sites_[entry.paths[iPair].back()].spreadForce(cr, mdatoms, reaction, force);
+        }
+    }
+
+    if (std::any_of(restraints_.begin(), restraints_.end(), [&isDueNow](const RestraintEntry& entry) {
+            return entry.usesLocalAtoms && isDueNow(entry);
+        }))
+    {
+        const int      numHomeAtoms = mdatoms.homenr;
+        LocalAtomsView atoms;
+        atoms.time        = t;
+        atoms.step        = step;
+        atoms.box         = arrayRefFromArray(reinterpret_cast<const RVec*>(box), DIM);
+        atoms.x           = x.subArray(0, numHomeAtoms);
+        atoms.globalIndex = homeAtomGlobalIndices(cr, numHomeAtoms);
+        if (mdatoms.massT != nullptr)
+        {
+            atoms.mass = arrayRefFromArray(mdatoms.massT, numHomeAtoms);
+        }
+        const ArrayRef<RVec> homeForce = force.subArray(0, numHomeAtoms);
+        for (const auto& entry : restraints_)
+        {
+            if (!entry.usesLocalAtoms || !isDueNow(entry))
+            {
+                continue;
+            }
+            startSubCounter(wcycle_, entry.evaluationCounter);
+            if (entry.evaluationPeriod == 1)
+            {
+                entry.restraint->calculateLocalForces(atoms, homeForce);
+                stopSubCounter(wcycle_, entry.evaluationCounter);
+            }
+            else
+            {
+                localForceBuffer_.assign(numHomeAtoms, { 0, 0, 0 });
+                entry.restraint->calculateLocalForces(atoms, localForceBuffer_);
+                stopSubCounter(wcycle_, entry.evaluationCounter);
+                const real impulseScale = entry.evaluationPeriod;
+                for (int i = 0; i < numHomeAtoms; ++i)
+                {
+                    homeForce[i] += impulseScale * localForceBuffer_[i];
+                }
+            }
+        }
+    }
+    wallcycle_stop(wcycle_, ewcRESTRAINT_MODULES);
+}
+
+void RestraintForceProvider::setWallcycle(gmx_wallcycle* wcycle)
+{
+    wcycle_ = wcycle;
+    for (auto& entry : restraints_)
     {
-        force[static_cast<size_t>(*aLocal)] += result.force;
+        // Keep the suffix within the 19 characters printed in the log.
+        entry.evaluationCounter =
+                wallcycle_sub_register(wcycle_, formatString("%.17s F", entry.name.c_str()).c_str());
+        entry.updateCounter = wallcycle_sub_register(
+                wcycle_, formatString("%.12s update", entry.name.c_str()).c_str());
+        entry.reductionCounter = wallcycle_sub_register(
+                wcycle_, formatString("%.12s reduce", entry.name.c_str()).c_str());
     }
+}
 
-    // Note: Currently calculateForces is called once per restraint and each restraint
-    // applies to a pair of atoms. Future optimizations may consolidate multiple restraints
-    // with possibly duplicated sites, in which case we may prefer to iterate over non-frozen
-    // sites to apply forces without explicitly expressing pairwise symmetry as in the
-    // following logic.
-    const int  site2  = static_cast<int>(sites_.back().index());
-    const int* bLocal = &site2;
-    if ((cr.dd == nullptr) || (bLocal = cr.dd->ga2la->findHome(site2)))
+std::vector<RestraintTiming> RestraintForceProvider::timings(double secondsPerCycle) const
+{
+    std::vector<RestraintTiming> timings;
+    for (const auto& entry : restraints_)
     {
-        force[static_cast<size_t>(*bLocal)] -= result.force;
+        RestraintTiming timing;
+        timing.name = entry.name;
+        double cycles;
+        if (entry.evaluationCounter >= 0)
+        {
+            wallcycle_sub_get(wcycle_, entry.evaluationCounter, &timing.numEvaluations, &cycles);
+            timing.evaluationSeconds = cycles * secondsPerCycle;
+        }
+        if (entry.updateCounter >= 0)
+        {
+            wallcycle_sub_get(wcycle_, entry.updateCounter, &timing.numUpdates, &cycles);
+            timing.updateSeconds = cycles * secondsPerCycle;
+        }
+        if (entry.reductionCounter >= 0)
+        {
+            wallcycle_sub_get(wcycle_, entry.reductionCounter, &timing.numReductions, &cycles);
+            timing.reductionSeconds = cycles * secondsPerCycle;
+        }
+        timings.push_back(timing);
+    }
+    return timings;
+}
+
+ArrayRef<const int> RestraintForceProvider::homeAtomGlobalIndices(const t_commrec& cr, int numHomeAtoms)
+{
+    if (DOMAINDECOMP(&cr))
+    {
+        return constArrayRefFromArray(cr.dd->globalAtomIndices.data(), numHomeAtoms);
+    }
+    if (identityIndices_.size() != static_cast<size_t>(numHomeAtoms))
+    {
+        identityIndices_.resize(numHomeAtoms);
+        std::iota(identityIndices_.begin(), identityIndices_.end(), 0);
+    }
+    return identityIndices_;
+}
+
+void RestraintForceProvider::preparePairs(RestraintEntry* entry, const t_pbc& pbc) const
+{
+    const PairBatch& batch = entry->batch;
+    for (size_t iPair = 0; iPair < batch.size; ++iPair)
+    {
+        const auto& siteSlots = entry->paths[iPair];
+        const RVec  r1        = sites_[siteSlots.front()].position();
+        // r2 is to be constructed as
+        // r2 = (site[N] - site[N-1]) + (site_{N-1} - site_{N-2}) + ... + (site_2 - site_1) + site_1
+        // where the minimum image convention is applied to each path but not to the overall sum.
+        // It is redundant to pass both r1 and r2 to called code, and potentially confusing, since
+        // r1 may refer to an actual coordinate in the simulation while r2 may be in an expanded
+        // Cartesian coordinate system. Called code should not use r1 and r2 to attempt to identify
+        // sites in the simulation. If we need that functionality, we should do it separately by
+        // allowing called code to look up atoms by tag or global index.
+        RVec r2 = r1;
+        rvec dr = { 0, 0, 0 };
+        // Build r2 by following a path of difference vectors that are each presumed to be less than
+        // a half-box apart, in case we are battling periodic boundary conditions along the lines of
+        // a big molecule in a small box.
+        for (size_t i = 0; i < siteSlots.size() - 1; ++i)
+        {
+            const RVec& a = sites_[siteSlots[i]].position();
+            const RVec& b = sites_[siteSlots[i + 1]].position();
+            // dr = minimum_image_vector(b - a)
+            pbc_dx(&pbc, b, a, dr);
+            r2[0] += dr[0];
+            r2[1] += dr[1];
+            r2[2] += dr[2];
+        }
+        for (int d = 0; d < DIM; ++d)
+        {
+            // The batch only exposes const input arrays to the restraint.
+            entry->positions[d * batch.size + iPair]         = r1[d];
+            entry->positions[(DIM + d) * batch.size + iPair] = r2[d];
+        }
     }
 }
 
@@ -153,9 +631,34 @@ RestraintMDModuleImpl::~RestraintMDModuleImpl() = default;
 
 RestraintMDModuleImpl::RestraintMDModuleImpl(std::shared_ptr<IRestraintPotential> restraint,
                                              const std::vector<int>&              sites) :
-    forceProvider_(std::make_unique<RestraintForceProvider>(restraint, sites))
+    forceProvider_(std::make_unique<RestraintForceProvider>())
+{
+    GMX_ASSERT(forceProvider_, "Class invariant implies non-null ForceProvider.");
+    std::vector<AtomGroupSite> groups;
+    for (const int index : sites)
+    {
+        groups.push_back({ { index }, {} });
+    }
+    forceProvider_->addRestraint(std::move(restraint), { groups });
+}
+
+RestraintMDModuleImpl::RestraintMDModuleImpl(ArrayRef<const std::shared_ptr<IRestraintPotential>> restraints,
+                                             ArrayRef<const int>         evaluationPeriods,
+                                             ArrayRef<const std::string> names) :
+    forceProvider_(std::make_unique<RestraintForceProvider>())
 {
     GMX_ASSERT(forceProvider_, "Class invariant implies non-null ForceProvider.");
+    GMX_RELEASE_ASSERT(evaluationPeriods.empty() || evaluationPeriods.size() == restraints.size(),
+                       "Need either no evaluation periods or one per restraint.");
+    GMX_RELEASE_ASSERT(names.empty() || names.size() == restraints.size(),
+                       "Need either no names or one per restraint.");
+    for (size_t i = 0; i < restraints.size(); ++i)
+    {
+        GMX_ASSERT(restraints[i], "Valid RestraintMDModules wrap non-null restraints.");
+        forceProvider_->addRestraint(restraints[i], restraints[i]->sitePaths(),
+                                     evaluationPeriods.empty() ? 1 : evaluationPeriods[i],
+                                     names.empty() ? std::string() : names[i]);
+    }
 }
 
 void RestraintMDModuleImpl::initForceProviders(ForceProviders* forceProviders)
@@ -194,7 +697,47 @@ std::unique_ptr<RestraintMDModule> RestraintMDModule::create(std::shared_ptr<IRe
     return newModule;
 }
 
-void RestraintMDModule::subscribeToSimulationSetupNotifications(MdModulesNotifier* /*notifier*/) {}
+std::unique_ptr<RestraintMDModule>
+RestraintMDModule::create(ArrayRef<const std::shared_ptr<IRestraintPotential>> restraints,
+                          ArrayRef<const int>                                  evaluationPeriods,
+                          ArrayRef<const std::string>                          names)
+{
+    auto implementation =
+            std::make_unique<RestraintMDModuleImpl>(restraints, evaluationPeriods, names);
+    auto newModule = std::make_unique<RestraintMDModule>(std::move(implementation));
+    return newModule;
+}
+
+std::vector<RestraintTiming> RestraintMDModule::timings(double elapsedSeconds) const
+{
+    GMX_ASSERT(impl_, "Class invariant implies non-null implementation member.");
+    gmx_wallcycle* wcycle = impl_->forceProvider_->wallcycle();
+    if (wcycle == nullptr)
+    {
+        return {};
+    }
+    int    numRuns;
+    double runCycles;
+    wallcycle_get(wcycle, ewcRUN, &numRuns, &runCycles);
+    const double secondsPerCycle = runCycles > 0 ? elapsedSeconds / runCycles : 0;
+    return impl_->forceProvider_->timings(secondsPerCycle);
+}
+
+void RestraintMDModule::subscribeToSimulationSetupNotifications(MdModulesNotifier* notifier)
+{
+    GMX_ASSERT(impl_, "Class invariant implies non-null implementation member.");
+    // Let each rank find the home atoms of the restraint sites without global lookups.
+    const auto setLocalAtomSetFunction = [this](LocalAtomSetManager* localAtomSetManager) {
+        impl_->forceProvider_->setLocalAtomSets(localAtomSetManager);
+    };
+    notifier->simulationSetupNotifications_.subscribe(setLocalAtomSetFunction);
+
+    // Time the restraint work under its own counter.
+    const auto setWallcycleFunction = [this](const SimulationWallcycle& simulationWallcycle) {
+        impl_->forceProvider_->setWallcycle(simulationWallcycle.wcycle);
+    };
+    notifier->simulationSetupNotifications_.subscribe(setWallcycleFunction);
+}
 
 void RestraintMDModule::subscribeToPreProcessingNotifications(MdModulesNotifier* /*notifier*/) {}
 
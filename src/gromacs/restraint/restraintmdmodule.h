@@ -46,7 +46,11 @@
  */
 
 #include "gromacs/mdtypes/imdmodule.h"
+#include "gromacs/restraint/manager.h"
 #include "gromacs/restraint/restraintpotential.h"
+#include "gromacs/utility/arrayref.h"
+
+struct gmx_wallcycle;
 
 namespace gmx
 {
@@ -55,6 +59,35 @@ namespace gmx
 class RestraintMDModuleImpl;
 struct MdModulesNotifier;
 
+/*! \libinternal \ingroup module_restraint
+ * \brief Times its scope as an ensemble reduction of the restraint being updated.
+ *
+ * While an update call-back of a restraint waits for an ensemble reduction,
+ * the update sub-counter of the restraint is paused and its reduction
+ * sub-counter runs instead, so that the two are reported separately.
+ * Outside of an update call-back on the calling thread, or when nested,
+ * the timer does nothing.
+ */
+class RestraintReductionTimer
+{
+public:
+    //! Start timing a reduction of the restraint being updated, if any.
+    RestraintReductionTimer();
+    //! Stop timing the reduction and resume the update sub-counter.
+    ~RestraintReductionTimer();
+
+    RestraintReductionTimer(const RestraintReductionTimer&) = delete;
+    RestraintReductionTimer& operator=(const RestraintReductionTimer&) = delete;
+
+private:
+    //! Cycle counting of the simulation, nullptr when this timer does nothing.
+    gmx_wallcycle* wcycle_ = nullptr;
+    //! Sub-counter of the update call-back that is paused.
+    int updateCounter_ = -1;
+    //! Sub-counter of the reductions of the restraint.
+    int reductionCounter_ = -1;
+};
+
 /*! \libinternal \ingroup module_restraint
  * \brief MDModule wrapper for Restraint implementations.
  *
@@ -90,6 +123,46 @@ public:
     static std::unique_ptr<RestraintMDModule> create(std::shared_ptr<gmx::IRestraintPotential> restraint,
                                                      const std::vector<int>& sites);
 
+    /*!
+     * \brief Wrap several restraint potentials as a single MDModule
+     *
+     * The positions of the sites of all restraints are gathered together, so
+     * that a simulation with domain decomposition needs only one collective
+     * per step for all restraints, rather than one per site per restraint.
+     * The sites of each restraint are taken from IRestraintPotential::sitePaths().
+     *
+     * A restraint with an evaluation period \p k larger than one is only evaluated
+     * every \p k steps, and its forces are then scaled by \p k, as for the slow
+     * forces with multiple time-stepping. When no restraint is due at a step,
+     * the module does no work at all.
+     *
+     * The force evaluation and update call-backs of each restraint, and the
+     * ensemble reductions it waits for during its update call-backs, are timed
+     * with named wallcycle sub-counters, which are reported in the log file
+     * and by timings().
+     *
+     * \param restraints handles to objects to wrap
+     * \param evaluationPeriods number of MD steps between evaluations of each restraint,
+     *                          or empty to evaluate all restraints every step.
+     * \param names name of each restraint in the timing report, or empty for numbered defaults.
+     * \return new wrapper object sharing ownership of the restraints.
+     */
+    static std::unique_ptr<RestraintMDModule>
+    create(ArrayRef<const std::shared_ptr<gmx::IRestraintPotential>> restraints,
+           ArrayRef<const int>                                        evaluationPeriods = {},
+           ArrayRef<const std::string>                                names             = {});
+
+    /*!
+     * \brief Get the time spent in the call-backs of each restraint.
+     *
+     * Only meaningful at the end of the simulation, before the cycle counting
+     * is destroyed.
+     *
+     * \param elapsedSeconds wall time of the run since the cycle counters were last reset.
+     * \return the timings, in the order of the restraints, empty without cycle counting.
+     */
+    std::vector<RestraintTiming> timings(double elapsedSeconds) const;
+
     /*!
      * \brief Implement IMDModule interface
      *
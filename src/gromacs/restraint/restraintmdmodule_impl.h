@@ -45,10 +45,15 @@
  */
 
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/domdec/ga2la.h"
+#include "gromacs/domdec/localatomset.h"
 #include "gromacs/gmxlib/network.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdtypes/commrec.h"
@@ -58,22 +63,31 @@
 #include "gromacs/mdtypes/imdpoptionprovider.h"
 #include "gromacs/mdtypes/mdatom.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/restraint/manager.h"
 #include "gromacs/restraint/restraintpotential.h"
+#include "gromacs/timing/wallcycle.h"
 #include "gromacs/utility/arrayref.h"
 
 namespace gmx
 {
 
+class LocalAtomSetManager;
+
 /*! \libinternal
  * \brief Abstraction for a restraint interaction site.
  *
  * A restraint may operate on a single atom or some other entity, such as a selection of atoms.
  * The Restraint implementation is very independent from how coordinates are provided or what they mean.
  *
- * First implementation can only represent single atoms in a global context.
+ * A site is a group of atoms, located at the (weighted) center of mass of
+ * the group. Local atoms are found through a LocalAtomSet when one has been
+ * provided by the LocalAtomSetManager of the simulation, so that no per-atom
+ * global-to-local lookups are needed with domain decomposition.
  *
- * Ultimately, this should be replaced with a more universal facility for acting
- * on distributed atom data or simple transformations thereof.
+ * Coordinates of multi-atom groups are accumulated relative to a reference
+ * position that is the same on all ranks, so the group is made whole under
+ * periodic boundary conditions as long as it spans less than half a box.
+ * The reference is the center of mass of the previous evaluation.
  *
  * \inlibraryapi
  * \ingroup module_restraint
@@ -81,21 +95,21 @@ namespace gmx
 class Site
 {
 public:
+    //! Number of elements per site in a packed reduction buffer (weighted position and weight).
+    static constexpr int c_bufferStride = DIM + 1;
+
     /*! \brief Construct from global atom indices
      *
      * \param globalIndex Atom index in the global state (as input to the simulation)
      */
-    explicit Site(int globalIndex) : index_(globalIndex), r_(0, 0, 0) {}
+    explicit Site(int globalIndex);
 
-    /*!
-     * \brief Explicitly define copies.
+    /*! \brief Construct from a group definition
      *
-     * Implicit definition is not possible because of the mutex member,
-     * and a copy constructor is necessary to use Site in a std::vector. Really, we should make
-     * a copy point to the same implementation object to reuse its cache.
-
+     * \param group Global atom indices and optional relative weights.
+     * \throws InvalidInputError if the group is empty or the weights do not match the atoms.
      */
-    Site(const Site& site) : index_(site.index_), r_(site.r_) {}
+    explicit Site(const AtomGroupSite& group);
 
     /*! \brief Disallow assignment.
      *
@@ -105,95 +119,154 @@ public:
      */
     Site& operator=(const Site&) = delete;
 
+    //! Copies are allowed so that Site can be held in a std::vector.
+    Site(const Site& site) = default;
+
     /*!
-     * \brief Get the global atom index of an atomic site.
+     * \brief Get the global atom index of the first atom of the site.
      *
      * \return global index provided at construction.
      *
      */
-    int index() const { return index_; }
+    int index() const { return globalIndex_.front(); }
+
+    //! Get the global atom indices of the site.
+    ArrayRef<const int> globalIndices() const { return globalIndex_; }
+
+    //! Whether \p other has the same atoms and weights.
+    bool hasSameDefinition(const Site& other) const
+    {
+        return globalIndex_ == other.globalIndex_ && weights_ == other.weights_;
+    }
+
+    /*! \brief Use a LocalAtomSet to find the home atoms of this site.
+     *
+     * \param localAtomSet Atom set constructed from globalIndices().
+     */
+    void setLocalAtomSet(const LocalAtomSet& localAtomSet);
+
+    //! Whether the site needs a reference position before contributions can be computed.
+    bool needsReference() const { return globalIndex_.size() > 1 && !haveReference_; }
 
     /*!
-     * \brief Get the position of this site at time t.
+     * \brief Write the contribution of this rank to the reference position.
+     *
+     * The reference is the position of the first atom of the site. Only the
+     * rank that has this atom as home atom contributes a non-zero value.
      *
      * \param cr Communications record.
-     * \param nx Number of locally available atoms (size of local atom data arrays)
      * \param x Array of locally available atom coordinates.
-     * \param t the current time.
-     * \return position vector.
+     * \param[out] buffer DIM elements to receive the (partial) reference position.
+     */
+    void referenceContribution(const t_commrec& cr, ArrayRef<const RVec> x, double* buffer) const;
+
+    /*! \brief Set the reference position from the reduced reference buffer.
+     *
+     * \param buffer DIM elements of the reduced reference position.
+     */
+    void setReference(const double* buffer);
+
+    /*!
+     * \brief Write the contribution of this rank to the site position.
+     *
+     * The caller is responsible for summing the contributions of all ranks
+     * (if there is domain decomposition) so that a single collective can
+     * serve any number of sites.
      *
-     * \internal
-     * By providing the current time, we can cache results in order to use them once per timestep.
-     * In the long term, we would prefer to also allow client code to preregister interest in a
-     * position at a given time, or issue "futures".
+     * \param cr Communications record.
+     * \param mdatoms Local atom data, masses are used for multi-atom sites.
+     * \param x Array of locally available atom coordinates.
+     * \param pbc Periodic boundary information.
+     * \param[out] buffer c_bufferStride elements to receive the (partial) weighted
+     *                    position and weight.
      */
-    RVec centerOfMass(const t_commrec& cr, size_t nx, ArrayRef<const RVec> x, double gmx_unused t)
+    void localContribution(const t_commrec&     cr,
+                           const t_mdatoms&     mdatoms,
+                           ArrayRef<const RVec> x,
+                           const t_pbc*         pbc,
+                           double*              buffer) const;
+
+    /*! \brief Set the position of the site from the reduced buffer.
+     *
+     * Also makes the new position the reference for the next evaluation.
+     *
+     * \param buffer c_bufferStride elements of the reduced weighted position and weight.
+     * \throws InternalError if the total weight of the site is not positive.
+     */
+    void setPosition(const double* buffer);
+
+    //! Get the position set with the last call to setPosition().
+    const RVec& position() const { return position_; }
+
+    /*!
+     * \brief Distribute a force acting on the site over its home atoms.
+     *
+     * \param cr Communications record.
+     * \param mdatoms Local atom data, masses are used for multi-atom sites.
+     * \param f Force acting on the site.
+     * \param[in,out] force Local force array to add to.
+     */
+    void spreadForce(const t_commrec& cr, const t_mdatoms& mdatoms, const RVec& f, ArrayRef<RVec> force) const;
+
+private:
+    /*! \brief Call \p function with the local and collective index of each home atom.
+     *
+     * Uses the LocalAtomSet when available. Otherwise falls back to looking up
+     * each atom with domain decomposition, or to the global indices without.
+     */
+    template<typename Function>
+    void forEachHomeAtom(const t_commrec& cr, Function&& function) const
     {
-        // Center of mass to return for the site. Currently the only form of site
-        // implemented is as a global atomic coordinate.
-        gmx::RVec r = { 0, 0, 0 };
-        if (DOMAINDECOMP(&cr)) // Domain decomposition
+        if (localAtomSet_)
         {
-            // Get global-to-local indexing structure
-            auto crossRef = cr.dd->ga2la;
-            GMX_ASSERT(crossRef, "Domain decomposition must provide global/local cross-reference.");
-            if (const auto localIndex = crossRef->findHome(index_))
+            const auto localIndex      = localAtomSet_->localIndex();
+            const auto collectiveIndex = localAtomSet_->collectiveIndex();
+            for (size_t i = 0; i < localIndex.size(); ++i)
             {
-                GMX_ASSERT(localIndex,
-                           "Expect not to reach this point if findHome does not find index_.");
-                GMX_ASSERT(*localIndex < static_cast<decltype(*localIndex)>(nx),
-                           "We assume that the local index cannot be larger than the number of "
-                           "atoms.");
-                GMX_ASSERT(*localIndex >= 0, "localIndex is a signed type, but is assumed >0.");
-                // If atom is local, get its location
-                copy_rvec(x[*localIndex], r);
+                function(localIndex[i], collectiveIndex[i]);
             }
-            else
+        }
+        else if (DOMAINDECOMP(&cr))
+        {
+            GMX_ASSERT(cr.dd->ga2la, "Domain decomposition must provide global/local cross-reference.");
+            for (int i = 0; i < ssize(globalIndex_); ++i)
             {
-                // Nothing to contribute on this rank. Leave position == [0,0,0].
+                if (const int* localIndex = cr.dd->ga2la->findHome(globalIndex_[i]))
+                {
+                    function(*localIndex, i);
+                }
             }
-            // AllReduce across the ranks of the simulation to get the center-of-mass
-            // of the site locally available everywhere. For single-atom sites, this
-            // is trivial: exactly one rank should have a non-zero position.
-            // For future multi-atom selections,
-            // we will receive weighted center-of-mass contributions from
-            // each rank and combine to get the global center of mass.
-            // \todo use generalized "pull group" facility when available.
-            std::array<double, 3> buffer{ { r[0], r[1], r[2] } };
-            // This should be an all-reduce sum, which gmx_sumd appears to be.
-            gmx_sumd(3, buffer.data(), &cr);
-            r[0] = static_cast<real>(buffer[0]);
-            r[1] = static_cast<real>(buffer[1]);
-            r[2] = static_cast<real>(buffer[2]);
-
-        } // end domain decomposition branch
+        }
         else
         {
-            // No DD so all atoms are local.
-            copy_rvec(x[index_], r);
-            (void)nx;
+            for (int i = 0; i < ssize(globalIndex_); ++i)
+            {
+                function(globalIndex_[i], i);
+            }
         }
-        // Update cache and cache status.
-        copy_rvec(r, r_);
-
-        return r_;
     }
 
-private:
-    /*!
-     * \brief Global index of the single-atom site.
-     *
-     * \todo This class should be a specialization of a more general Site data source.
-     * \todo use LocalAtomSet
-     */
-    const int index_;
+    //! Effective weight of an atom of a multi-atom site.
+    real atomWeight(const t_mdatoms& mdatoms, int localIndex, int collectiveIndex) const
+    {
+        GMX_ASSERT(mdatoms.massT, "Multi-atom sites need atom masses.");
+        return (weights_.empty() ? 1 : weights_[collectiveIndex]) * mdatoms.massT[localIndex];
+    }
 
-    /*!
-     * \brief Last known value of the center-of-mass.
-     *
-     * Updated with centerOfMass().
-     */
-    RVec r_;
+    //! Global indices of the atoms in the site.
+    std::vector<int> globalIndex_;
+    //! Relative weights of the atoms, empty for mass weighting only.
+    std::vector<real> weights_;
+    //! Home atoms of the site, when provided by the simulation.
+    std::optional<LocalAtomSet> localAtomSet_;
+    //! Whether reference_ has been set.
+    bool haveReference_ = false;
+    //! Reference position for making multi-atom sites whole.
+    RVec reference_ = { 0, 0, 0 };
+    //! Last known position of the site.
+    RVec position_ = { 0, 0, 0 };
+    //! Sum of the effective weights of all atoms of the site.
+    double totalWeight_ = 1;
 };
 
 /*! \internal
@@ -201,28 +274,75 @@ private:
  *
  * Adapter class from IForceProvider to IRestraintPotential.
  * Objects of this type are uniquely owned by instances of RestraintMDModuleImpl. The object will
- * dispatch calls to IForceProvider->calculateForces() to the functor managed by
- * RestraintMDModuleImpl. \ingroup module_restraint
+ * dispatch calls to IForceProvider->calculateForces() to the functors managed by
+ * RestraintMDModuleImpl.
+ *
+ * All restraints of a simulation are handled by a single provider so that
+ * the positions of their sites can be gathered into one packed buffer and,
+ * with domain decomposition, reduced with a single collective per step.
+ * Sites shared by several restraints are gathered only once.
+ *
+ * \ingroup module_restraint
  */
 class RestraintForceProvider final : public gmx::IForceProvider
 {
 public:
-    /*!
-     * \brief Can only be constructed when initialized from a restraint.
-     */
-    RestraintForceProvider() = delete;
+    RestraintForceProvider() = default;
 
     ~RestraintForceProvider() = default;
 
     /*!
-     * \brief RAII construction with an IRestraintPotential
+     * \brief Add a restraint to be evaluated by this provider.
      *
      * Note, this object must outlive the pointer that will be provided to ForceProviders.
      * \param restraint handle to an object providing restraint potential calculation
-     * \param sites List of atomic site indices
+     * \param sitePaths List of site paths, one per site pair of the restraint
+     * \param evaluationPeriod Number of MD steps between evaluations of the restraint
+     * \param name Name of the restraint in the timing report, or empty for a numbered default.
+     * \throws InvalidInputError if a path has a single site, a site is invalid
+     *         or the evaluation period is not positive.
+     */
+    void addRestraint(std::shared_ptr<gmx::IRestraintPotential>     restraint,
+                      const std::vector<std::vector<AtomGroupSite>>& sitePaths,
+                      int                                            evaluationPeriod = 1,
+                      const std::string&                             name             = {});
+
+    /*!
+     * \brief Construct local atom sets for all sites.
+     *
+     * \param localAtomSetManager the manager to add local atom sets to.
      */
-    explicit RestraintForceProvider(std::shared_ptr<gmx::IRestraintPotential> restraint,
-                                    const std::vector<int>&                   sites);
+    void setLocalAtomSets(LocalAtomSetManager* localAtomSetManager);
+
+    /*!
+     * \brief Set the cycle counting used to time the restraint work.
+     *
+     * Registers named sub-counters for the force evaluation, the update
+     * call-backs and the ensemble reductions of each restraint.
+     *
+     * \param wcycle cycle counting of the simulation, may be nullptr.
+     */
+    void setWallcycle(gmx_wallcycle* wcycle);
+
+    //! Get the cycle counting of the simulation, nullptr if not set.
+    gmx_wallcycle* wallcycle() const { return wcycle_; }
+
+    /*!
+     * \brief Get the time spent in the call-backs of each restraint.
+     *
+     * \param secondsPerCycle conversion of the cycle counts to wall time.
+     * \return the timings, in the order the restraints were added.
+     */
+    std::vector<RestraintTiming> timings(double secondsPerCycle) const;
+
+    //! Get the number of restraints handled by this provider.
+    size_t numRestraints() const { return restraints_.size(); }
+
+    //! Get the number of distinct sites of all restraints of this provider.
+    size_t numSites() const { return sites_.size(); }
+
+    //! Get the number of sites gathered at the last step where a restraint was due.
+    size_t numGatheredSites() const { return dueSites_.size(); }
 
     /*!
      * \brief Implement the IForceProvider interface.
@@ -238,25 +358,108 @@ public:
      * This would be an invalid assumption if, say, several restraints applied
      * to an entire membrane or the entire solvent group.
      *
-     * If the assumption causes performance problems, we can look for a good
-     * way to reduce from several restraints in a single pass or a very
-     * lightweight way to determine whether a given restraint applies to a given atom.
-     * There is also the notion in the pulling code of a limited number of
-     * "pull groups" used by the "pull coordinates".
-     * The right optimization will depend on how the code is being used.
+     * Only restraints whose evaluation period divides the current step are
+     * evaluated, and their forces are scaled by the evaluation period. If no
+     * restraint is due, nothing is done, in particular no communication.
+     *
+     * The positions of the sites of the restraints that are due are gathered
+     * first, with a single reduction under domain decomposition. Each rank only sums over
+     * the home atoms of the sites. Then the update() hooks
+     * of all restraints are called on the master rank, followed by a single
+     * barrier, and then the evaluator(s) for the restraints are called.
      *
-     * Call the evaluator(s) for the restraints for the configured sites.
      * Forces are applied to atoms in the first and last site listed.
      * Intermediate sites are used as reference coordinates when the relevant
      * vector between sites is on the order of half a box length or otherwise
      * ambiguous in the case of periodic boundary conditions.
+     *
+     * Finally, restraints that use the local atoms get views of the home
+     * coordinates and of the force buffer. Their forces are accumulated in
+     * a separate buffer only when they need to be scaled.
      */
     void calculateForces(const ForceProviderInput& forceProviderInput,
                          ForceProviderOutput*      forceProviderOutput) override;
 
 private:
-    std::shared_ptr<gmx::IRestraintPotential> restraint_;
-    std::vector<Site>                         sites_;
+    /*!
+     * \brief Select the sites of the restraints that are due at \p step.
+     *
+     * Sites shared with restraints that are not due are selected once.
+     */
+    void selectDueSites(int64_t step);
+
+    /*!
+     * \brief Update the positions of the sites selected with selectDueSites().
+     *
+     * Local contributions are written to a packed buffer that is summed over
+     * the ranks of the simulation with a single collective. Before the first
+     * evaluation of a multi-atom site, one more collective sets up its reference.
+     */
+    void gatherSitePositions(const t_commrec&     cr,
+                             const t_mdatoms&     mdatoms,
+                             ArrayRef<const RVec> x,
+                             const t_pbc*         pbc);
+
+    /*! \internal
+     * \brief A restraint, the slots of its sites in RestraintForceProvider::sites_
+     * and the buffers for its batched evaluation.
+     */
+    struct RestraintEntry
+    {
+        //! Restraint potential to evaluate.
+        std::shared_ptr<gmx::IRestraintPotential> restraint;
+        //! For each pair, indices into sites_ in the order of the path of the pair.
+        std::vector<std::vector<size_t>> paths;
+        //! Structure-of-arrays positions of the pairs, first the DIM arrays for r1, then for r2.
+        std::vector<real> positions;
+        //! Structure-of-arrays forces and energies of the pairs.
+        std::vector<real> forcesAndEnergies;
+        //! View of the buffers, as passed to the restraint.
+        PairBatch batch;
+        //! Number of MD steps between evaluations.
+        int evaluationPeriod = 1;
+        //! Whether the restraint gets views of the home atoms.
+        bool usesLocalAtoms = false;
+        //! Name of the restraint in the timing report.
+        std::string name;
+        //! Sub-counter of the force evaluation call-backs, -1 when not timed.
+        int evaluationCounter = -1;
+        //! Sub-counter of the update call-backs, -1 when not timed.
+        int updateCounter = -1;
+        //! Sub-counter of the ensemble reductions in the update call-backs, -1 when not timed.
+        int reductionCounter = -1;
+    };
+
+    /*! \brief Fill the input positions of the pairs of a restraint.
+     *
+     * \param[in,out] entry restraint to prepare.
+     * \param pbc Periodic boundary information.
+     */
+    void preparePairs(RestraintEntry* entry, const t_pbc& pbc) const;
+
+    /*! \brief Get the global indices of the home atoms.
+     *
+     * \param cr Communication record of the simulation.
+     * \param numHomeAtoms Number of home atoms.
+     */
+    ArrayRef<const int> homeAtomGlobalIndices(const t_commrec& cr, int numHomeAtoms);
+
+    //! Registered restraints.
+    std::vector<RestraintEntry> restraints_;
+    //! Distinct sites of all restraints.
+    std::vector<Site> sites_;
+    //! Whether each site is used by a restraint that is due at the current step.
+    std::vector<bool> siteIsDue_;
+    //! Indices into sites_ of the sites gathered at the current step.
+    std::vector<size_t> dueSites_;
+    //! Packed buffer of partial site positions and weights for the reduction.
+    std::vector<double> siteBuffer_;
+    //! Global indices of the home atoms without domain decomposition.
+    std::vector<int> identityIndices_;
+    //! Forces of restraints using the local atoms that are scaled before they are applied.
+    std::vector<RVec> localForceBuffer_;
+    //! Cycle counting, may be nullptr.
+    gmx_wallcycle* wcycle_ = nullptr;
 };
 
 /*! \internal
@@ -279,6 +482,20 @@ public:
     RestraintMDModuleImpl(std::shared_ptr<gmx::IRestraintPotential> restraint,
                           const std::vector<int>&                   sites);
 
+    /*!
+     * \brief Wrap several objects implementing IRestraintPotential.
+     *
+     * The sites of each restraint are obtained from IRestraintPotential::sitePaths().
+     *
+     * \param restraints handles to restraints to wrap.
+     * \param evaluationPeriods number of MD steps between evaluations of each restraint,
+     *                          or empty to evaluate all restraints every step.
+     * \param names name of each restraint in the timing report, or empty for numbered defaults.
+     */
+    RestraintMDModuleImpl(ArrayRef<const std::shared_ptr<gmx::IRestraintPotential>> restraints,
+                          ArrayRef<const int>                                        evaluationPeriods,
+                          ArrayRef<const std::string>                                names);
+
     /*!
      * \brief Allow moves.
      *
@@ -54,12 +54,15 @@
  * \ingroup module_restraint
  */
 
+#include <cstdint>
+
 #include <functional>
 #include <memory>
 #include <ostream>
 #include <vector>
 
 #include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
 
 // TODO: Get from a header once the public API settles down a bit.
 namespace gmxapi
@@ -116,6 +119,82 @@ public:
     real energy;
 };
 
+/*!
+ * \brief Definition of a restraint site as a group of atoms.
+ *
+ * The position of the site is the center of mass of the atoms. As for pull
+ * groups, each atom can be given an additional relative weight, so that the
+ * effective weight of an atom is its mass multiplied by its weight.
+ * The force acting on the site is distributed over the atoms in proportion to
+ * their effective weights.
+ *
+ * A site with a single atom is located at that atom, independent of masses and weights.
+ *
+ * \ingroup module_restraint
+ */
+struct AtomGroupSite
+{
+    //! Global indices of the atoms in the site.
+    std::vector<int> indices;
+    //! Relative weights of the atoms, or empty for pure mass weighting.
+    std::vector<real> weights;
+};
+
+/*!
+ * \brief Structure-of-arrays view of the site pairs of a restraint.
+ *
+ * Used for batched evaluation of all pairs of a restraint with a single call.
+ * Element \c i of each array refers to pair \c i. The input coordinates are
+ * the positions of the first and (unwrapped) second site of each pair, as
+ * passed to the scalar IRestraintPotential::evaluate(). The output arrays are
+ * to be filled by IRestraintPotential::evaluateBatch() with the force acting
+ * on the first site and the potential energy of each pair.
+ *
+ * Each array is contiguous, so that a loop over the pairs can be vectorized
+ * by the compiler.
+ *
+ * \ingroup module_restraint
+ */
+struct PairBatch
+{
+    //! Number of pairs.
+    size_t size = 0;
+    //! Components of the position of the first site of each pair.
+    const real* r1[DIM] = { nullptr, nullptr, nullptr };
+    //! Components of the position of the second site of each pair.
+    const real* r2[DIM] = { nullptr, nullptr, nullptr };
+    //! Components of the force acting on the first site of each pair.
+    real* force[DIM] = { nullptr, nullptr, nullptr };
+    //! Potential energy of each pair.
+    real* energy = nullptr;
+};
+
+/*!
+ * \brief Read-only view of the home atoms of a rank during an MD step.
+ *
+ * The arrays refer to the simulation data without copies, and are only valid
+ * during the call that receives the view. With domain decomposition, each rank
+ * only sees its home atoms, in an order that changes when atoms are
+ * redistributed. \c globalIndex maps them to the atom indices of the input.
+ *
+ * \ingroup module_restraint
+ */
+struct LocalAtomsView
+{
+    //! Simulation time in picoseconds.
+    double time = 0;
+    //! MD step.
+    int64_t step = 0;
+    //! The three box vectors.
+    ArrayRef<const RVec> box;
+    //! Coordinates of the home atoms.
+    ArrayRef<const RVec> x;
+    //! Global index of each home atom.
+    ArrayRef<const int> globalIndex;
+    //! Mass of each home atom.
+    ArrayRef<const real> mass;
+};
+
 /*!
  * \brief Interface for Restraint potentials.
  *
@@ -126,6 +205,10 @@ public:
  * restraints will be programmed by subclassing gmx::RestraintPotential<>
  * rather than gmx::IRestraintPotential.
  *
+ * A restraint may act on several pairs of sites, declared with sitePaths().
+ * All pairs of a restraint are evaluated with one call to evaluateBatch(),
+ * which receives structure-of-arrays input and output buffers.
+ *
  * For a set of \f$n\f$ coordinates, generate a force field according to a
  * scalar potential that is a fun. \f$F_i = - \nabla_{q_i} \Phi (q_0, q_1, ... q_n; t)\f$
  *
@@ -165,10 +248,36 @@ public:
      * \param t simulation time in picoseconds
      * \return force vector and potential energy to be applied by calling code.
      *
-     * \todo The virtual function call should be replaced by a (table of) function objects retrieved before the run.
+     * \note Restraints acting on many pairs should override evaluateBatch() or derive
+     * from gmx::RestraintPotential<> to avoid a virtual call per pair.
      */
     virtual PotentialPointData evaluate(Vector r1, Vector r2, double t) = 0;
 
+    /*!
+     * \brief Calculate forces and energies for all site pairs of the restraint.
+     *
+     * Called by the framework once per evaluation with the positions of all pairs
+     * from sitePaths(). If not overridden by derived class, calls evaluate() for
+     * each pair. Derive from gmx::RestraintPotential<> to get an implementation
+     * without virtual calls per pair.
+     *
+     * \param pairs input positions and output forces and energies.
+     * \param t simulation time in picoseconds
+     */
+    virtual void evaluateBatch(const PairBatch& pairs, double t)
+    {
+        for (size_t i = 0; i < pairs.size; ++i)
+        {
+            const auto result =
+                    evaluate(Vector(pairs.r1[XX][i], pairs.r1[YY][i], pairs.r1[ZZ][i]),
+                             Vector(pairs.r2[XX][i], pairs.r2[YY][i], pairs.r2[ZZ][i]), t);
+            pairs.force[XX][i] = result.force[XX];
+            pairs.force[YY][i] = result.force[YY];
+            pairs.force[ZZ][i] = result.force[ZZ];
+            pairs.energy[i]    = result.energy;
+        }
+    }
+
 
     /*!
      * \brief Call-back hook for restraint implementations.
@@ -199,6 +308,26 @@ public:
         (void)t;
     }
 
+    /*!
+     * \brief Call-back hook for all site pairs of the restraint.
+     *
+     * Called on the simulation master rank with the input positions of all
+     * pairs from sitePaths(), before evaluateBatch(). The output arrays of
+     * \p pairs are not to be used. If not overridden by derived class, calls
+     * update() for each pair.
+     *
+     * \param pairs input positions of the pairs.
+     * \param t simulation time
+     */
+    virtual void updateBatch(const PairBatch& pairs, double t)
+    {
+        for (size_t i = 0; i < pairs.size; ++i)
+        {
+            update(Vector(pairs.r1[XX][i], pairs.r1[YY][i], pairs.r1[ZZ][i]),
+                   Vector(pairs.r2[XX][i], pairs.r2[YY][i], pairs.r2[ZZ][i]), t);
+        }
+    }
+
 
     /*!
      * \brief Find out what sites this restraint is configured to act on.
@@ -206,6 +335,72 @@ public:
      */
     virtual std::vector<int> sites() const = 0;
 
+    /*!
+     * \brief Find out what groups of atoms this restraint is configured to act on.
+     *
+     * Each group is reduced to its (weighted) center of mass before the restraint
+     * is evaluated, so a restraint between, e.g., the centers of two protein domains
+     * needs a single pair evaluation rather than one restraint per atom pair.
+     *
+     * If not overridden by derived class, each site from sites() is a single-atom group.
+     *
+     * \return the site definitions, in the same order as used by evaluate().
+     */
+    virtual std::vector<AtomGroupSite> siteGroups() const
+    {
+        std::vector<AtomGroupSite> groups;
+        for (const int index : sites())
+        {
+            groups.push_back({ { index }, {} });
+        }
+        return groups;
+    }
+
+    /*!
+     * \brief Find out what site pairs this restraint is configured to act on.
+     *
+     * Each path is a list of at least two sites. Empty paths are ignored. The pair built from a path has
+     * the first site as its first position. The second position is the last site,
+     * reached by following the minimum image vectors between consecutive sites
+     * of the path. Forces are applied to the first and last site of each path.
+     *
+     * A restraint acting on many pairs is evaluated with a single call to
+     * evaluateBatch() per step.
+     *
+     * If not overridden by derived class, the restraint has a single path given by siteGroups().
+     *
+     * \return the site paths, in the order of the pairs in evaluateBatch().
+     */
+    virtual std::vector<std::vector<AtomGroupSite>> sitePaths() const { return { siteGroups() }; }
+
+    /*!
+     * \brief Whether calculateLocalForces() is to be called.
+     *
+     * Queried once, when the restraint is added to the simulation.
+     *
+     * \return false, if not overridden by derived class.
+     */
+    virtual bool usesLocalAtoms() const { return false; }
+
+    /*!
+     * \brief Calculate forces with direct access to the home atoms of this rank.
+     *
+     * Called once per evaluation on every rank of the simulation, after
+     * evaluateBatch(), if usesLocalAtoms() returns true. The coordinates and
+     * the force buffer are those of the simulation, so a restraint acting on
+     * many atoms, such as a machine-learned bias, can be evaluated with a
+     * single call instead of one call per site pair. A restraint that only
+     * uses this function returns no sites.
+     *
+     * \param atoms coordinates of the home atoms of this rank.
+     * \param force forces of the home atoms, to which the restraint adds its contribution.
+     */
+    virtual void calculateLocalForces(const LocalAtomsView& atoms, ArrayRef<RVec> force)
+    {
+        (void)atoms;
+        (void)force;
+    }
+
     /*!
      * \brief Allow Session-mediated interaction with other resources or workflow elements.
      *
@@ -220,6 +415,54 @@ public:
     virtual void bindSession(gmxapi::SessionResources* resources) { (void)resources; }
 };
 
+/*!
+ * \brief Convenience base class for restraint potentials.
+ *
+ * Derived classes provide a non-virtual member function
+ * \code
+ * PotentialPointData calculate(Vector r1, Vector r2, double t);
+ * \endcode
+ * with the semantics of IRestraintPotential::evaluate(). This template uses
+ * the curiously recurring template pattern to implement both evaluate() and
+ * evaluateBatch() with calls to calculate() that the compiler can inline, so
+ * that the batched evaluation of many pairs is a single virtual call to a
+ * loop that is free of indirect calls.
+ *
+ * \tparam Derived the class implementing calculate().
+ *
+ * \ingroup module_restraint
+ */
+template<class Derived>
+class RestraintPotential : public IRestraintPotential
+{
+public:
+    //! Implement IRestraintPotential::evaluate() with Derived::calculate().
+    PotentialPointData evaluate(Vector r1, Vector r2, double t) final
+    {
+        return derived().calculate(r1, r2, t);
+    }
+
+    //! Implement IRestraintPotential::evaluateBatch() with a loop over Derived::calculate().
+    void evaluateBatch(const PairBatch& pairs, double t) final
+    {
+        Derived& potential = derived();
+        for (size_t i = 0; i < pairs.size; ++i)
+        {
+            const PotentialPointData result =
+                    potential.calculate(Vector(pairs.r1[XX][i], pairs.r1[YY][i], pairs.r1[ZZ][i]),
+                                        Vector(pairs.r2[XX][i], pairs.r2[YY][i], pairs.r2[ZZ][i]), t);
+            pairs.force[XX][i] = result.force[XX];
+            pairs.force[YY][i] = result.force[YY];
+            pairs.force[ZZ][i] = result.force[ZZ];
+            pairs.energy[i]    = result.energy;
+        }
+    }
+
+private:
+    //! Access the derived class.
+    Derived& derived() { return static_cast<Derived&>(*this); }
+};
+
 } // end namespace gmx
 
 #endif // GMX_PULLING_PULLPOTENTIAL_H
@@ -39,6 +39,8 @@
 
 #include <gtest/gtest.h>
 
+#include "gromacs/utility/exceptions.h"
+
 namespace
 {
 
@@ -76,4 +78,18 @@ TEST(RestraintManager, restraintList)
     EXPECT_EQ(managerInstance.countRestraints(), 2);
 }
 
+TEST(RestraintManager, evaluationPeriods)
+{
+    auto managerInstance = gmx::RestraintManager();
+    managerInstance.addToSpec(std::make_shared<DummyRestraint>(), "a");
+    managerInstance.addToSpec(std::make_shared<DummyRestraint>(), "b", 10);
+    const std::vector<int> expected = { 1, 10 };
+    EXPECT_EQ(managerInstance.getEvaluationPeriods(), expected);
+    EXPECT_THROW(managerInstance.addToSpec(std::make_shared<DummyRestraint>(), "c", 0),
+                 gmx::InvalidInputError);
+    EXPECT_EQ(managerInstance.countRestraints(), 2);
+    managerInstance.clear();
+    EXPECT_TRUE(managerInstance.getEvaluationPeriods().empty());
+}
+
 } // end namespace
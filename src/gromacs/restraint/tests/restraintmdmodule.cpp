@@ -0,0 +1,465 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the RestraintMDModule force provider.
+ *
+ * \ingroup module_restraint
+ */
+#include "gmxpre.h"
+
+#include "gromacs/restraint/restraintmdmodule.h"
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/paddedvector.h"
+#include "gromacs/mdtypes/commrec.h"
+#include "gromacs/mdtypes/enerdata.h"
+#include "gromacs/mdtypes/forceoutput.h"
+#include "gromacs/mdtypes/iforceprovider.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/restraint/restraintmdmodule_impl.h"
+#include "gromacs/timing/wallcycle.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+/*! \brief Harmonic pair restraint with unit spring constant.
+ *
+ * Counts calls to update() so that tests can check the call-backs.
+ */
+class HarmonicRestraint : public IRestraintPotential
+{
+public:
+    explicit HarmonicRestraint(std::vector<int> sites) : sites_(std::move(sites)) {}
+
+    PotentialPointData evaluate(Vector r1, Vector r2, double gmx_unused t) override
+    {
+        const Vector dr = r2 - r1;
+        return { dr, real(0.5) * dr.norm2() };
+    }
+
+    void update(Vector gmx_unused v, Vector gmx_unused v0, double gmx_unused t) override
+    {
+        ++numUpdates_;
+        if (waitsForReduction_)
+        {
+            RestraintReductionTimer timer;
+            // Nested timers, e.g. for several reductions at once, are not counted again.
+            RestraintReductionTimer nestedTimer;
+        }
+    }
+
+    std::vector<int> sites() const override { return sites_; }
+
+    std::vector<AtomGroupSite> siteGroups() const override
+    {
+        return groups_.empty() ? IRestraintPotential::siteGroups() : groups_;
+    }
+
+    int numUpdates_ = 0;
+
+    //! Whether update() times an ensemble reduction.
+    bool waitsForReduction_ = false;
+
+    //! Optional multi-atom site definitions.
+    std::vector<AtomGroupSite> groups_;
+
+private:
+    std::vector<int> sites_;
+};
+
+/*! \brief Harmonic restraint acting on several pairs, evaluated in batches.
+ *
+ * Uses gmx::RestraintPotential so that the batched evaluation does not go
+ * through IRestraintPotential::evaluate().
+ */
+class MultiPairRestraint : public RestraintPotential<MultiPairRestraint>
+{
+public:
+    explicit MultiPairRestraint(std::vector<std::vector<AtomGroupSite>> paths) :
+        paths_(std::move(paths))
+    {
+    }
+
+    PotentialPointData calculate(Vector r1, Vector r2, double gmx_unused t)
+    {
+        ++numCalculations_;
+        const Vector dr = r2 - r1;
+        return { dr, real(0.5) * dr.norm2() };
+    }
+
+    void updateBatch(const PairBatch& pairs, double gmx_unused t) override
+    {
+        lastNumPairs_ = pairs.size;
+    }
+
+    std::vector<int> sites() const override { return {}; }
+
+    std::vector<std::vector<AtomGroupSite>> sitePaths() const override { return paths_; }
+
+    int    numCalculations_ = 0;
+    size_t lastNumPairs_    = 0;
+
+private:
+    std::vector<std::vector<AtomGroupSite>> paths_;
+};
+
+/*! \brief Restraint pulling all atoms towards the origin through the local atom views.
+ *
+ * Has no sites, so that no pair is evaluated.
+ */
+class LocalAtomsRestraint : public IRestraintPotential
+{
+public:
+    PotentialPointData evaluate(Vector gmx_unused r1, Vector gmx_unused r2, double gmx_unused t) override
+    {
+        return {};
+    }
+
+    std::vector<int> sites() const override { return {}; }
+
+    std::vector<std::vector<AtomGroupSite>> sitePaths() const override { return { {} }; }
+
+    bool usesLocalAtoms() const override { return true; }
+
+    void calculateLocalForces(const LocalAtomsView& atoms, ArrayRef<RVec> force) override
+    {
+        ++numCalls_;
+        lastGlobalIndex_ = { atoms.globalIndex.begin(), atoms.globalIndex.end() };
+        lastBoxX_        = atoms.box[XX][XX];
+        for (size_t i = 0; i < atoms.x.size(); ++i)
+        {
+            force[i] -= atoms.x[i];
+        }
+    }
+
+    int              numCalls_ = 0;
+    std::vector<int> lastGlobalIndex_;
+    real             lastBoxX_ = 0;
+};
+
+TEST(RestraintForceProvider, SharedSitesAreGatheredOnce)
+{
+    RestraintForceProvider provider;
+    const std::vector<AtomGroupSite> sitesA = { { { 0 }, {} }, { { 1 }, {} } };
+    const std::vector<AtomGroupSite> sitesB = { { { 1 }, {} }, { { 2 }, {} } };
+    provider.addRestraint(std::make_shared<HarmonicRestraint>(std::vector<int>{ 0, 1 }), { sitesA });
+    provider.addRestraint(std::make_shared<HarmonicRestraint>(std::vector<int>{ 1, 2 }), { sitesB });
+    EXPECT_EQ(provider.numRestraints(), 2);
+    EXPECT_EQ(provider.numSites(), 3);
+}
+
+TEST(RestraintForceProvider, TimesEachRestraintAndItsReductions)
+{
+    RestraintForceProvider                          provider;
+    const std::vector<AtomGroupSite>                sites = { { { 0 }, {} }, { { 1 }, {} } };
+    const int                                       numRestraints = 20;
+    std::vector<std::shared_ptr<HarmonicRestraint>> restraints;
+    for (int i = 0; i < numRestraints; ++i)
+    {
+        restraints.push_back(std::make_shared<HarmonicRestraint>(std::vector<int>{ 0, 1 }));
+        provider.addRestraint(restraints.back(), { sites }, 1, "restraint");
+    }
+    restraints[1]->waitsForReduction_ = true;
+    t_commrec       cr{};
+    gmx_wallcycle_t wcycle = wallcycle_init(nullptr, 0, &cr);
+    if (wcycle == nullptr)
+    {
+        return;
+    }
+    provider.setWallcycle(wcycle);
+
+    std::vector<RVec> x = { { 1, 1, 1 }, { 2, 1, 1 } };
+    t_mdatoms         md{};
+    md.homenr = ssize(x);
+    matrix box = { { 10, 0, 0 }, { 0, 10, 0 }, { 0, 0, 10 } };
+    for (int64_t step = 0; step < 2; ++step)
+    {
+        ForceProviderInput  forceProviderInput(x, md, 0.0, step, box, cr);
+        PaddedVector<RVec>  f = { { 0, 0, 0 }, { 0, 0, 0 } };
+        ForceWithVirial     forceWithVirial(f, true);
+        gmx_enerdata_t      enerdDummy(1, 0);
+        ForceProviderOutput forceProviderOutput(&forceWithVirial, &enerdDummy);
+        provider.calculateForces(forceProviderInput, &forceProviderOutput);
+    }
+    // Outside of an update call-back, the timer does nothing.
+    {
+        RestraintReductionTimer timer;
+    }
+
+    // Restraints with the same name are reported separately, in the order they were added.
+    const auto timings = provider.timings(1.0);
+    ASSERT_EQ(ssize(timings), numRestraints);
+    for (int i = 0; i < numRestraints; ++i)
+    {
+        EXPECT_EQ(timings[i].numEvaluations, 2) << "restraint " << i;
+        EXPECT_EQ(timings[i].numUpdates, 2) << "restraint " << i;
+        EXPECT_EQ(timings[i].numReductions, i == 1 ? 2 : 0) << "restraint " << i;
+    }
+    wallcycle_destroy(wcycle);
+}
+
+TEST(RestraintForceProvider, RejectsSingleSite)
+{
+    RestraintForceProvider provider;
+    const std::vector<AtomGroupSite> sites = { { { 0 }, {} } };
+    EXPECT_THROW_GMX(provider.addRestraint(std::make_shared<HarmonicRestraint>(std::vector<int>{ 0 }), { sites }),
+                     InvalidInputError);
+}
+
+TEST(RestraintForceProvider, RejectsMismatchedWeights)
+{
+    RestraintForceProvider           provider;
+    const std::vector<AtomGroupSite> sites = { { { 0, 1 }, { 1 } }, { { 2 }, {} } };
+    EXPECT_THROW_GMX(provider.addRestraint(std::make_shared<HarmonicRestraint>(std::vector<int>{ 0, 2 }), { sites }),
+                     InvalidInputError);
+}
+
+TEST(RestraintMDModule, AppliesForcesOfAllRestraints)
+{
+    auto restraintA = std::make_shared<HarmonicRestraint>(std::vector<int>{ 0, 1 });
+    auto restraintB = std::make_shared<HarmonicRestraint>(std::vector<int>{ 1, 2 });
+    const std::vector<std::shared_ptr<IRestraintPotential>> restraints{ restraintA, restraintB };
+    auto module = RestraintMDModule::create(restraints);
+
+    std::vector<RVec> x = { { 1, 1, 1 }, { 2, 1, 1 }, { 2, 3, 1 } };
+    t_mdatoms         md{};
+    md.homenr = ssize(x);
+    t_commrec          cr{};
+    matrix             box = { { 10, 0, 0 }, { 0, 10, 0 }, { 0, 0, 10 } };
+    ForceProviderInput forceProviderInput(x, md, 0.0, 0, box, cr);
+
+    PaddedVector<RVec>  f = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+    ForceWithVirial     forceWithVirial(f, true);
+    gmx_enerdata_t      enerdDummy(1, 0);
+    ForceProviderOutput forceProviderOutput(&forceWithVirial, &enerdDummy);
+
+    ForceProviders forceProviders;
+    module->initForceProviders(&forceProviders);
+    forceProviders.calculateForces(forceProviderInput, &forceProviderOutput);
+
+    FloatingPointTolerance tolerance(defaultRealTolerance());
+    EXPECT_REAL_EQ_TOL(f[0][XX], 1, tolerance);
+    EXPECT_REAL_EQ_TOL(f[1][XX], -1, tolerance);
+    EXPECT_REAL_EQ_TOL(f[1][YY], 2, tolerance);
+    EXPECT_REAL_EQ_TOL(f[2][YY], -2, tolerance);
+    EXPECT_REAL_EQ_TOL(f[2][XX], 0, tolerance);
+    EXPECT_EQ(restraintA->numUpdates_, 1);
+    EXPECT_EQ(restraintB->numUpdates_, 1);
+}
+
+TEST(RestraintMDModule, AppliesForcesToMassWeightedGroups)
+{
+    auto restraint     = std::make_shared<HarmonicRestraint>(std::vector<int>{ 0, 2 });
+    restraint->groups_ = { { { 0, 1 }, {} }, { { 2 }, {} } };
+    const std::vector<std::shared_ptr<IRestraintPotential>> restraints{ restraint };
+    auto module = RestraintMDModule::create(restraints);
+
+    std::vector<RVec> x    = { { 0, 0, 0 }, { 4, 0, 0 }, { 3, 2, 0 } };
+    std::vector<real> mass = { 1, 3, 1 };
+    t_mdatoms         md{};
+    md.homenr = ssize(x);
+    md.massT  = mass.data();
+    t_commrec          cr{};
+    matrix             box = { { 10, 0, 0 }, { 0, 10, 0 }, { 0, 0, 10 } };
+    ForceProviderInput forceProviderInput(x, md, 0.0, 0, box, cr);
+
+    PaddedVector<RVec>  f = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+    ForceWithVirial     forceWithVirial(f, true);
+    gmx_enerdata_t      enerdDummy(1, 0);
+    ForceProviderOutput forceProviderOutput(&forceWithVirial, &enerdDummy);
+
+    ForceProviders forceProviders;
+    module->initForceProviders(&forceProviders);
+    forceProviders.calculateForces(forceProviderInput, &forceProviderOutput);
+
+    // The group is centered at (3, 0, 0), so the restraint force is (0, 2, 0),
+    // spread over the group atoms by mass.
+    FloatingPointTolerance tolerance(defaultRealTolerance());
+    EXPECT_REAL_EQ_TOL(f[0][YY], 0.5, tolerance);
+    EXPECT_REAL_EQ_TOL(f[1][YY], 1.5, tolerance);
+    EXPECT_REAL_EQ_TOL(f[2][YY], -2, tolerance);
+    EXPECT_REAL_EQ_TOL(f[0][XX], 0, tolerance);
+    EXPECT_REAL_EQ_TOL(f[1][XX], 0, tolerance);
+}
+
+TEST(RestraintMDModule, EvaluatesAllPairsOfARestraintInOneBatch)
+{
+    auto restraint = std::make_shared<MultiPairRestraint>(std::vector<std::vector<AtomGroupSite>>{
+            { { { 0 }, {} }, { { 1 }, {} } }, { { { 1 }, {} }, { { 2 }, {} } } });
+    const std::vector<std::shared_ptr<IRestraintPotential>> restraints{ restraint };
+    auto module = RestraintMDModule::create(restraints);
+
+    std::vector<RVec> x = { { 1, 1, 1 }, { 2, 1, 1 }, { 2, 3, 1 } };
+    t_mdatoms         md{};
+    md.homenr = ssize(x);
+    t_commrec          cr{};
+    matrix             box = { { 10, 0, 0 }, { 0, 10, 0 }, { 0, 0, 10 } };
+    ForceProviderInput forceProviderInput(x, md, 0.0, 0, box, cr);
+
+    PaddedVector<RVec>  f = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+    ForceWithVirial     forceWithVirial(f, true);
+    gmx_enerdata_t      enerdDummy(1, 0);
+    ForceProviderOutput forceProviderOutput(&forceWithVirial, &enerdDummy);
+
+    ForceProviders forceProviders;
+    module->initForceProviders(&forceProviders);
+    forceProviders.calculateForces(forceProviderInput, &forceProviderOutput);
+
+    FloatingPointTolerance tolerance(defaultRealTolerance());
+    EXPECT_REAL_EQ_TOL(f[0][XX], 1, tolerance);
+    EXPECT_REAL_EQ_TOL(f[1][XX], -1, tolerance);
+    EXPECT_REAL_EQ_TOL(f[1][YY], 2, tolerance);
+    EXPECT_REAL_EQ_TOL(f[2][YY], -2, tolerance);
+    EXPECT_EQ(restraint->numCalculations_, 2);
+    EXPECT_EQ(restraint->lastNumPairs_, 2);
+}
+
+TEST(RestraintMDModule, AppliesScaledImpulsesWithEvaluationPeriod)
+{
+    auto restraint = std::make_shared<HarmonicRestraint>(std::vector<int>{ 0, 1 });
+    const std::vector<std::shared_ptr<IRestraintPotential>> restraints{ restraint };
+    const std::vector<int>                                  evaluationPeriods{ 4 };
+    auto module = RestraintMDModule::create(restraints, evaluationPeriods);
+
+    ForceProviders forceProviders;
+    module->initForceProviders(&forceProviders);
+
+    std::vector<RVec> x = { { 1, 1, 1 }, { 2, 1, 1 } };
+    t_mdatoms         md{};
+    md.homenr = ssize(x);
+    t_commrec              cr{};
+    matrix                 box = { { 10, 0, 0 }, { 0, 10, 0 }, { 0, 0, 10 } };
+    FloatingPointTolerance tolerance(defaultRealTolerance());
+    for (int64_t step = 0; step < 4; ++step)
+    {
+        ForceProviderInput  forceProviderInput(x, md, 0.0, step + 1, box, cr);
+        PaddedVector<RVec>  f = { { 0, 0, 0 }, { 0, 0, 0 } };
+        ForceWithVirial     forceWithVirial(f, true);
+        gmx_enerdata_t      enerdDummy(1, 0);
+        ForceProviderOutput forceProviderOutput(&forceWithVirial, &enerdDummy);
+        forceProviders.calculateForces(forceProviderInput, &forceProviderOutput);
+
+        // Only step 4 is due, where four times the force is applied.
+        const real expectedForce = (step + 1 == 4) ? 4 : 0;
+        EXPECT_REAL_EQ_TOL(f[0][XX], expectedForce, tolerance);
+        EXPECT_REAL_EQ_TOL(f[1][XX], -expectedForce, tolerance);
+    }
+    EXPECT_EQ(restraint->numUpdates_, 1);
+}
+
+TEST(RestraintForceProvider, GathersOnlySitesOfRestraintsThatAreDue)
+{
+    RestraintForceProvider           provider;
+    const std::vector<AtomGroupSite> sitesA = { { { 0 }, {} }, { { 1 }, {} } };
+    const std::vector<AtomGroupSite> sitesB = { { { 1 }, {} }, { { 2 }, {} } };
+    auto restraintA = std::make_shared<HarmonicRestraint>(std::vector<int>{ 0, 1 });
+    auto restraintB = std::make_shared<HarmonicRestraint>(std::vector<int>{ 1, 2 });
+    provider.addRestraint(restraintA, { sitesA }, 1);
+    provider.addRestraint(restraintB, { sitesB }, 2);
+
+    std::vector<RVec> x = { { 1, 1, 1 }, { 2, 1, 1 }, { 2, 3, 1 } };
+    t_mdatoms         md{};
+    md.homenr = ssize(x);
+    t_commrec              cr{};
+    matrix                 box = { { 10, 0, 0 }, { 0, 10, 0 }, { 0, 0, 10 } };
+    FloatingPointTolerance tolerance(defaultRealTolerance());
+    for (int64_t step = 1; step <= 2; ++step)
+    {
+        ForceProviderInput  forceProviderInput(x, md, 0.0, step, box, cr);
+        PaddedVector<RVec>  f = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+        ForceWithVirial     forceWithVirial(f, true);
+        gmx_enerdata_t      enerdDummy(1, 0);
+        ForceProviderOutput forceProviderOutput(&forceWithVirial, &enerdDummy);
+        provider.calculateForces(forceProviderInput, &forceProviderOutput);
+
+        // The site shared with restraint A is gathered once at step 2.
+        EXPECT_EQ(provider.numGatheredSites(), step == 2 ? 3 : 2) << "step " << step;
+        EXPECT_REAL_EQ_TOL(f[2][YY], step == 2 ? -4 : 0, tolerance);
+    }
+    EXPECT_EQ(restraintA->numUpdates_, 2);
+    EXPECT_EQ(restraintB->numUpdates_, 1);
+}
+
+TEST(RestraintMDModule, AppliesForcesThroughLocalAtomViews)
+{
+    auto restraint = std::make_shared<LocalAtomsRestraint>();
+    const std::vector<std::shared_ptr<IRestraintPotential>> restraints{ restraint, restraint };
+    const std::vector<int>                                  evaluationPeriods{ 1, 2 };
+    auto module = RestraintMDModule::create(restraints, evaluationPeriods);
+
+    ForceProviders forceProviders;
+    module->initForceProviders(&forceProviders);
+
+    std::vector<RVec> x = { { 1, 2, 3 }, { -1, 0, 2 } };
+    t_mdatoms         md{};
+    md.homenr = ssize(x);
+    t_commrec              cr{};
+    matrix                 box = { { 10, 0, 0 }, { 0, 10, 0 }, { 0, 0, 10 } };
+    FloatingPointTolerance tolerance(defaultRealTolerance());
+    for (int64_t step = 1; step <= 2; ++step)
+    {
+        ForceProviderInput  forceProviderInput(x, md, 0.0, step, box, cr);
+        PaddedVector<RVec>  f = { { 0, 0, 0 }, { 0, 0, 0 } };
+        ForceWithVirial     forceWithVirial(f, true);
+        gmx_enerdata_t      enerdDummy(1, 0);
+        ForceProviderOutput forceProviderOutput(&forceWithVirial, &enerdDummy);
+        forceProviders.calculateForces(forceProviderInput, &forceProviderOutput);
+
+        // At step 2, the second registration adds twice its force as an impulse.
+        const real expectedScale = (step == 2) ? 3 : 1;
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+            for (int d = 0; d < DIM; ++d)
+            {
+                EXPECT_REAL_EQ_TOL(f[i][d], -expectedScale * x[i][d], tolerance);
+            }
+        }
+    }
+    EXPECT_EQ(restraint->numCalls_, 3);
+    EXPECT_EQ(restraint->lastGlobalIndex_, std::vector<int>({ 0, 1 }));
+    EXPECT_REAL_EQ_TOL(restraint->lastBoxX_, 10, tolerance);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
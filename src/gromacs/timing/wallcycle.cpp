@@ -44,6 +44,7 @@
 #include <cstdlib>
 
 #include <array>
+#include <string>
 #include <vector>
 
 #include "gromacs/math/functions.h"
@@ -98,6 +99,9 @@ struct gmx_wallcycle
     MPI_Comm mpi_comm_mygroup;
 #endif
     wallcc_t* wcsc;
+    /* the named sub counters, numbered from ewcsNR, and their names */
+    std::vector<wallcc_t>    namedSubcounters;
+    std::vector<std::string> namedSubcounterNames;
 };
 
 /* Each name should not exceed 19 printing characters
@@ -138,6 +142,7 @@ static const char* wcn[ewcNR] = { "Run",
                                   "Vsite spread",
                                   "COM pull force",
                                   "AWH",
+                                  "Restraint modules",
                                   "Write traj.",
                                   "Update",
                                   "Constraints",
@@ -203,7 +208,8 @@ gmx_wallcycle_t wallcycle_init(FILE* fplog, int resetstep, t_commrec gmx_unused*
         return nullptr;
     }
 
-    snew(wc, 1);
+    /* Not snew, because of the vectors of named sub counters */
+    wc = new gmx_wallcycle{};
 
     wc->haveInvalidCount = FALSE;
     wc->wc_barrier       = FALSE;
@@ -265,7 +271,7 @@ void wallcycle_destroy(gmx_wallcycle_t wc)
     {
         sfree(wc->wcsc);
     }
-    sfree(wc);
+    delete wc;
 }
 
 static void wallcycle_all_start(gmx_wallcycle_t wc, int ewc, gmx_cycles_t cycle)
@@ -463,6 +469,11 @@ void wallcycle_reset_all(gmx_wallcycle_t wc)
             wc->wcsc[i].c = 0;
         }
     }
+    for (auto& counter : wc->namedSubcounters)
+    {
+        counter.n = 0;
+        counter.c = 0;
+    }
 }
 
 static gmx_bool is_pme_counter(int ewc)
@@ -533,6 +544,13 @@ void wallcycle_scale_by_num_threads(gmx_wallcycle_t wc, bool isPmeRank, int nthr
             wc->wcsc[i].c *= nthreads_pp;
         }
     }
+    if (!isPmeRank)
+    {
+        for (auto& counter : wc->namedSubcounters)
+        {
+            counter.c *= nthreads_pp;
+        }
+    }
 }
 
 /* TODO Make an object for this function to return, containing some
@@ -549,24 +567,36 @@ void wallcycle_scale_by_num_threads(gmx_wallcycle_t wc, bool isPmeRank, int nthr
  * only MASTERRANK uses any of the results. */
 WallcycleCounts wallcycle_sum(const t_commrec* cr, gmx_wallcycle_t wc)
 {
-    WallcycleCounts cycles_sum;
-    wallcc_t*       wcc;
-    double          cycles[int(ewcNR) + int(ewcsNR)];
-#if GMX_MPI
-    double cycles_n[int(ewcNR) + int(ewcsNR) + 1];
-#endif
-    int i;
-    int nsum;
+    wallcc_t* wcc;
+    int       i;
+    int       nsum;
 
     if (wc == nullptr)
     {
-        /* Default construction of std::array of non-class T can leave
-           the values indeterminate, just like a C array, and icc
-           warns about it. */
-        cycles_sum.fill(0);
-        return cycles_sum;
+        return WallcycleCounts(int(ewcNR) + int(ewcsNR), 0);
     }
 
+#if GMX_MPI
+    if (cr->nnodes > 1)
+    {
+        /* PME-only ranks do not register the named sub counters of the
+           PP ranks, so agree on the number of them before summing */
+        int localNamed = gmx::ssize(wc->namedSubcounters);
+        int maxNamed   = 0;
+        MPI_Allreduce(&localNamed, &maxNamed, 1, MPI_INT, MPI_MAX, cr->mpi_comm_mysim);
+        wc->namedSubcounters.resize(maxNamed, wallcc_t{});
+        wc->namedSubcounterNames.resize(maxNamed);
+    }
+#endif
+
+    const int           numNamed   = gmx::ssize(wc->namedSubcounters);
+    const int           firstNamed = int(ewcNR) + int(ewcsNR);
+    WallcycleCounts     cycles_sum(firstNamed + numNamed, 0);
+    std::vector<double> cycles(firstNamed + numNamed, 0);
+#if GMX_MPI
+    std::vector<double> cycles_n(firstNamed + numNamed + 1, 0);
+#endif
+
     wcc = wc->wcc;
 
     subtract_cycles(wcc, ewcDOMDEC, ewcDDCOMMLOAD);
@@ -609,20 +639,28 @@ WallcycleCounts wallcycle_sum(const t_commrec* cr, gmx_wallcycle_t wc)
 #endif
             cycles[ewcNR + i] = static_cast<double>(wc->wcsc[i].c);
         }
-        nsum += ewcsNR;
     }
+    nsum += ewcsNR;
+    for (i = 0; i < numNamed; i++)
+    {
+#if GMX_MPI
+        cycles_n[firstNamed + i] = static_cast<double>(wc->namedSubcounters[i].n);
+#endif
+        cycles[firstNamed + i] = static_cast<double>(wc->namedSubcounters[i].c);
+    }
+    nsum += numNamed;
 
 #if GMX_MPI
     if (cr->nnodes > 1)
     {
-        double buf[int(ewcNR) + int(ewcsNR) + 1];
+        std::vector<double> buf(nsum + 1);
 
         // TODO this code is used only at the end of the run, so we
         // can just do a simple reduce of haveInvalidCount in
         // wallcycle_print, and avoid bugs
         cycles_n[nsum] = (wc->haveInvalidCount ? 1 : 0);
         // TODO Use MPI_Reduce
-        MPI_Allreduce(cycles_n, buf, nsum + 1, MPI_DOUBLE, MPI_MAX, cr->mpi_comm_mysim);
+        MPI_Allreduce(cycles_n.data(), buf.data(), nsum + 1, MPI_DOUBLE, MPI_MAX, cr->mpi_comm_mysim);
         for (i = 0; i < ewcNR; i++)
         {
             wcc[i].n = gmx::roundToInt(buf[i]);
@@ -635,9 +673,13 @@ WallcycleCounts wallcycle_sum(const t_commrec* cr, gmx_wallcycle_t wc)
                 wc->wcsc[i].n = gmx::roundToInt(buf[ewcNR + i]);
             }
         }
+        for (i = 0; i < numNamed; i++)
+        {
+            wc->namedSubcounters[i].n = gmx::roundToInt(buf[firstNamed + i]);
+        }
 
         // TODO Use MPI_Reduce
-        MPI_Allreduce(cycles, cycles_sum.data(), nsum, MPI_DOUBLE, MPI_SUM, cr->mpi_comm_mysim);
+        MPI_Allreduce(cycles.data(), cycles_sum.data(), nsum, MPI_DOUBLE, MPI_SUM, cr->mpi_comm_mysim);
 
         if (wc->wcc_all != nullptr)
         {
@@ -949,6 +991,18 @@ void wallcycle_print(FILE*                            fplog,
         fprintf(fplog, "%s\n", hline);
     }
 
+    if (!wc->namedSubcounters.empty())
+    {
+        fprintf(fplog, " Breakdown of modules\n");
+        fprintf(fplog, "%s\n", hline);
+        for (i = 0; i < gmx::ssize(wc->namedSubcounters); i++)
+        {
+            print_cycles(fplog, c2t_pp, wc->namedSubcounterNames[i].c_str(), npp, nth_pp,
+                         wc->namedSubcounters[i].n, cyc_sum[ewcNR + ewcsNR + i], tot);
+        }
+        fprintf(fplog, "%s\n", hline);
+    }
+
     /* print GPU timing summary */
     double tot_gpu = 0.0;
     if (gpu_pme_t)
@@ -1158,28 +1212,66 @@ extern void wcycle_set_reset_counters(gmx_wallcycle_t wc, int64_t reset_counters
     wc->reset_counters = reset_counters;
 }
 
+/* Returns the sub counter ewcs, or nullptr when it is not active */
+static wallcc_t* active_sub_counter(gmx_wallcycle_t wc, int ewcs)
+{
+    if (wc == nullptr)
+    {
+        return nullptr;
+    }
+    if (ewcs >= ewcsNR)
+    {
+        return &wc->namedSubcounters[ewcs - ewcsNR];
+    }
+    return useCycleSubcounters ? &wc->wcsc[ewcs] : nullptr;
+}
+
 void wallcycle_sub_start(gmx_wallcycle_t wc, int ewcs)
 {
-    if (useCycleSubcounters && wc != nullptr)
+    wallcc_t* counter = active_sub_counter(wc, ewcs);
+    if (counter != nullptr)
     {
-        wc->wcsc[ewcs].start = gmx_cycles_read();
+        counter->start = gmx_cycles_read();
     }
 }
 
 void wallcycle_sub_start_nocount(gmx_wallcycle_t wc, int ewcs)
 {
-    if (useCycleSubcounters && wc != nullptr)
+    wallcc_t* counter = active_sub_counter(wc, ewcs);
+    if (counter != nullptr)
     {
-        wallcycle_sub_start(wc, ewcs);
-        wc->wcsc[ewcs].n--;
+        counter->start = gmx_cycles_read();
+        counter->n--;
     }
 }
 
 void wallcycle_sub_stop(gmx_wallcycle_t wc, int ewcs)
 {
-    if (useCycleSubcounters && wc != nullptr)
+    wallcc_t* counter = active_sub_counter(wc, ewcs);
+    if (counter != nullptr)
     {
-        wc->wcsc[ewcs].c += gmx_cycles_read() - wc->wcsc[ewcs].start;
-        wc->wcsc[ewcs].n++;
+        counter->c += gmx_cycles_read() - counter->start;
+        counter->n++;
     }
 }
+
+int wallcycle_sub_register(gmx_wallcycle_t wc, const char* name)
+{
+    if (wc == nullptr)
+    {
+        return -1;
+    }
+
+    wc->namedSubcounters.push_back(wallcc_t{});
+    wc->namedSubcounterNames.emplace_back(name);
+
+    return ewcsNR + gmx::ssize(wc->namedSubcounters) - 1;
+}
+
+void wallcycle_sub_get(gmx_wallcycle_t wc, int ewcs, int* n, double* c)
+{
+    const wallcc_t& counter =
+            (ewcs >= ewcsNR) ? wc->namedSubcounters[ewcs - ewcsNR] : wc->wcsc[ewcs];
+    *n = counter.n;
+    *c = static_cast<double>(counter.c);
+}
@@ -87,6 +87,7 @@ enum
     ewcVSITESPREAD,
     ewcPULLPOT,
     ewcAWH,
+    ewcRESTRAINT_MODULES,
     ewcTRAJ,
     ewcUPDATE,
     ewcCONSTR,
@@ -182,4 +183,17 @@ void wallcycle_sub_start_nocount(gmx_wallcycle_t wc, int ewcs);
 void wallcycle_sub_stop(gmx_wallcycle_t wc, int ewcs);
 /* Stop the sub cycle count for ewcs */
 
+int wallcycle_sub_register(gmx_wallcycle_t wc, const char* name);
+/* Adds a sub counter named name, to be used with wallcycle_sub_start
+ * and wallcycle_sub_stop like the other sub counters. The named sub
+ * counters are numbered from ewcsNR on in the order of registration,
+ * are active also without GMX_CYCLE_SUBCOUNTERS and are reported in a
+ * separate table. Only the first 19 characters of name are printed.
+ * All PP ranks should register the same counters in the same order.
+ * Returns -1 when wc is NULL.
+ */
+
+void wallcycle_sub_get(gmx_wallcycle_t wc, int ewcs, int* n, double* c);
+/* Returns the cumulative count and cycle count for sub counter ewcs */
+
 #endif
@@ -43,7 +43,7 @@
 
 #include <stdio.h>
 
-#include <array>
+#include <vector>
 
 #include "gromacs/utility/basedefinitions.h"
 
@@ -58,8 +58,9 @@ typedef struct gmx_wallcycle* gmx_wallcycle_t;
 struct gmx_wallclock_gpu_nbnxn_t;
 struct gmx_wallclock_gpu_pme_t;
 
-typedef std::array<double, int(ewcNR) + int(ewcsNR)> WallcycleCounts;
-/* Convenience typedef */
+typedef std::vector<double> WallcycleCounts;
+/* Convenience typedef, holds the ewcNR counters, the ewcsNR sub counters
+   and the named sub counters */
 
 WallcycleCounts wallcycle_sum(const t_commrec* cr, gmx_wallcycle_t wc);
 /* Return a vector of the sum of cycle counts over the nodes in
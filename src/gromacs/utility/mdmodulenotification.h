@@ -49,6 +49,7 @@
 
 #include "gromacs/utility/mdmodulenotification-impl.h"
 
+struct gmx_wallcycle;
 struct t_commrec;
 enum class PbcType : int;
 
@@ -116,6 +117,17 @@ struct SimulationTimeStep
     const double delta_t;
 };
 
+/*! \libinternal \brief Provides the cycle counting of the simulation.
+ *
+ * Unlike other arguments passed as pointers, the cycle counting structure
+ * may be kept by modules for the duration of the simulation to time their work.
+ */
+struct SimulationWallcycle
+{
+    //! Cycle counting structure, may be nullptr when cycle counting is not supported
+    gmx_wallcycle* const wcycle;
+};
+
 /*! \libinternal
  * \brief Collection of callbacks to MDModules at differnt run-times.
  *
@@ -207,13 +219,16 @@ struct MdModulesNotifier
      *                           time information
      * const t_commrec& provides a communicator to the modules during simulation
      *                  setup
+     * const SimulationWallcycle& provides modules with the cycle counting of
+     *                            the simulation
      */
     registerMdModuleNotification<const KeyValueTreeObject&,
                                  LocalAtomSetManager*,
                                  MdModulesEnergyOutputToDensityFittingRequestChecker*,
                                  const PbcType&,
                                  const SimulationTimeStep&,
-                                 const t_commrec&>::type simulationSetupNotifications_;
+                                 const t_commrec&,
+                                 const SimulationWallcycle&>::type simulationSetupNotifications_;
 };
 
 } // namespace gmx